@@ -49,14 +49,43 @@ Client::Client(int _nthreads) {
     pthread_barrier_init(&barrier, nullptr, nthreads);
     
     minSleepNs = getOpt("TBENCH_MINSLEEPNS", 0);
+    spinNs = getOpt("TBENCH_SPINNS", 0);
     seed = getOpt("TBENCH_RANDSEED", 0);
     lambda = getOpt<double>("TBENCH_QPS", 1000.0) * 1e-9;
 
     dist = nullptr; // Will get initialized in startReq()
+    startNs = 0;
 
     startedReqs = 0;
 
-    tBenchClientInit();
+    std::string recordPath = getOpt<std::string>("TBENCH_RECORD", "");
+    std::string replayPath = getOpt<std::string>("TBENCH_REPLAY", "");
+
+    replay = nullptr;
+    replayScale = 1.0;
+    if (replayPath.size()) {
+        replay = new TraceReader(replayPath, MAX_REQ_BYTES);
+        double replayQps = getOpt<double>("TBENCH_REPLAY_QPS", 0.0);
+        if (replayQps > 0) {
+            // Traces recorded during a replay only have their average rate
+            double recordedQps = replay->qps() > 0 ? replay->qps() :
+                replay->count() * 1e9 / replay->durationNs();
+            replayScale = recordedQps / replayQps;
+        }
+        std::cout << "Replaying " << replay->count() << " requests from " \
+            << replayPath << std::endl;
+    } else {
+        tBenchClientInit(); // The app generates the requests
+    }
+
+    metrics = Metrics::get();
+    if (metrics) metrics->enableClient();
+
+    recorder = nullptr;
+    if (recordPath.size()) {
+        // A replay does not send at TBENCH_QPS
+        recorder = new TraceWriter(recordPath, replay ? 0.0 : lambda * 1e9);
+    }
 }
 
 Request* Client::startReq() {
@@ -68,6 +97,7 @@ Request* Client::startReq() {
         if (!dist) {
             uint64_t curNs = getCurNs();
             dist = new ExpDist(lambda, seed, curNs);
+            startNs = curNs;
 
             status = WARMUP;
 
@@ -83,11 +113,30 @@ Request* Client::startReq() {
     pthread_mutex_lock(&lock);
 
     Request* req = new Request();
-    size_t len = tBenchClientGenReq(&req->data);
-    req->len = len;
-
     req->id = startedReqs++;
-    req->genNs = dist->nextArrivalNs();
+
+    if (replay) {
+        // Loops over the trace if the run outlasts it
+        uint64_t r = req->id % replay->count();
+        uint64_t loop = req->id / replay->count();
+        if (loop == 1 && r == 0) {
+            std::cerr << "WARNING: Trace exhausted, replaying it again" \
+                << std::endl;
+        }
+
+        const TraceRecord& rec = replay->get(r);
+        memcpy(req->data, replay->payload(r), rec.len);
+        req->len = rec.len;
+
+        uint64_t offsetNs = loop * replay->durationNs() + rec.offsetNs;
+        req->genNs = startNs + static_cast<uint64_t>(offsetNs * replayScale);
+    } else {
+        req->len = tBenchClientGenReq(&req->data);
+        req->genNs = dist->nextArrivalNs();
+    }
+
+    if (recorder) recorder->append(req->genNs - startNs, req->data, req->len);
+
     inFlightReqs[req->id] = req;
 
     pthread_mutex_unlock(&lock);
@@ -95,9 +144,11 @@ Request* Client::startReq() {
     uint64_t curNs = getCurNs();
 
     if (curNs < req->genNs) {
-        sleepUntil(std::max(req->genNs, curNs + minSleepNs));
+        sleepUntil(std::max(req->genNs, curNs + minSleepNs), spinNs);
     }
 
+    if (metrics) metrics->add(CLIENT_ISSUED);
+
     return req;
 }
 
@@ -108,6 +159,13 @@ void Client::finiReq(Response* resp) {
     assert(it != inFlightReqs.end());
     Request* req = it->second;
 
+    if (metrics) {
+        uint64_t sjrn = getCurNs() - req->genNs;
+        metrics->add(CLIENT_COMPLETED);
+        metrics->record(CLIENT_SOJOURN, sjrn);
+        metrics->record(CLIENT_QUEUE, sjrn > resp->svcNs ? sjrn - resp->svcNs : 0);
+    }
+
     if (status == ROI) {
         uint64_t curNs = getCurNs();
 
@@ -143,6 +201,8 @@ void Client::startRoi() {
 }
 
 void Client::dumpStats() {
+    if (recorder) recorder->finish(getCurNs() - startNs);
+
     std::ofstream out("lats.bin", std::ios::out | std::ios::binary);
     int reqs = sjrnTimes.size();
 
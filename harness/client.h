@@ -20,6 +20,8 @@
 #include "msgs.h"
 #include "msgs.h"
 #include "dist.h"
+#include "metrics.h"
+#include "trace.h"
 
 #include <pthread.h>
 #include <stdint.h>
@@ -39,9 +41,17 @@ class Client {
         pthread_barrier_t barrier;
 
         uint64_t minSleepNs;
+        uint64_t spinNs;
         uint64_t seed;
         double lambda;
         ExpDist* dist;
+        uint64_t startNs;
+
+        TraceWriter* recorder; // TBENCH_RECORD
+        TraceReader* replay;   // TBENCH_REPLAY
+        double replayScale;    // Replayed ns per recorded ns
+
+        Metrics* metrics;      // TBENCH_METRICS_PORT
 
         uint64_t startedReqs;
         std::unordered_map<uint64_t, Request*> inFlightReqs;
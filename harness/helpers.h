@@ -61,6 +61,13 @@ static void sleepUntil(uint64_t targetNs) {
     }
 }
 
+// Sleeps until spinNs before targetNs, then spins. Paces requests closer than
+// the wakeup latency of nanosleep allows.
+static void sleepUntil(uint64_t targetNs, uint64_t spinNs) {
+    if (targetNs > spinNs) sleepUntil(targetNs - spinNs);
+    while (getCurNs() < targetNs);
+}
+
 static int sendfull(int fd, const char* msg, int len, int flags) {
     int remaining = len;
     const char* cur = msg;
@@ -0,0 +1,357 @@
+/** $lic$
+ * Copyright (C) 2016-2017 by Massachusetts Institute of Technology
+ *
+ * This file is part of TailBench.
+ *
+ * If you use this software in your research, we request that you reference the
+ * TaiBench paper ("TailBench: A Benchmark Suite and Evaluation Methodology for
+ * Latency-Critical Applications", Kasture and Sanchez, IISWC-2016) as the
+ * source in any publications that use this software, and that you send us a
+ * citation of your work.
+ *
+ * TailBench is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include "helpers.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Live metrics (TBENCH_METRICS_PORT)
+ *
+ * Counters and latency histograms of the client and server, served in the
+ * Prometheus text format over HTTP on localhost while the run goes on. Each
+ * thread counts into a slot of its own with relaxed atomic adds; a scrape sums
+ * the slots. Nothing else runs unless someone scrapes: the endpoint thread
+ * waits in accept().
+ *
+ * Histograms have 8 buckets per power of two of ns (at most 12.5% error).
+ * Besides the cumulative histograms, a scrape reports the throughput and the
+ * percentiles of the requests finished since the previous scrape.
+ */
+
+enum MetricsCounter {
+    SERVER_STARTED,     // Requests handed to the app
+    SERVER_FINISHED,    // Responses from the app
+    CLIENT_ISSUED,      // Requests sent (past their send time)
+    CLIENT_COMPLETED,   // Responses received
+    NUM_COUNTERS
+};
+
+enum MetricsHist {
+    SERVER_SERVICE,
+    CLIENT_QUEUE,
+    CLIENT_SOJOURN,
+    NUM_HISTS
+};
+
+class Metrics {
+    private:
+        static const int SUB_BITS = 3;
+        static const int NUM_BUCKETS = 64 << SUB_BITS;
+        static const int MAX_SLOTS = 1024;
+
+        struct Slot {
+            std::atomic<uint64_t> counts[NUM_COUNTERS];
+            std::atomic<uint64_t> sumNs[NUM_HISTS];
+            std::atomic<uint64_t> buckets[NUM_HISTS][NUM_BUCKETS];
+        };
+
+        // What a scrape sees
+        struct Snapshot {
+            uint64_t ns;
+            uint64_t counts[NUM_COUNTERS];
+            uint64_t sumNs[NUM_HISTS];
+            std::vector<uint64_t> buckets[NUM_HISTS];
+        };
+
+        std::atomic<Slot*> slots[MAX_SLOTS];
+        std::atomic<int> nextSlot;
+
+        std::atomic<bool> hasClient;
+        std::atomic<bool> hasServer;
+
+        int port;
+        pthread_t thread;
+        Snapshot last; // Only touched by the endpoint thread
+
+        Metrics(int _port) : nextSlot(0), hasClient(false), hasServer(false),
+            port(_port) {
+            for (int s = 0; s < MAX_SLOTS; ++s) slots[s] = nullptr;
+            take(last);
+
+            int status = pthread_create(&thread, nullptr, serve, this);
+            if (status != 0) {
+                std::cerr << "Cannot start metrics thread: " \
+                    << strerror(status) << std::endl;
+                exit(-1);
+            }
+        }
+
+        static Metrics* create() {
+            int port = getOpt<int>("TBENCH_METRICS_PORT", 0);
+            return port > 0 ? new Metrics(port) : nullptr;
+        }
+
+        Slot* mySlot() {
+            static __thread Slot* slot = nullptr;
+            if (!slot) {
+                int s = nextSlot++;
+                if (s < MAX_SLOTS) {
+                    slot = new Slot();
+                    slots[s] = slot;
+                } else {
+                    // More threads than slots: share one, adds are atomic
+                    while (!(slot = slots[s % MAX_SLOTS]));
+                }
+            }
+            return slot;
+        }
+
+        // Bucket b holds (bucketTopNs(b - 1), bucketTopNs(b)], so that the
+        // "le" bounds of a scrape are bucket tops
+        static int bucket(uint64_t ns) {
+            if (ns == 0) return 0;
+            --ns;
+            if (ns < (1 << SUB_BITS)) return ns;
+            int log = 63 - __builtin_clzll(ns);
+            int sub = (ns >> (log - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+            return ((log - SUB_BITS + 1) << SUB_BITS) + sub;
+        }
+
+        static uint64_t bucketTopNs(int b) {
+            if (b < (1 << SUB_BITS)) return b + 1;
+            int log = (b >> SUB_BITS) + SUB_BITS - 1;
+            uint64_t sub = b & ((1 << SUB_BITS) - 1);
+            return ((1 << SUB_BITS) + sub + 1) << (log - SUB_BITS);
+        }
+
+        void take(Snapshot& snap) {
+            snap.ns = getCurNs();
+            memset(snap.counts, 0, sizeof(snap.counts));
+            memset(snap.sumNs, 0, sizeof(snap.sumNs));
+            for (int h = 0; h < NUM_HISTS; ++h) {
+                snap.buckets[h].assign(NUM_BUCKETS, 0);
+            }
+
+            int n = std::min<int>(nextSlot, MAX_SLOTS);
+            for (int s = 0; s < n; ++s) {
+                Slot* slot = slots[s];
+                if (!slot) continue; // Being set up
+                for (int c = 0; c < NUM_COUNTERS; ++c) {
+                    snap.counts[c] += slot->counts[c].load(
+                            std::memory_order_relaxed);
+                }
+                for (int h = 0; h < NUM_HISTS; ++h) {
+                    snap.sumNs[h] += slot->sumNs[h].load(
+                            std::memory_order_relaxed);
+                    for (int b = 0; b < NUM_BUCKETS; ++b) {
+                        snap.buckets[h][b] += slot->buckets[h][b].load(
+                                std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        // Counters are read one by one while they change, so a difference
+        // can come out slightly negative
+        static uint64_t diff(uint64_t a, uint64_t b) {
+            return a > b ? a - b : 0;
+        }
+
+        static void gauge(std::ostream& out, const char* name,
+                const char* help, double value) {
+            out << "# HELP " << name << " " << help << "\n";
+            out << "# TYPE " << name << " gauge\n";
+            out << name << " " << value << "\n";
+        }
+
+        static void counter(std::ostream& out, const char* name,
+                const char* help, uint64_t value) {
+            out << "# HELP " << name << " " << help << "\n";
+            out << "# TYPE " << name << " counter\n";
+            out << name << " " << value << "\n";
+        }
+
+        // Cumulative histogram, and percentiles since the previous scrape
+        void histogram(std::ostream& out, const char* name, const char* help,
+                const Snapshot& now, MetricsHist h) {
+            const std::vector<uint64_t>& buckets = now.buckets[h];
+
+            out << "# HELP " << name << " " << help << "\n";
+            out << "# TYPE " << name << " histogram\n";
+            // Powers of two from ~1us to ~69s
+            uint64_t cum = 0;
+            int b = 0;
+            for (int log = 10; log <= 36; ++log) {
+                for (; b <= bucket(1ull << log); ++b) cum += buckets[b];
+                out << name << "_bucket{le=\"" << (1ull << log) * 1e-9 \
+                    << "\"} " << cum << "\n";
+            }
+            for (; b < NUM_BUCKETS; ++b) cum += buckets[b];
+            out << name << "_bucket{le=\"+Inf\"} " << cum << "\n";
+            out << name << "_sum " << now.sumNs[h] * 1e-9 << "\n";
+            out << name << "_count " << cum << "\n";
+
+            uint64_t total = 0;
+            for (b = 0; b < NUM_BUCKETS; ++b) {
+                total += buckets[b] - last.buckets[h][b];
+            }
+            out << "# HELP " << name << "_window " << help \
+                << ", since the previous scrape\n";
+            out << "# TYPE " << name << "_window summary\n";
+            const double quantiles[] = {0.5, 0.9, 0.95, 0.99, 0.999};
+            for (double q : quantiles) {
+                double value = 0;
+                if (total) {
+                    uint64_t rank = std::max<uint64_t>(1, q * total + 0.5);
+                    uint64_t seen = 0;
+                    for (b = 0; b < NUM_BUCKETS; ++b) {
+                        seen += buckets[b] - last.buckets[h][b];
+                        if (seen >= rank) break;
+                    }
+                    value = bucketTopNs(b) * 1e-9;
+                }
+                out << name << "_window{quantile=\"" << q << "\"} " \
+                    << value << "\n";
+            }
+            out << name << "_window_sum " \
+                << (now.sumNs[h] - last.sumNs[h]) * 1e-9 << "\n";
+            out << name << "_window_count " << total << "\n";
+        }
+
+        std::string render() {
+            Snapshot now;
+            take(now);
+            double windowS = (now.ns - last.ns) * 1e-9;
+            if (windowS <= 0) windowS = 1e-9;
+            const uint64_t* c = now.counts;
+
+            std::stringstream out;
+            out.precision(10);
+            if (hasServer) {
+                counter(out, "tbench_server_requests_total",
+                        "Requests served", c[SERVER_FINISHED]);
+                gauge(out, "tbench_server_in_service",
+                        "Requests being served",
+                        diff(c[SERVER_STARTED], c[SERVER_FINISHED]));
+                gauge(out, "tbench_server_throughput",
+                        "Requests served per second since the previous scrape",
+                        (c[SERVER_FINISHED] - last.counts[SERVER_FINISHED]) / \
+                        windowS);
+                histogram(out, "tbench_server_service_seconds",
+                        "Service time", now, SERVER_SERVICE);
+            }
+            if (hasClient) {
+                counter(out, "tbench_client_requests_total",
+                        "Requests sent", c[CLIENT_ISSUED]);
+                counter(out, "tbench_client_responses_total",
+                        "Responses received", c[CLIENT_COMPLETED]);
+                gauge(out, "tbench_client_in_flight",
+                        "Requests sent and not answered yet",
+                        diff(c[CLIENT_ISSUED], c[CLIENT_COMPLETED]));
+                gauge(out, "tbench_client_throughput",
+                        "Responses per second since the previous scrape",
+                        (c[CLIENT_COMPLETED] - last.counts[CLIENT_COMPLETED]) \
+                        / windowS);
+                histogram(out, "tbench_client_queue_seconds",
+                        "Queuing time", now, CLIENT_QUEUE);
+                histogram(out, "tbench_client_sojourn_seconds",
+                        "End-to-end time", now, CLIENT_SOJOURN);
+            }
+            if (hasServer && hasClient) {
+                // Integrated: both ends in this process
+                gauge(out, "tbench_queue_depth",
+                        "Requests sent and not being served yet",
+                        diff(diff(c[CLIENT_ISSUED], c[CLIENT_COMPLETED]),
+                            diff(c[SERVER_STARTED], c[SERVER_FINISHED])));
+            }
+
+            last = now;
+            return out.str();
+        }
+
+        static void* serve(void* m) {
+            Metrics* metrics = reinterpret_cast<Metrics*>(m);
+
+            int listener = socket(AF_INET, SOCK_STREAM, 0);
+            int yes = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(metrics->port);
+
+            if (listener == -1 || bind(listener,
+                        reinterpret_cast<struct sockaddr*>(&addr),
+                        sizeof(addr)) == -1 || listen(listener, 4) == -1) {
+                std::cerr << "Cannot serve metrics on port " << metrics->port \
+                    << ": " << strerror(errno) << std::endl;
+                return nullptr;
+            }
+
+            while (true) {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd == -1) continue;
+
+                // Whatever was asked for, the answer is the metrics
+                char req[4096];
+                recv(fd, req, sizeof(req), 0);
+
+                std::string body = metrics->render();
+                std::stringstream resp;
+                resp << "HTTP/1.0 200 OK\r\n" \
+                    << "Content-Type: text/plain; version=0.0.4\r\n" \
+                    << "Content-Length: " << body.size() << "\r\n\r\n" \
+                    << body;
+                std::string r = resp.str();
+                sendfull(fd, r.c_str(), r.size(), MSG_NOSIGNAL);
+                close(fd);
+            }
+
+            return nullptr;
+        }
+
+    public:
+        // nullptr unless TBENCH_METRICS_PORT is set
+        static Metrics* get() {
+            static Metrics* instance = create();
+            return instance;
+        }
+
+        void enableClient() { hasClient = true; }
+        void enableServer() { hasServer = true; }
+
+        void add(MetricsCounter c) {
+            mySlot()->counts[c].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void record(MetricsHist h, uint64_t ns) {
+            Slot* slot = mySlot();
+            slot->buckets[h][bucket(ns)].fetch_add(1,
+                    std::memory_order_relaxed);
+            slot->sumNs[h].fetch_add(ns, std::memory_order_relaxed);
+        }
+};
+
+#endif
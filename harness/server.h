@@ -20,6 +20,7 @@
 #include "client.h"
 #include "dist.h"
 #include "helpers.h"
+#include "metrics.h"
 #include "msgs.h"
 
 #include <pthread.h>
@@ -41,12 +42,17 @@ class Server {
 
         std::vector<ReqInfo> reqInfo; // Request info for each thread 
 
+        Metrics* serverMetrics; // TBENCH_METRICS_PORT
+
     public:
         Server(int nthreads) {
             finishedReqs = 0;
             maxReqs = getOpt("TBENCH_MAXREQS", 0);
             warmupReqs = getOpt("TBENCH_WARMUPREQS", 0);
             reqInfo.resize(nthreads);
+
+            serverMetrics = Metrics::get();
+            if (serverMetrics) serverMetrics->enableServer();
         }
 
         virtual size_t recvReq(int id, void** data) = 0;
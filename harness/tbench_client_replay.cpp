@@ -0,0 +1,34 @@
+/** $lic$
+ * Copyright (C) 2016-2017 by Massachusetts Institute of Technology
+ *
+ * This file is part of TailBench.
+ *
+ * If you use this software in your research, we request that you reference the
+ * TaiBench paper ("TailBench: A Benchmark Suite and Evaluation Methodology for
+ * Latency-Critical Applications", Kasture and Sanchez, IISWC-2016) as the
+ * source in any publications that use this software, and that you send us a
+ * citation of your work.
+ *
+ * TailBench is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+/* Request generator of tbench_replay_client, a networked client for any
+ * application that only sends the requests of a trace (TBENCH_REPLAY) and
+ * needs none of the application's client code or data.
+ */
+
+#include "tbench_client.h"
+
+#include <iostream>
+
+void tBenchClientInit() {
+    std::cerr << "tbench_replay_client only replays traces, set " \
+        << "TBENCH_REPLAY" << std::endl;
+    exit(-1);
+}
+
+size_t tBenchClientGenReq(void*) {
+    return 0; // Never called, see tBenchClientInit()
+}
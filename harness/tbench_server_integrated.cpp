@@ -53,6 +53,7 @@ size_t IntegratedServer::recvReq(int id, void** data) {
     uint64_t curNs = getCurNs();
     reqInfo[id].id = req->id;
     reqInfo[id].startNs = curNs;
+    if (serverMetrics) serverMetrics->add(SERVER_STARTED);
     return req->len;
 };
 
@@ -69,6 +70,11 @@ void IntegratedServer::sendResp(int id, const void* data, size_t len) {
 
     resp->svcNs = curNs - reqInfo[id].startNs;
 
+    if (serverMetrics) {
+        serverMetrics->add(SERVER_FINISHED);
+        serverMetrics->record(SERVER_SERVICE, resp->svcNs);
+    }
+
     Client::finiReq(resp);
 
     delete resp;
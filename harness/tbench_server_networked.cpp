@@ -224,6 +224,8 @@ size_t NetworkedServer::recvReq(int id, void** data) {
         reqInfo[id].startNs = curNs;
         activeFds[id] = fd;
 
+        if (serverMetrics) serverMetrics->add(SERVER_STARTED);
+
         *data = reinterpret_cast<void*>(&req->data);
     }
 
@@ -246,6 +248,11 @@ void NetworkedServer::sendResp(int id, const void* data, size_t len) {
     assert(curNs > reqInfo[id].startNs);
     resp->svcNs = curNs - reqInfo[id].startNs;
 
+    if (serverMetrics) {
+        serverMetrics->add(SERVER_FINISHED);
+        serverMetrics->record(SERVER_SERVICE, resp->svcNs);
+    }
+
     int fd = activeFds[id];
     int totalLen = sizeof(Response) - MAX_RESP_BYTES + len;
     int sent = sendfull(fd, reinterpret_cast<const char*>(resp), totalLen, 0);
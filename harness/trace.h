@@ -0,0 +1,239 @@
+/** $lic$
+ * Copyright (C) 2016-2017 by Massachusetts Institute of Technology
+ *
+ * This file is part of TailBench.
+ *
+ * If you use this software in your research, we request that you reference the
+ * TaiBench paper ("TailBench: A Benchmark Suite and Evaluation Methodology for
+ * Latency-Critical Applications", Kasture and Sanchez, IISWC-2016) as the
+ * source in any publications that use this software, and that you send us a
+ * citation of your work.
+ *
+ * TailBench is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Request traces (TBENCH_RECORD / TBENCH_REPLAY)
+ *
+ * A trace holds the payload of each request a client generated and the time,
+ * relative to the start of the run, it was meant to be sent at. Layout:
+ *
+ *   TraceHeader
+ *   TraceRecord, payload, padding to 8 bytes   (one per request)
+ *   uint64_t index[count]                      (file offset of each record)
+ *
+ * The index is written when the run ends. A trace whose writer died before
+ * that has no index (indexOffset == 0), and the reader rebuilds it by walking
+ * the records, dropping a partly written last one. Records longer than the
+ * largest request the client can send are rejected.
+ */
+
+const char TRACE_MAGIC[8] = {'T', 'B', 'T', 'R', 'A', 'C', 'E', '1'};
+
+struct TraceHeader {
+    char magic[8];
+    double qps;           // TBENCH_QPS of the recording, 0 if unknown
+    uint64_t count;
+    uint64_t durationNs;  // Start of the run to the end of the recording
+    uint64_t indexOffset;
+};
+
+struct TraceRecord {
+    uint64_t offsetNs;    // Intended send time, from the start of the run
+    uint64_t len;
+};
+
+static inline uint64_t tracePadded(uint64_t len) {
+    return (len + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Appends and the final write of the index can come from different threads
+class TraceWriter {
+    private:
+        pthread_mutex_t lock;
+        FILE* file;
+        std::string path;
+        TraceHeader header;
+        std::vector<uint64_t> index;
+        uint64_t pos;
+
+    public:
+        TraceWriter(const std::string& _path, double qps)
+            : path(_path), pos(sizeof(TraceHeader)) {
+            pthread_mutex_init(&lock, nullptr);
+            file = fopen(path.c_str(), "w");
+            if (!file) {
+                std::cerr << "Cannot open trace " << path << ": " \
+                    << strerror(errno) << std::endl;
+                exit(-1);
+            }
+            setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+            header.qps = qps;
+            fwrite(&header, sizeof(header), 1, file);
+        }
+
+        ~TraceWriter() { finish(0); }
+
+        void append(uint64_t offsetNs, const void* data, size_t len) {
+            pthread_mutex_lock(&lock);
+            if (!file) {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            TraceRecord rec = {offsetNs, len};
+            static const char zeros[8] = {0};
+            fwrite(&rec, sizeof(rec), 1, file);
+            fwrite(data, 1, len, file);
+            fwrite(zeros, 1, tracePadded(len) - len, file);
+
+            index.push_back(pos);
+            pos += sizeof(rec) + tracePadded(len);
+            pthread_mutex_unlock(&lock);
+        }
+
+        // Writes the index; appending after this is a no-op
+        void finish(uint64_t durationNs) {
+            pthread_mutex_lock(&lock);
+            if (!file) {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            header.count = index.size();
+            header.durationNs = durationNs;
+            header.indexOffset = pos;
+            fwrite(index.data(), sizeof(uint64_t), index.size(), file);
+            fseek(file, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, file);
+            if (fclose(file) != 0) {
+                std::cerr << "Cannot write trace " << path << ": " \
+                    << strerror(errno) << std::endl;
+            }
+            file = nullptr;
+            pthread_mutex_unlock(&lock);
+        }
+};
+
+class TraceReader {
+    private:
+        const char* base;
+        size_t size;
+        TraceHeader header;
+        const uint64_t* index;
+        std::vector<uint64_t> rebuilt; // If the trace has no index
+
+        void fail(const std::string& path, const std::string& why) {
+            std::cerr << "Cannot read trace " << path << ": " << why \
+                << std::endl;
+            exit(-1);
+        }
+
+    public:
+        // Requests longer than maxLen bytes make the trace unusable
+        TraceReader(const std::string& path, uint64_t maxLen) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd == -1) fail(path, strerror(errno));
+            struct stat st;
+            if (fstat(fd, &st) == -1) fail(path, strerror(errno));
+            size = st.st_size;
+            if (size < sizeof(TraceHeader)) fail(path, "too short");
+
+            void* m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m == MAP_FAILED) fail(path, strerror(errno));
+            close(fd);
+            base = reinterpret_cast<const char*>(m);
+            madvise(m, size, MADV_SEQUENTIAL);
+
+            memcpy(&header, base, sizeof(header));
+            if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+                fail(path, "not a trace");
+            }
+
+            if (header.indexOffset != 0 && header.indexOffset +
+                    header.count * sizeof(uint64_t) <= size) {
+                index = reinterpret_cast<const uint64_t*>(
+                        base + header.indexOffset);
+                for (uint64_t i = 0; i < header.count; i++) {
+                    if (index[i] < sizeof(TraceHeader) ||
+                            index[i] + sizeof(TraceRecord) > size) {
+                        fail(path, "bad index");
+                    }
+                    uint64_t len = get(i).len;
+                    if (len > maxLen) {
+                        fail(path, "request " + std::to_string(i) + \
+                                " is longer than " + \
+                                std::to_string(maxLen) + " bytes");
+                    }
+                    if (index[i] + sizeof(TraceRecord) + len > size) {
+                        fail(path, "bad index");
+                    }
+                }
+            } else {
+                std::cerr << "Trace " << path << " has no index (the run " \
+                    << "did not finish), rebuilding it" << std::endl;
+                uint64_t pos = sizeof(TraceHeader);
+                uint64_t lastNs = 0;
+                while (pos + sizeof(TraceRecord) <= size) {
+                    const TraceRecord* rec =
+                        reinterpret_cast<const TraceRecord*>(base + pos);
+                    if (rec->len > maxLen) break;
+                    uint64_t end = pos + sizeof(TraceRecord) +
+                        tracePadded(rec->len);
+                    if (end > size) break;
+                    rebuilt.push_back(pos);
+                    lastNs = rec->offsetNs;
+                    pos = end;
+                }
+                header.count = rebuilt.size();
+                header.durationNs = lastNs;
+                index = rebuilt.data();
+            }
+
+            if (header.count == 0) fail(path, "no requests");
+            // Back to back loops of the trace should not send two requests
+            // at once
+            uint64_t gapNs = std::max<uint64_t>(header.durationNs / \
+                    header.count, 1);
+            if (header.durationNs < get(header.count - 1).offsetNs + gapNs) {
+                header.durationNs = get(header.count - 1).offsetNs + gapNs;
+            }
+        }
+
+        ~TraceReader() { munmap(const_cast<char*>(base), size); }
+
+        uint64_t count() const { return header.count; }
+        uint64_t durationNs() const { return header.durationNs; }
+        double qps() const { return header.qps; }
+
+        const TraceRecord& get(uint64_t i) const {
+            return *reinterpret_cast<const TraceRecord*>(base + index[i]);
+        }
+
+        const char* payload(uint64_t i) const {
+            return base + index[i] + sizeof(TraceRecord);
+        }
+};
+
+#endif
@@ -117,3 +117,91 @@ readData(cv::Mat &x, cv::Mat &y, std::string xpath, std::string ypath, int numbe
     x = concatenateMat(vec);
 }
 
+
+static void
+writeMat(cv::FileStorage& fs, const char* name, const cv::Mat& m){
+    // an empty matrix (e.g. of a stage not trained yet) cannot be read back
+    if (m.empty()) return;
+    cv::Mat d;
+    m.convertTo(d, CV_64FC1);
+    fs << name << d;
+}
+
+void
+writeModel(cv::FileStorage& fs, const SMR& smr, \
+           const std::vector<SA>& HiddenLayers){
+
+    // Save smr
+    fs << "smr" << "{:";
+    writeMat(fs, "Weight", smr.Weight);
+    writeMat(fs, "Wgrad", smr.Wgrad);
+    fs << "cost" << smr.cost << "}";
+
+    // Save HiddenLayers
+    fs << "HiddenLayers" << "[";
+    for (const SA& sa : HiddenLayers) {
+        fs << "{:";
+        writeMat(fs, "W1", sa.W1);
+        writeMat(fs, "W2", sa.W2);
+        writeMat(fs, "b1", sa.b1);
+        writeMat(fs, "b2", sa.b2);
+        writeMat(fs, "W1grad", sa.W1grad);
+        writeMat(fs, "W2grad", sa.W2grad);
+        writeMat(fs, "b1grad", sa.b1grad);
+        writeMat(fs, "b2grad", sa.b2grad);
+        fs << "cost" << sa.cost << "}";
+    }
+    fs << "]";
+}
+
+void
+readModel(const cv::FileStorage& fs, SMR& smr, std::vector<SA>& HiddenLayers){
+
+    cv::FileNode smrNode = fs["smr"];
+    smrNode["Weight"] >> smr.Weight;
+    smrNode["Wgrad"] >> smr.Wgrad;
+    smrNode["cost"] >> smr.cost;
+
+    HiddenLayers.clear();
+    cv::FileNode layersNode = fs["HiddenLayers"];
+
+    for (auto it = layersNode.begin(); it != layersNode.end(); ++it) {
+        SA sa;
+        (*it)["W1"] >> sa.W1;
+        (*it)["W2"] >> sa.W2;
+        (*it)["b1"] >> sa.b1;
+        (*it)["b2"] >> sa.b2;
+        (*it)["W1grad"] >> sa.W1grad;
+        (*it)["W2grad"] >> sa.W2grad;
+        (*it)["b1grad"] >> sa.b1grad;
+        (*it)["b2grad"] >> sa.b2grad;
+        (*it)["cost"] >> sa.cost;
+
+        HiddenLayers.push_back(sa);
+    }
+}
+
+void
+saveModel(const SMR& smr, const std::vector<SA>& HiddenLayers, \
+          const std::string& modelFile){
+    cv::FileStorage fs(modelFile, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cerr << "Failed to write model to file " << modelFile \
+            << std::endl;
+        exit(-1);
+    }
+    writeModel(fs, smr, HiddenLayers);
+    fs.release();
+}
+
+void
+loadModel(SMR& smr, std::vector<SA>& HiddenLayers, \
+          const std::string& modelFile){
+    cv::FileStorage fs(modelFile, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "Failed to read model from file " << modelFile \
+            << std::endl;
+        exit(-1);
+    }
+    readModel(fs, smr, HiddenLayers);
+}
@@ -71,6 +71,19 @@ struct Result {
     int res;
 };
 
+// The model file, shared by the trainer and the server (a cv::FileStorage
+// XML or YAML file). Matrices are stored as doubles whatever they were
+// trained in. writeModel()/readModel() work on an open file, so that the
+// trainer can keep its own state next to the model in a checkpoint.
+void writeModel(cv::FileStorage& fs, const SMR& smr, \
+                const std::vector<SA>& HiddenLayers);
+void readModel(const cv::FileStorage& fs, SMR& smr, \
+               std::vector<SA>& HiddenLayers);
+void saveModel(const SMR& smr, const std::vector<SA>& HiddenLayers, \
+               const std::string& modelFile);
+void loadModel(SMR& smr, std::vector<SA>& HiddenLayers, \
+               const std::string& modelFile);
+
 cv::Mat sigmoid(cv::Mat &M);
 cv::Mat dsigmoid(cv::Mat &a);
 
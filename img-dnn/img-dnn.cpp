@@ -66,33 +66,6 @@ resultProdict(const Mat &x, const vector<SA> &hLayers, const SMR &smr){
     return result;
 }
 
-void loadModel(SMR& smr, vector<SA>& HiddenLayers, string modelFile) {
-    FileStorage fs(modelFile, FileStorage::READ);
-
-    FileNode smrNode = fs["smr"];
-    smrNode["Weight"] >> smr.Weight;
-    smrNode["Wgrad"] >> smr.Wgrad;
-    smrNode["cost"] >> smr.cost;
-
-    HiddenLayers.clear();
-    FileNode layersNode = fs["HiddenLayers"];
-
-    for (auto it = layersNode.begin(); it != layersNode.end(); ++it) {
-        SA sa;
-        (*it)["W1"] >> sa.W1;
-        (*it)["W2"] >> sa.W2;
-        (*it)["b1"] >> sa.b1;
-        (*it)["b2"] >> sa.b2;
-        (*it)["W1grad"] >> sa.W1grad;
-        (*it)["W2grad"] >> sa.W2grad;
-        (*it)["b1grad"] >> sa.b1grad;
-        (*it)["b2grad"] >> sa.b2grad;
-        (*it)["cost"] >> sa.cost;
-
-        HiddenLayers.push_back(sa);
-    }
-}
-
 void printHelp(char* argv[]) {
     cerr << endl;
     cerr << "Usage: " << argv[0] << " [-f model_file] [-n max_reqs]" \
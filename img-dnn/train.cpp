@@ -2,339 +2,691 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+// Mini-batch gradient descent, with every batch split across the trainer
+// threads. Training runs in float: the kernels are OpenCV's gemm and
+// loops the compiler can vectorize, on buffers that are sized on the
+// first step and reused for the rest of a stage. The model file keeps
+// doubles, and is read by the server as before.
+
 int batch;
 
-void saveModel(const SMR& smr, const std::vector<SA>& HiddenLayers, \
-               std::string modelFile) {
-    cv::FileStorage fs(modelFile, cv::FileStorage::WRITE);
-
-    // Save smr
-    fs << "smr" << "{:" << "Weight" << smr.Weight << "Wgrad" << smr.Wgrad \
-        << "cost" << smr.cost << "}";
-
-    // Save HiddenLayers
-    fs << "HiddenLayers" << "[";
-    for (const SA& sa : HiddenLayers) {
-        fs << "{:" << "W1" << sa.W1 << "W2" << sa.W2 << "b1" << sa.b1 \
-            << "b2" << sa.b2 << "W1grad" << sa.W1grad << "W2grad" << sa.W2grad \
-            << "b1grad" << sa.b1grad << "b2grad" << sa.b2grad \
-            << "cost" << sa.cost << "}";
+// The stages of training, in order; a checkpoint records which one it
+// was taken in.
+enum {
+    SoftmaxStage = SparseAutoencoderLayers, // before it, one per layer
+    FineTuneStage,
+    DoneStage
+};
+
+// The trainer threads. run() hands a step to all of them, the calling
+// thread included as thread 0, and returns when all are done with it.
+class TrainerPool {
+    private:
+        int nThreads;
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int)>* step;
+        long generation;
+        int pending;
+        bool stopping;
+
+        void loop(int tid) {
+            long seen = 0;
+            while (true) {
+                const std::function<void(int)>* f;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    while (generation == seen) wake.wait(lock);
+                    seen = generation;
+                    if (stopping) return;
+                    f = step;
+                }
+
+                (*f)(tid);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (--pending == 0) done.notify_one();
+            }
+        }
+
+    public:
+        TrainerPool(int nThreads)
+            : nThreads(nThreads)
+            , step(nullptr)
+            , generation(0)
+            , pending(0)
+            , stopping(false)
+        {
+            for (int t = 1; t < nThreads; ++t) {
+                threads.push_back(std::thread(&TrainerPool::loop, this, t));
+            }
+        }
+
+        ~TrainerPool() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopping = true;
+                ++generation;
+            }
+            wake.notify_all();
+            for (std::thread& t : threads) t.join();
+        }
+
+        int size() const { return nThreads; }
+
+        void run(const std::function<void(int)>& f) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                step = &f;
+                pending = nThreads - 1;
+                ++generation;
+            }
+            wake.notify_all();
+
+            f(0);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (pending > 0) done.wait(lock);
+        }
+};
+
+// Buffers of one trainer thread
+struct ThreadBuffers {
+    cv::Mat hidden;
+    cv::Mat output;
+    cv::Mat delta2;
+    cv::Mat delta3;
+    cv::Mat rowSum;
+    cv::Mat prob;
+    std::vector<cv::Mat> acti;
+    std::vector<cv::Mat> delta;
+
+    // this thread's share of the gradients, and of the cost
+    std::vector<cv::Mat> grads;
+    double cost;
+};
+
+// The part [begin, end) of n that thread tid works on
+static void
+slice(int n, int tid, int nThreads, int& begin, int& end){
+    begin = (long)n * tid / nThreads;
+    end = (long)n * (tid + 1) / nThreads;
+}
+
+// Adds the column b to every column of M
+static void
+addBias(cv::Mat& M, const cv::Mat& b){
+    for (int r = 0; r < M.rows; ++r) {
+        float* p = M.ptr<float>(r);
+        const float v = b.at<float>(r, 0);
+        for (int c = 0; c < M.cols; ++c) p[c] += v;
     }
-    fs << "]";
-    fs.release();
 }
 
-void
-weightRandomInit(SA &sa, int inputsize, int hiddensize, int nsamples, double epsilon){
+static void
+sigmoidInPlace(cv::Mat& M){
+    M.convertTo(M, -1, -1.0);
+    cv::exp(M, M);
+    M += cv::Scalar(1.0);
+    cv::divide(1.0, M, M);
+}
 
-    double *pData;
-    sa.W1 = cv::Mat::ones(hiddensize, inputsize, CV_64FC1);
-    for(int i=0; i<hiddensize; i++){
-        pData = sa.W1.ptr<double>(i);
-        for(int j=0; j<inputsize; j++){
-            pData[j] = cv::randu<double>();
-        }
+// D = D .* dsigmoid(A), for A the output of a sigmoid
+static void
+mulDsigmoid(cv::Mat& D, const cv::Mat& A){
+    for (int r = 0; r < D.rows; ++r) {
+        float* d = D.ptr<float>(r);
+        const float* a = A.ptr<float>(r);
+        for (int c = 0; c < D.cols; ++c) d[c] *= a[c] * (1.0f - a[c]);
     }
-    sa.W1 = sa.W1 * (2 * epsilon) - epsilon;
+}
 
-    sa.W2 = cv::Mat::ones(inputsize, hiddensize, CV_64FC1);
-    for(int i=0; i<inputsize; i++){
-        pData = sa.W2.ptr<double>(i);
-        for(int j=0; j<hiddensize; j++){
-            pData[j] = cv::randu<double>();
+// Turns the class scores M (a column per sample) into the gradient of
+// the log loss, softmax(M) - groundTruth, and returns the summed loss
+static double
+softmaxGrad(cv::Mat& M, const cv::Mat& labels){
+    double loss = 0.0;
+    for (int c = 0; c < M.cols; ++c) {
+        float maxele = M.at<float>(0, c);
+        for (int r = 1; r < M.rows; ++r) {
+            maxele = std::max(maxele, M.at<float>(r, c));
         }
-    }
-    sa.W2 = sa.W2 * (2 * epsilon) - epsilon;
+        float sum = 0.0f;
+        for (int r = 0; r < M.rows; ++r) {
+            float& v = M.at<float>(r, c);
+            v = std::exp(v - maxele);
+            sum += v;
+        }
+        for (int r = 0; r < M.rows; ++r) M.at<float>(r, c) /= sum;
 
-    sa.b1 = cv::Mat::ones(hiddensize, 1, CV_64FC1);
-    for(int j=0; j<hiddensize; j++){
-        sa.b1.at<double>(j, 0) = cv::randu<double>();
+        float& p = M.at<float>((int)labels.at<double>(0, c), c);
+        loss -= std::log(std::max(p, FLT_MIN));
+        p -= 1.0f;
     }
-    sa.b1 = sa.b1 * (2 * epsilon) - epsilon;
+    return loss;
+}
 
-    sa.b2 = cv::Mat::ones(inputsize, 1, CV_64FC1);
-    for(int j=0; j<inputsize; j++){
-        sa.b2.at<double>(j, 0) = cv::randu<double>();
+// out[k] = scale * (sum of the threads' grads[k]), each thread summing
+// its share of the rows
+static void
+sumGrads(TrainerPool& pool, std::vector<ThreadBuffers>& bufs, \
+         const std::vector<cv::Mat*>& out, float scale){
+    for (size_t k = 0; k < out.size(); ++k) {
+        out[k]->create(bufs[0].grads[k].size(), CV_32FC1);
     }
-    sa.b2 = sa.b2 * (2 * epsilon) - epsilon;
+    pool.run([&](int tid) {
+        for (size_t k = 0; k < out.size(); ++k) {
+            cv::Mat& o = *out[k];
+            int begin, end;
+            slice(o.rows, tid, pool.size(), begin, end);
+            for (int r = begin; r < end; ++r) {
+                float* po = o.ptr<float>(r);
+                const float* p0 = bufs[0].grads[k].ptr<float>(r);
+                for (int c = 0; c < o.cols; ++c) po[c] = p0[c];
+                for (size_t t = 1; t < bufs.size(); ++t) {
+                    const float* pt = bufs[t].grads[k].ptr<float>(r);
+                    for (int c = 0; c < o.cols; ++c) po[c] += pt[c];
+                }
+                for (int c = 0; c < o.cols; ++c) po[c] *= scale;
+            }
+        }
+    });
+}
 
-    sa.W1grad = cv::Mat::zeros(hiddensize, inputsize, CV_64FC1);
-    sa.W2grad = cv::Mat::zeros(inputsize, hiddensize, CV_64FC1);
-    sa.b1grad = cv::Mat::zeros(hiddensize, 1, CV_64FC1);
-    sa.b2grad = cv::Mat::zeros(inputsize, 1, CV_64FC1);
-    sa.cost = 0.0;
+static double
+sumCost(const std::vector<ThreadBuffers>& bufs){
+    double cost = 0.0;
+    for (const ThreadBuffers& b : bufs) cost += b.cost;
+    return cost;
 }
 
-void 
-weightRandomInit(SMR &smr, int nclasses, int nfeatures, double epsilon){
+// sigmoid(W1 * x + b1) for all the columns of x
+static cv::Mat
+layerActivation(TrainerPool& pool, const SA& sa, const cv::Mat& x){
+    cv::Mat out(sa.W1.rows, x.cols, CV_32FC1);
+    pool.run([&](int tid) {
+        int begin, end;
+        slice(x.cols, tid, pool.size(), begin, end);
+        if (begin == end) return;
+        cv::Mat part;
+        cv::gemm(sa.W1, x.colRange(begin, end), 1.0, cv::Mat(), 0.0, part);
+        addBias(part, sa.b1);
+        sigmoidInPlace(part);
+        cv::Mat dst = out.colRange(begin, end);
+        part.copyTo(dst);
+    });
+    return out;
+}
 
-    smr.Weight = cv::Mat::ones(nclasses, nfeatures, CV_64FC1);
-    double *pData; 
-    for(int i = 0; i<smr.Weight.rows; i++){
-        pData = smr.Weight.ptr<double>(i);
-        for(int j=0; j<smr.Weight.cols; j++){
-            pData[j] = cv::randu<double>();        
+// Fraction of the columns of x the network classifies as in y
+static double
+accuracy(TrainerPool& pool, const std::vector<SA>& hLayers, const SMR& smr, \
+         const cv::Mat& x, const cv::Mat& y){
+    cv::Mat acti = x;
+    for (const SA& sa : hLayers) acti = layerActivation(pool, sa, acti);
+
+    std::vector<int> correct(pool.size(), 0);
+    pool.run([&](int tid) {
+        int begin, end;
+        slice(acti.cols, tid, pool.size(), begin, end);
+        if (begin == end) return;
+        cv::Mat M;
+        cv::gemm(smr.Weight, acti.colRange(begin, end), 1.0, cv::Mat(), \
+                0.0, M);
+        for (int i = 0; i < M.cols; ++i) {
+            int which = 0;
+            for (int j = 1; j < M.rows; ++j) {
+                if (M.at<float>(j, i) > M.at<float>(which, i)) which = j;
+            }
+            if (which == (int)y.at<double>(0, begin + i)) ++correct[tid];
         }
-    }
-    smr.Weight = smr.Weight * (2 * epsilon) - epsilon;
-    smr.cost = 0.0;
-    smr.Wgrad = cv::Mat::zeros(nclasses, nfeatures, CV_64FC1);
+    });
+
+    int total = 0;
+    for (int c : correct) total += c;
+    return (double)total / x.cols;
 }
 
-SAA
-getSparseAutoencoderActivation(SA &sa, cv::Mat &data){
-    SAA acti;
-    data.copyTo(acti.aInput);
-    acti.aHidden = sa.W1 * acti.aInput + repeat(sa.b1, 1, data.cols);
-    acti.aHidden = sigmoid(acti.aHidden);
-    acti.aOutput = sa.W2 * acti.aHidden + repeat(sa.b2, 1, data.cols);
-    acti.aOutput = sigmoid(acti.aOutput);
-    return acti;
+// What the training loops do between steps: checkpoints, and the
+// accuracy on the test set against the time since training started
+class Progress {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        TrainerPool& pool;
+        std::vector<SA>& hLayers;
+        SMR& smr;
+        Clock::time_point start;
+        double lastAccuracy;
+        double reachedAt;
+
+    public:
+        std::string checkpointFile;
+        int checkpointEvery;
+        int evalEvery;
+        double targetAccuracy;
+        cv::Mat testX, testY;
+
+        Progress(TrainerPool& pool, std::vector<SA>& hLayers, SMR& smr)
+            : pool(pool)
+            , hLayers(hLayers)
+            , smr(smr)
+            , start(Clock::now())
+            , lastAccuracy(-1.0)
+            , reachedAt(-1.0)
+            , checkpointEvery(0)
+            , evalEvery(0)
+            , targetAccuracy(0.0)
+        { }
+
+        double elapsed() const {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        void checkpoint(int stage, int iter) {
+            if (checkpointFile.empty()) return;
+            cv::FileStorage fs(checkpointFile, cv::FileStorage::WRITE);
+            if (!fs.isOpened()) {
+                std::cerr << "Failed to write checkpoint " << checkpointFile \
+                    << std::endl;
+                return;
+            }
+            writeModel(fs, smr, hLayers);
+            fs << "trainer" << "{:" << "stage" << stage << "iter" << iter \
+                << "}";
+            fs.release();
+        }
+
+        // True once the target accuracy is reached
+        bool evaluate(int iter) {
+            if (testX.empty()) return false;
+            lastAccuracy = accuracy(pool, hLayers, smr, testX, testY);
+            double t = elapsed();
+            std::cout << "threads: " << pool.size() << ", step: " << iter \
+                << ", time: " << t << " s, test accuracy: " << lastAccuracy \
+                << std::endl;
+            if (targetAccuracy > 0.0 && lastAccuracy >= targetAccuracy) {
+                if (reachedAt < 0.0) reachedAt = t;
+                return true;
+            }
+            return false;
+        }
+
+        // After step iter of stage; true to end the stage
+        bool step(int stage, int iter) {
+            if (checkpointEvery > 0 && iter % checkpointEvery == 0) {
+                checkpoint(stage, iter);
+            }
+            if (stage == FineTuneStage && evalEvery > 0 \
+                    && iter % evalEvery == 0) {
+                return evaluate(iter);
+            }
+            return false;
+        }
+
+        void finish(int stage) {
+            checkpoint(stage + 1, 0);
+            if (stage >= SoftmaxStage) evaluate(0);
+        }
+
+        void report() {
+            std::cout << "Training time with " << pool.size() \
+                << " threads: " << elapsed() << " s";
+            if (lastAccuracy >= 0.0) {
+                std::cout << ", test accuracy: " << lastAccuracy;
+            }
+            std::cout << std::endl;
+            if (targetAccuracy > 0.0) {
+                std::cout << "Time to accuracy " << targetAccuracy << " with " \
+                    << pool.size() << " threads: ";
+                if (reachedAt >= 0.0) {
+                    std::cout << reachedAt << " s" << std::endl;
+                } else {
+                    std::cout << "not reached" << std::endl;
+                }
+            }
+        }
+};
+
+void
+weightRandomInit(SA &sa, int inputsize, int hiddensize, int nsamples, double epsilon){
+
+    sa.W1.create(hiddensize, inputsize, CV_32FC1);
+    cv::randu(sa.W1, -epsilon, epsilon);
+    sa.W2.create(inputsize, hiddensize, CV_32FC1);
+    cv::randu(sa.W2, -epsilon, epsilon);
+    sa.b1.create(hiddensize, 1, CV_32FC1);
+    cv::randu(sa.b1, -epsilon, epsilon);
+    sa.b2.create(inputsize, 1, CV_32FC1);
+    cv::randu(sa.b2, -epsilon, epsilon);
+
+    sa.W1grad = cv::Mat::zeros(hiddensize, inputsize, CV_32FC1);
+    sa.W2grad = cv::Mat::zeros(inputsize, hiddensize, CV_32FC1);
+    sa.b1grad = cv::Mat::zeros(hiddensize, 1, CV_32FC1);
+    sa.b2grad = cv::Mat::zeros(inputsize, 1, CV_32FC1);
+    sa.cost = 0.0;
 }
 
 void
-sparseAutoencoderCost(SA &sa, cv::Mat &data, double lambda, double sparsityParam, double beta){
+weightRandomInit(SMR &smr, int nclasses, int nfeatures, double epsilon){
 
-    int nfeatures = data.rows;
-    int nsamples = data.cols;
-    SAA acti = getSparseAutoencoderActivation(sa, data);
-
-    cv::Mat errtp = acti.aOutput - data;
-    pow(errtp, 2.0, errtp);
-    errtp /= 2.0;
-    double err = sum(errtp)[0] / nsamples;
-    // now calculate pj which is the average activation of hidden units
-    cv::Mat pj;
-    reduce(acti.aHidden, pj, 1, CV_REDUCE_SUM);
-    pj /= nsamples;
-    // the second part is weight decay part
-    double err2 = sum(sa.W1)[0] + sum(sa.W2)[0];
-    err2 *= (lambda / 2.0);
-    // the third part of overall cost function is the sparsity part
-    cv::Mat err3;
-    cv::Mat temp;
-    temp = sparsityParam / pj;
-    log(temp, temp);
-    temp *= sparsityParam;
-    temp.copyTo(err3);
-    temp = (1 - sparsityParam) / (1 - pj);
-    log(temp, temp);
-    temp *= (1 - sparsityParam);
-    err3 += temp;
-    sa.cost = err + err2 + sum(err3)[0] * beta;
-
-    // following are for calculating the grad of weights.
-    cv::Mat delta3 = -(data - acti.aOutput);
-    delta3 = delta3.mul(dsigmoid(acti.aOutput));
-    cv::Mat temp2 = -sparsityParam / pj + (1 - sparsityParam) / (1 - pj);
-    temp2 *= beta;
-    cv::Mat delta2 = sa.W2.t() * delta3 + repeat(temp2, 1, nsamples);
-    delta2 = delta2.mul(dsigmoid(acti.aHidden));
-    cv::Mat nablaW1 = delta2 * acti.aInput.t();
-    cv::Mat nablaW2 = delta3 * acti.aHidden.t();
-    cv::Mat nablab1, nablab2; 
-    delta3.copyTo(nablab2);
-    delta2.copyTo(nablab1);
-    sa.W1grad = nablaW1 / nsamples + lambda * sa.W1;
-    sa.W2grad = nablaW2 / nsamples + lambda * sa.W2;
-    reduce(nablab1, sa.b1grad, 1, CV_REDUCE_SUM);
-    reduce(nablab2, sa.b2grad, 1, CV_REDUCE_SUM);
-    sa.b1grad /= nsamples;
-    sa.b2grad /= nsamples;
+    smr.Weight.create(nclasses, nfeatures, CV_32FC1);
+    cv::randu(smr.Weight, -epsilon, epsilon);
+    smr.cost = 0.0;
+    smr.Wgrad = cv::Mat::zeros(nclasses, nfeatures, CV_32FC1);
 }
 
 void
-trainSparseAutoencoder(SA &sa, cv::Mat &data, int hiddenSize, double lambda, double sparsityParam, double beta, double lrate, int MaxIter){
+trainSparseAutoencoder(TrainerPool& pool, Progress& progress, int layer, \
+        SA &sa, cv::Mat &data, int hiddenSize, double lambda, \
+        double sparsityParam, double beta, double lrate, int MaxIter, \
+        int startIter){
 
     int nfeatures = data.rows;
     int nsamples = data.cols;
-    weightRandomInit(sa, nfeatures, hiddenSize, nsamples, 0.12);
-    int converge = 0;
+    if (startIter == 0) {
+        weightRandomInit(sa, nfeatures, hiddenSize, nsamples, 0.12);
+    }
+    std::vector<ThreadBuffers> bufs(pool.size());
+    std::vector<cv::Mat*> grads = { &sa.W1grad, &sa.W2grad, &sa.b1grad, \
+        &sa.b2grad };
+    cv::Mat pj(hiddenSize, 1, CV_32FC1);
+    cv::Mat sparsity(hiddenSize, 1, CV_32FC1);
+    cv::Mat batchX;
+    int converge = startIter;
     double lastcost = 0.0;
     std::cout<<"Sparse Autoencoder Learning: "<<std::endl;
     while(converge < MaxIter){
 
         int randomNum = rand() % (data.cols - batch);
-        cv::Rect roi = cv::Rect(randomNum, 0, batch, data.rows);
-        cv::Mat batchX = data(roi);
+        batchX = data.colRange(randomNum, randomNum + batch);
+
+        // Forward pass, and the hidden activations for the sparsity term
+        pool.run([&](int tid) {
+            ThreadBuffers& b = bufs[tid];
+            int begin, end;
+            slice(batch, tid, pool.size(), begin, end);
+            cv::Mat x = batchX.colRange(begin, end);
+            cv::gemm(sa.W1, x, 1.0, cv::Mat(), 0.0, b.hidden);
+            addBias(b.hidden, sa.b1);
+            sigmoidInPlace(b.hidden);
+            cv::gemm(sa.W2, b.hidden, 1.0, cv::Mat(), 0.0, b.output);
+            addBias(b.output, sa.b2);
+            sigmoidInPlace(b.output);
+            cv::subtract(b.output, x, b.delta3);
+            b.cost = 0.5 * cv::norm(b.delta3, cv::NORM_L2SQR);
+            cv::reduce(b.hidden, b.rowSum, 1, CV_REDUCE_SUM);
+        });
+
+        // pj is the average activation of hidden units over the batch
+        bufs[0].rowSum.copyTo(pj);
+        for (size_t t = 1; t < bufs.size(); ++t) pj += bufs[t].rowSum;
+        pj /= batch;
+        double err3 = 0.0;
+        for (int j = 0; j < hiddenSize; ++j) {
+            double p = pj.at<float>(j, 0);
+            err3 += sparsityParam * log(sparsityParam / p) \
+                + (1 - sparsityParam) * log((1 - sparsityParam) / (1 - p));
+            sparsity.at<float>(j, 0) = beta * (-sparsityParam / p \
+                    + (1 - sparsityParam) / (1 - p));
+        }
+        double err2 = cv::norm(sa.W1, cv::NORM_L2SQR) \
+            + cv::norm(sa.W2, cv::NORM_L2SQR);
+        sa.cost = sumCost(bufs) / batch + err2 * lambda / 2.0 + err3 * beta;
 
-        sparseAutoencoderCost(sa, batchX, lambda, sparsityParam, beta);
         std::cout<<"learning step: "<<converge<<", Cost function value = "\
             <<sa.cost<<", randomNum = "<<randomNum<<std::endl;
         if(fabs((sa.cost - lastcost) ) <= 5e-5 && converge > 0) break;
         if(sa.cost <= 0.0) break;
         lastcost = sa.cost;
-        sa.W1 -= lrate * sa.W1grad;
-        sa.W2 -= lrate * sa.W2grad;
-        sa.b1 -= lrate * sa.b1grad;
-        sa.b2 -= lrate * sa.b2grad;
-        ++ converge;
-    }
-}
-
-void 
-softmaxRegressionCost(cv::Mat &x, cv::Mat &y, SMR &smr, double lambda){
 
-    int nsamples = x.cols;
-    int nfeatures = x.rows;
-    //calculate cost function
-    cv::Mat theta(smr.Weight);
-    cv::Mat M = theta * x;
-    cv::Mat temp, temp2;
-    temp = cv::Mat::ones(1, M.cols, CV_64FC1);
-    reduce(M, temp, 0, CV_REDUCE_SUM);
-    temp2 = repeat(temp, nclasses, 1);
-    M -= temp2;
-    exp(M, M);
-    temp = cv::Mat::ones(1, M.cols, CV_64FC1);
-    reduce(M, temp, 0, CV_REDUCE_SUM);
-    temp2 = repeat(temp, nclasses, 1);
-    divide(M, temp2, M); 
-    cv::Mat groundTruth = cv::Mat::zeros(nclasses, nsamples, CV_64FC1);
-    for(int i=0; i<nsamples; i++){
-        groundTruth.at<double>(y.at<double>(0, i), i) = 1.0;
+        // Backward pass
+        pool.run([&](int tid) {
+            ThreadBuffers& b = bufs[tid];
+            int begin, end;
+            slice(batch, tid, pool.size(), begin, end);
+            cv::Mat x = batchX.colRange(begin, end);
+            mulDsigmoid(b.delta3, b.output);
+            cv::gemm(sa.W2, b.delta3, 1.0, cv::Mat(), 0.0, b.delta2, \
+                    cv::GEMM_1_T);
+            addBias(b.delta2, sparsity);
+            mulDsigmoid(b.delta2, b.hidden);
+            b.grads.resize(4);
+            cv::gemm(b.delta2, x, 1.0, cv::Mat(), 0.0, b.grads[0], \
+                    cv::GEMM_2_T);
+            cv::gemm(b.delta3, b.hidden, 1.0, cv::Mat(), 0.0, b.grads[1], \
+                    cv::GEMM_2_T);
+            cv::reduce(b.delta2, b.grads[2], 1, CV_REDUCE_SUM);
+            cv::reduce(b.delta3, b.grads[3], 1, CV_REDUCE_SUM);
+        });
+        sumGrads(pool, bufs, grads, 1.0f / batch);
+        cv::scaleAdd(sa.W1, lambda, sa.W1grad, sa.W1grad);
+        cv::scaleAdd(sa.W2, lambda, sa.W2grad, sa.W2grad);
+
+        cv::scaleAdd(sa.W1grad, -lrate, sa.W1, sa.W1);
+        cv::scaleAdd(sa.W2grad, -lrate, sa.W2, sa.W2);
+        cv::scaleAdd(sa.b1grad, -lrate, sa.b1, sa.b1);
+        cv::scaleAdd(sa.b2grad, -lrate, sa.b2, sa.b2);
+        ++ converge;
+        if (progress.step(layer, converge)) break;
     }
-    cv::Mat logM;
-    log(M, logM);
-    temp = groundTruth.mul(logM);
-    smr.cost = - sum(temp)[0] / nsamples;
-    cv::Mat theta2;
-    pow(theta, 2.0, theta2);
-    smr.cost += sum(theta2)[0] * lambda / 2;
-    //calculate gradient
-    temp = groundTruth - M;   
-    temp = temp * x.t();
-    smr.Wgrad = - temp / nsamples;
-    smr.Wgrad += lambda * theta;
 }
 
-void 
-trainSoftmaxRegression(SMR& smr, cv::Mat &x, cv::Mat &y, double lambda, double lrate, int MaxIter){
+void
+trainSoftmaxRegression(TrainerPool& pool, Progress& progress, SMR& smr, \
+        cv::Mat &x, cv::Mat &y, double lambda, double lrate, int MaxIter, \
+        int startIter){
     int nfeatures = x.rows;
-    int nsamples = x.cols;
-    weightRandomInit(smr, nclasses, nfeatures, 0.12);
-    int converge = 0;
+    if (startIter == 0) weightRandomInit(smr, nclasses, nfeatures, 0.12);
+    std::vector<ThreadBuffers> bufs(pool.size());
+    std::vector<cv::Mat*> grads = { &smr.Wgrad };
+    cv::Mat batchX, batchY;
+    int converge = startIter;
     double lastcost = 0.0;
     std::cout<<"Softmax Regression Learning: "<<std::endl;
     while(converge < MaxIter){
 
         int randomNum = rand() % (x.cols - batch);
-        cv::Rect roi = cv::Rect(randomNum, 0, batch, x.rows);
-        cv::Mat batchX = x(roi);
-        roi = cv::Rect(randomNum, 0, batch, y.rows);
-        cv::Mat batchY = y(roi);
+        batchX = x.colRange(randomNum, randomNum + batch);
+        batchY = y.colRange(randomNum, randomNum + batch);
+
+        pool.run([&](int tid) {
+            ThreadBuffers& b = bufs[tid];
+            int begin, end;
+            slice(batch, tid, pool.size(), begin, end);
+            cv::Mat bx = batchX.colRange(begin, end);
+            cv::gemm(smr.Weight, bx, 1.0, cv::Mat(), 0.0, b.prob);
+            b.cost = softmaxGrad(b.prob, batchY.colRange(begin, end));
+            b.grads.resize(1);
+            cv::gemm(b.prob, bx, 1.0, cv::Mat(), 0.0, b.grads[0], \
+                    cv::GEMM_2_T);
+        });
+        sumGrads(pool, bufs, grads, 1.0f / batch);
+        double theta2 = cv::norm(smr.Weight, cv::NORM_L2SQR);
+        smr.cost = sumCost(bufs) / batch + theta2 * lambda / 2;
 
-        softmaxRegressionCost(batchX, batchY, smr, lambda);
         std::cout<<"learning step: "<<converge<<", Cost function value = "\
             <<smr.cost<<", randomNum = "<<randomNum<<std::endl;
         if(fabs((smr.cost - lastcost) ) <= 1e-6 && converge > 0) break;
         if(smr.cost <= 0) break;
         lastcost = smr.cost;
-        smr.Weight -= lrate * smr.Wgrad;
+        cv::scaleAdd(smr.Weight, lambda, smr.Wgrad, smr.Wgrad);
+        cv::scaleAdd(smr.Wgrad, -lrate, smr.Weight, smr.Weight);
         ++ converge;
+        if (progress.step(SoftmaxStage, converge)) break;
     }
 }
 
 void
-fineTuneNetworkCost(cv::Mat &x, cv::Mat &y, std::vector<SA> &hLayers, SMR &smr, double lambda){
-
-    int nfeatures = x.rows;
-    int nsamples = x.cols;
-    std::vector<cv::Mat> acti;
-
-    acti.push_back(x);
-    for(int i=1; i<=SparseAutoencoderLayers; i++){
-        cv::Mat tmpacti = hLayers[i - 1].W1 * acti[i - 1] + repeat(hLayers[i - 1].b1, 1, x.cols);
-        acti.push_back(sigmoid(tmpacti));
-    }
-    cv::Mat M = smr.Weight * acti[acti.size() - 1];
-    cv::Mat tmp;
-    reduce(M, tmp, 0, CV_REDUCE_MAX);
-    M = M + repeat(tmp, M.rows, 1);
-    cv::Mat p;
-    exp(M, p);
-    reduce(p, tmp, 0, CV_REDUCE_SUM);
-    divide(p, repeat(tmp, p.rows, 1), p);
-
-    cv::Mat groundTruth = cv::Mat::zeros(nclasses, nsamples, CV_64FC1);
-    for(int i=0; i<nsamples; i++){
-        groundTruth.at<double>(y.at<double>(0, i), i) = 1.0;
-    }
-    cv::Mat logP;
-    log(p, logP);
-    logP = logP.mul(groundTruth);
-    smr.cost = - sum(logP)[0] / nsamples;
-    pow(smr.Weight, 2.0, tmp);
-    smr.cost += sum(tmp)[0] * lambda / 2;
-
-    tmp = (groundTruth - p) * acti[acti.size() - 1].t();
-    tmp /= -nsamples;
-    smr.Wgrad = tmp + lambda * smr.Weight;
-
-    std::vector<cv::Mat> delta(acti.size());
-    delta[delta.size() -1] = -smr.Weight.t() * (groundTruth - p);
-    delta[delta.size() -1] = delta[delta.size() -1].mul(dsigmoid(acti[acti.size() - 1]));
-    for(int i = delta.size() - 2; i >= 0; i--){
-        delta[i] = hLayers[i].W1.t() * delta[i + 1];
-        delta[i] = delta[i].mul(dsigmoid(acti[i]));
+trainFineTuneNetwork(TrainerPool& pool, Progress& progress, cv::Mat &x, \
+        cv::Mat &y, std::vector<SA> &HiddenLayers, SMR &smr, double lambda, \
+        double lrate, int MaxIter, int startIter){
+
+    const int L = SparseAutoencoderLayers;
+    std::vector<ThreadBuffers> bufs(pool.size());
+    // smr first, then W1 and b1 of each layer
+    std::vector<cv::Mat*> grads;
+    grads.push_back(&smr.Wgrad);
+    for (int i = 0; i < L; i++) {
+        grads.push_back(&HiddenLayers[i].W1grad);
+        grads.push_back(&HiddenLayers[i].b1grad);
     }
-    for(int i=SparseAutoencoderLayers - 1; i >=0; i--){
-        hLayers[i].W1grad = delta[i + 1] * acti[i].t();
-        hLayers[i].W1grad /= nsamples;
-        reduce(delta[i + 1], tmp, 1, CV_REDUCE_SUM);
-        hLayers[i].b1grad = tmp / nsamples;
-    }
-    acti.clear();
-    delta.clear();
-}
-
-
-void
-trainFineTuneNetwork(cv::Mat &x, cv::Mat &y, std::vector<SA> &HiddenLayers, SMR &smr, double lambda, double lrate, int MaxIter){
-
-    int converge = 0;
+    cv::Mat batchX, batchY;
+    int converge = startIter;
     double lastcost = 0.0;
     std::cout<<"Fine-Tune network Learning: "<<std::endl;
     while(converge < MaxIter){
 
         int randomNum = rand() % (x.cols - batch);
-        cv::Rect roi = cv::Rect(randomNum, 0, batch, x.rows);
-        cv::Mat batchX = x(roi);
-        roi = cv::Rect(randomNum, 0, batch, y.rows);
-        cv::Mat batchY = y(roi);
+        batchX = x.colRange(randomNum, randomNum + batch);
+        batchY = y.colRange(randomNum, randomNum + batch);
+
+        pool.run([&](int tid) {
+            ThreadBuffers& b = bufs[tid];
+            int begin, end;
+            slice(batch, tid, pool.size(), begin, end);
+            b.acti.resize(L + 1);
+            b.delta.resize(L + 1);
+            b.grads.resize(1 + 2 * L);
+
+            b.acti[0] = batchX.colRange(begin, end);
+            for (int i = 1; i <= L; i++) {
+                cv::gemm(HiddenLayers[i - 1].W1, b.acti[i - 1], 1.0, \
+                        cv::Mat(), 0.0, b.acti[i]);
+                addBias(b.acti[i], HiddenLayers[i - 1].b1);
+                sigmoidInPlace(b.acti[i]);
+            }
+            cv::gemm(smr.Weight, b.acti[L], 1.0, cv::Mat(), 0.0, b.prob);
+            b.cost = softmaxGrad(b.prob, batchY.colRange(begin, end));
+            cv::gemm(b.prob, b.acti[L], 1.0, cv::Mat(), 0.0, b.grads[0], \
+                    cv::GEMM_2_T);
+
+            cv::gemm(smr.Weight, b.prob, 1.0, cv::Mat(), 0.0, b.delta[L], \
+                    cv::GEMM_1_T);
+            mulDsigmoid(b.delta[L], b.acti[L]);
+            for (int i = L - 1; i >= 0; i--) {
+                cv::gemm(b.delta[i + 1], b.acti[i], 1.0, cv::Mat(), 0.0, \
+                        b.grads[1 + 2 * i], cv::GEMM_2_T);
+                cv::reduce(b.delta[i + 1], b.grads[2 + 2 * i], 1, \
+                        CV_REDUCE_SUM);
+                if (i == 0) break;
+                cv::gemm(HiddenLayers[i].W1, b.delta[i + 1], 1.0, cv::Mat(), \
+                        0.0, b.delta[i], cv::GEMM_1_T);
+                mulDsigmoid(b.delta[i], b.acti[i]);
+            }
+        });
+        sumGrads(pool, bufs, grads, 1.0f / batch);
+        double theta2 = cv::norm(smr.Weight, cv::NORM_L2SQR);
+        smr.cost = sumCost(bufs) / batch + theta2 * lambda / 2;
 
-        fineTuneNetworkCost(batchX, batchY, HiddenLayers, smr, lambda);
         std::cout<<"learning step: "<<converge<<", Cost function value = "\
             <<smr.cost<<", randomNum = "<<randomNum<<std::endl;
         if(fabs((smr.cost - lastcost) / smr.cost) <= 1e-6 && converge > 0) break;
         if(smr.cost <= 0) break;
         lastcost = smr.cost;
-        smr.Weight -= lrate * smr.Wgrad;
-        for(int i=0; i<HiddenLayers.size(); i++){
-            HiddenLayers[i].W1 -= lrate * HiddenLayers[i].W1grad;
-            HiddenLayers[i].W2 -= lrate * HiddenLayers[i].W2grad;
-            HiddenLayers[i].b1 -= lrate * HiddenLayers[i].b1grad;
-            HiddenLayers[i].b2 -= lrate * HiddenLayers[i].b2grad;
+        cv::scaleAdd(smr.Weight, lambda, smr.Wgrad, smr.Wgrad);
+        cv::scaleAdd(smr.Wgrad, -lrate, smr.Weight, smr.Weight);
+        // W2 and b2 only reconstruct the input, prediction doesn't use them
+        for(int i=0; i<L; i++){
+            cv::scaleAdd(HiddenLayers[i].W1grad, -lrate, HiddenLayers[i].W1, \
+                    HiddenLayers[i].W1);
+            cv::scaleAdd(HiddenLayers[i].b1grad, -lrate, HiddenLayers[i].b1, \
+                    HiddenLayers[i].b1);
         }
         ++ converge;
+        if (progress.step(FineTuneStage, converge)) break;
+    }
+}
+
+// The trainer works on float copies of the model
+static void
+toFloat(cv::Mat& m){
+    if (!m.empty()) m.convertTo(m, CV_32FC1);
+}
+
+static void
+toFloat(SMR& smr, std::vector<SA>& HiddenLayers){
+    toFloat(smr.Weight);
+    toFloat(smr.Wgrad);
+    for (SA& sa : HiddenLayers) {
+        toFloat(sa.W1);
+        toFloat(sa.W2);
+        toFloat(sa.b1);
+        toFloat(sa.b2);
+        toFloat(sa.W1grad);
+        toFloat(sa.W2grad);
+        toFloat(sa.b1grad);
+        toFloat(sa.b2grad);
+    }
+}
+
+// Reads a checkpoint, or a finished model, which is taken as the start
+// of fine-tuning
+void loadCheckpoint(const std::string& file, SMR& smr, \
+        std::vector<SA>& HiddenLayers, int& stage, int& iter) {
+    cv::FileStorage fs(file, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cerr << "Failed to read checkpoint " << file << std::endl;
+        exit(-1);
+    }
+    readModel(fs, smr, HiddenLayers);
+    cv::FileNode trainer = fs["trainer"];
+    if (trainer.empty()) {
+        stage = FineTuneStage;
+        iter = 0;
+    } else {
+        trainer["stage"] >> stage;
+        trainer["iter"] >> iter;
     }
+    std::cout << "Resuming from " << file << " at stage " << stage \
+        << ", step " << iter << std::endl;
 }
 
 void printHelp(char* argv[]) {
     std::cerr << std::endl;
     std::cerr << "Usage: " << argv[0] << " [-m mnist_dir]"  \
         << " [-f model_file]" << " [-t training_set_size]" \
-        << " [-i max_training_iters]" << std::endl << std::endl;
+        << " [-i max_training_iters]" << " [-p threads]" \
+        << " [-b batch_size]" << " [-c checkpoint_file]" \
+        << " [-k checkpoint_interval]" << " [-r resume_file]" \
+        << " [-e eval_interval]" << " [-a target_accuracy]" \
+        << std::endl << std::endl;
     std::cerr << "-m : Directory where mnist data is stored (default: .mnist)" \
         << std::endl << std::endl;
     std::cerr << "-f : File to save model to" << std::endl << std::endl;
     std::cerr << "-t : Size of training set" << std::endl << std::endl;
-    std::cerr << "-f : Maximum iterations during training" << std::endl \
+    std::cerr << "-i : Maximum iterations during training" << std::endl \
         << std::endl;
+    std::cerr << "-p : Number of trainer threads (default: all cpus)" \
+        << std::endl << std::endl;
+    std::cerr << "-b : Samples per step (default: 1/100 of the training set)" \
+        << std::endl << std::endl;
+    std::cerr << "-c : File to write checkpoints to, after every stage" \
+        << std::endl << std::endl;
+    std::cerr << "-k : Also write a checkpoint every this many steps" \
+        << std::endl << std::endl;
+    std::cerr << "-r : Checkpoint or model file to resume training from" \
+        << std::endl << std::endl;
+    std::cerr << "-e : Test accuracy every this many fine-tuning steps" \
+        << " (needs the MNIST test set)" << std::endl << std::endl;
+    std::cerr << "-a : Stop once the test accuracy reaches this, and report" \
+        << " the time it took" << std::endl << std::endl;
     std::cerr << "-h : Print this help and exit" << std::endl << std::endl;
 }
 
@@ -342,11 +694,18 @@ void printHelp(char* argv[]) {
 int main(int argc, char* argv[]) {
     std::string mnistDataDir = "mnist";
     std::string modelFile = "model.xml";
+    std::string checkpointFile;
+    std::string resumeFile;
     int trainingSetSize = 60000; // Full MNIST training dataset
     int maxTrainingIter = 80000; // Max iters in original code
+    int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    int batchSize = 0;
+    int checkpointEvery = 0;
+    int evalEvery = 0;
+    double targetAccuracy = 0.0;
 
     int c;
-    while ((c = getopt(argc, argv, "m:f:t:i:h")) != -1) {
+    while ((c = getopt(argc, argv, "m:f:t:i:p:b:c:k:r:e:a:h")) != -1) {
         switch(c) {
             case 'm':
                 mnistDataDir = optarg;
@@ -360,6 +719,27 @@ int main(int argc, char* argv[]) {
             case 'i':
                 maxTrainingIter = atoi(optarg);
                 break;
+            case 'p':
+                nThreads = atoi(optarg);
+                break;
+            case 'b':
+                batchSize = atoi(optarg);
+                break;
+            case 'c':
+                checkpointFile = optarg;
+                break;
+            case 'k':
+                checkpointEvery = atoi(optarg);
+                break;
+            case 'r':
+                resumeFile = optarg;
+                break;
+            case 'e':
+                evalEvery = atoi(optarg);
+                break;
+            case 'a':
+                targetAccuracy = atof(optarg);
+                break;
             case 'h':
                 printHelp(argv);
                 return 0;
@@ -373,6 +753,7 @@ int main(int argc, char* argv[]) {
 
     std::vector<SA> HiddenLayers;
     SMR smr;
+    smr.cost = 0.0;
 
     cv::Mat trainX, trainY;
     std::string trainImages = mnistDataDir + "/train-images-idx3-ubyte";
@@ -385,40 +766,85 @@ int main(int argc, char* argv[]) {
     trainX = trainX(roi);
     roi = cv::Rect(0, 0, trainingSetSize, trainY.rows);
     trainY = trainY(roi);
+    trainX.convertTo(trainX, CV_32FC1);
 
     std::cout <<"Read trainX successfully, including "<< trainX.rows \
         << " features and " << trainX.cols << " samples." << std::endl;
     std::cout <<"Read trainY successfully, including "<<trainY.cols<<" samples"<< std::endl;
-    batch = trainX.cols / 100;
+    batch = batchSize > 0 ? batchSize : trainX.cols / 100;
+    // Every thread gets at least one sample of a batch
+    nThreads = std::max(1, std::min(nThreads, batch));
     // Finished reading data
 
-    // pre-processing data. 
+    cv::Mat testX, testY;
+    std::string testImages = mnistDataDir + "/t10k-images-idx3-ubyte";
+    std::string testLabels = mnistDataDir + "/t10k-labels-idx1-ubyte";
+    if (std::ifstream(testImages).good()) {
+        readData(testX, testY, testImages, testLabels, 10000);
+        testX.convertTo(testX, CV_32FC1);
+    } else if (evalEvery > 0 || targetAccuracy > 0.0) {
+        std::cerr << "No MNIST test set in " << mnistDataDir \
+            << ", not reporting accuracy" << std::endl;
+    }
+
+    int stage = 0;
+    int iter = 0;
+    if (!resumeFile.empty()) {
+        loadCheckpoint(resumeFile, smr, HiddenLayers, stage, iter);
+        toFloat(smr, HiddenLayers);
+    }
+
+    // The clock starts here, so the times reported leave out reading data
+    TrainerPool pool(nThreads);
+    Progress progress(pool, HiddenLayers, smr);
+    progress.checkpointFile = checkpointFile;
+    progress.checkpointEvery = checkpointEvery;
+    progress.evalEvery = evalEvery;
+    progress.targetAccuracy = targetAccuracy;
+    progress.testX = testX;
+    progress.testY = testY;
+
+    std::cout << "Training with " << nThreads << " threads, " << batch \
+        << " samples per step" << std::endl;
+
+    // pre-processing data.
     // For some dataset, you may like to pre-processing the data,
-    // however, in MNIST dataset, it actually already pre-processed. 
+    // however, in MNIST dataset, it actually already pre-processed.
     // Scalar mean, stddev;
     // meanStdDev(trainX, mean, stddev);
     // cv::Mat normX = trainX - mean[0];
     // normX.copyTo(trainX);
 
-    std::vector<cv::Mat> Activations;
+    cv::Mat activation = trainX;
     for(int i=0; i<SparseAutoencoderLayers; i++){
-        cv::Mat tempX;
-        if(i == 0) trainX.copyTo(tempX); else Activations[Activations.size() - 1].copyTo(tempX);
-        SA tmpsa;
-        trainSparseAutoencoder(tmpsa, tempX, 600, 3e-3, 0.1, 3, 2e-2, \
-                maxTrainingIter);
-        cv::Mat tmpacti = tmpsa.W1 * tempX + repeat(tmpsa.b1, 1, tempX.cols);
-        tmpacti = sigmoid(tmpacti);
-        HiddenLayers.push_back(tmpsa);
-        Activations.push_back(tmpacti);
+        if (i == (int)HiddenLayers.size()) {
+            HiddenLayers.push_back(SA());
+            HiddenLayers[i].cost = 0.0;
+        }
+        if (stage <= i) {
+            trainSparseAutoencoder(pool, progress, i, HiddenLayers[i], \
+                    activation, 600, 3e-3, 0.1, 3, 2e-2, maxTrainingIter, \
+                    stage == i ? iter : 0);
+            progress.finish(i);
+        }
+        activation = layerActivation(pool, HiddenLayers[i], activation);
     }
     // Finished training Sparse Autoencoder
     // Now train Softmax.
-    trainSoftmaxRegression(smr, Activations[Activations.size() - 1], trainY, \
-            3e-3, 2e-2, maxTrainingIter);
+    if (stage <= SoftmaxStage) {
+        trainSoftmaxRegression(pool, progress, smr, activation, trainY, \
+                3e-3, 2e-2, maxTrainingIter, \
+                stage == SoftmaxStage ? iter : 0);
+        progress.finish(SoftmaxStage);
+    }
     // Finetune using Back Propogation
-    trainFineTuneNetwork(trainX, trainY, HiddenLayers, smr, 1e-4, 2e-2, \
-            maxTrainingIter);
+    if (stage <= FineTuneStage) {
+        trainFineTuneNetwork(pool, progress, trainX, trainY, HiddenLayers, \
+                smr, 1e-4, 2e-2, maxTrainingIter, \
+                stage == FineTuneStage ? iter : 0);
+        progress.finish(FineTuneStage);
+    }
 
     saveModel(smr, HiddenLayers, modelFile);
+    progress.report();
 }
@@ -0,0 +1,17 @@
+#!/bin/bash
+# Time for train to reach a test accuracy, against the number of trainer
+# threads. Every run trains from scratch with the same seed.
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+source ${DIR}/../configs.sh
+
+THREADS=${THREADS:-"1 2 4 8 16"}
+ITERS=${ITERS:-80000}
+TARGET=${TARGET:-0.95}
+EVAL_EVERY=${EVAL_EVERY:-100}
+
+for t in ${THREADS}; do
+    ${DIR}/train -m ${DATA_ROOT}/img-dnn/mnist -i ${ITERS} -p ${t} \
+        -e ${EVAL_EVERY} -a ${TARGET} -f ${SCRATCH_DIR}/img-dnn.model.xml | \
+        grep -E "^(Training time|Time to accuracy)"
+done
@@ -0,0 +1,37 @@
+#!/bin/bash
+# Time to read an ARPA file with build_binary, plain and gzipped. ARPA
+# loading is line and number parsing in util::FilePiece, and for the
+# gzipped copy decompression too (on its own thread in threaded builds).
+#
+# Usage: arpa_load_time.sh <file.arpa>  (a few GB makes for a stable number)
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+source ${DIR}/../configs.sh
+
+BIN=./bin/build_binary
+
+ARPA=$1
+if [ ! -f "${ARPA}" ]; then
+    echo "Usage: $0 <file.arpa>"
+    exit 1
+fi
+
+mkdir -p ${SCRATCH_DIR}
+GZ=${SCRATCH_DIR}/$(basename ${ARPA}).gz
+OUT=${SCRATCH_DIR}/arpa_load_time.binary
+[ -f ${GZ} ] || gzip -c ${ARPA} > ${GZ}
+
+MB=$(( $(stat -c %s ${ARPA}) / 1048576 ))
+
+for INPUT in ${ARPA} ${GZ}; do
+    # From the page cache, so that the disk doesn't hide the parsing.
+    cat ${INPUT} > /dev/null
+    START=$(date +%s.%N)
+    ${BIN} -s probing ${INPUT} ${OUT} > /dev/null || exit 1
+    END=$(date +%s.%N)
+    SECONDS_TAKEN=$(echo "${END} - ${START}" | bc)
+    echo "$(basename ${INPUT}): ${SECONDS_TAKEN} seconds," \
+        "$(echo "${MB} / ${SECONDS_TAKEN}" | bc) MB/s of ARPA"
+done
+
+rm -f ${OUT}
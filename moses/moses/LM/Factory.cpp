@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <iostream>
+#include <memory>
 #include "Factory.h"
 #include "moses/UserMessage.h"
 #include "moses/TypeDef.h"
@@ -61,14 +62,95 @@ namespace Moses
 namespace LanguageModelFactory
 {
 
-LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
-                                   , const std::vector<FactorType> &factorTypes
-                                   , size_t nGramOrder
-                                   , const std::string &languageModelFile
-                                   , int dub)
+namespace
+{
+
+/*
+ * Models of a LanguageModelImplementation, made into a feature by
+ * LMRefCount. The toolkits behind them are not known to load safely
+ * alongside each other, so they load on the calling thread.
+ */
+class ImplementationLoad : public LanguageModelLoad
+{
+public:
+  ImplementationLoad(LanguageModelImplementation *lm
+                     , const std::vector<FactorType> &factorTypes
+                     , size_t nGramOrder
+                     , const std::string &languageModelFile)
+    : m_lm(lm), m_factorTypes(factorTypes), m_nGramOrder(nGramOrder)
+    , m_languageModelFile(languageModelFile) {}
+
+  ~ImplementationLoad() {
+    delete m_lm;
+  }
+
+  bool Load() {
+    switch (m_lm->GetLMType()) {
+    case SingleFactor:
+      if (! static_cast<LanguageModelSingleFactor*>(m_lm)->Load(m_languageModelFile, m_factorTypes[0], m_nGramOrder)) {
+        cerr << "single factor model failed" << endl;
+        return false;
+      }
+      break;
+    case MultiFactor:
+      if (! static_cast<LanguageModelMultiFactor*>(m_lm)->Load(m_languageModelFile, m_factorTypes, m_nGramOrder)) {
+        cerr << "multi factor model failed" << endl;
+        return false;
+      }
+      break;
+    }
+    return true;
+  }
+
+  LanguageModel *Create() {
+    LanguageModelImplementation *lm = m_lm;
+    m_lm = NULL;
+    return new LMRefCount(lm);
+  }
+
+private:
+  LanguageModelImplementation *m_lm;
+  std::vector<FactorType> m_factorTypes;
+  size_t m_nGramOrder;
+  std::string m_languageModelFile;
+};
+
+#ifdef LM_LDHT
+/*
+ * Distributed models have nothing to read up front.
+ */
+class LDHTLoad : public LanguageModelLoad
+{
+public:
+  LDHTLoad(const std::string &languageModelFile, FactorType factorType)
+    : m_languageModelFile(languageModelFile), m_factorType(factorType) {}
+
+  bool Load() {
+    return true;
+  }
+
+  LanguageModel *Create() {
+    return ConstructLDHTLM(m_languageModelFile,
+                           scoreIndexManager,
+                           m_factorType);
+  }
+
+private:
+  std::string m_languageModelFile;
+  FactorType m_factorType;
+};
+#endif
+
+}
+
+LanguageModelLoad* PrepareLanguageModel(LMImplementation lmImplementation
+                                        , const std::vector<FactorType> &factorTypes
+                                        , size_t nGramOrder
+                                        , const std::string &languageModelFile
+                                        , int dub)
 {
   if (lmImplementation == Ken || lmImplementation == LazyKen) {
-    return ConstructKenLM(languageModelFile, factorTypes[0], lmImplementation == LazyKen);
+    return PrepareKenLM(languageModelFile, factorTypes[0], lmImplementation == LazyKen);
   }
   LanguageModelImplementation *lm = NULL;
   switch (lmImplementation) {
@@ -85,7 +167,6 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
     lm = new LanguageModelRemote();
 #endif
     break;
-
   case SRI:
 #ifdef LM_SRI
     lm = new LanguageModelSRI();
@@ -108,9 +189,7 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
     break;
   case LDHTLM:
 #ifdef LM_LDHT
-    return ConstructLDHTLM(languageModelFile,
-                           scoreIndexManager,
-                           factorTypes[0]);
+    return new LDHTLoad(languageModelFile, factorTypes[0]);
 #endif
     break;
   default:
@@ -120,26 +199,21 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
   if (lm == NULL) {
     UserMessage::Add("Language model type unknown. Probably not compiled into library");
     return NULL;
-  } else {
-    switch (lm->GetLMType()) {
-    case SingleFactor:
-      if (! static_cast<LanguageModelSingleFactor*>(lm)->Load(languageModelFile, factorTypes[0], nGramOrder)) {
-        cerr << "single factor model failed" << endl;
-        delete lm;
-        lm = NULL;
-      }
-      break;
-    case MultiFactor:
-      if (! static_cast<LanguageModelMultiFactor*>(lm)->Load(languageModelFile, factorTypes, nGramOrder)) {
-        cerr << "multi factor model failed" << endl;
-        delete lm;
-        lm = NULL;
-      }
-      break;
-    }
   }
+  return new ImplementationLoad(lm, factorTypes, nGramOrder, languageModelFile);
+}
 
-  return new LMRefCount(lm);
+LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
+                                   , const std::vector<FactorType> &factorTypes
+                                   , size_t nGramOrder
+                                   , const std::string &languageModelFile
+                                   , int dub)
+{
+  std::auto_ptr<LanguageModelLoad> load(PrepareLanguageModel(lmImplementation, factorTypes, nGramOrder, languageModelFile, dub));
+  if (load.get() == NULL || !load->Load()) {
+    return NULL;
+  }
+  return load->Create();
 }
 }
 
@@ -12,6 +12,25 @@ namespace Moses
 
 class LanguageModel;
 
+/** A language model made in two steps, so that the files of several
+ *  can be read at once (see ModelLoader): Load() reads them, Create()
+ *  then makes the feature. Only Create() registers scores, so it has
+ *  to run on the thread that reads the config, in config order.
+ */
+class LanguageModelLoad
+{
+public:
+  virtual ~LanguageModelLoad() {}
+
+  virtual bool Load() = 0;
+  virtual LanguageModel *Create() = 0;
+
+  //! whether Load() may run on another thread, alongside other loads
+  virtual bool Concurrent() const {
+    return false;
+  }
+};
+
 namespace LanguageModelFactory {
 
 	/**
@@ -23,6 +42,15 @@ namespace LanguageModelFactory {
 																		, size_t nGramOrder
 																		, const std::string &languageModelFile
 																		, int dub);
+
+	/**
+	 * the same, in two steps. NULL if the type is unknown
+	 */
+	 LanguageModelLoad* PrepareLanguageModel(LMImplementation lmImplementation
+																		, const std::vector<FactorType> &factorTypes
+																		, size_t nGramOrder
+																		, const std::string &languageModelFile
+																		, int dub);
 	 
 };
 
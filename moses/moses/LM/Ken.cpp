@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "lm/model.hh"
 
 #include "Ken.h"
+#include "Factory.h"
 #include "Base.h"
 #include "moses/FFState.h"
 #include "moses/TypeDef.h"
@@ -62,7 +63,8 @@ struct KenLMState : public FFState {
  */
 template <class Model> class LanguageModelKen : public LanguageModel {
   public:
-    LanguageModelKen(const std::string &file, FactorType factorType, bool lazy);
+    // takes over the mapping from factor ids to the vocabulary of ngram
+    LanguageModelKen(const boost::shared_ptr<Model> &ngram, std::vector<lm::WordIndex> &lmIdLookup, FactorType factorType);
 
     LanguageModel *Duplicate() const;
 
@@ -143,22 +145,55 @@ private:
   std::vector<lm::WordIndex> &m_mapping;
 };
 
-template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::string &file, FactorType factorType, bool lazy) : m_factorType(factorType) {
-  lm::ngram::Config config;
-  IFVERBOSE(1) {
-    config.messages = &std::cerr;
-  } else {
-    config.messages = NULL;
-  }
-  FactorCollection &collection = FactorCollection::Instance();
-  MappingBuilder builder(collection, m_lmIdLookup);
-  config.enumerate_vocab = &builder;
-  config.load_method = lazy ? util::LAZY : util::POPULATE_OR_READ;
+template <class Model> LanguageModelKen<Model>::LanguageModelKen(const boost::shared_ptr<Model> &ngram, std::vector<lm::WordIndex> &lmIdLookup, FactorType factorType) :
+    m_ngram(ngram),
+    m_factorType(factorType) {
+  m_lmIdLookup.swap(lmIdLookup);
+  m_beginSentenceFactor = FactorCollection::Instance().AddFactor(BOS_);
+}
+
+/*
+ * Reads a KenLM model, and then makes the feature of it.
+ */
+template <class Model> class KenLMLoad : public LanguageModelLoad {
+  public:
+    KenLMLoad(const std::string &file, FactorType factorType, bool lazy)
+      : m_file(file), m_factorType(factorType), m_lazy(lazy) {}
 
-  m_ngram.reset(new Model(file.c_str(), config));
+    bool Concurrent() const { return true; }
 
-  m_beginSentenceFactor = collection.AddFactor(BOS_);
-}
+    bool Load() {
+      lm::ngram::Config config;
+      IFVERBOSE(1) {
+        config.messages = &std::cerr;
+      } else {
+        config.messages = NULL;
+      }
+      MappingBuilder builder(FactorCollection::Instance(), m_lmIdLookup);
+      config.enumerate_vocab = &builder;
+      config.load_method = m_lazy ? util::LAZY : util::POPULATE_OR_READ;
+
+      try {
+        m_ngram.reset(new Model(m_file.c_str(), config));
+      } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+      }
+      return true;
+    }
+
+    LanguageModel *Create() {
+      return new LanguageModelKen<Model>(m_ngram, m_lmIdLookup, m_factorType);
+    }
+
+  private:
+    std::string m_file;
+    FactorType m_factorType;
+    bool m_lazy;
+
+    boost::shared_ptr<Model> m_ngram;
+    std::vector<lm::WordIndex> m_lmIdLookup;
+};
 
 template <class Model> LanguageModel *LanguageModelKen<Model>::Duplicate() const {
   return new LanguageModelKen<Model>(*this);
@@ -337,29 +372,29 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const Cha
 
 } // namespace
 
-LanguageModel *ConstructKenLM(const std::string &file, FactorType factorType, bool lazy) {
+LanguageModelLoad *PrepareKenLM(const std::string &file, FactorType factorType, bool lazy) {
   try {
     lm::ngram::ModelType model_type;
     if (lm::ngram::RecognizeBinary(file.c_str(), model_type)) {
       switch(model_type) {
         case lm::ngram::PROBING:
-          return new LanguageModelKen<lm::ngram::ProbingModel>(file,  factorType, lazy);
+          return new KenLMLoad<lm::ngram::ProbingModel>(file,  factorType, lazy);
         case lm::ngram::REST_PROBING:
-          return new LanguageModelKen<lm::ngram::RestProbingModel>(file, factorType, lazy);
+          return new KenLMLoad<lm::ngram::RestProbingModel>(file, factorType, lazy);
         case lm::ngram::TRIE:
-          return new LanguageModelKen<lm::ngram::TrieModel>(file, factorType, lazy);
+          return new KenLMLoad<lm::ngram::TrieModel>(file, factorType, lazy);
         case lm::ngram::QUANT_TRIE:
-          return new LanguageModelKen<lm::ngram::QuantTrieModel>(file, factorType, lazy);
+          return new KenLMLoad<lm::ngram::QuantTrieModel>(file, factorType, lazy);
         case lm::ngram::ARRAY_TRIE:
-          return new LanguageModelKen<lm::ngram::ArrayTrieModel>(file, factorType, lazy);
+          return new KenLMLoad<lm::ngram::ArrayTrieModel>(file, factorType, lazy);
         case lm::ngram::QUANT_ARRAY_TRIE:
-          return new LanguageModelKen<lm::ngram::QuantArrayTrieModel>(file, factorType, lazy);
+          return new KenLMLoad<lm::ngram::QuantArrayTrieModel>(file, factorType, lazy);
         default:
           std::cerr << "Unrecognized kenlm model type " << model_type << std::endl;
           abort();
       }
     } else {
-      return new LanguageModelKen<lm::ngram::ProbingModel>(file, factorType, lazy);
+      return new KenLMLoad<lm::ngram::ProbingModel>(file, factorType, lazy);
     }
   } catch (std::exception &e) {
     std::cerr << e.what() << std::endl;
@@ -367,5 +402,11 @@ LanguageModel *ConstructKenLM(const std::string &file, FactorType factorType, bo
   }
 }
 
+LanguageModel *ConstructKenLM(const std::string &file, FactorType factorType, bool lazy) {
+  std::auto_ptr<LanguageModelLoad> load(PrepareKenLM(file, factorType, lazy));
+  if (!load->Load()) abort();
+  return load->Create();
+}
+
 }
 
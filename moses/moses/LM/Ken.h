@@ -29,10 +29,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses {
 
 class LanguageModel;
+class LanguageModelLoad;
 
 //! This will also load. Returns a templated KenLM class
 LanguageModel *ConstructKenLM(const std::string &file, FactorType factorType, bool lazy);
 
+//! Loading and creating as separate steps, see LanguageModelLoad
+LanguageModelLoad *PrepareKenLM(const std::string &file, FactorType factorType, bool lazy);
+
 } // namespace Moses
 
 #endif
@@ -15,7 +15,9 @@ LexicalReordering::LexicalReordering(std::vector<FactorType>& f_factors,
                                      const std::vector<float>& weights)
   : StatefulFeatureFunction("LexicalReordering_" + configuration.GetModelString(),
                             configuration.GetNumScoreComponents()),
-    m_configuration(configuration)
+    m_configuration(configuration),
+    m_filePath(filePath),
+    m_table(NULL)
 {
   m_configuration.SetScoreProducer(this);
   std::cerr << "Creating lexical reordering...\n";
@@ -60,8 +62,12 @@ LexicalReordering::LexicalReordering(std::vector<FactorType>& f_factors,
   }
 
   const_cast<StaticData&>(StaticData::Instance()).SetWeights(this, weights);
+}
 
-  m_table = LexicalReorderingTable::LoadAvailable(filePath, m_factorsF, m_factorsE, std::vector<FactorType>());
+bool LexicalReordering::Load()
+{
+  m_table = LexicalReorderingTable::LoadAvailable(m_filePath, m_factorsF, m_factorsE, std::vector<FactorType>());
+  return m_table != NULL;
 }
 
 LexicalReordering::~LexicalReordering()
@@ -32,6 +32,9 @@ public:
                       const std::string &filePath, 
                       const std::vector<float>& weights);
     virtual ~LexicalReordering();
+
+    //! reads the table; may run on a loader thread (see ModelLoader)
+    bool Load();
     
     virtual FFState* Evaluate(const Hypothesis& cur_hypo,
                               const FFState* prev_state,
@@ -65,6 +68,7 @@ private:
     LexicalReorderingConfiguration m_configuration;
     std::string m_modelTypeString;
     std::vector<std::string> m_modelType;
+    std::string m_filePath;
     LexicalReorderingTable* m_table;
     //std::vector<Direction> m_direction;
     std::vector<LexicalReorderingConfiguration::Condition> m_condition;
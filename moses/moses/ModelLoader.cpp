@@ -0,0 +1,164 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2009 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <exception>
+#include <iostream>
+
+#include "ModelLoader.h"
+#include "StaticData.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+ModelLoader::ModelLoader(size_t numThreads)
+  : m_numThreads(numThreads ? numThreads : 1)
+#ifdef WITH_THREADS
+  , m_next(0), m_stopping(false)
+#endif
+{
+#ifndef WITH_THREADS
+  m_numThreads = 1;
+#endif
+}
+
+ModelLoader::~ModelLoader()
+{
+#ifdef WITH_THREADS
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobAdded.notify_all();
+  m_threads.join_all();
+#endif
+}
+
+bool ModelLoader::Run(const string &name, const Job &job)
+{
+  IFVERBOSE(1)
+  PrintUserTime("Start loading " + name);
+  bool ok;
+  try {
+    ok = job();
+  } catch (const std::exception &e) {
+    cerr << "Loading " << name << " failed: " << e.what() << endl;
+    ok = false;
+  }
+  IFVERBOSE(1)
+  PrintUserTime("Finished loading " + name);
+  return ok;
+}
+
+ModelLoader::JobId ModelLoader::Add(const string &name, const Job &job)
+{
+  Entry entry;
+  entry.name = name;
+  entry.job = job;
+  entry.done = false;
+  entry.ok = false;
+
+#ifdef WITH_THREADS
+  if (m_numThreads > 1) {
+    JobId id;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      id = m_jobs.size();
+      m_jobs.push_back(entry);
+      // a thread per job, up to the limit
+      if (m_threads.size() < m_numThreads) {
+        m_threads.create_thread(boost::bind(&ModelLoader::Execute, this));
+      }
+    }
+    m_jobAdded.notify_one();
+    return id;
+  }
+#endif
+
+  entry.ok = Run(name, job);
+  entry.done = true;
+  m_jobs.push_back(entry);
+  return m_jobs.size() - 1;
+}
+
+#ifdef WITH_THREADS
+void ModelLoader::Execute()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (true) {
+    while (m_next == m_jobs.size() && !m_stopping) {
+      m_jobAdded.wait(lock);
+    }
+    if (m_stopping) return;
+
+    JobId id = m_next++;
+    string name = m_jobs[id].name;
+    Job job = m_jobs[id].job;
+
+    lock.unlock();
+    bool ok = Run(name, job);
+    lock.lock();
+
+    m_jobs[id].ok = ok;
+    m_jobs[id].done = true;
+    m_jobDone.notify_all();
+  }
+}
+#endif
+
+bool ModelLoader::Wait(const vector<JobId> &jobs)
+{
+  bool ok = true;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  for (size_t i = 0; i < jobs.size(); ++i) {
+#ifdef WITH_THREADS
+    while (!m_jobs[jobs[i]].done) {
+      m_jobDone.wait(lock);
+    }
+#endif
+    if (!m_jobs[jobs[i]].ok) {
+      cerr << "Could not load " << m_jobs[jobs[i]].name << endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool ModelLoader::WaitAll()
+{
+  vector<JobId> jobs;
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    for (JobId id = 0; id < m_jobs.size(); ++id) {
+      jobs.push_back(id);
+    }
+  }
+  return Wait(jobs);
+}
+
+}
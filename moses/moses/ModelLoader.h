@@ -0,0 +1,102 @@
+// $Id$
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2009 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#ifndef moses_ModelLoader_h
+#define moses_ModelLoader_h
+
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+namespace Moses
+{
+
+/** Reads model files on several threads while StaticData goes on with
+ *  the configuration.
+ *
+ *  Only the reading moves off the calling thread. Features are still
+ *  created there, in the order of the config, since creating a feature
+ *  registers its scores. So a job either fills in a feature that exists
+ *  already (reordering tables), or reads what a feature
+ *  is then made of (language models). Whatever needs a model waits for
+ *  its job first; that is how the dependencies between models (e.g. the
+ *  language models that phrase tables are pre-scored with) are kept.
+ *
+ *  Without thread support, or with a single thread, a job runs as soon
+ *  as it is added, which is the old serial load.
+ */
+class ModelLoader
+{
+public:
+  typedef size_t JobId;
+  //! returns false if the model could not be loaded
+  typedef boost::function<bool ()> Job;
+
+  explicit ModelLoader(size_t numThreads);
+
+  //! waits for the jobs that are running; the rest are dropped
+  ~ModelLoader();
+
+  JobId Add(const std::string &name, const Job &job);
+
+  //! false if any of them failed
+  bool Wait(const std::vector<JobId> &jobs);
+  bool WaitAll();
+
+  size_t GetNumThreads() const {
+    return m_numThreads;
+  }
+
+private:
+  struct Entry {
+    std::string name;
+    Job job;
+    bool done;
+    bool ok;
+  };
+
+  std::vector<Entry> m_jobs;
+  size_t m_numThreads;
+
+  static bool Run(const std::string &name, const Job &job);
+
+#ifdef WITH_THREADS
+  size_t m_next; // first job not started yet
+  bool m_stopping;
+  boost::thread_group m_threads;
+  boost::mutex m_mutex;
+  boost::condition_variable m_jobAdded;
+  boost::condition_variable m_jobDone;
+
+  void Execute();
+#endif
+};
+
+}
+
+#endif
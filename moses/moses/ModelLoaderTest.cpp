@@ -0,0 +1,74 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2013- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "ModelLoader.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(model_loader)
+
+namespace
+{
+
+bool Count(int *loaded, bool ok)
+{
+#ifdef WITH_THREADS
+  static boost::mutex mutex;
+  boost::mutex::scoped_lock lock(mutex);
+#endif
+  ++*loaded;
+  return ok;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(waits_for_jobs)
+{
+  for (size_t threads = 1; threads <= 4; threads *= 2) {
+    int loaded = 0;
+    ModelLoader loader(threads);
+    vector<ModelLoader::JobId> jobs;
+    for (size_t i = 0; i < 10; ++i) {
+      jobs.push_back(loader.Add("job", boost::bind(Count, &loaded, true)));
+    }
+    BOOST_CHECK(loader.Wait(jobs));
+    BOOST_CHECK_EQUAL(10, loaded);
+    BOOST_CHECK(loader.WaitAll());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(reports_failure)
+{
+  int loaded = 0;
+  ModelLoader loader(2);
+  vector<ModelLoader::JobId> good, bad;
+  good.push_back(loader.Add("good", boost::bind(Count, &loaded, true)));
+  bad.push_back(loader.Add("bad", boost::bind(Count, &loaded, false)));
+  BOOST_CHECK(loader.Wait(good));
+  BOOST_CHECK(!loader.Wait(bad));
+  BOOST_CHECK(!loader.WaitAll());
+  BOOST_CHECK_EQUAL(2, loaded);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
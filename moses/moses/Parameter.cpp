@@ -77,6 +77,7 @@ Parameter::Parameter()
   AddParam("stack", "s", "maximum stack size for histogram pruning");
   AddParam("stack-diversity", "sd", "minimum number of hypothesis of each coverage in stack (default 0)");
   AddParam("threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam("loader-threads", "number of threads reading model files at startup, or all (default: all cores; 1 reads them one after another)");
 	AddParam("translation-details", "T", "for each best hypothesis, report translation details to the given file");
 	AddParam("ttable-file", "location and properties of the translation tables");
 	AddParam("ttable-limit", "ttl", "maximum number of translation table entries per input phrase");
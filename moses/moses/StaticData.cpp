@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Timer.h"
 #include "LM/Factory.h"
 #include "LexicalReordering.h"
+#include "ModelLoader.h"
 #include "GlobalLexicalModel.h"
 #include "GlobalLexicalModelUnlimited.h"
 #include "SentenceStats.h"
@@ -556,8 +557,22 @@ bool StaticData::LoadData(Parameter *parameter)
 	}
 #endif
 	
-  if (!LoadLexicalReorderingModel()) return false;
-  if (!LoadLanguageModels()) return false;
+  // From here on, model files are read on the loader threads while the
+  // features are configured; everything is loaded by the end of LoadData
+  size_t loaderThreads = 1;
+#ifdef WITH_THREADS
+  loaderThreads = boost::thread::hardware_concurrency();
+#endif
+  if (m_parameter->GetParam("loader-threads").size() > 0
+      && m_parameter->GetParam("loader-threads")[0] != "all") {
+    loaderThreads = Scan<size_t>(m_parameter->GetParam("loader-threads")[0]);
+  }
+  ModelLoader loader(loaderThreads);
+  Timer loadTimer;
+  loadTimer.start();
+
+  if (!LoadLexicalReorderingModel(loader)) return false;
+  if (!LoadLanguageModels(loader)) return false;
   if (!LoadGenerationTables()) return false;
   if (!LoadPhraseTables()) return false;
   if (!LoadGlobalLexicalModel()) return false;
@@ -810,6 +825,10 @@ bool StaticData::LoadData(Parameter *parameter)
       m_outputFileName = m_parameter->GetParam("output-file")[0];
   }
 
+  if (!loader.WaitAll()) return false;
+  VERBOSE(1, "Loaded models in " << loadTimer.get_elapsed_time()
+          << " seconds with " << loader.GetNumThreads() << " loader threads" << endl);
+
   return true;
 }
 
@@ -941,7 +960,7 @@ StaticData::~StaticData()
   }
 #endif
 
-bool StaticData::LoadLexicalReorderingModel()
+bool StaticData::LoadLexicalReorderingModel(ModelLoader &loader)
 {
   VERBOSE(1, "Loading lexical distortion models...");
   const vector<string> fileStr    = m_parameter->GetParam("distortion-file");
@@ -1009,6 +1028,7 @@ bool StaticData::LoadLexicalReorderingModel()
     string filePath = spec[3];
 
     m_reorderModels.push_back(new LexicalReordering(input, output, LexicalReorderingConfiguration(modelType), filePath, mweights));
+    loader.Add("lexical reordering table " + filePath, boost::bind(&LexicalReordering::Load, m_reorderModels.back()));
   }
   return true;
 }
@@ -1108,7 +1128,7 @@ bool StaticData::LoadGlobalLexicalModelUnlimited()
   return true;
 }
 
-bool StaticData::LoadLanguageModels()
+bool StaticData::LoadLanguageModels(ModelLoader &loader)
 {
   if (m_parameter->GetParam("lmodel-file").size() > 0) {
     // weights
@@ -1124,49 +1144,85 @@ bool StaticData::LoadLanguageModels()
     // initialize n-gram order for each factor. populated only by factored lm
     const vector<string> &lmVector = m_parameter->GetParam("lmodel-file");
     //prevent language models from being loaded twice
-    map<string,LanguageModel*> languageModelsLoaded;
+    map<string,LanguageModelLoad*> languageModelsToLoad;
+    vector<LanguageModelLoad*> loads(lmVector.size(), NULL);
 
+    // First what to load, so that nothing is loading when the config is wrong
     for(size_t i=0; i<lmVector.size(); i++) {
-      LanguageModel* lm = NULL;
-      if (languageModelsLoaded.find(lmVector[i]) != languageModelsLoaded.end()) {
-        lm = languageModelsLoaded[lmVector[i]]->Duplicate(); 
-      } else {
-        vector<string>	token		= Tokenize(lmVector[i]);
-        if (token.size() != 4 && token.size() != 5 ) {
+      if (languageModelsToLoad.find(lmVector[i]) != languageModelsToLoad.end()) {
+        continue;
+      }
+      vector<string>	token		= Tokenize(lmVector[i]);
+      if (token.size() != 4 && token.size() != 5 ) {
+        UserMessage::Add("Expected format 'LM-TYPE FACTOR-TYPE NGRAM-ORDER filePath [mapFilePath (only for IRSTLM)]'");
+        RemoveAllInColl(loads);
+        return false;
+      }
+      // type = implementation, SRI, IRST etc
+      LMImplementation lmImplementation = static_cast<LMImplementation>(Scan<int>(token[0]));
+
+      // factorType = 0 = Surface, 1 = POS, 2 = Stem, 3 = Morphology, etc
+      vector<FactorType> 	factorTypes		= Tokenize<FactorType>(token[1], ",");
+
+      // nGramOrder = 2 = bigram, 3 = trigram, etc
+      size_t nGramOrder = Scan<int>(token[2]);
+
+      string &languageModelFile = token[3];
+      if (token.size() == 5) {
+        if (lmImplementation==IRST)
+          languageModelFile += " " + token[4];
+        else {
           UserMessage::Add("Expected format 'LM-TYPE FACTOR-TYPE NGRAM-ORDER filePath [mapFilePath (only for IRSTLM)]'");
+          RemoveAllInColl(loads);
           return false;
         }
-        // type = implementation, SRI, IRST etc
-        LMImplementation lmImplementation = static_cast<LMImplementation>(Scan<int>(token[0]));
-
-        // factorType = 0 = Surface, 1 = POS, 2 = Stem, 3 = Morphology, etc
-        vector<FactorType> 	factorTypes		= Tokenize<FactorType>(token[1], ",");
+      }
 
-        // nGramOrder = 2 = bigram, 3 = trigram, etc
-        size_t nGramOrder = Scan<int>(token[2]);
+      loads[i] = LanguageModelFactory::PrepareLanguageModel(
+                   lmImplementation
+                   , factorTypes
+                   , nGramOrder
+                   , languageModelFile
+                   , LMdub[i]);
+      if (loads[i] == NULL) {
+        UserMessage::Add("no LM created. We probably don't have it compiled");
+        RemoveAllInColl(loads);
+        return false;
+      }
+      languageModelsToLoad[lmVector[i]] = loads[i];
+    }
 
-        string &languageModelFile = token[3];
-        if (token.size() == 5) {
-          if (lmImplementation==IRST)
-            languageModelFile += " " + token[4];
-          else {
-            UserMessage::Add("Expected format 'LM-TYPE FACTOR-TYPE NGRAM-ORDER filePath [mapFilePath (only for IRSTLM)]'");
-            return false;
-          }
-        }
+    // Then load them, on the loader threads where the LM allows
+    vector<ModelLoader::JobId> jobs;
+    bool ok = true;
+    for(size_t i=0; i<loads.size(); i++) {
+      if (loads[i] && loads[i]->Concurrent()) {
+        jobs.push_back(loader.Add("LanguageModel " + lmVector[i], boost::bind(&LanguageModelLoad::Load, loads[i])));
+      }
+    }
+    for(size_t i=0; i<loads.size() && ok; i++) {
+      if (loads[i] && !loads[i]->Concurrent()) {
         IFVERBOSE(1)
-        PrintUserTime(string("Start loading LanguageModel ") + languageModelFile);
-
-        lm = LanguageModelFactory::CreateLanguageModel(
-               lmImplementation
-               , factorTypes
-               , nGramOrder
-               , languageModelFile
-               , LMdub[i]);
-        if (lm == NULL) {
-          UserMessage::Add("no LM created. We probably don't have it compiled");
-          return false;
-        }
+        PrintUserTime(string("Start loading LanguageModel ") + lmVector[i]);
+        ok = loads[i]->Load();
+      }
+    }
+    ok = loader.Wait(jobs) && ok;
+    if (!ok) {
+      UserMessage::Add("no LM created. Could not load the language model");
+      RemoveAllInColl(loads);
+      return false;
+    }
+
+    // and make the features, in config order
+    map<string,LanguageModel*> languageModelsLoaded;
+
+    for(size_t i=0; i<lmVector.size(); i++) {
+      LanguageModel* lm = NULL;
+      if (languageModelsLoaded.find(lmVector[i]) != languageModelsLoaded.end()) {
+        lm = languageModelsLoaded[lmVector[i]]->Duplicate(); 
+      } else {
+        lm = loads[i]->Create();
         languageModelsLoaded[lmVector[i]] = lm;
       }
 
@@ -1180,6 +1236,7 @@ bool StaticData::LoadLanguageModels()
         SetWeight(lm,weightAll[i]);
       }
     }
+    RemoveAllInColl(loads);
   }
   // flag indicating that language models were loaded,
   // since phrase table loading requires their presence
@@ -1223,6 +1280,9 @@ bool StaticData::LoadGenerationTables()
 
       m_generationDictionary.push_back(new GenerationDictionary(numFeatures, input,output));
       CHECK(m_generationDictionary.back() && "could not create GenerationDictionary");
+      // Loaded here, not on a loader thread: loading makes score
+      // collections, which must not race with the score producers
+      // registered while the other features are created
       if (!m_generationDictionary.back()->Load(filePath, Output)) {
         delete m_generationDictionary.back();
         return false;
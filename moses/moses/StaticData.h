@@ -52,6 +52,7 @@ namespace Moses
 
 class InputType;
 class LexicalReordering;
+class ModelLoader;
 class GlobalLexicalModel;
 class GlobalLexicalModelUnlimited;
 class PhraseBoundaryFeature;
@@ -256,7 +257,7 @@ protected:
   //! helper fn to set bool param from ini file/command line
   void SetBooleanParameter(bool *paramter, std::string parameterName, bool defaultValue);
   //! load all language models as specified in ini file
-  bool LoadLanguageModels();
+  bool LoadLanguageModels(ModelLoader &loader);
 #ifdef HAVE_SYNLM
   //! load syntactic language model
 	bool LoadSyntacticLanguageModel();
@@ -267,7 +268,7 @@ protected:
   bool LoadGenerationTables();
   //! load decoding steps
   bool LoadDecodeGraphs();
-  bool LoadLexicalReorderingModel();
+  bool LoadLexicalReorderingModel(ModelLoader &loader);
   bool LoadGlobalLexicalModel();
   bool LoadGlobalLexicalModelUnlimited();
   //References used for scoring feature (eg BleuScoreFeature) for online training
@@ -33,9 +33,15 @@ const size_t MAX_MSG_QUEUE = 5;
 bool UserMessage::m_toStderr	= true;
 bool UserMessage::m_toQueue		= false;
 queue<string> UserMessage::m_msgQueue;
+#ifdef WITH_THREADS
+boost::mutex UserMessage::m_mutex;
+#endif
 
 void UserMessage::Add(const string &msg)
 {
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
   if (m_toStderr) {
     cerr << "ERROR:" << msg << endl;
   }
@@ -48,6 +54,9 @@ void UserMessage::Add(const string &msg)
 
 string UserMessage::GetQueue()
 {
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
   stringstream strme("");
   while (!m_msgQueue.empty()) {
     strme << m_msgQueue.front() << endl;
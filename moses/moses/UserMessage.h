@@ -25,6 +25,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 #include <queue>
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace Moses
 {
 
@@ -36,6 +40,10 @@ class UserMessage
 protected:
   static bool m_toStderr, m_toQueue;
   static std::queue<std::string> m_msgQueue;
+#ifdef WITH_THREADS
+  //! messages may come from the model loader threads
+  static boost::mutex m_mutex;
+#endif
 
 public:
   //! whether messages to go to stderr, a queue to later display, or both
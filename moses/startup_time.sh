@@ -0,0 +1,24 @@
+#!/bin/bash
+# Time to load the models of moses.ini, reading them one after another
+# and on all cores. Serves a single request, so the total time is close
+# to the time to the first request.
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+source ${DIR}/../configs.sh
+
+BIN=./bin/moses_integrated
+
+cp moses.ini.template moses.ini
+sed -i -e "s#@DATA_ROOT#$DATA_ROOT#g" moses.ini
+
+for LOADERS in 1 all; do
+    sync && echo 3 > /proc/sys/vm/drop_caches 2>/dev/null
+    START=$(date +%s.%N)
+    TBENCH_QPS=1 TBENCH_MAXREQS=1 TBENCH_WARMUPREQS=0 \
+        TBENCH_MINSLEEPNS=10000 ${BIN} -config ./moses.ini \
+        -input-file ${DATA_ROOT}/moses/testTerms \
+        -threads 1 -num-tasks 1 -verbose 1 -loader-threads ${LOADERS} \
+        2>&1 | grep "Loaded models"
+    END=$(date +%s.%N)
+    echo "loader-threads ${LOADERS}: $(echo "${END} - ${START}" | bc) seconds in all"
+done
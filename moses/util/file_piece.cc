@@ -18,9 +18,14 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace util {
 
 ParseNumberException::ParseNumberException(StringPiece value) throw() {
@@ -66,12 +71,12 @@ FilePiece::~FilePiece() {}
 StringPiece FilePiece::ReadLine(char delim) {
   std::size_t skip = 0;
   while (true) {
-    for (const char *i = position_ + skip; i < position_end_; ++i) {
-      if (*i == delim) {
-        StringPiece ret(position_, i - position_);
-        position_ = i + 1;
-        return ret;
-      }
+    // memchr is vectorized in any libc worth using.
+    const char *i = static_cast<const char*>(memchr(position_ + skip, delim, position_end_ - position_ - skip));
+    if (i) {
+      StringPiece ret(position_, i - position_);
+      position_ = i + 1;
+      return ret;
     }
     if (at_end_) {
       if (position_ == position_end_) Shift();
@@ -137,12 +142,80 @@ static const double_conversion::StringToDoubleConverter kConverter(
     "inf",
     "NaN");
 
+/* The numbers in ARPA files and phrase tables are short decimals like
+ * -2.345678.  If the digits fit exactly in a double and so does the power of
+ * ten, one multiplication or division rounds correctly (Clinger's fast path).
+ * Anything else (more digits, big exponents, inf, nan, a leading +) is left
+ * to double-conversion.  Returns false in that case.
+ *
+ * For float, the digits and the power of ten have to fit in a float too, so
+ * that rounding the double result again to float is still exact.
+ */
+#ifdef DOUBLE_CONVERSION_CORRECT_DOUBLE_OPERATIONS
+const double kPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool FastParse(const char *begin, const char *&end, uint64_t max_digits, int max_power, double &out) {
+  const char *i = begin;
+  bool negative = (i != end && *i == '-');
+  if (negative) ++i;
+  uint64_t digits = 0;
+  int power = 0;
+  const char *start = i;
+  for (; i != end && *i >= '0' && *i <= '9'; ++i) {
+    if (digits > (max_digits - 9) / 10) return false;
+    digits = digits * 10 + (*i - '0');
+  }
+  if (i == start) return false;
+  if (i != end && *i == '.') {
+    ++i;
+    start = i;
+    for (; i != end && *i >= '0' && *i <= '9'; ++i) {
+      if (digits > (max_digits - 9) / 10) return false;
+      digits = digits * 10 + (*i - '0');
+      --power;
+    }
+    if (i == start) return false;
+  }
+  if (i != end && (*i == 'e' || *i == 'E')) {
+    ++i;
+    bool negative_exponent = (i != end && *i == '-');
+    if (i != end && (*i == '-' || *i == '+')) ++i;
+    start = i;
+    int exponent = 0;
+    for (; i != end && *i >= '0' && *i <= '9' && exponent < 1000; ++i) {
+      exponent = exponent * 10 + (*i - '0');
+    }
+    if (i == start || (i != end && *i >= '0' && *i <= '9')) return false;
+    power += negative_exponent ? -exponent : exponent;
+  }
+  if (power > max_power || power < -max_power) return false;
+  double value = static_cast<double>(digits);
+  value = (power < 0) ? value / kPowersOfTen[-power] : value * kPowersOfTen[power];
+  out = negative ? -value : value;
+  end = i;
+  return true;
+}
+#else
+bool FastParse(const char *, const char *&, uint64_t, int, double &) {
+  return false;
+}
+#endif // DOUBLE_CONVERSION_CORRECT_DOUBLE_OPERATIONS
+
 void ParseNumber(const char *begin, const char *&end, float &out) {
+  double fast;
+  if (FastParse(begin, end, static_cast<uint64_t>(1) << 24, 10, fast)) {
+    out = static_cast<float>(fast);
+    return;
+  }
   int count;
   out = kConverter.StringToFloat(begin, end - begin, &count);
   end = begin + count;
 }
 void ParseNumber(const char *begin, const char *&end, double &out) {
+  if (FastParse(begin, end, static_cast<uint64_t>(1) << 53, 22, out)) return;
   int count;
   out = kConverter.StringToDouble(begin, end - begin, &count);
   end = begin + count;
@@ -183,9 +256,38 @@ template <class T> T FilePiece::ReadNumber() {
   return ret;
 }
 
+namespace {
+#ifdef __SSE2__
+// The first of kSpaces in [begin, end), 16 bytes at a time.
+const char *FindSpace(const char *begin, const char *end) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i span = _mm_set1_epi8('\r' - '\t');
+  for (; begin + 16 <= end; begin += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    // '\t' through '\r' are those for which byte - '\t' <= '\r' - '\t' unsigned.
+    __m128i shifted = _mm_sub_epi8(bytes, tab);
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, span), shifted);
+    int mask = _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(bytes, space)));
+    if (mask) return begin + __builtin_ctz(mask);
+  }
+  for (; begin < end; ++begin) {
+    if (kSpaces[static_cast<unsigned char>(*begin)]) return begin;
+  }
+  return end;
+}
+#endif // __SSE2__
+} // namespace
+
 const char *FilePiece::FindDelimiterOrEOF(const bool *delim)  {
   std::size_t skip = 0;
   while (true) {
+#ifdef __SSE2__
+    if (delim == kSpaces) {
+      const char *i = FindSpace(position_ + skip, position_end_);
+      if (i != position_end_) return i;
+    } else
+#endif
     for (const char *i = position_ + skip; i < position_end_; ++i) {
       if (delim[static_cast<unsigned char>(*i)]) return i;
     }
@@ -8,8 +8,10 @@
 #include <boost/test/unit_test.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -82,6 +84,46 @@ BOOST_AUTO_TEST_CASE(StreamReadLine) {
 }
 #endif
 
+/* numbers, with and without the fast path, against strtod */
+BOOST_AUTO_TEST_CASE(ReadNumbers) {
+  const char *kNumbers[] = {
+    "0", "-0", "1", "-2.345678", "0.000001234", "99.5", "-99.99999",
+    "16777217", "0.1", "3.4028234e38", "1e-45", "2.5e+10", "-7E-3",
+    "123456789012345678901234567890", "1.7976931348623157e308", "4.9e-324",
+    "0.30000000000000004", "-1.0000000000000002", "1e22", "1e23", "9007199254740993"
+  };
+  const std::size_t kCount = sizeof(kNumbers) / sizeof(const char*);
+  char name[] = "tempXXXXXX";
+  scoped_fd file(mkstemp(name));
+  BOOST_REQUIRE(file.get() > 0);
+  std::string text;
+  for (std::size_t i = 0; i < kCount; ++i) {
+    text += kNumbers[i];
+    text += (i % 3) ? "\t" : "\n";
+  }
+  text += "12 -34 inf -inf 1.5abc";
+  WriteOrThrow(file.get(), text.data(), text.size());
+  file.reset();
+
+  for (int as_float = 0; as_float < 2; ++as_float) {
+    FilePiece test(name);
+    for (std::size_t i = 0; i < kCount; ++i) {
+      if (as_float) {
+        BOOST_CHECK_EQUAL(strtof(kNumbers[i], NULL), test.ReadFloat());
+      } else {
+        BOOST_CHECK_EQUAL(strtod(kNumbers[i], NULL), test.ReadDouble());
+      }
+    }
+    BOOST_CHECK_EQUAL(12, test.ReadLong());
+    BOOST_CHECK_EQUAL(-34, test.ReadLong());
+    BOOST_CHECK_EQUAL(std::numeric_limits<float>::infinity(), test.ReadFloat());
+    BOOST_CHECK_EQUAL(-std::numeric_limits<float>::infinity(), test.ReadFloat());
+    BOOST_CHECK_EQUAL(1.5, test.ReadDouble());
+    BOOST_CHECK_EQUAL("abc", test.ReadDelimited());
+  }
+  unlink(name);
+}
+
 #ifdef HAVE_ZLIB
 
 // gzip file
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <string>
 
 #include <assert.h>
 #include <limits.h>
@@ -24,6 +25,13 @@
 #include <lzma.h>
 #endif
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
 namespace util {
 
 CompressedException::CompressedException() throw() {}
@@ -366,6 +374,141 @@ class XZip : public ReadBase {
 };
 #endif // HAVE_XZLIB
 
+#ifdef WITH_THREADS
+/* Runs a decompressor on a thread of its own, up to kBlocks blocks ahead of
+ * the reader, so that decompression overlaps with parsing.  Errors are
+ * thrown to the reader when it gets to them, as CompressedException.
+ */
+class Pipelined : public ReadBase {
+  private:
+    static const std::size_t kBlockSize = 1 << 20;
+    static const std::size_t kBlocks = 4;
+
+    struct Block {
+      scoped_malloc data;
+      std::size_t size;
+      // RawAmount after decompressing this block.
+      uint64_t raw;
+    };
+
+  public:
+    Pipelined(ReadBase *decompress, uint64_t raw_amount)
+      : produced_(0), consumed_(0), done_(false), stop_(false), current_(NULL), offset_(0) {
+      ReplaceThis(decompress, inner_);
+      ReadCount(inner_) = raw_amount;
+      for (std::size_t i = 0; i < kBlocks; ++i) {
+        blocks_[i].data.reset(malloc(kBlockSize));
+        if (!blocks_[i].data.get()) throw std::bad_alloc();
+      }
+      thread_ = boost::thread(boost::bind(&Pipelined::Decompress, this));
+    }
+
+    ~Pipelined() {
+      {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      changed_.notify_all();
+      thread_.join();
+    }
+
+    std::size_t Read(void *to, std::size_t amount, ReadCompressed &thunk) {
+      if (amount == 0) return 0;
+      if (!current_) {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while (consumed_ == produced_ && !done_) changed_.wait(lock);
+        if (consumed_ == produced_) {
+          UTIL_THROW_IF(!error_.empty(), CompressedException, error_);
+          return 0;
+        }
+        current_ = &blocks_[consumed_ % kBlocks];
+        offset_ = 0;
+      }
+      std::size_t sending = std::min<std::size_t>(amount, current_->size - offset_);
+      memcpy(to, static_cast<const uint8_t*>(current_->data.get()) + offset_, sending);
+      offset_ += sending;
+      ReadCount(thunk) = current_->raw;
+      if (offset_ == current_->size) {
+        current_ = NULL;
+        {
+          boost::unique_lock<boost::mutex> lock(mutex_);
+          ++consumed_;
+        }
+        changed_.notify_all();
+      }
+      return sending;
+    }
+
+  private:
+    void Decompress() {
+      try {
+        while (true) {
+          Block *block;
+          {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            while (produced_ - consumed_ == kBlocks && !stop_) changed_.wait(lock);
+            if (stop_) return;
+            block = &blocks_[produced_ % kBlocks];
+          }
+          // Fill the block, so the reader doesn't take the lock for a few bytes.
+          uint8_t *to = static_cast<uint8_t*>(block->data.get());
+          std::size_t got = 0, ret;
+          do {
+            ret = inner_.Read(to + got, kBlockSize - got);
+            got += ret;
+          } while (ret && got < kBlockSize);
+          block->size = got;
+          block->raw = inner_.RawAmount();
+          {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            if (got) {
+              ++produced_;
+            } else {
+              done_ = true;
+            }
+          }
+          changed_.notify_all();
+          if (!got) return;
+        }
+      } catch (const std::exception &e) {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        error_ = e.what();
+        if (error_.empty()) error_ = "Decompression failed";
+        done_ = true;
+        lock.unlock();
+        changed_.notify_all();
+      }
+    }
+
+    ReadCompressed inner_;
+
+    Block blocks_[kBlocks];
+
+    boost::mutex mutex_;
+    boost::condition_variable changed_;
+
+    // Guarded by mutex_.
+    uint64_t produced_, consumed_;
+    bool done_, stop_;
+    std::string error_;
+
+    // Only touched by the reader.
+    Block *current_;
+    std::size_t offset_;
+
+    boost::thread thread_;
+};
+#endif // WITH_THREADS
+
+// Decompression moves to a thread of its own if there are threads.
+ReadBase *Background(ReadBase *decompress, uint64_t raw_amount) {
+#ifdef WITH_THREADS
+  return new Pipelined(decompress, raw_amount);
+#else
+  return decompress;
+#endif
+}
+
 class IStreamReader : public ReadBase {
   public:
     explicit IStreamReader(std::istream &stream) : stream_(stream) {}
@@ -413,19 +556,19 @@ ReadBase *ReadFactory(int fd, uint64_t &raw_amount) {
   switch (DetectMagic(header)) {
     case GZIP:
 #ifdef HAVE_ZLIB
-      return new GZip(hold.release(), header, ReadCompressed::kMagicSize);
+      return Background(new GZip(hold.release(), header, ReadCompressed::kMagicSize), raw_amount);
 #else
       UTIL_THROW(CompressedException, "This looks like a gzip file but gzip support was not compiled in.");
 #endif
     case BZIP:
 #ifdef HAVE_BZLIB
-      return new BZip(hold.release(), header, ReadCompressed::kMagicSize);
+      return Background(new BZip(hold.release(), header, ReadCompressed::kMagicSize), raw_amount);
 #else
       UTIL_THROW(CompressedException, "This looks like a bzip file (it begins with BZ), but bzip support was not compiled in.");
 #endif
     case XZIP:
 #ifdef HAVE_XZLIB
-      return new XZip(hold.release(), header, ReadCompressed::kMagicSize);
+      return Background(new XZip(hold.release(), header, ReadCompressed::kMagicSize), raw_amount);
 #else
       UTIL_THROW(CompressedException, "This looks like an xz file, but xz support was not compiled in.");
 #endif
@@ -10,6 +10,11 @@ MAXREQS=2000
 
 DUMMYREQS=1000000 # set this really high so MAXREQS controls execution
 
+# Pages to warm up the buffer pool with, saved by the previous run. Off
+# unless set by the caller, e.g.
+#   BPOOL_IMAGE=${DATA_ROOT}/shore/db-tpcc-1.bpimage ./run.sh
+BPOOL_IMAGE=${BPOOL_IMAGE:-}
+
 # Point this to an appropriate location on your system
 SCRATCH_DIR=/doesnotexist
 
@@ -21,9 +26,11 @@ ln -s $TMP scratch
 mkdir scratch/log && ln -s scratch/log log
 mkdir scratch/diskrw && ln -s scratch/diskrw diskrw
 
-cp ${DATA_ROOT}/shore/db-tpcc-1 scratch/ && \
+# The database is restored copy-on-write from the clean image in DATA_ROOT
+# (reflink, or an overlay on top of the image), instead of copied whole
+shore-kits/scripts/db-snapshot.sh restore ${DATA_ROOT}/shore/db-tpcc-1 \
+    scratch/db-tpcc-1 && \
     ln -s scratch/db-tpcc-1 db-tpcc-1
-chmod 644 scratch/db-tpcc-1
 
 cp shore-kits/run-templates/cmdfile.template cmdfile
 sed -i -e "s#@NTHREADS#$THREADS#g" cmdfile
@@ -33,11 +40,16 @@ cp shore-kits/run-templates/shore.conf.template \
     shore.conf
 sed -i -e "s#@NTHREADS#$THREADS#g" shore.conf
 
+if [ -n "${BPOOL_IMAGE}" ]; then
+    echo "db-bpool-image = ${BPOOL_IMAGE}" >> shore.conf
+fi
+
 # Run app
 TBENCH_QPS=${QPS} TBENCH_MAXREQS=${MAXREQS} TBENCH_WARMUPREQS=${WARMUPREQS} \
     TBENCH_MINSLEEPNS=10000 chrt -r 99 ${BIN} -i cmdfile
 
 # Cleanup
+rm -rf ${TMP}
 rm -f log scratch cmdfile db-tpcc-1 diskrw shore.conf info
 
 ../utilities/parselats.py ./lats.bin
@@ -145,7 +145,7 @@ public:
 
     // stats
     virtual void statistics(worker_stats_t& gather)=0;
-    virtual void stlsize(uint& gather)=0;
+    virtual void stlsize(uint& entries, uint& slots)=0;
 
     // dumps information
     virtual void dump();
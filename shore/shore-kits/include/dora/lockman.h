@@ -58,12 +58,15 @@ typedef BaseActionPtrList::iterator     BaseActionPtrIt;
  * @brief: Lock manager for the locks of a partition
  *
  * @note:  The lock manager consists of a
- *         - A map for the status of logical locks (llst_map_t)
- *         - A bi-map for associating trxs with Keys
+ *         - A table for the status of logical locks (KeyLockHash, or
+ *           the KeyLockMap if HASH_LLMAP is undefined)
+ *         - The list of the keys of each action, for the release
  *
  *
  ********************************************************************/
 
+#define HASH_LLMAP
+
 
 template<class DataType>
 struct lock_man_t
@@ -74,10 +77,11 @@ public:
 
     typedef key_wrapper_t<DataType>  Key;
 
+#ifdef HASH_LLMAP
+    typedef KeyLockHash<DataType>    KeyLLMap;
+#else
     typedef KeyLockMap<DataType>     KeyLLMap;
-    typedef std::pair<Key,LogicalLock>        KeyLLPair;
-
-    typedef std::_Rb_tree_node<KeyLLPair>     KeyLLMapNode;
+#endif
 
     typedef KALReq_t<DataType>      KALReq;
     //typedef typename PooledVec<KALReq>::Type KALReqVec;
@@ -104,36 +108,33 @@ public:
     // @return: (true) on success
     inline bool acquire_all(KALReqVec& akalrvec) 
     {
-        bool bResult = true;
-        int i=0;
-        for (KALReqIt it=akalrvec.begin(); it!=akalrvec.end(); ++it) {
-            // request to acquire all the locks for this partition
-            ++i;
-            if (!_key_ll_m->acquire(*it)) {
-
-                // !!! WARNING WARNING WARNING !!!
-                //
-                // It works correctly only when it wants to acquire a single Lock.
-                // Not correct when it wants to acquire a list of Locks.
-                //
-                //
-                // It should ignore that it failed to acquire one, keep on
-                // trying to acquire the rest of the list, and then come back on
-                // the not acquired one. Also, the resume algorithm needs to
-                // be modified. That is, when an action is promoted, because a
-                // lock it was waiting for got released, it should make sure that
-                // all the keys are now acquired.
-                //
-                // !!! WARNING WARNING WARNING !!!
-
-                // if a key cannot be acquired, return false
-                TRACE( TRACE_TRX_FLOW, "Cannot acquire for (%d)\n", 
-                       ((*it).tid()->get_lo()));
-                bResult = false;
-            }
+        // makes sure that the action tries to acquire at least one key
+        assert (!akalrvec.empty());
+
+        // request to acquire all the locks for this partition at once
+        if (!_key_ll_m->acquire_all(akalrvec)) {
+
+            // !!! WARNING WARNING WARNING !!!
+            //
+            // It works correctly only when it wants to acquire a single Lock.
+            // Not correct when it wants to acquire a list of Locks.
+            //
+            //
+            // It should ignore that it failed to acquire one, keep on
+            // trying to acquire the rest of the list, and then come back on
+            // the not acquired one. Also, the resume algorithm needs to
+            // be modified. That is, when an action is promoted, because a
+            // lock it was waiting for got released, it should make sure that
+            // all the keys are now acquired.
+            //
+            // !!! WARNING WARNING WARNING !!!
+
+            // if a key cannot be acquired, return false
+            TRACE( TRACE_TRX_FLOW, "Cannot acquire for (%d)\n", 
+                   (akalrvec.front().tid()->get_lo()));
+            return (false);
         }
-        assert(i); // makes sure that the action tries to acquire at least one key
-        return (bResult);
+        return (true);
     }
 
 
@@ -149,10 +150,7 @@ public:
         TRACE( TRACE_TRX_FLOW, "Releasing (%d)\n", paction->tid().get_lo());
 
         // 1. Release and drop all the keys of this trx
-        for (KALReqIt it=paction->requests()->begin(); it!=paction->requests()->end(); ++it) {
-            Key* pkey = (*it).key();
-            _key_ll_m->release(*pkey,paction,promotedList);
-        }
+        _key_ll_m->release_all(*paction->requests(),paction,promotedList);
 
         // 2. Iterate over all the promoted actions
         BaseActionPtr ap = NULL;
@@ -175,6 +173,7 @@ public:
     //// Debugging ////
 
     uint keystouched() const { return (_key_ll_m->keystouched()); }
+    uint slots() const { return (_key_ll_m->slots()); }
 
     void reset() { _key_ll_m->reset(); }
     void dump() { _key_ll_m->dump(); }
@@ -196,13 +196,20 @@ struct LogicalLock
     typedef ActionLockReqList::iterator         ActionLockReqListIt;
     typedef ActionLockReqList::const_iterator   ActionLockReqListCit;
 
-//     LogicalLock() 
-//         : _dlm(DL_CC_NOLOCK)
-//     { }
+    LogicalLock() 
+        : _dlm(DL_CC_NOLOCK)
+    { }
 
     LogicalLock(ActionLockReq& anowner);
     ~LogicalLock() { }
 
+    // exchanges the state of two locks, without copying owners or waiters
+    void swap(LogicalLock& rhs) {
+        std::swap(_dlm,rhs._dlm);
+        _owners.swap(rhs._owners);
+        _waiters.swap(rhs._waiters);
+    }
+
 
     eDoraLockMode       dlm() const { return (_dlm); }
     ActionLockReqVec&   owners()  { return (_owners); }
@@ -280,6 +287,8 @@ public:
     typedef std::vector<Key>   KeyList;
 
     typedef KALReq_t<DataType>              KALReq;
+    typedef std::vector<KALReq>             KALReqVec;
+    typedef typename KALReqVec::iterator    KALReqIt;
 
 #ifdef BLOCK_ALLOC_LLMAP
     typedef typename map__block_alloc<Key,LogicalLock>::Type LLMap;
@@ -389,6 +398,26 @@ public:
         return (rhs);
     }
 
+    // acquire the keys of an action, return true if all were acquired
+    inline bool acquire_all(KALReqVec& akalrvec) 
+    {
+        bool bResult = true;
+        for (KALReqIt it=akalrvec.begin(); it!=akalrvec.end(); ++it) {
+            if (!acquire(*it)) bResult = false;
+        }
+        return (bResult);
+    }
+
+    // release the keys of an action
+    inline void release_all(KALReqVec& akalrvec,
+                            BaseActionPtr paction,
+                            BaseActionPtrList& promotedList) 
+    {
+        for (KALReqIt it=akalrvec.begin(); it!=akalrvec.end(); ++it) {
+            release(*(*it).key(),paction,promotedList);
+        }
+    }
+
 
     //// Debugging ////
 
@@ -409,6 +438,9 @@ public:
     // return the number of keys
     uint keystouched() const { return (_ll_map->size()); }
 
+    // return the number of entries allocated
+    uint slots() const { return (_ll_map->size()); }
+
     // returns (true) if all locks are clean
     bool is_clean(vector<xct_t*>& toabort) {
         // clear all entries
@@ -439,6 +471,327 @@ public:
 
 }; // EOF: struct KeyLockMap
 
+
+
+/******************************************************************** 
+ *
+ * @struct: KeyLockHash
+ *
+ * @brief:  Template-based class for maintaining the logical locks of
+ *          the keys of a partition in an open-addressing hash table.
+ *
+ *          (Acquire) Returns false if locked in incompatible mode.
+ *
+ * @note:   Same interface as KeyLockMap. Linear probing, with the 
+ *          fields of the key and its LogicalLock stored in the slot, so
+ *          that locking a key already in the table allocates nothing.
+ *
+ * @note:   Released entries stay in the table, since the same keys are
+ *          usually locked again soon. Every time the table has seen as
+ *          many acquires as it has slots (an epoch), the entries that
+ *          have not been acquired for a whole epoch and are clean are
+ *          reclaimed. The table only grows if it is more than 3/4 full
+ *          after that, hence it follows the keys in use instead of all
+ *          the keys ever touched.
+ *
+ * @note:   Only the worker of the partition touches it.
+ *
+ ********************************************************************/
+
+static const uint MIN_LL_HASH_SLOTS = 64;
+
+template<class DataType>
+struct KeyLockHash
+{
+public:
+
+    typedef key_wrapper_t<DataType>         Key;
+    typedef KALReq_t<DataType>              KALReq;
+    typedef std::vector<KALReq>             KALReqVec;
+    typedef typename KALReqVec::iterator    KALReqIt;
+
+    struct LLSlot
+    {
+        DataType    _key[MAX_KEY_SIZE];
+        uint        _keysz;     // 0: free
+        uint        _hash;
+        uint        _epoch;     // epoch of the last acquire
+        LogicalLock _ll;
+
+        LLSlot() : _keysz(0), _hash(0), _epoch(0) { }
+
+        bool matches(const Key& akey, const uint ahash) const {
+            if ((_hash!=ahash) || (_keysz!=akey._key_v.size())) return (false);
+            for (uint i=0; i<_keysz; ++i) {
+                if (!(_key[i]==akey._key_v[i])) return (false);
+            }
+            return (true);
+        }
+
+        void swap(LLSlot& rhs) {
+            for (uint i=0; i<MAX_KEY_SIZE; ++i) std::swap(_key[i],rhs._key[i]);
+            std::swap(_keysz,rhs._keysz);
+            std::swap(_hash,rhs._hash);
+            std::swap(_epoch,rhs._epoch);
+            _ll.swap(rhs._ll);
+        }
+    };
+
+protected:
+
+    // data
+    LLSlot*  _slots;
+    uint     _mask;         // number of slots - 1
+    uint     _used;
+    uint     _min_slots;
+
+    uint     _epoch;
+    uint     _epoch_acquires;
+
+    // hashes of the keys of the current batch, reused
+    std::vector<uint> _batch_hash;
+
+public:
+
+    KeyLockHash(const int keyEstimation) 
+        : _slots(NULL), _mask(0), _used(0), _min_slots(MIN_LL_HASH_SLOTS),
+          _epoch(1), _epoch_acquires(0)
+    { 
+        assert (keyEstimation);
+        while (_min_slots < 2*(uint)keyEstimation) _min_slots <<= 1;
+        _slots = new LLSlot[_min_slots];
+        _mask = _min_slots-1;
+    }
+
+    ~KeyLockHash() 
+    { 
+        reset();
+        delete [] _slots;
+    }
+
+
+    // acquire, return true on success
+    // false means not compatible
+    inline bool acquire(KALReq& akalr) 
+    {
+        _make_room(1);
+        return (_acquire(akalr, _hash_of(*akalr._key)));
+    }
+
+    // release        
+    inline int release(const Key& aKey, 
+                       BaseActionPtr paction,
+                       BaseActionPtrList& promotedList) 
+    {        
+        LLSlot* pslot = _find(aKey, _hash_of(aKey));
+        assert (pslot);
+        return (pslot->_ll.release(paction,promotedList));
+    }
+
+    // acquire the keys of an action, return true if all were acquired
+    //
+    // Hashes all the keys and touches their home slots first, so that
+    // the cache misses of the lookups overlap
+    inline bool acquire_all(KALReqVec& akalrvec) 
+    {
+        _make_room(akalrvec.size());
+        _batch_hash.resize(akalrvec.size());
+        for (uint i=0; i<akalrvec.size(); ++i) {
+            uint h = _hash_of(*akalrvec[i]._key);
+            _batch_hash[i] = h;
+            __builtin_prefetch(&_slots[h & _mask]);
+        }
+        bool bResult = true;
+        for (uint i=0; i<akalrvec.size(); ++i) {
+            if (!_acquire(akalrvec[i], _batch_hash[i])) bResult = false;
+        }
+        return (bResult);
+    }
+
+    // release the keys of an action
+    inline void release_all(KALReqVec& akalrvec,
+                            BaseActionPtr paction,
+                            BaseActionPtrList& promotedList) 
+    {
+        _batch_hash.resize(akalrvec.size());
+        for (uint i=0; i<akalrvec.size(); ++i) {
+            uint h = _hash_of(*akalrvec[i]._key);
+            _batch_hash[i] = h;
+            __builtin_prefetch(&_slots[h & _mask]);
+        }
+        for (uint i=0; i<akalrvec.size(); ++i) {
+            LLSlot* pslot = _find(*akalrvec[i]._key, _batch_hash[i]);
+            assert (pslot);
+            pslot->_ll.release(paction,promotedList);
+        }
+    }
+
+
+    //// Debugging ////
+
+    // clear table
+    void clear() { 
+        for (uint i=0; i<=_mask; ++i) {
+            LogicalLock empty;
+            _slots[i]._ll.swap(empty);
+            _slots[i]._keysz = 0;
+        }
+        _used = 0;
+    }
+
+    // reset table, and shrink it back to its initial size
+    void reset() {
+        vector<xct_t*> toabort;
+        for (uint i=0; i<=_mask; ++i) {
+            if (_slots[i]._keysz) _slots[i]._ll.abort_and_reset(toabort);
+        }
+        if (_mask+1 > _min_slots) {
+            delete [] _slots;
+            _slots = new LLSlot[_min_slots];
+            _mask = _min_slots-1;
+            _used = 0;
+        }
+        else {
+            clear();
+        }
+    }
+
+    // return the number of keys
+    uint keystouched() const { return (_used); }
+
+    // return the number of entries allocated
+    uint slots() const { return (_mask+1); }
+
+    // returns (true) if all locks are clean
+    bool is_clean(vector<xct_t*>& toabort) {
+        bool isClean = true;
+        uint dirtyCount = 0;
+        for (uint i=0; i<=_mask; ++i) {
+            if (_slots[i]._keysz && !_slots[i]._ll.is_clean()) {
+                ++dirtyCount;
+                _slots[i]._ll.abort_and_reset(toabort);
+            }
+        }
+        if (dirtyCount) {
+            TRACE( TRACE_ALWAYS, "(%d) dirty locks\n", dirtyCount);
+        }
+        return (isClean);
+    }
+
+    void dump() {
+        TRACE( TRACE_DEBUG, "Keys (%d) Slots (%d)\n", _used, _mask+1);
+        for (uint i=0; i<=_mask; ++i) {
+            if (!_slots[i]._keysz) continue;
+            cout << "K (";
+            for (uint j=0; j<_slots[i]._keysz; ++j) cout << _slots[i]._key[j] << "|";
+            cout << ")\nL\n"; 
+            cout << _slots[i]._ll << "\n";
+        }
+    }
+
+private:
+
+    static uint _hash_of(const Key& akey) {
+        // FNV-1a over the bytes of the fields
+        uint h = 2166136261U;
+        for (uint i=0; i<akey._key_v.size(); ++i) {
+            const unsigned char* p = (const unsigned char*)&akey._key_v[i];
+            for (uint j=0; j<sizeof(DataType); ++j) {
+                h = (h ^ p[j]) * 16777619U;
+            }
+        }
+        return (h);
+    }
+
+    LLSlot* _find(const Key& akey, const uint ahash) {
+        for (uint i=ahash & _mask; _slots[i]._keysz; i=(i+1) & _mask) {
+            if (_slots[i].matches(akey,ahash)) return (&_slots[i]);
+        }
+        return (NULL);
+    }
+
+    bool _acquire(KALReq& akalr, const uint ahash) {
+        const Key& akey = *akalr._key;
+        uint i = ahash & _mask;
+        for (; _slots[i]._keysz; i=(i+1) & _mask) {
+            if (_slots[i].matches(akey,ahash)) break;
+        }
+
+        LLSlot& slot = _slots[i];
+        if (!slot._keysz) {
+            // insert, the lock of a free slot is clean
+            assert (akey._key_v.size() && akey._key_v.size()<=MAX_KEY_SIZE);
+            for (uint j=0; j<akey._key_v.size(); ++j) slot._key[j] = akey._key_v[j];
+            slot._keysz = akey._key_v.size();
+            slot._hash = ahash;
+            ++_used;
+        }
+        slot._epoch = _epoch;
+        ++_epoch_acquires;
+
+        bool bAcquire = slot._ll.acquire(akalr);
+        if (bAcquire) akalr.action()->gotkeys(1);
+        return (bAcquire);
+    }
+
+    // Called before inserting up to n keys: reclaims the idle entries
+    // at the end of an epoch, and grows the table if it is still too
+    // full. Slots move, so nothing may point into the table across it.
+    void _make_room(const uint n) {
+        uint nslots = _mask+1;
+        bool full = (4*(_used+n) > 3*nslots);
+        if (!full && (_epoch_acquires < nslots)) return;
+
+        _reclaim();
+        _epoch_acquires = 0;
+        ++_epoch;
+
+        while (4*(_used+n) > 3*nslots) nslots <<= 1;
+        if (nslots > _mask+1) _rehash(nslots);
+    }
+
+    // Drops the clean entries not acquired in the current epoch.
+    // Backward-shift deletion: the entries that follow a removed one
+    // in its probe sequence move up, so no tombstones are left.
+    void _reclaim() {
+        for (uint i=0; i<=_mask; ) {
+            LLSlot& slot = _slots[i];
+            if (!slot._keysz || (slot._epoch==_epoch) || !slot._ll.is_clean()) {
+                ++i;
+                continue;
+            }
+            uint hole = i;
+            for (uint j=(hole+1) & _mask; _slots[j]._keysz; j=(j+1) & _mask) {
+                uint home = _slots[j]._hash & _mask;
+                // stays if its home is cyclically in (hole,j]
+                bool stays = (hole<=j) ? (hole<home && home<=j) 
+                    : (hole<home || home<=j);
+                if (stays) continue;
+                _slots[hole].swap(_slots[j]);
+                hole = j;
+            }
+            _slots[hole]._keysz = 0;
+            --_used;
+            // slot i has a new entry (or is free): look at it again
+        }
+    }
+
+    void _rehash(const uint nslots) {
+        LLSlot* old = _slots;
+        uint oldslots = _mask+1;
+        _slots = new LLSlot[nslots];
+        _mask = nslots-1;
+        for (uint i=0; i<oldslots; ++i) {
+            if (!old[i]._keysz) continue;
+            uint j = old[i]._hash & _mask;
+            while (_slots[j]._keysz) j = (j+1) & _mask;
+            _slots[j].swap(old[i]);
+        }
+        delete [] old;
+    }
+
+}; // EOF: struct KeyLockHash
+
 EXIT_NAMESPACE(dora);
 
 #endif /* __DORA_LOGICAL_LOCK_H */
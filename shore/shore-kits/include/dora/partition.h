@@ -114,6 +114,12 @@ protected:
     // single reader - multiple writers
     guard<Queue>    _committed_queue;
 
+    // committed Actions of trxs whose terminal rvp ran by the owner itself.
+    // Only the owner touches it, so there is no locking and no wake-up.
+    // Served in order from _own_committed_head, like the queue.
+    std::vector<Action*> _own_committed;
+    uint                 _own_committed_head;
+
     // pools for actions for the srmwqueues
     guard<Pool>     _actionptr_input_pool;
     guard<Pool>     _actionptr_commit_pool;
@@ -178,7 +184,8 @@ public:
     int enqueue_commit(Action* apa, const bool bWake=true);
     virtual base_action_t* dequeue_commit();
     inline int has_committed(void) const { 
-        return (!_committed_queue->is_empty()); 
+        return ((_own_committed_head < _own_committed.size()) || 
+                !_committed_queue->is_empty()); 
     }
     bool is_committed_owner(base_worker_t* aworker) {
         return (_committed_queue->is_control(aworker));
@@ -203,7 +210,7 @@ public:
 
     virtual void dump();
 
-    void stlsize(uint& gather);
+    void stlsize(uint& entries, uint& slots);
 
 private:                
 
@@ -246,6 +253,8 @@ partition_t<DataType>::partition_t(ShoreEnv* env, table_desc_t* ptable,
 
     _actionptr_commit_pool = new Pool(sizeof(Action*),ACTIONS_PER_COMMIT_QUEUE_POOL_SZ);
     _committed_queue = new Queue(_actionptr_commit_pool.get());
+    _own_committed.reserve(ACTIONS_PER_COMMIT_QUEUE_POOL_SZ);
+    _own_committed_head = 0;
 }
 
 
@@ -303,6 +312,10 @@ inline base_action_t* partition_t<DataType>::dequeue()
  *
  * @brief:  Pushes an action to the partition's committed actions list
  *
+ * @note:   If it is the owner that committed the trx (it ran the terminal
+ *          rvp), the action does not go through the queue but to a list
+ *          of the owner, which releases its locks right after
+ *
  ******************************************************************/
 
 template <class DataType>
@@ -311,7 +324,12 @@ int partition_t<DataType>::enqueue_commit(Action* pAction, const bool bWake)
     assert (pAction->get_partition()==this);
     TRACE( TRACE_TRX_FLOW, "Enq committed (%d) to (%s-%d)\n", 
            pAction->tid().get_lo(), _table->name(), _part_id);
-    _committed_queue->push(pAction,bWake);
+    if (smthread_t::me() == _owner) {
+        _own_committed.push_back(pAction);
+    }
+    else {
+        _committed_queue->push(pAction,bWake);
+    }
     return (0);
 }
 
@@ -329,6 +347,14 @@ template <class DataType>
 inline base_action_t* partition_t<DataType>::dequeue_commit()
 {
     //assert (has_committed());
+    if (_own_committed_head < _own_committed.size()) {
+        Action* pAction = _own_committed[_own_committed_head++];
+        if (_own_committed_head == _own_committed.size()) {
+            _own_committed.clear();
+            _own_committed_head = 0;
+        }
+        return (pAction);
+    }
     return (_committed_queue->pop());
 }
 
@@ -353,6 +379,8 @@ void partition_t<DataType>::stop()
     // Clear queues
     _input_queue->clear();
     _committed_queue->clear();
+    _own_committed.clear();
+    _own_committed_head = 0;
     
     // Reset lock-manager
     _plm->reset();
@@ -387,6 +415,8 @@ int partition_t<DataType>::reset(const processorid_t aprsid,
     // Clear queues
     _input_queue->clear();
     _committed_queue->clear();
+    _own_committed.clear();
+    _own_committed_head = 0;
     
     // Reset lock-manager
     _plm->reset();
@@ -457,6 +487,7 @@ w_rc_t partition_t<DataType>::prepareNewRun()
     // _owner->set_control(WC_RECOVERY);
 
     // Clear queues but not remove owner
+    assert (_own_committed_head == _own_committed.size());
     while (!_committed_queue->is_really_empty()) {
         TRACE( TRACE_ALWAYS, "CommittedQueue of (%s-%d) not empty\n");
         _owner->doRecovery();
@@ -788,15 +819,17 @@ void partition_t<DataType>::statistics(worker_stats_t& gather)
  *
  * @fn:     stlsize()
  *
- * @brief:  The size of the map of the lock manager (aka local lock table)
+ * @brief:  The size of the map of the lock manager (aka local lock table):
+ *          the keys in it, and the entries it has room for
  *
  ******************************************************************/
 
 template <class DataType>
-void partition_t<DataType>::stlsize(uint& gather) 
+void partition_t<DataType>::stlsize(uint& entries, uint& slots) 
 {
     assert (_plm); 
-    gather += _plm->keystouched();
+    entries += _plm->keystouched();
+    slots += _plm->slots();
 }
 
 
@@ -27,6 +27,7 @@
 #include "qpipe/core/cpu_bind.h"
 #include "qpipe/core/dispatcher.h"
 #include "qpipe/core/functors.h"
+#include "qpipe/core/memory_broker.h"
 #include "qpipe/core/packet.h"
 #include "qpipe/core/stage.h"
 #include "qpipe/core/stage_container.h"
@@ -0,0 +1,141 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   memory_broker.h
+ *
+ *  @brief:  Global memory budget for the stages that buffer their input
+ *           (sort, hash aggregate, sort-merge join)
+ *
+ */
+
+#ifndef __QPIPE_MEMORY_BROKER_H
+#define __QPIPE_MEMORY_BROKER_H
+
+#include "util.h"
+
+
+ENTER_NAMESPACE(qpipe);
+
+
+/**
+ *  @brief Hands out pages (of the default page size) of a global
+ *  budget to the stages that need working memory. A stage asks for
+ *  what it would like and for the least it can work with, and gets
+ *  its fair share: the budget split evenly among the holders, itself
+ *  included, as far as it is free. Whatever it gets, the stage fits
+ *  in it and spills the rest to disk.
+ *
+ *  The broker never blocks. The stages of a query are a pipeline, so
+ *  a stage waiting for memory may be the only reader of a stage that
+ *  holds it. Instead, when the budget is used up a stage still gets
+ *  its minimum, and the budget is exceeded by at most the minimums.
+ *
+ *  A budget of 0 means no limit, and the stages get what they ask for.
+ */
+
+class memory_broker_t {
+
+private:
+
+    static memory_broker_t _instance;
+
+    pthread_mutex_t _lock;
+
+    size_t _budget;   /* pages, 0 for no limit */
+    size_t _granted;  /* pages held by the stages */
+    int    _holders;  /* stages holding a grant */
+
+    /* stats (don't affect correctness) */
+    size_t _peak;
+    size_t _grants;
+    size_t _short_grants;  /* got less than asked for */
+    size_t _overcommits;   /* got the minimum past the budget */
+    size_t _spills;
+
+    memory_broker_t();
+
+public:
+
+    enum { DEFAULT_BUDGET_MB = 1024 };
+
+    static memory_broker_t* instance() { return (&_instance); }
+
+    void   set_budget(const size_t pages);
+    size_t budget() const { return (_budget); }
+
+    size_t acquire(const size_t want, const size_t min);
+    void   release(const size_t pages);
+
+    // a stage had to go to disk
+    void note_spill();
+
+    // also the peak RSS of the process
+    void clear_stats();
+    void trace_stats();
+    size_t peak_pages() const { return (_peak); }
+};
+
+
+
+/**
+ *  @brief The grant of a stage, returned to the broker when it goes
+ *  out of scope. A stage that works in passes (runs, partitions)
+ *  renews it at each pass, so that it gets more when others finish
+ *  and less when others start.
+ */
+
+class memory_grant_t {
+
+    size_t _want;
+    size_t _min;
+    size_t _pages;
+
+public:
+
+    memory_grant_t(const size_t want, const size_t min)
+        : _want(want), _min(min),
+          _pages(memory_broker_t::instance()->acquire(want, min))
+    {
+    }
+
+    ~memory_grant_t() {
+        memory_broker_t::instance()->release(_pages);
+    }
+
+    size_t pages() const { return (_pages); }
+
+    void renew() {
+        memory_broker_t::instance()->release(_pages);
+        _pages = memory_broker_t::instance()->acquire(_want, _min);
+    }
+
+private:
+    memory_grant_t(memory_grant_t const &);
+    memory_grant_t &operator =(memory_grant_t const &);
+};
+
+
+EXIT_NAMESPACE(qpipe);
+
+
+#endif
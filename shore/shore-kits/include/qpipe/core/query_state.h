@@ -47,6 +47,34 @@ public:
      */
     virtual void rebind_self(packet_t*)=0;
 
+
+    /**
+     * Load accounting for the policies that bind by load: while a
+     * thread processes a packet it counts against (at most) one CPU.
+     * The count is dropped by the stage when the packet is done, since
+     * the query state may be gone by then.
+     */
+    static void hold_load(unsigned int volatile* load) {
+        drop_load();
+        atomic_inc_uint(load);
+        _held_load() = load;
+    }
+
+    static void drop_load() {
+        unsigned int volatile*& held = _held_load();
+        if (held) {
+            atomic_dec_uint(held);
+            held = NULL;
+        }
+    }
+
+private:
+
+    static unsigned int volatile*& _held_load() {
+        static __thread unsigned int volatile* held = NULL;
+        return held;
+    }
+
 };
 
 
@@ -148,6 +148,12 @@ public:
         if (qstate != NULL)
             /* do CPU binding */
             qstate->rebind_self(packet);
+
+        /* whatever the binding held, it is released when done (or
+           stopped by an exception) */
+        struct load_dropper_t {
+            ~load_dropper_t() { query_state_t::drop_load(); }
+        } dropper;
         
 	process_packet();
     }
@@ -38,5 +38,7 @@
 #include "qpipe/scheduler/policy_query_cpu.h"
 #include "qpipe/scheduler/policy_rr_cpu.h"
 #include "qpipe/scheduler/policy_rr_module.h"
+#include "qpipe/scheduler/policy_steal_cpu.h"
+#include "qpipe/scheduler/policy_numa.h"
 
 #endif
@@ -46,6 +46,7 @@ typedef struct cpu_s* cpu_t;
 
 void cpu_bind_self(cpu_t cpu);
 int  cpu_get_unique_id(cpu_t cpu);
+int  cpu_get_node(cpu_t cpu);
 
 EXIT_NAMESPACE(qpipe);
 
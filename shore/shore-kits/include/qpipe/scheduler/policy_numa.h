@@ -0,0 +1,156 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#ifndef __QPIPE_POLICY_NUMA_H
+#define __QPIPE_POLICY_NUMA_H
+
+#include <algorithm>
+
+#include "util.h"
+#include "qpipe/scheduler/policy_steal_cpu.h"
+
+
+
+ENTER_NAMESPACE(qpipe);
+
+
+
+/* exported datatypes */
+
+/**
+ *  @brief Binds all the stages of a query to the CPUs of a single NUMA
+ *  node, the one running the fewest queries when the query starts.
+ *  Within the node it binds by load, like policy_steal_cpu_t.
+ *
+ *  A tuple_fifo page is first written by the producer, so it is placed
+ *  on the producer's node, and the consumer of the same query reads
+ *  it there without going to remote memory.
+ */
+class policy_numa_t : public policy_steal_cpu_t {
+
+protected:
+
+    struct node_t {
+        int _first;   // position of its first CPU in _order
+        int _count;
+        unsigned int volatile _queries;
+    };
+
+    std::vector<node_t> _nodes;
+
+
+    class numa_query_state_t : public qpipe::query_state_t {
+
+    private:
+        policy_numa_t* _policy;
+
+    public:
+
+        // The node we picked for this query
+        int _node;
+
+        numa_query_state_t(policy_numa_t* policy, int node)
+            : _policy(policy), _node(node)
+        {
+        }
+
+        virtual ~numa_query_state_t() { }
+
+        virtual void rebind_self(packet_t*) {
+            /* Rebind calling thread to a CPU of the query's node. */
+            node_t& node = _policy->_nodes[_node];
+            _policy->bind_self(node._first, node._count);
+        }
+    };
+
+
+    struct by_node_t {
+        const std::vector<int>& _node_of;
+        by_node_t(const std::vector<int>& node_of) : _node_of(node_of) { }
+        bool operator()(int a, int b) const {
+            return (_node_of[a] < _node_of[b]);
+        }
+    };
+
+  
+public:
+   
+    policy_numa_t()
+    {
+        // Order the CPUs by node, and find where each node starts
+        std::vector<int> node_of;
+        for (int i = 0; i < _cpu_num; i++)
+            node_of.push_back(cpu_get_node(cpu_set_get_cpu(&_cpu_set, i)));
+        std::stable_sort(_order.begin(), _order.end(), by_node_t(node_of));
+
+        for (int p = 0; p < _cpu_num; p++) {
+            _pos[_order[p]] = p;
+            if ((p == 0) || (node_of[_order[p]] != node_of[_order[p-1]])) {
+                node_t node;
+                node._first = p;
+                node._count = 0;
+                node._queries = 0;
+                _nodes.push_back(node);
+            }
+            _nodes.back()._count++;
+        }
+
+        TRACE(TRACE_ALWAYS, "(%d) CPUs in (%d) NUMA nodes\n",
+              _cpu_num, (int)_nodes.size());
+    }
+
+
+    virtual ~policy_numa_t() { }
+
+
+    virtual query_state_t* query_state_create() {
+
+        // The node running the fewest queries (ties do not matter much)
+        int next_node = 0;
+        for (int n = 1; n < (int)_nodes.size(); n++) {
+            if (*&_nodes[n]._queries < *&_nodes[next_node]._queries)
+                next_node = n;
+        }
+        atomic_inc_uint(&_nodes[next_node]._queries);
+    
+        return new numa_query_state_t(this, next_node);
+    }
+  
+
+    virtual void query_state_destroy(query_state_t* qs) {
+        // Dynamic cast acts like an assert(), verifying the type.
+        numa_query_state_t* qstate = dynamic_cast<numa_query_state_t*>(qs);
+        atomic_dec_uint(&_nodes[qstate->_node]._queries);
+        delete qstate;
+    }
+
+   
+};
+
+
+
+EXIT_NAMESPACE(qpipe);
+
+
+
+#endif
@@ -0,0 +1,188 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#ifndef __QPIPE_POLICY_STEAL_CPU_H
+#define __QPIPE_POLICY_STEAL_CPU_H
+
+#include <climits>
+#include <vector>
+
+#include "util.h"
+#include "qpipe/scheduler/policy.h"
+#include "qpipe/scheduler/cpu_set_struct.h"
+#include "qpipe/scheduler/cpu_set.h"
+
+
+
+ENTER_NAMESPACE(qpipe);
+
+
+
+/* exported datatypes */
+
+/**
+ *  @brief Binds by load. A stage thread stays on the CPU it ran its
+ *  last packet on, unless that CPU is busy while another one is less
+ *  loaded. Then it moves there, so idle CPUs take over the work
+ *  queued at busy ones, instead of the fixed assignments of the RR
+ *  policies that leave CPUs idle when stages have skewed costs.
+ *
+ *  The load of a CPU is the number of stage threads bound to it that
+ *  are processing a packet (see query_state_t::hold_load()).
+ */
+class policy_steal_cpu_t : public policy_t {
+
+protected:
+
+    enum { CACHE_LINE = 64 };
+
+    struct cpu_load_t {
+        unsigned int volatile _running;
+        char _pad[CACHE_LINE - sizeof(unsigned int)];
+    };
+
+    class steal_cpu_state_t : public qpipe::query_state_t {
+
+    private:
+        policy_steal_cpu_t* _policy;
+
+    public:
+        steal_cpu_state_t(policy_steal_cpu_t* policy)
+        : _policy(policy)
+        {
+        }
+
+        virtual ~steal_cpu_state_t() { }
+
+        virtual void rebind_self(packet_t*) {
+            /* Rebind calling thread to the least loaded CPU. */
+            _policy->bind_self(0, _policy->_cpu_num);
+        }
+    };
+
+
+    struct cpu_set_s _cpu_set;
+    int _cpu_num;
+
+    // The CPUs (indexes in _cpu_set) in the order they are picked
+    // from, and the position of each one in that order
+    std::vector<int> _order;
+    std::vector<int> _pos;
+
+    cpu_load_t* _load;  // per CPU
+    unsigned int volatile _next;
+
+    // The CPU the calling thread was bound to by bind_self(), if any
+    static int& _home() {
+        static __thread int home = -1;
+        return home;
+    }
+
+
+    /**
+     *  @brief Binds the calling thread to one of the CPUs at positions
+     *  [first,first+count) of _order. It stays on its current CPU if
+     *  that is one of them and no other is less loaded.
+     */
+    void bind_self(const int first, const int count) {
+
+        assert ((first >= 0) && (count > 0) && (first+count <= _cpu_num));
+        int& home = _home();
+        bool at_home = (home >= 0) && (home < _cpu_num) &&
+            (_pos[home] >= first) && (_pos[home] < first+count);
+
+        int pick = home;
+        if (!at_home || (*&_load[home]._running > 0)) {
+
+            // Start from a different CPU every time, so that threads
+            // moving at the same time do not all pick the same one
+            unsigned int least = UINT_MAX;
+            int start = atomic_inc_uint_nv(&_next) % count;
+            for (int i = 0; i < count; i++) {
+                int cpu = _order[first + (start + i) % count];
+                unsigned int running = *&_load[cpu]._running;
+                if (running < least) {
+                    least = running;
+                    pick = cpu;
+                    if (running == 0) break;
+                }
+            }
+
+            // Moving is not worth it if home is as loaded
+            if (at_home && (*&_load[home]._running <= least))
+                pick = home;
+        }
+
+        query_state_t::hold_load(&_load[pick]._running);
+        if (pick != home) {
+            cpu_t bind_cpu = cpu_set_get_cpu(&_cpu_set, pick);
+            cpu_bind_self(bind_cpu);
+            TRACE(TRACE_CPU_BINDING, "Binding to CPU %d\n", 
+                  cpu_get_unique_id(bind_cpu));
+            home = pick;
+        }
+    }
+
+
+public:
+
+    policy_steal_cpu_t()
+        : _next(0)
+    {
+        cpu_set_init(&_cpu_set);
+        _cpu_num = cpu_set_get_num_cpus(&_cpu_set);
+        _load = new cpu_load_t[_cpu_num];
+        for (int i = 0; i < _cpu_num; i++) {
+            _load[i]._running = 0;
+            _order.push_back(i);
+            _pos.push_back(i);
+        }
+    }
+
+
+    virtual ~policy_steal_cpu_t() {
+        delete [] _load;
+        cpu_set_finish(&_cpu_set);
+    }
+
+
+    virtual query_state_t* query_state_create() {
+        return new steal_cpu_state_t(this);
+    }
+
+  
+    virtual void query_state_destroy(query_state_t* qs) {
+        // Dynamic cast acts like an assert(), verifying the type.
+        steal_cpu_state_t* qstate = dynamic_cast<steal_cpu_state_t*>(qs);
+        delete qstate;
+    }
+
+};
+
+
+
+EXIT_NAMESPACE(qpipe);
+
+
+
+#endif
@@ -75,20 +75,37 @@ struct hash_aggregate_packet_t : public packet_t {
 
 
 
+/**
+ * @brief Hybrid hash aggregation. The groups are aggregated in the
+ * pages granted by the memory broker. Once they are full, the tuples
+ * of the groups that did not fit are hash partitioned to disk, and
+ * each partition is aggregated the same way afterwards.
+ */
 class hash_aggregate_stage_t : public stage_t {
 
     page_trash_stack _page_list;
     size_t _page_count;
+    size_t _page_quota;
     tuple_aggregate_t* _aggregate;
     qpipe::page* _agg_page;
     size_t _tuple_align;
+
+    struct input_t;
+    
 public:
     static const c_str DEFAULT_STAGE_NAME;
     typedef hash_aggregate_packet_t stage_packet_t;
 
+    // the write pages of the partitions of a pass that spills
+    static const size_t SPILL_PARTITIONS = 16;
+
 protected:
     virtual void process_packet();
     int alloc_agg(tuple_t &agg, const char* key);
+
+private:
+    void aggregate_pass(hash_aggregate_packet_t* packet, input_t &input,
+                        memory_grant_t &grant, const int level);
 };
 
 
@@ -24,12 +24,10 @@
 #ifndef __QPIPE_SORT_H
 #define __QPIPE_SORT_H
 
-#include "qpipe/stages/merge.h"
 #include "qpipe/core.h"
 
 #include <list>
-#include <map>
-#include <deque>
+#include <vector>
 
 
 
@@ -129,7 +127,9 @@ public:
 
 /**
  * @brief Sort stage that partitions the input into sorted runs and
- * merges them into a single output run.
+ * merges them into a single output run. The runs are as large as the
+ * memory broker allows, and so is the number of runs merged at a
+ * time.
  */
 class sort_stage_t : public stage_t {
 
@@ -138,6 +138,7 @@ private:
 
     static const unsigned int MERGE_FACTOR;
     static const unsigned int PAGES_PER_INITIAL_SORTED_RUN;
+    static const unsigned int CACHE_RUN_TUPLES;
 
     
     // state provided by the packet
@@ -148,42 +149,13 @@ private:
     
 
     typedef list<c_str> run_list_t;
-
-
-    // all information we need for an active merge
-    struct merge_t {
-	c_str _output; // name of output file
-	run_list_t _inputs;
-        tuple_fifo* _signal_buffer;
-	
-	merge_t () { }
-        merge_t(const c_str &output, const run_list_t &inputs, tuple_fifo * signal_buffer)
-            : _output(output),
-	      _inputs(inputs),
-	      _signal_buffer(signal_buffer)
-        {
-        }
-    };
-
-    
-    typedef std::map<int, run_list_t> run_map_t;
-    typedef std::list<merge_t> merge_list_t;
-    typedef std::map<int, merge_list_t> merge_map_t;
-    typedef merge_packet_t::buffer_list_t buffer_list_t;
     typedef std::vector<hint_tuple_pair_t> hint_vector_t;
 
-
-    // used to communicate with the monitor thread
-    pthread_t _monitor_thread;
-    notify_t  _monitor;
+    struct run_reader_t;
 
 
-    volatile bool _sorting_finished;
-    
-
-    // run/merge management
-    run_map_t   _run_map;
-    merge_map_t _merge_map;
+    // sorted runs on disk, in the order they are to be merged
+    run_list_t _runs;
     
 public:
 
@@ -193,33 +165,14 @@ public:
 
     sort_stage_t()
         : _input_buffer(NULL), _extract(NULL), _compare(NULL),
-          _tuple_size(0), _monitor_thread(0)
+          _tuple_size(0)
     {
     }
 
     
     ~sort_stage_t() {
-
-        // make sure the monitor thread exits before we do...
-        {
-	    //This critical section makes sure that the monitor thread will be joined only once.
-            critical_section_t cs(_monitor._lock);
-            if(_monitor_thread) {
-                thread_join<void>(_monitor_thread);
-                //MA: Have to make sure it is not breaking anything <-- Indeed it was breaking. But we need the changes in the sort.cpp
-                //pthread_kill(_monitor_thread,SIGKILL);
-            }
-        }
-        // also, remove any remaining temp files
-        merge_map_t::iterator level_it=_merge_map.begin();
-        while(level_it != _merge_map.end()) {
-            merge_list_t::iterator it = level_it->second.begin();
-            while(it != level_it->second.end()) {
-                remove_input_files(it->_inputs);
-                ++it;
-            }
-            ++level_it;
-        }
+        // remove any remaining temp files
+        remove_input_files(_runs);
     }
 
 protected:
@@ -228,19 +181,10 @@ protected:
     
 private:
 
-    bool final_merge_ready();
-    int create_sorted_run(int page_count);
-
-    tuple_fifo* monitor_merge_packets();
-
-    void check_finished_merges();
-    void start_new_merges();
-    void start_merge(int new_level, run_list_t& runs, int merge_factor);
+    void sort_run(hint_vector_t &array);
+    c_str write_run(hint_vector_t &array, qpipe::page* out_page);
+    void merge_runs(size_t count, FILE* out, qpipe::page* out_page);
     void remove_input_files(run_list_t& files);
-
-    // debug
-    int print_runs();
-    int print_merges();
 };
 
 
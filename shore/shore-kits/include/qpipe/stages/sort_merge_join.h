@@ -157,6 +157,14 @@ private:
     tuple_join_t* _join;
     key_compare_t* _compare;
 
+    /* The right tuples of the key being joined are copied to pages,
+       as many as the memory broker grants, and the rest to a temp
+       file that is read again for each left tuple. */
+    static const size_t MAX_GROUP_PAGES = 1024;
+
+    void join_group(const tuple_t &left, qpipe::page* group,
+                    FILE* spill, qpipe::page* spill_page, char* data);
+
 
 public:
 
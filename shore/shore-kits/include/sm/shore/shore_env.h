@@ -87,9 +87,11 @@ const string SHORE_SYS_SM_OPTIONS[][3]  = {
     { "-sm_diskrw", "shore-diskrw", "diskrw" },
     { "-sm_errlog", "shore-errlog", "info" },
     { "-sm_num_page_writers", "shore-pagecleaners", "16" },
+    { "-sm_stats_sample_ms", "shore-stats-sample-ms", "0" },
+    { "-sm_stats_sample_file", "shore-stats-sample-file", "sm_stats.csv" },
 };
 
-const int    SHORE_NUM_SYS_SM_OPTIONS   = 5;
+const int    SHORE_NUM_SYS_SM_OPTIONS   = 7;
 
 
 // SHORE_DB_SM_OPTIONS: 
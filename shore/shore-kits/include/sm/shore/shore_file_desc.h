@@ -103,6 +103,9 @@ enum file_type_t  { FT_HEAP         = 0x1,
  *                          to one leaf MRBTree index page
  *         PD_NOLOCK      - have indexes without CC
  *         PD_NOLATCH     - have indexes without even latching
+ *         PD_HASHIDX     - primary indexes also get an in-memory hash
+ *                          index for the equality probes
+ *         PD_KEYCOMPRESS - multi-field indexes are prefix-compressed
  *
  * --------------------------------------------------------------- */
 
@@ -112,7 +115,9 @@ enum physical_design_t { PD_NORMAL      = 0x1,
                          PD_MRBT_PART   = 0x8,
                          PD_MRBT_LEAF   = 0x10,
                          PD_NOLOCK      = 0x20,
-                         PD_NOLATCH     = 0x40
+                         PD_NOLATCH     = 0x40,
+                         PD_HASHIDX     = 0x80,
+                         PD_KEYCOMPRESS = 0x100
 };
 
 
@@ -48,6 +48,12 @@
    if up to T msecs or N bytes or K xcts are unflushed a call to flush is 
    triggered.  
 
+   With "flusher-policy = 1" the K xcts and T usecs thresholds are not fixed
+   but tuned online by flusher_ctl_t, from the arrival rate, the time a flush
+   takes, and a target commit latency ("flusher-target-latency" usecs) for a
+   percentile of the groups ("flusher-target-percentile"). See 
+   flusher_ctl_t for the details.
+
    worker:
    {  ...
       commit_xct(lazy);
@@ -99,13 +105,27 @@ struct flusher_stats_t
     uint trigByXcts;
     uint trigBySize;
     uint trigByTimeout;
-    
+    uint trigByIdle;                 // queue drained before the thresholds
+
+    // Per-group statistics, in usecs. The commit latency of a group is that
+    // of its first xct: from the time it was seen by the flusher until the
+    // flush of the group completed.
+    enum { LAT_BUCKETS = 32 };       // power-of-2 usec buckets
+    long long groupWait;             // sum of first arrival -> flush start
+    long long groupFlush;            // sum of flush start -> flush end
+    uint      groupMax;              // biggest group flushed
+    uint      latHist[LAT_BUCKETS];  // commit latency of the groups
+
     flusher_stats_t();
     ~flusher_stats_t();
 
     void print() const;
     void reset();
 
+    void add_group(const uint gsize, const long waitusec, const long flushusec);
+    static uint lat_bucket(const long usec);
+    static long percentile(const uint* hist, const double pct);
+
 
     // Helper functions used by both the mainstream and the DORA flusher
     // They are here in order to be accessed by both 
@@ -137,6 +157,72 @@ const int FLUSHER_GROUP_SIZE_THRESHOLD  = 100;    // Flush every 100 xcts
 const int FLUSHER_LOG_SIZE_THRESHOLD    = 200000; // Flush every 200K
 const int FLUSHER_TIME_THRESHOLD        = 1000;   // Flush every 1000usec (msec)
 
+const int FLUSHER_POLICY_FIXED          = 0;      // K xcts, N bytes, T usecs
+const int FLUSHER_POLICY_ADAPTIVE       = 1;      // K and T tuned by flusher_ctl_t
+const int FLUSHER_TARGET_LATENCY        = 5000;   // usecs
+const int FLUSHER_TARGET_PERCENTILE     = 99;
+const int FLUSHER_POLL_USEC             = 50;     // poll while a group fills
+
+
+
+/******************************************************************** 
+ *
+ * @struct: flusher_ctl_t
+ *
+ * @brief:  The controller of the adaptive group commit policy
+ *
+ * @note:   The first xct of a group waits for the group to fill and 
+ *          then for the flush, so for a target commit latency L the
+ *          group may wait for at most W = L - F, where F is the (EWMA)
+ *          time a flush takes. At an (EWMA) arrival rate R that is 
+ *          R*W xcts, which becomes the group size threshold, while W 
+ *          becomes the timeout.
+ *
+ *          The estimate is corrected by the latency the groups actually 
+ *          see: every CTL_WINDOW groups the target percentile of their
+ *          latencies is compared with L; clearly above it the wait 
+ *          budget is halved, within it the budget grows back by an 
+ *          eighth. The group size is never larger than the
+ *          "flusher-group-size" and the timeout never longer than the
+ *          "flusher-timeout" of the fixed policy.
+ * 
+ ********************************************************************/
+
+struct flusher_ctl_t
+{
+    enum { CTL_WINDOW = 64 };     // groups per feedback step
+
+    long   _target;               // target commit latency (usecs)
+    double _pct;                  // ... for this percentile of the groups
+    uint   _max_group;
+    long   _max_timeout;
+
+    double _rate;                 // EWMA of xcts per usec
+    double _flush;                // EWMA of usecs per flush
+    double _gain;                 // feedback scaling of the wait budget, (0,1]
+
+    uint   _group;                // current thresholds
+    long   _timeout;
+
+    uint   _groups;               // groups in the current window
+    uint   _hist[flusher_stats_t::LAT_BUCKETS];
+
+    flusher_ctl_t(const long target, const double pct,
+                  const uint max_group, const long max_timeout);
+
+    // Called after each flush, with the size of the group, the usecs since
+    // the previous flush completed, and the latency breakdown of the group
+    void on_flush(const uint gsize, const long sinceusec,
+                  const long waitusec, const long flushusec);
+
+    void print() const;
+
+private:
+    void _retune();
+
+}; // EOF: flusher_ctl_t
+
+
 
 class flusher_t : public base_worker_t
 {   
@@ -156,6 +242,7 @@ protected:
     guard<Pool> _pxct_flushing_pool;
 
     flusher_stats_t _stats;
+    guard<flusher_ctl_t> _ctl;    // only with the adaptive policy
     
     virtual int _pre_STOP_impl();
     int _work_ACTIVE_impl(); 
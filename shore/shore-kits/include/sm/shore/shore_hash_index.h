@@ -0,0 +1,147 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   shore_hash_index.h
+ *
+ *  @brief:  In-memory hash index, from the key of a primary index to
+ *           the rid of the record, for the equality probes of
+ *           index_probe() that would otherwise descend the B-tree
+ *
+ */
+
+/* The hash index is not logged and it is not transactional. It is a
+ * cache in front of the B-tree of the primary index:
+ *
+ * - add_tuple() and the B-tree probes that find a record insert the
+ *   key; delete_tuple() removes it.
+ * - An entry may be stale, for example after the xct that inserted the
+ *   record aborted. So a hit is trusted only after the pinned record is
+ *   found to carry the same key (see matches()), otherwise the entry is
+ *   dropped and the B-tree is probed.
+ * - A miss always goes to the B-tree.
+ *
+ * Hence after a restart (or recovery) the hash index starts empty, and
+ * it is filled either lazily by the probes or at once by
+ * table_man_t::rebuild_hash_index().
+ *
+ * The comparison is on the disk format of the record, so the table
+ * cannot have null-able fields and the key fields have to be of fixed
+ * length (table_desc_t checks it before attaching one).
+ */
+
+#ifndef __SHORE_HASH_INDEX_H
+#define __SHORE_HASH_INDEX_H
+
+#include "sm_vas.h"
+#include "util.h"
+
+
+ENTER_NAMESPACE(shore);
+
+
+/******************************************************************
+ *
+ *  @class: hash_index_t
+ *
+ *  @brief: Chained hash table of (key,rid). The chains are protected
+ *          by a number of reader-writer locks (stripes), picked by
+ *          the hash value, so that growing the table (which takes all
+ *          the stripes) does not move a key to another stripe.
+ *
+ ******************************************************************/
+
+class hash_index_t
+{
+public:
+
+    enum { STRIPES = 256 };
+    enum { INITIAL_BUCKETS = 1024 };
+    enum { CACHE_LINE = 64 };
+
+private:
+
+    struct entry_t {
+        entry_t* _next;
+        rid_t    _rid;
+        uint     _hash;
+        uint     _klen;
+        char     _key[1]; // _klen bytes
+    };
+
+    struct stripe_t {
+        mcs_rwlock _lock;
+        char       _pad[CACHE_LINE - sizeof(mcs_rwlock)]; // one per line
+    };
+
+    stripe_t*         _stripes;
+    entry_t**         _buckets;
+    uint              _bucket_cnt; // power of 2
+    volatile uint     _count;
+
+    // where the key fields are in the disk format of the record
+    vector<uint>      _rec_offset;
+    vector<uint>      _field_size;
+
+    static uint _hash_key(const char* key, const uint klen);
+
+    inline mcs_rwlock& _stripe(const uint h) {
+        return (_stripes[h & (STRIPES-1)]._lock);
+    }
+
+    void _grow(); // takes all the stripes
+
+    // not to be copied
+    hash_index_t(const hash_index_t&);
+    hash_index_t& operator=(const hash_index_t&);
+
+public:
+
+    hash_index_t();
+    ~hash_index_t();
+
+    // the key field (in key order) is at offset of the record, of size
+    void add_key_field(const uint offset, const uint size);
+
+    // true if the record (disk format) has this key
+    bool matches(const char* body, const char* key) const;
+
+    bool probe(const char* key, const uint klen, rid_t& rid);
+
+    // inserts, or replaces the rid of the key
+    void insert(const char* key, const uint klen, const rid_t& rid);
+
+    // removes the key, or only if it still points to rid
+    void remove(const char* key, const uint klen);
+    void remove(const char* key, const uint klen, const rid_t& rid);
+
+    void clear();
+
+    uint size() const { return (*&_count); }
+    uint buckets() const { return (_bucket_cnt); }
+
+}; // EOF: hash_index_t
+
+
+EXIT_NAMESPACE(shore);
+
+#endif /* __SHORE_HASH_INDEX_H */
@@ -277,9 +277,11 @@ public:
                 assert (pdest); // if NULL invalid key
             
 		int pnum = _pmanager->get_pnum(_pindex, _ptuple);
+                char elem[index_desc_t::MAX_ELEM_SIZE];
+                int esz = _pmanager->format_elem(_pindex, _ptuple, elem);
                 W_DO(_pssm->create_assoc(_pindex->fid(pnum),
                                          vec_t(pdest, key_sz),
-                                         vec_t(&(_ptuple->_rid), sizeof(rid_t))));
+                                         vec_t(elem, esz)));
             
                 _has_to_consume = false;
                 cons_happened = true; // a consumption just happened
@@ -42,6 +42,7 @@
 #include "sm/shore/shore_error.h"
 #include "sm/shore/shore_file_desc.h"
 #include "sm/shore/shore_iter.h"
+#include "sm/shore/shore_hash_index.h"
 
 
 ENTER_NAMESPACE(shore);
@@ -75,6 +76,13 @@ private:
     uint            _mr;                       /* is it multi-rooted */ 
     bool            _latchless;                /* does it use any latches at all */ 
     bool            _rmapholder;               /* it is used only for the range mapping */
+    bool            _compressed;               /* is its btree prefix-compressed */
+    hash_index_t*   _hash;                     /* in-memory hash in front of it, if any */
+
+    uint*           _payload;                  /* fields carried in the entries, if covering */
+    uint            _payload_count;
+    uint*           _rec_offset;               /* offsets of the key and payload fields in the record */
+    uint            _elem_size;                /* the rid and the payload */
 
     index_desc_t*   _next;                     /* linked list of all indices */
 
@@ -154,8 +162,30 @@ public:
     inline bool is_mr() const { return (_mr); }
     inline bool is_latchless() const { return (_latchless); }
     inline bool is_rmapholder() const { return (_rmapholder); }
+    inline bool is_compressed() const { return (_compressed); }
     inline bool is_partitioned() const { return _partition_count > 1; }
 
+    // the in-memory hash index of the equality probes (or NULL)
+    inline hash_index_t* hash() const { return (_hash); }
+    void set_hash(hash_index_t* phash);
+
+    // a covering index carries the payload fields in its entries,
+    // after the rid, so that scans need not fetch the record
+    enum { MAX_ELEM_SIZE = 256, MAX_COVERING_KEY_SIZE = 256 };
+    inline bool is_covering() const { return (_payload_count > 0); }
+    inline uint payload_count() const { return (_payload_count); }
+    inline uint payload_index(const uint i) const { 
+        assert (i < _payload_count); return (_payload[i]); 
+    }
+    inline uint elem_size() const { return (_elem_size); }
+    void set_payload(const uint* fields, const uint num, 
+                     const uint* offsets, const uint payload_size);
+
+    // offset in the record of the i-th key field, followed by the payload ones
+    inline uint rec_offset(const uint i) const { 
+        assert (_rec_offset); return (_rec_offset[i]); 
+    }
+
     inline int  get_partition_count() const { return _partition_count; }
     inline int  get_keysize() { return (*&_maxkeysize); }
     inline void set_keysize(const uint_t sz) { atomic_swap_uint(&_maxkeysize, sz); }
@@ -102,6 +102,8 @@ protected:
     uint                 _pnum;
 
     guard<scan_index_i>  _scanner;
+
+    char*         _elem;    // the current element: rid, and payload
     
 public:
 
@@ -116,6 +118,10 @@ public:
 
     w_rc_t next(bool& eof, rid_t& rid);
 
+    // the payload fields of the current entry of a covering index,
+    // each of its maxsize, valid until the next()
+    const char* payload() const { return (_elem + sizeof(rid_t)); }
+
     w_rc_t close_scan();
 
 }; // EOF: simple_index_iter_t
@@ -0,0 +1,284 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   shore_row_layout.h
+ *
+ *  @brief:  Compile-time layouts of the records of tables with only
+ *           fixed-size, non-null fields, and typed access to such
+ *           records directly on the pinned page
+ *
+ *  @note:   row_field_t    - a field of a layout, with its offset
+ *           typed_pin_t    - a pinned record accessed through a layout
+ *
+ */
+
+/* For a table without null-able and variable-length fields the disk
+ * format of table_row_t (see shore_row.h) is simply the values of the
+ * fields one after the other, each taking its maxsize(). So the offset
+ * of every field is known at compile time, and a field can be read from
+ * (or written to) the record on the page without going through load()
+ * and format() of the whole row.
+ *
+ * A layout is a struct with a row_field_t typedef per field, each one
+ * chained to the previous:
+ *
+ *   struct warehouse_layout {
+ *       typedef row_field_t<row_layout_begin_t, int>  W_ID;
+ *       typedef row_field_t<W_ID, char, 10>           W_NAME;
+ *       ...
+ *       typedef row_field_t<W_TAX, double>            W_YTD;
+ *       typedef W_YTD last;
+ *   };
+ *
+ * The layout has to agree with the table_desc_t of the table, which
+ * typed_pin_t checks (once per table) in debug builds.
+ *
+ * Records are still inserted through table_row_t, since add_tuple() also
+ * needs to format the keys of the indexes.
+ */
+
+#ifndef __SHORE_ROW_LAYOUT_H
+#define __SHORE_ROW_LAYOUT_H
+
+
+#include "sm/shore/shore_table.h"
+
+
+ENTER_NAMESPACE(shore);
+
+
+
+/* ---------------------------------------------------------------
+ *
+ * @struct: row_field_t
+ *
+ * @brief:  A field of type T[N], right after field Prev in the record
+ *
+ * --------------------------------------------------------------- */
+
+struct row_layout_begin_t
+{
+    enum { INDEX = -1, END = 0 };
+};
+
+template <class Prev, class T, uint N = 1>
+struct row_field_t
+{
+    typedef Prev prev;
+    typedef T    value_type;
+
+    enum { INDEX  = Prev::INDEX + 1,
+           OFFSET = Prev::END,
+           SIZE   = sizeof(T) * N,
+           END    = OFFSET + SIZE };
+};
+
+
+/* ---------------------------------------------------------------
+ *
+ * @fn:     row_layout_matches
+ *
+ * @brief:  True if the layout describes the records of the table:
+ *          same number of fields, of the same size, none of them
+ *          null-able or of variable length
+ *
+ * --------------------------------------------------------------- */
+
+template <class Field>
+struct row_layout_check_t
+{
+    static bool matches(table_desc_t* ptd) {
+        field_desc_t* pfd = ptd->desc(Field::INDEX);
+        if (pfd->allow_null() || pfd->is_variable_length()) return (false);
+        if (pfd->fieldmaxsize() != (uint)Field::SIZE) return (false);
+        return (row_layout_check_t<typename Field::prev>::matches(ptd));
+    }
+};
+
+template <>
+struct row_layout_check_t<row_layout_begin_t>
+{
+    static bool matches(table_desc_t*) { return (true); }
+};
+
+template <class Layout>
+inline bool row_layout_matches(table_desc_t* ptd)
+{
+    assert (ptd);
+    if (ptd->field_count() != (uint)Layout::last::INDEX + 1) return (false);
+    return (row_layout_check_t<typename Layout::last>::matches(ptd));
+}
+
+
+
+/* ---------------------------------------------------------------
+ *
+ * @class: typed_pin_t
+ *
+ * @brief: A record of a table pinned in the buffer pool, whose fields
+ *         are read and updated in place through the Layout
+ *
+ * @note:  The pin holds the latch of the page, so it should be
+ *         released (unpin()) before probing for another record. The
+ *         lock taken by the probe stays until the end of the xct,
+ *         hence pin(rid()) gets the record back later on.
+ *
+ * --------------------------------------------------------------- */
+
+template <class Layout>
+class typed_pin_t
+{
+private:
+
+    table_man_t* _pmanager;
+    mutable pin_i _pin;          // body() is not const
+    rid_t        _rid;
+    lock_mode_t  _lm;
+
+    // not to be copied
+    typed_pin_t(const typed_pin_t&);
+    typed_pin_t& operator=(const typed_pin_t&);
+
+public:
+
+    typed_pin_t(table_man_t* pmanager)
+        : _pmanager(pmanager), _rid(rid_t::null), _lm(NL)
+    {
+        assert (_pmanager);
+#ifndef NDEBUG
+        static bool checked = false;
+        if (!checked) {
+            assert (row_layout_matches<Layout>(_pmanager->table()));
+            checked = true;
+        }
+#endif
+    }
+
+    ~typed_pin_t() { unpin(); }
+
+
+    /* --------------------------- */
+    /* --- pinning the record  --- */
+    /* --------------------------- */
+
+    // probes the index with the key fields of ptuple and pins the record
+    w_rc_t probe(ss_m* db,
+                 index_desc_t* pindex,
+                 table_row_t* ptuple,
+                 const lock_mode_t lm = SH,
+                 const lpid_t& root = lpid_t::null)
+    {
+        unpin();
+        W_DO(_pmanager->index_probe_pin(db, pindex, ptuple, _pin, lm, root));
+        _rid = ptuple->rid();
+        _lm = lm;
+        return (RCOK);
+    }
+
+    // pins (again) a record, directly through its rid
+    w_rc_t pin(const rid_t& rid, const lock_mode_t lm = SH)
+    {
+        unpin();
+        W_DO(_pmanager->read_pin(rid, _pin, lm));
+        _rid = rid;
+        _lm = lm;
+        return (RCOK);
+    }
+
+    void unpin() { if (_pin.pinned()) _pin.unpin(); }
+
+    bool  is_pinned() const { return (_pin.pinned()); }
+    rid_t rid() const { return (_rid); }
+
+
+    /* ------------------------ */
+    /* --- get field values --- */
+    /* ------------------------ */
+
+    template <class Field>
+    typename Field::value_type get() const
+    {
+        assert (_pin.pinned());
+        typename Field::value_type v;
+        memcpy(&v, _pin.body() + Field::OFFSET, sizeof(v));
+        return (v);
+    }
+
+    // like table_row_t::get_value() of a string, at most bufsize-1 chars
+    template <class Field>
+    void get(char* destbuf, const uint bufsize) const
+    {
+        assert (_pin.pinned());
+        uint sz = MIN(bufsize-1, (uint)Field::SIZE);
+        memcpy(destbuf, _pin.body() + Field::OFFSET, sz);
+        destbuf[sz] = '\0';
+    }
+
+    // the field on the page, valid while pinned
+    template <class Field>
+    const char* ptr() const
+    {
+        assert (_pin.pinned());
+        return (_pin.body() + Field::OFFSET);
+    }
+
+
+    /* ------------------------------- */
+    /* --- update fields in place  --- */
+    /* ------------------------------- */
+
+    template <class Field>
+    w_rc_t set(const typename Field::value_type& v)
+    {
+        assert (Field::SIZE == sizeof(v));
+        return (_pmanager->update_pinned(_pin, Field::OFFSET,
+                                         &v, sizeof(v), _lm));
+    }
+
+    // fields First to Last, in one update; data in the order of the layout
+    template <class First, class Last>
+    w_rc_t set_span(const void* data)
+    {
+        assert (First::INDEX <= Last::INDEX);
+        return (_pmanager->update_pinned(_pin, First::OFFSET, data, 
+                                         Last::END - First::OFFSET, _lm));
+    }
+
+    // a string field, padded with zeros
+    template <class Field>
+    w_rc_t set(const char* string)
+    {
+        char buf[Field::SIZE];
+        memset(buf, 0, Field::SIZE);
+        strncpy(buf, string, Field::SIZE);
+        return (_pmanager->update_pinned(_pin, Field::OFFSET,
+                                         buf, Field::SIZE, _lm));
+    }
+
+}; // EOF: typed_pin_t
+
+
+
+EXIT_NAMESPACE(shore);
+
+#endif /* __SHORE_ROW_LAYOUT_H */
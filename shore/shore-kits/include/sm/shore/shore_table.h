@@ -143,6 +143,13 @@ protected:
 
     int find_field_by_name(const char* field_name) const;
 
+    // puts a hash index in front of the (primary) index, if possible
+    bool attach_hash_index(index_desc_t* pindex);
+
+    // offset of a fixed-length field in the disk format of a record
+    // of a table without null-able fields
+    uint_t fixed_field_offset(const uint_t ix) const;
+
 public:
 
     /* ------------------- */
@@ -205,6 +212,11 @@ public:
                                    const uint num,
                                    const uint4_t& pd=PD_NORMAL);
 
+    // make an index covering, with the fields as the payload of its entries
+    bool   set_index_payload(const char* name,
+                             const uint* fields,
+                             const uint num);
+
 
 
     /* ------------------------ */
@@ -282,13 +294,31 @@ protected:
 
     guard<ats_char_t> _pts;   /* trash stack */
 
+    bool _defer_indexes;      /* add_tuple() skips the (non-mr) indexes */
+
+    // keeps the payload of the covering indexes up to date, when (sz)
+    // bytes of the record at (offset) are to be replaced by (data)
+    w_rc_t update_covering(ss_m* db,
+                           const rid_t& rid,
+                           const char* body,
+                           const uint offset,
+                           const void* data,
+                           const uint sz,
+                           const bool bIgnoreLocks);
+
+    // one trx of build_index(): inserts up to (batch) records from (start)
+    // and moves (start) past them
+    w_rc_t build_index_batch(ss_m* db, index_desc_t* pindex, 
+                             const int batch, rid_t& start, bool& eof,
+                             uint_t& count);
+
 public:
 
     typedef table_row_t table_tuple; 
 
     table_man_t(table_desc_t* aTableDesc,
 		bool construct_cache=true) 
-        : _ptable(aTableDesc)
+        : _ptable(aTableDesc), _defer_indexes(false)
     {
 	// init tuple cache
         if (construct_cache) {
@@ -434,6 +464,32 @@ public:
 			 latch_mode_t heap_latch_mode = LATCH_SH);
 
 
+    /* ------------------------------------------------------------ */
+    /* --- access to the pinned record, used by typed_pin_t     --- */
+    /* --- (see shore_row_layout.h), no load()/format() of rows --- */
+    /* ------------------------------------------------------------ */
+
+    // idx probe, which leaves the record pinned
+    w_rc_t    index_probe_pin(ss_m* db,
+                              index_desc_t* pidx,
+                              table_tuple*  ptuple,
+                              pin_i& pin,
+                              lock_mode_t lock_mode = SH,
+                              const lpid_t& root = lpid_t::null);
+
+    // pins a record through its rid
+    w_rc_t    read_pin(const rid_t& rid, 
+                       pin_i& pin,
+                       lock_mode_t lock_mode = SH);
+
+    // updates sz bytes of the pinned record, at offset
+    w_rc_t    update_pinned(pin_i& pin,
+                            const uint offset,
+                            const void* data,
+                            const uint sz,
+                            const lock_mode_t lock_mode = EX);
+
+
     
     /* ----------------------------- */
     /* --- formatting operations --- */
@@ -458,6 +514,17 @@ public:
                   index_desc_t* pindex,
                   table_tuple* ptuple);
 
+    // format the element of an index entry: the rid, and the payload
+    // of a covering index (elem has index_desc_t::MAX_ELEM_SIZE bytes)
+    int  format_elem(index_desc_t* pindex,
+                     table_tuple* ptuple,
+                     char* elem);
+
+    // load the rid and the payload from an index element
+    bool load_elem(const char* elem,
+                   index_desc_t* pindex,
+                   table_tuple* ptuple);
+
     // set indexed fields of the row to minimum
     int  min_key(index_desc_t* pindex, 
                  table_tuple* ptuple, 
@@ -512,6 +579,27 @@ public:
     /* fetch the pages of the table and its indexes to buffer pool */
     virtual w_rc_t fetch_table(ss_m* db, lock_mode_t alm = SH); 
 
+    /* refill the hash index of the primary index (if any) from the B-tree */
+    w_rc_t rebuild_hash_index(ss_m* db);
+
+
+    /* -------------------- */
+    /* --- bulk loading --- */
+    /* -------------------- */
+
+    /* While set, add_tuple() only appends to the heap file, and the
+       indexes are filled afterwards from it by build_index(). Not for
+       tables with MRBTrees. */
+    void set_defer_indexes(const bool defer);
+    bool defer_indexes() const { return (_defer_indexes); }
+
+    /* fill an index from the heap file, committing every (batch) records */
+    w_rc_t build_index(ss_m* db, index_desc_t* pindex, const int batch);
+
+    /* build all the deferred indexes of the tables, one thread per index */
+    static w_rc_t build_deferred_indexes(ss_m* db, 
+                                         table_man_t** mans, const int count);
+
 
     /* ---------------------------------------------------------------
      *
@@ -594,6 +682,12 @@ inline int table_desc_t::find_field_by_name(const char* field_name) const
  * @brief: Iterates over all the fields of a selected index and returns 
  *         on a single string the corresponding key description
  *
+ * @note:  If the index is compressed (db-key-compression), the first
+ *         field is marked as compressible (capital letter), which makes
+ *         the SM create the btree with prefix compression. The keys of a
+ *         multi-field index often share long prefixes (e.g. the
+ *         warehouse and district ids).
+ *
  ******************************************************************/
 
 inline char* table_desc_t::index_keydesc(index_desc_t* idx)
@@ -606,6 +700,9 @@ inline char* table_desc_t::index_keydesc(index_desc_t* idx)
     for (uint_t i=0; i<idx->field_count(); i++) {
         strcat(idx->_keydesc, _desc[idx->key_index(i)].keydesc());
     }
+    if (idx->is_compressed()) {
+        idx->_keydesc[0] = toupper(idx->_keydesc[0]);
+    }
     return (idx->_keydesc);
 }
 
@@ -688,6 +785,36 @@ inline uint_t table_desc_t::maxsize()
 
 
 
+/* ---------------------------------------------------------------
+ *
+ * @class: index_builder_t
+ *
+ * @brief: Thread to build a deferred index from the heap file
+ *
+ * --------------------------------------------------------------- */
+
+class index_builder_t : public thread_t
+{
+private:
+
+    ss_m* _db;
+    table_man_t* _pmanager;
+    index_desc_t* _pindex;
+
+    enum { BUILD_BATCH = 10000 }; // index entries per trx
+
+public:
+
+    w_rc_t _rc;
+
+    index_builder_t(ss_m* db, table_man_t* pmanager, index_desc_t* pindex);
+    ~index_builder_t();
+    void work();
+
+}; // EOF: index_builder_t
+
+
+
 /* ---------------------------------------------------------------
  *
  * @class: table_printer_t
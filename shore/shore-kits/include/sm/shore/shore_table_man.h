@@ -301,6 +301,9 @@ public:
  *
  * @brief: Declaration of a index scan iterator
  *
+ * @note:  Unless need_tuple, it does not fetch the records, and only the
+ *         key fields and the payload of a covering index are loaded
+ *
  * --------------------------------------------------------------------- */
 
 
@@ -389,13 +392,14 @@ public:
 
             vec_t    key(tuple._rep->_dest, key_sz);
 
-            rid_t    rid;
-            vec_t    record(&rid, sizeof(rid_t));
+            // the rid, and the payload of a covering index
+            char     elem[index_desc_t::MAX_ELEM_SIZE];
             smsize_t klen = 0;
-            smsize_t elen = sizeof(rid_t);
+            smsize_t elen = index_iter::_file->elem_size();
+            vec_t    record(elem, elen);
 
             W_DO(index_iter::_scan->curr(&key, klen, &record, elen));
-            tuple.set_rid(rid);
+            _pmanager->load_elem(elem, index_iter::_file, &tuple);
             
             _pmanager->load_key((const char*)key.ptr(0), 
                                 index_iter::_file, &tuple);
@@ -403,7 +407,7 @@ public:
 
             if (_need_tuple) {
                 pin_i  pin;
-                W_DO(pin.pin(rid, 0, index_iter::_lm, index_iter::_file->is_latchless()));
+                W_DO(pin.pin(tuple.rid(), 0, index_iter::_lm, index_iter::_file->is_latchless()));
                 if (!_pmanager->load(&tuple, pin.body())) {
                     pin.unpin();
                     return RC(se_WRONG_DISK_DATA);
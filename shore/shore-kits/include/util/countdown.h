@@ -55,6 +55,8 @@ public:
 
 private:
 
+    // the count is kept in the upper bits, so that an error (the low bit)
+    // does not have to clear it and a post is a single atomic add
     enum { CD_ERROR=0x1, CD_NUMBER=0x2 };
     unsigned int volatile _state;
 
@@ -40,6 +40,7 @@
 
 #include "workload/tpcc/tpcc_const.h"
 #include "sm/shore/shore_table_man.h"
+#include "sm/shore/shore_row_layout.h"
 
 using namespace shore;
 
@@ -67,6 +68,139 @@ DECLARE_TABLE_SCHEMA_PD(new_order_t);
 DECLARE_TABLE_SCHEMA_PD(item_t);
 
 
+
+/* -------------------------------------------------- */
+/* --- Compile-time layouts of the records, for   --- */
+/* --- typed_pin_t. They must follow the schemas  --- */
+/* --- in shore_tpcc_schema.cpp field by field.   --- */
+/* -------------------------------------------------- */
+
+struct warehouse_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> W_ID;
+    typedef row_field_t<W_ID,      char, 10>     W_NAME;
+    typedef row_field_t<W_NAME,    char, 20>     W_STREET1;
+    typedef row_field_t<W_STREET1, char, 20>     W_STREET2;
+    typedef row_field_t<W_STREET2, char, 20>     W_CITY;
+    typedef row_field_t<W_CITY,    char, 2>      W_STATE;
+    typedef row_field_t<W_STATE,   char, 9>      W_ZIP;
+    typedef row_field_t<W_ZIP,     double>       W_TAX;
+    typedef row_field_t<W_TAX,     double>       W_YTD;
+    typedef W_YTD last;
+};
+
+struct district_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> D_ID;
+    typedef row_field_t<D_ID,      int>          D_W_ID;
+    typedef row_field_t<D_W_ID,    char, 10>     D_NAME;
+    typedef row_field_t<D_NAME,    char, 20>     D_STREET1;
+    typedef row_field_t<D_STREET1, char, 20>     D_STREET2;
+    typedef row_field_t<D_STREET2, char, 20>     D_CITY;
+    typedef row_field_t<D_CITY,    char, 2>      D_STATE;
+    typedef row_field_t<D_STATE,   char, 9>      D_ZIP;
+    typedef row_field_t<D_ZIP,     double>       D_TAX;
+    typedef row_field_t<D_TAX,     double>       D_YTD;
+    typedef row_field_t<D_YTD,     int>          D_NEXT_O_ID;
+    typedef D_NEXT_O_ID last;
+};
+
+struct customer_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int>   C_ID;
+    typedef row_field_t<C_ID,           int>       C_D_ID;
+    typedef row_field_t<C_D_ID,         int>       C_W_ID;
+    typedef row_field_t<C_W_ID,         char, 16>  C_FIRST;
+    typedef row_field_t<C_FIRST,        char, 2>   C_MIDDLE;
+    typedef row_field_t<C_MIDDLE,       char, 16>  C_LAST;
+    typedef row_field_t<C_LAST,         char, 20>  C_STREET1;
+    typedef row_field_t<C_STREET1,      char, 20>  C_STREET2;
+    typedef row_field_t<C_STREET2,      char, 20>  C_CITY;
+    typedef row_field_t<C_CITY,         char, 2>   C_STATE;
+    typedef row_field_t<C_STATE,        char, 9>   C_ZIP;
+    typedef row_field_t<C_ZIP,          char, 16>  C_PHONE;
+    typedef row_field_t<C_PHONE,        double>    C_SINCE;
+    typedef row_field_t<C_SINCE,        char, 2>   C_CREDIT;
+    typedef row_field_t<C_CREDIT,       double>    C_CREDIT_LIM;
+    typedef row_field_t<C_CREDIT_LIM,   double>    C_DISCOUNT;
+    typedef row_field_t<C_DISCOUNT,     double>    C_BALANCE;
+    typedef row_field_t<C_BALANCE,      double>    C_YTD_PAYMENT;
+    typedef row_field_t<C_YTD_PAYMENT,  double>    C_LAST_PAYMENT;
+    typedef row_field_t<C_LAST_PAYMENT, int>       C_PAYMENT_CNT;
+    typedef row_field_t<C_PAYMENT_CNT,  char, 250> C_DATA_1;
+    typedef row_field_t<C_DATA_1,       char, 250> C_DATA_2;
+    typedef C_DATA_2 last;
+};
+
+struct order_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> O_ID;
+    typedef row_field_t<O_ID,         int>       O_C_ID;
+    typedef row_field_t<O_C_ID,       int>       O_D_ID;
+    typedef row_field_t<O_D_ID,       int>       O_W_ID;
+    typedef row_field_t<O_W_ID,       double>    O_ENTRY_D;
+    typedef row_field_t<O_ENTRY_D,    int>       O_CARRIER_ID;
+    typedef row_field_t<O_CARRIER_ID, int>       O_OL_CNT;
+    typedef row_field_t<O_OL_CNT,     int>       O_ALL_LOCAL;
+    typedef O_ALL_LOCAL last;
+};
+
+struct order_line_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> OL_O_ID;
+    typedef row_field_t<OL_O_ID,        int>     OL_D_ID;
+    typedef row_field_t<OL_D_ID,        int>     OL_W_ID;
+    typedef row_field_t<OL_W_ID,        int>     OL_NUMBER;
+    typedef row_field_t<OL_NUMBER,      int>     OL_I_ID;
+    typedef row_field_t<OL_I_ID,        int>     OL_SUPPLY_W_ID;
+    typedef row_field_t<OL_SUPPLY_W_ID, double>  OL_DELIVERY_D;
+    typedef row_field_t<OL_DELIVERY_D,  int>     OL_QUANTITY;
+    typedef row_field_t<OL_QUANTITY,    int>     OL_AMOUNT;
+    typedef row_field_t<OL_AMOUNT,      char, 25> OL_DIST_INFO;
+    typedef OL_DIST_INFO last;
+};
+
+struct item_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> I_ID;
+    typedef row_field_t<I_ID,    int>            I_IM_ID;
+    typedef row_field_t<I_IM_ID, char, 24>       I_NAME;
+    typedef row_field_t<I_NAME,  int>            I_PRICE;
+    typedef row_field_t<I_PRICE, char, 50>       I_DATA;
+    typedef I_DATA last;
+};
+
+struct stock_layout 
+{
+    typedef row_field_t<row_layout_begin_t, int> S_I_ID;
+    typedef row_field_t<S_I_ID,       int>       S_W_ID;
+    typedef row_field_t<S_W_ID,       int>       S_REMOTE_CNT;
+    typedef row_field_t<S_REMOTE_CNT, int>       S_QUANTITY;
+    typedef row_field_t<S_QUANTITY,   int>       S_ORDER_CNT;
+    typedef row_field_t<S_ORDER_CNT,  int>       S_YTD;
+    typedef row_field_t<S_YTD,        char, 24>  S_DIST0;  // S_DIST1..9 follow
+    typedef row_field_t<S_DIST0,      char, 24>  S_DIST1;
+    typedef row_field_t<S_DIST1,      char, 24>  S_DIST2;
+    typedef row_field_t<S_DIST2,      char, 24>  S_DIST3;
+    typedef row_field_t<S_DIST3,      char, 24>  S_DIST4;
+    typedef row_field_t<S_DIST4,      char, 24>  S_DIST5;
+    typedef row_field_t<S_DIST5,      char, 24>  S_DIST6;
+    typedef row_field_t<S_DIST6,      char, 24>  S_DIST7;
+    typedef row_field_t<S_DIST7,      char, 24>  S_DIST8;
+    typedef row_field_t<S_DIST8,      char, 24>  S_DIST9;
+    typedef row_field_t<S_DIST9,      char, 50>  S_DATA;
+    typedef S_DATA last;
+};
+
+typedef typed_pin_t<warehouse_layout> warehouse_pin;
+typedef typed_pin_t<district_layout>  district_pin;
+typedef typed_pin_t<customer_layout>  customer_pin;
+typedef typed_pin_t<order_layout>     order_pin;
+typedef typed_pin_t<order_line_layout> order_line_pin;
+typedef typed_pin_t<item_layout>      item_pin;
+typedef typed_pin_t<stock_layout>     stock_pin;
+
+
 EXIT_NAMESPACE(tpcc);
 
 #endif // __SHORE_TPCC_SCHEMA_H
@@ -84,6 +84,13 @@ public:
                             warehouse_tuple* ptuple,
                             const double h_amount);
     
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t wh_index_pin(ss_m* db,
+                        warehouse_pin& pin,
+                        warehouse_tuple* ptuple,
+                        const int w_id,
+                        lock_mode_t lm = SH);
+
 }; // EOF: warehouse_man_impl
 
 
@@ -137,6 +144,14 @@ public:
                                     district_tuple* ptuple,
                                     const int  next_o_id);
 
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t dist_index_pin(ss_m* db,
+                          district_pin& pin,
+                          district_tuple* ptuple,
+                          const int w_id,
+                          const int d_id,
+                          lock_mode_t lm = SH);
+
 }; // EOF: district_man_impl
 
 
@@ -229,6 +244,20 @@ public:
                                            const decimal discount,
                                            const decimal balance);
 
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t cust_index_pin(ss_m* db,
+                          customer_pin& pin,
+                          customer_tuple* ptuple,
+                          const int w_id,
+                          const int d_id,
+                          const int c_id,
+                          lock_mode_t lm = SH);
+
+    w_rc_t cust_update_tuple(customer_pin& pin,
+                             const tpcc_customer_tuple& acustomer,
+                             const char* adata1,
+                             const char* adata2);
+
 }; // EOF: customer_man_impl
 
 
@@ -350,6 +379,12 @@ public:
                                           order_tuple* ptuple,
                                           const int carrier_id);
 
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t ord_update_carrier_by_index(ss_m* db,
+                                       order_pin& pin,
+                                       order_tuple* ptuple,
+                                       const int carrier_id);
+
 }; // EOF: order_man_impl
 
 
@@ -450,6 +485,13 @@ public:
                              item_tuple* ptuple,
                              const int i_id);
 
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t it_index_pin(ss_m* db, 
+                        item_pin& pin,
+                        item_tuple* ptuple,
+                        const int i_id,
+                        lock_mode_t lm = SH);
+
 }; // EOF: item_man_impl
 
 
@@ -497,6 +539,17 @@ public:
                               stock_tuple* ptuple,
                               const tpcc_stock_tuple* pstock);
 
+    // --- typed access, pins the tuple (see shore_row_layout.h) --- //
+    w_rc_t st_index_pin(ss_m* db,
+                        stock_pin& pin,
+                        stock_tuple* ptuple,
+                        const int w_id,
+                        const int i_id,
+                        lock_mode_t lm = SH);
+
+    w_rc_t st_update_tuple(stock_pin& pin,
+                           const tpcc_stock_tuple* pstock);
+
 }; // EOF: stock_man_impl
 
 
@@ -95,7 +95,10 @@
 
 ENTER_NAMESPACE(dbgentpch);
 
-extern int dbgen_init();
+extern int dbgen_init(const double sf);
+extern void init_text_pool();
+extern void init_build();
+extern void free_asc_date();
 
 
 #define  NONE		-1
@@ -243,6 +246,8 @@ DSS_HUGE	UnifInt PROTO((DSS_HUGE nLow, DSS_HUGE nHigh, long nStream));
 void	dss_random(DSS_HUGE *tgt, DSS_HUGE min, DSS_HUGE max, long seed);
 void	row_start(int t);
 void	row_stop(int t);
+void	row_seek(int t, DSS_HUGE n);
+void	seed_reset();
 void	dump_seeds(int t);
 
 /* text.c */
@@ -65,7 +65,13 @@ double   dM = 2147483647.0;
  * preferred solution, but not initializing correctly
  */
 #define VSTR_MAX(len)	(long)(len / 5 + (len % 5 == 0)?0:1 + 1)
-seed_t     Seed[MAX_STREAM + 1] =
+
+/*
+ * Each thread that generates rows has its own streams (Seed), which
+ * start from these values (see seed_reset() and row_seek()), so that
+ * loaders can generate their chunks concurrently
+ */
+const seed_t     Seed0[MAX_STREAM + 1] =
 {
     {PART,   1,          0,	1},					/* P_MFG_SD     0 */
     {PART,   46831694,   0, 1},					/* P_BRND_SD    1 */
@@ -117,6 +123,8 @@ seed_t     Seed[MAX_STREAM + 1] =
     {SUPP,   715851524,  0, 1}       /* BBB junk     47 */
 };
 
+__thread seed_t     Seed[MAX_STREAM + 1];
+
 
 EXIT_NAMESPACE(dbgentpch);
 
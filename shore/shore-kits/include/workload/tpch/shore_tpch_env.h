@@ -69,6 +69,7 @@ const double TPCH_SCALING_FACTOR = 1;
 // For the population
 const long CUST_POP_UNIT = 10;
 const long PART_POP_UNIT = 10;
+const long BULK_POP_UNIT = 100; // when the indexes are deferred
 
 /* ---------------------------------------------------------------
  *
@@ -0,0 +1,83 @@
+#!/bin/bash
+#
+# @file:  db-snapshot.sh
+#
+# @brief: Keeps a clean copy of a database and restores it for a run
+#         without copying the whole volume
+#
+# db-snapshot.sh create <db> <snapshot>
+#   Copies the database <db> (which has to be closed cleanly, so that it
+#   does not need its log) to the read-only <snapshot>.
+#
+# db-snapshot.sh restore <snapshot> <db>
+#   Makes <db> a copy of <snapshot> that can be written, in the cheapest
+#   way the file system allows:
+#   - a reflink (FICLONE) copy, which shares the blocks until written
+#     (btrfs, xfs, ...),
+#   - otherwise an empty sparse <db> of the size of the snapshot, with a
+#     <db>.base symlink to it. Shore-MT then opens <db> as an overlay:
+#     pages never written are read from the snapshot, written ones go to
+#     <db> (see sdisk_overlay.h). Needs SEEK_HOLE (ext4, xfs, tmpfs, ...).
+#
+# db-snapshot.sh drop <db>
+#   Deletes a restored <db> (and its <db>.base link, if any).
+
+usage()
+{
+    echo "Usage: $0 create <db> <snapshot>"
+    echo "       $0 restore <snapshot> <db>"
+    echo "       $0 drop <db>"
+    exit 127
+}
+
+now_ms()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+if [ $# -lt 2 ]; then
+    usage
+fi
+
+case "$1" in
+create)
+    [ $# -eq 3 ] || usage
+    db="$2"
+    snap="$3"
+    echo "+ Snapshot of ($db) to ($snap)"
+    rm -f "$snap"
+    cp --sparse=always "$db" "$snap" || exit 1
+    chmod a-w "$snap"
+    ;;
+
+restore)
+    [ $# -eq 3 ] || usage
+    snap=$(readlink -f "$2")
+    db="$3"
+    if [ ! -f "$snap" ]; then
+        echo "No snapshot ($snap)"
+        exit 1
+    fi
+    start=$(now_ms)
+    rm -f "$db" "$db.base"
+    if cp --reflink=always "$snap" "$db" 2>/dev/null; then
+        how="reflink"
+    else
+        rm -f "$db"
+        truncate -s $(stat -c %s "$snap") "$db" && \
+            ln -s "$snap" "$db.base" || exit 1
+        how="overlay"
+    fi
+    chmod 644 "$db"
+    echo "+ Restored ($db) from ($snap) as $how in $(( $(now_ms) - start )) ms"
+    ;;
+
+drop)
+    [ $# -eq 2 ] || usage
+    rm -f "$2" "$2.base"
+    ;;
+
+*)
+    usage
+    ;;
+esac
@@ -213,13 +213,14 @@ void part_table_t::statistics() const
 
     worker_stats_t ws_gathered;
     uint stl_sz = 0;
+    uint stl_slots = 0;
 
     for (BPPMapCIt it=_bppmap.begin(); it != _bppmap.end(); it++) {
         // gather worker statistics
         (*it).second->statistics(ws_gathered);
 
         // gather dora-related structures statistics
-        (*it).second->stlsize(stl_sz);
+        (*it).second->stlsize(stl_sz,stl_slots);
     }
 
     if (ws_gathered._processed > MINIMUM_PROCESSED) {
@@ -228,7 +229,8 @@ void part_table_t::statistics() const
         // print worker stats
         ws_gathered.print_and_reset();
         // print dora stl stats
-        TRACE( TRACE_STATISTICS, "stl.entries (%d)\n", stl_sz);
+        TRACE( TRACE_STATISTICS, "stl.entries (%d) stl.slots (%d)\n", 
+               stl_sz, stl_slots);
     }
 }        
 
@@ -197,12 +197,13 @@ terminal_rvp_t::~terminal_rvp_t()
  *
  * @brief: Notifies for any committed actions
  *
+ * @note:  The actions of the partition whose owner runs the rvp do not
+ *         go through its committed queue (see partition_t::enqueue_commit)
+ *
  ******************************************************************/
 
 int terminal_rvp_t::notify_partitions()
 {
-#warning (IP) Perf. optimization --> Do not enqueue_committed your own action!
-
     for (baseActionsIt it=_actions.begin(); it!=_actions.end(); ++it) {
         (*it)->notify_own_partition();
     }
@@ -304,13 +304,18 @@ w_rc_t r_ord_ordst_action::trx_exec()
      * plan: index scan on "O_CUST_IDX"
      */
     
+    // if covering, O_CUST_IDX carries all the fields read below
+    bool need_tuple = 
+        !_penv->order_man()->table()->find_index("O_CUST_IDX")->is_covering();
+
     guard<index_scan_iter_impl<order_t> > o_iter;
     {
 	index_scan_iter_impl<order_t>* tmp_o_iter;
 	TRACE(TRACE_TRX_FLOW,"App: %d ORDST:ord-iter-by-idx-nl\n",_tid.get_lo());
 	W_DO(_penv->order_man()->ord_get_iter_by_index_nl(_penv->db(), tmp_o_iter,
 							  prord, lowrep, highrep,
-							  w_id, d_id, c_id));
+							  w_id, d_id, c_id,
+							  need_tuple));
 	o_iter = tmp_o_iter;
     }
     
@@ -0,0 +1,174 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   memory_broker.cpp
+ *
+ *  @brief:  Implementation of the memory broker of the QPipe stages
+ *
+ */
+
+#include "util/thread.h"
+#include "util/sync.h"
+#include "qpipe/core/tuple.h"
+#include "qpipe/core/memory_broker.h"
+
+
+ENTER_NAMESPACE(qpipe);
+
+
+memory_broker_t memory_broker_t::_instance;
+
+
+
+/* The peak resident set of the process, in KB, since the last
+   reset_peak_rss(). 0 if the OS does not tell. */
+static long peak_rss_kb()
+{
+    long kb = 0;
+#if defined(linux) || defined(__linux)
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return (0);
+    char line[128];
+    while (fgets(line, sizeof(line), status)) {
+        if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+    }
+    fclose(status);
+#endif
+    return (kb);
+}
+
+static void reset_peak_rss()
+{
+#if defined(linux) || defined(__linux)
+    // since 4.0, older kernels ignore it
+    FILE* refs = fopen("/proc/self/clear_refs", "w");
+    if (!refs) return;
+    fputs("5", refs);
+    fclose(refs);
+#endif
+}
+
+
+memory_broker_t::memory_broker_t()
+    : _lock(thread_mutex_create()),
+      _budget(0), _granted(0), _holders(0)
+{
+    clear_stats();
+}
+
+
+void memory_broker_t::set_budget(const size_t pages)
+{
+    critical_section_t cs(_lock);
+    _budget = pages;
+}
+
+
+
+/******************************************************************** 
+ *
+ *  @fn:     acquire
+ *
+ *  @brief:  Grants between min and want pages, depending on how many
+ *           other stages hold memory and how much of the budget is
+ *           free. Never blocks (see memory_broker_t).
+ *
+ *  @return: The number of pages granted, at least min
+ *
+ ********************************************************************/
+
+size_t memory_broker_t::acquire(const size_t want, const size_t min)
+{
+    assert (min > 0);
+    size_t request = (want < min) ? min : want;
+
+    critical_section_t cs(_lock);
+    size_t pages = request;
+    if (_budget) {
+        size_t share = _budget/(_holders+1);
+        size_t free = (_granted < _budget) ? _budget - _granted : 0;
+        if (pages > share) pages = share;
+        if (pages > free) pages = free;
+        if (pages < min) {
+            pages = min;
+            if (_granted + pages > _budget) _overcommits++;
+        }
+    }
+
+    _granted += pages;
+    _holders++;
+    _grants++;
+    if (pages < request) _short_grants++;
+    if (_granted > _peak) _peak = _granted;
+
+    TRACE( TRACE_DEBUG, "Granted (%zd/%zd) pages, (%zd) in use by (%d)\n",
+           pages, request, _granted, _holders);
+    return (pages);
+}
+
+
+void memory_broker_t::release(const size_t pages)
+{
+    critical_section_t cs(_lock);
+    assert (_holders > 0);
+    assert (_granted >= pages);
+    _granted -= pages;
+    _holders--;
+}
+
+
+void memory_broker_t::note_spill()
+{
+    critical_section_t cs(_lock);
+    _spills++;
+}
+
+
+void memory_broker_t::clear_stats()
+{
+    critical_section_t cs(_lock);
+    _peak = _granted;
+    _grants = 0;
+    _short_grants = 0;
+    _overcommits = 0;
+    _spills = 0;
+    reset_peak_rss();
+}
+
+
+/**
+ * @brief Dump stats using TRACE.
+ */
+void memory_broker_t::trace_stats()
+{
+    critical_section_t cs(_lock);
+    double mb = get_default_page_size()/(1024.0*1024.0);
+    TRACE( TRACE_ALWAYS, "Stage memory: budget (%.1f MB) peak (%.1f MB)\n",
+           _budget*mb, _peak*mb);
+    TRACE( TRACE_ALWAYS, "Grants (%zd) short (%zd) over budget (%zd) spills (%zd)\n",
+           _grants, _short_grants, _overcommits, _spills);
+    TRACE( TRACE_ALWAYS, "Peak RSS (%.1f MB)\n", peak_rss_kb()/1024.0);
+}
+
+
+EXIT_NAMESPACE(qpipe);
@@ -28,6 +28,9 @@
  *  @bug None known.
  */
 
+#include <cstdio>
+#include <dirent.h>
+
 #include "util.h"
 #include "qpipe/scheduler/cpu.h"
 #include "qpipe/scheduler/cpu_struct.h"
@@ -102,4 +105,40 @@ int  cpu_get_unique_id(cpu_t cpu) {
   return cpu->cpu_unique_id;
 }
 
+
+
+/**
+ *  @brief Return the NUMA node (memory locality group) of the
+ *  specified CPU, or 0 if it cannot be told.
+ *
+ *  @param cpu The cpu.
+ */
+int cpu_get_node(cpu_t cpu)
+{
+#ifdef FOUND_LINUX
+  /* detected GNU Linux */
+  /* The directory of each CPU in sysfs has a nodeN link to its node */
+  c_str cpu_dir("/sys/devices/system/cpu/cpu%d", cpu->cpu_unique_id);
+  DIR* dir = opendir(cpu_dir.data());
+  if (dir == NULL)
+      return 0;
+
+  int node = 0;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+      if (sscanf(entry->d_name, "node%d", &node) == 1)
+          break;
+      node = 0;
+  }
+  closedir(dir);
+  return node;
+
+#else
+//#ifdef FOUND_SOLARIS
+  /* Sun Solaris */
+  /* TODO: lgroups */
+  return 0;
+#endif
+}
+
 EXIT_NAMESPACE(qpipe);
@@ -44,8 +44,10 @@ const c_str hash_aggregate_stage_t::DEFAULT_STAGE_NAME = "HASH_AGGREGATE_STAGE";
 
 
 
-// the maximum number of pages allowed in a single run
+// the most pages a pass asks the memory broker for, and the least
+// it can work with
 static const size_t MAX_RUN_PAGES = 10000;
+static const size_t MIN_RUN_PAGES = 2*hash_aggregate_stage_t::SPILL_PARTITIONS;
 
 
 
@@ -102,10 +104,68 @@ typedef hashtable<char *, const char *,
 		  equalbytes_t, alloc_t> tuple_hash_t;
 
 
+/* The input of a pass: the input buffer of the packet, or a partition
+   that an earlier pass spilled to disk. */
+struct hash_aggregate_stage_t::input_t {
+    tuple_fifo* _buffer;
+    FILE* _file;
+    guard<qpipe::page> _page;
+    qpipe::page::iterator _it;
+
+    input_t(tuple_fifo* buffer)
+        : _buffer(buffer), _file(NULL)
+    {
+    }
+
+    input_t(FILE* file, size_t tuple_size)
+        : _buffer(NULL), _file(file), _page(qpipe::page::alloc(tuple_size))
+    {
+        _it = _page->end();
+    }
+
+    bool get_tuple(tuple_t &tuple) {
+        if(_buffer)
+            return _buffer->get_tuple(tuple);
+        while(_it == _page->end()) {
+            if(!_page->fread_full_page(_file))
+                return false;
+            _it = _page->begin();
+        }
+        tuple = _it.advance();
+        return true;
+    }
+};
+
+
+struct spill_partition_t {
+    c_str _file_name;
+    FILE* _file;
+    qpipe::page* _page;
+
+    spill_partition_t()
+        : _file(NULL), _page(NULL)
+    {
+    }
+};
+
+
+/* The partition of a spilled key. The hash differs at each level, so
+   that the keys of a partition spread over the partitions of the next
+   pass. */
+static size_t spill_partition(const char* key, size_t key_size, int level) {
+    uint32_t h = fnv_hash(key, key_size);
+    h ^= (level+1)*0x9e3779b9U;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    return h % hash_aggregate_stage_t::SPILL_PARTITIONS;
+}
+
+
 int hash_aggregate_stage_t::alloc_agg(tuple_t &agg, const char* key) {
     // out of space?
     if(!_agg_page || _agg_page->full()) {
-        if(_page_count >= MAX_RUN_PAGES)
+        if(_page_count >= _page_quota)
             return 1;
 
         _agg_page = qpipe::page::alloc(_aggregate->tuple_size());
@@ -126,20 +186,25 @@ int hash_aggregate_stage_t::alloc_agg(tuple_t &agg, const char* key) {
     return 0;
 }
 
-void hash_aggregate_stage_t::process_packet() {
-    hash_aggregate_packet_t* packet;
-    packet = (hash_aggregate_packet_t*) _adaptor->get_packet();
-    tuple_fifo* input_buffer = packet->_input_buffer;
-    dispatcher_t::dispatch_packet(packet->_input);
-    _aggregate = packet->_aggregate;
+
+
+/**
+ * @brief Aggregates (input) in the granted pages, less the write
+ * pages of the partitions. The tuples of the groups that do not fit
+ * go to the partitions, which are aggregated by passes of their
+ * own. Each pass aggregates at least the groups that fit, so there
+ * are only as many levels as it takes.
+ */
+void hash_aggregate_stage_t::aggregate_pass(hash_aggregate_packet_t* packet,
+                                            input_t &input,
+                                            memory_grant_t &grant,
+                                            const int level)
+{
     key_extractor_t* agg_key = _aggregate->key_extractor();
     key_extractor_t* tup_key = packet->_extractor;
-    //    key_compare_t* compare = packet->_compare;
-    
-    
-    // create a set to hold the sorted run
-    //    tuple_less_t less(agg_key, compare);
     size_t key_size = agg_key->key_size();
+    size_t tuple_size = packet->_input_buffer->tuple_size();
+
     hashfcn_t hf(key_size);
     equalbytes_t eql(key_size);
     extractkey_t ext(agg_key);
@@ -147,54 +212,105 @@ void hash_aggregate_stage_t::process_packet() {
     // start with 10001 buckets
     tuple_hash_t run(10001, hf, eql, ext);
 
-    // read in the tuples and aggregate them in the set
-    while(!input_buffer->eof()) {
-        _page_list.clear();
-        _page_count = 0;
-        _agg_page = NULL;
-        while(_page_count < MAX_RUN_PAGES && !input_buffer->eof()) {
-            guard<qpipe::page> page = NULL;
-            tuple_t in;
-            while(1) {
-                // out of pages?
-                if(!input_buffer->get_tuple(in))
-                   break;
-
-                // search for the key in the hash table
-		char const* key = tup_key->extract_key(in);
-		tuple_hash_t::iterator candidate = run.find(key);
-                if(candidate == run.end()) {
-                    // initialize a blank aggregate tuple
-		    tuple_t agg;
-                    if(alloc_agg(agg, key))
-                        break;
-                    
-                    // insert the new aggregate tuple
-                    candidate = run.insert_unique(agg.data).first;
+    _page_list.clear();
+    _page_count = 0;
+    _page_quota = grant.pages() - SPILL_PARTITIONS;
+    _agg_page = NULL;
+
+    std::vector<spill_partition_t> partitions;
+
+    // read in the tuples and aggregate them in the table
+    tuple_t in;
+    while(input.get_tuple(in)) {
+
+        // search for the key in the hash table
+        char const* key = tup_key->extract_key(in);
+        tuple_hash_t::iterator candidate = run.find(key);
+        if(candidate == run.end()) {
+            // initialize a blank aggregate tuple
+            tuple_t agg;
+            if(alloc_agg(agg, key)) {
+                // no room for the group, it goes to disk
+                if(partitions.empty()) {
+                    TRACE(TRACE_DEBUG, "Spilling at level %d after %zd pages\n",
+                          level, _page_count);
+                    memory_broker_t::instance()->note_spill();
+                    partitions.resize(SPILL_PARTITIONS);
                 }
-                else {
-                    TRACE(TRACE_DEBUG, "Merging a tuple\n");
+                spill_partition_t &p =
+                    partitions[spill_partition(key, key_size, level)];
+                if(!p._page) {
+                    p._file = create_tmp_file(p._file_name, "agg-partition");
+                    p._page = qpipe::page::alloc(tuple_size);
                 }
-
-                // update an existing aggregate tuple (which may have
-                // just barely been inserted)
-                _aggregate->aggregate(*candidate, in);
+                if(p._page->full()) {
+                    p._page->fwrite_full_page(p._file);
+                    p._page->clear();
+                }
+                p._page->append_tuple(in);
+                continue;
             }
+                    
+            // insert the new aggregate tuple
+            candidate = run.insert_unique(agg.data).first;
         }
-
-        // TODO: handle cases where the run doesn't fit in memory
-        assert(input_buffer->eof());
-
-        // write out the result
-        size_t out_size = packet->_output_filter->input_tuple_size();
-        array_guard_t<char> out_data = new char[out_size];
-        tuple_t out(out_data, out_size);
-        for(tuple_hash_t::iterator it=run.begin(); it != run.end(); ++it) {
-            // convert the aggregate tuple to an output tuple
-            _aggregate->finish(out, *it);
-            _adaptor->output(out);
+        else {
+            TRACE(TRACE_DEBUG, "Merging a tuple\n");
         }
+
+        // update an existing aggregate tuple (which may have
+        // just barely been inserted)
+        _aggregate->aggregate(*candidate, in);
+    }
+
+    // write out the result
+    size_t out_size = packet->_output_filter->input_tuple_size();
+    array_guard_t<char> out_data = new char[out_size];
+    tuple_t out(out_data, out_size);
+    for(tuple_hash_t::iterator it=run.begin(); it != run.end(); ++it) {
+        // convert the aggregate tuple to an output tuple
+        _aggregate->finish(out, *it);
+        _adaptor->output(out);
+    }
+    run.clear();
+    _page_list.clear();
+
+    // and the groups that did not fit
+    for(size_t i=0; i < partitions.size(); i++) {
+        spill_partition_t &p = partitions[i];
+        if(!p._page)
+            continue;
+        
+        guard<qpipe::page> last = p._page;
+        if(!last->empty())
+            last->fwrite_full_page(p._file);
+        last.done();
+        fclose(p._file);
+
+        file_guard_t file = fopen(p._file_name.data(), "r");
+        if(!file)
+            THROW2(FileException, "Unable to reopen %s", p._file_name.data());
+
+        // the share may have changed since the last pass
+        grant.renew();
+        input_t partition(file, tuple_size);
+        aggregate_pass(packet, partition, grant, level+1);
+
+        file.done();
+        if(remove(p._file_name.data()))
+            TRACE(TRACE_ALWAYS, "Unable to remove temp file %s", p._file_name.data());
     }
 }
 
 
+void hash_aggregate_stage_t::process_packet() {
+    hash_aggregate_packet_t* packet;
+    packet = (hash_aggregate_packet_t*) _adaptor->get_packet();
+    tuple_fifo* input_buffer = packet->_input_buffer;
+    dispatcher_t::dispatch_packet(packet->_input);
+    _aggregate = packet->_aggregate;
+
+    memory_grant_t grant(MAX_RUN_PAGES, MIN_RUN_PAGES);
+    input_t input(input_buffer);
+    aggregate_pass(packet, input, grant, 0);
+}
@@ -22,21 +22,16 @@
 */
 
 #include "qpipe/stages/sort.h"
-#include "qpipe/stages/merge.h"
-#include "qpipe/stages/fdump.h"
-#include "qpipe/stages/fscan.h"
 
 #include <algorithm>
 #include <string>
 #include <cstdlib>
-#include <deque>
-#include <map>
 #include <list>
+#include <vector>
 
 using std::string;
-using std::deque;
-using std::map;
 using std::list;
+using std::vector;
 
 
 
@@ -47,10 +42,15 @@ const c_str sort_packet_t::PACKET_TYPE = "SORT";
 
 const c_str sort_stage_t::DEFAULT_STAGE_NAME = "SORT_STAGE";
 
+// the least number of runs merged at a time
 const unsigned int sort_stage_t::MERGE_FACTOR = 8;
 
+// the most pages of a run, if the memory broker allows
 const unsigned int sort_stage_t::PAGES_PER_INITIAL_SORTED_RUN = 8 * 1024;
 
+// (hint, pointer) pairs that fit in the L2 with room to spare
+const unsigned int sort_stage_t::CACHE_RUN_TUPLES = 16 * 1024;
+
 
 
 static void flush_page(qpipe::page* pg, FILE* file);
@@ -58,325 +58,180 @@ static void flush_page(qpipe::page* pg, FILE* file);
 
 
 /**
- *  @brief At any point in our merge sort, we have a set of "runs"
- *  (sorted output files) and a set of active merge operations. This
- *  function checks the set of active merges to see if any of them
- *  have completed. If so, we promote the resulting sorted file to the
- *  "run set".
+ *  @brief Reads back a sorted run, one page at a time.
  */
-void sort_stage_t::check_finished_merges() {
+struct sort_stage_t::run_reader_t {
 
-    
-    /* The merge operations required to complete the sort form a
-       tree. The lowest level (0) The _merge_map contains one entry
-       per level in the merge tree.  0 being the lowest) to a
-       merge_list_t (a list of merge operations happening at that
-       level). */
-
-    merge_map_t::iterator level_it = _merge_map.begin();
-    while(level_it != _merge_map.end()) {
-        int level = level_it->first;
-        merge_list_t &merges = level_it->second;
-        merge_list_t::iterator it = merges.begin();
-        while(it != merges.end()) {
-            // finished? 
-            if(it->_signal_buffer->eof()) {
-
-                // move it to the finished run list
-                _run_map[level].push_back(it->_output);
-                TRACE(TRACE_DEBUG, "Added finished merge file %s to _run_map[%d]\n",
-                      it->_output.data(),
-                      level);
-
-                // delete the merge record and any input files it used
-                remove_input_files(it->_inputs);
-                it = merges.erase(it);
-            }
-            else {
-                // next!
-                ++it;
-            }
-        }
+    file_guard_t _file;
+    guard<qpipe::page> _page;
+    qpipe::page::iterator _it;
 
-        // if that was the last merge at this level, remove it
-        merge_map_t::iterator old_level_it = level_it++;
-        if(merges.empty())
-            _merge_map.erase(old_level_it);
+    run_reader_t()
+    {
     }
-}
-
-
-
-void sort_stage_t::start_merge(int new_level, run_list_t& runs, int merge_factor)
-{
 
-    assert(merge_factor > 0);
-    assert(runs.size() >= (unsigned int)merge_factor);
+    void open(const c_str &file_name, size_t tuple_size) {
+        _file = fopen(file_name.data(), "r");
+        if(!_file)
+            THROW2(FileException, "Unable to reopen %s", file_name.data());
+        _page = qpipe::page::alloc(tuple_size);
+        _it = _page->end();
+    }
 
+    // the next tuple of the run, valid until the one after it is read
+    bool next(char* &data) {
+        while(_it == _page->end()) {
+            if(!_page->fread_full_page(_file))
+                return false;
+            _it = _page->begin();
+        }
+        data = _it.advance().data;
+        return true;
+    }
+};
 
-    // allocate a new merge
-    merge_list_t &merges = _merge_map[new_level];
-    merges.resize(merges.size()+1);
-    merge_t &merge = merges.back();
 
+/* the smallest tuple among the heads of the runs being merged is on
+   top of the heap */
+struct merge_head_t {
+    hint_tuple_pair_t _tuple;
+    int _run;
+};
 
-    run_list_t merge_inputs;
-    buffer_list_t fscan_buffers;
+struct merge_head_greater_t {
+    tuple_comparator_t _compare;
 
+    merge_head_greater_t(key_extractor_t* e, key_compare_t *c)
+        : _compare(e, c)
+    {
+    }
 
-    run_list_t::iterator it = runs.begin();
-    for(int i = 0; i < merge_factor; i++) {
+    bool operator()(const merge_head_t &a, const merge_head_t &b) const {
+        return _compare(a._tuple, b._tuple) > 0;
+    }
+};
 
-        // grab one of our runs
-	c_str run_filename = *it;
-        it = runs.erase(it);
-	
-        fscan_packet_t* p;
-        tuple_fifo* buf = new tuple_fifo(_tuple_size);
 
 
-        c_str fscan_packet_id("SORT_FSCAN_PACKET_%d", i);
+/**
+ *  @brief Sorts the key array of a run. The pieces of it that fit in
+ *  the cache are sorted first, and are then merged pairwise. Most of
+ *  the comparisons, and of the tuple keys they look at, then stay in
+ *  the cache, instead of every level of a sort of the whole run
+ *  going through memory.
+ */
+void sort_stage_t::sort_run(hint_vector_t &array) {
 
-        p = new fscan_packet_t(fscan_packet_id,
-			       buf,
-                               new trivial_filter_t(_tuple_size),
-                               run_filename.data());
-        dispatcher_t::dispatch_packet(p);
+    tuple_less_t less(_extract, _compare);
+    size_t count = array.size();
+    hint_vector_t::iterator begin = array.begin();
 
-	merge._inputs.push_back(run_filename.data());
-	fscan_buffers.push_back(buf);
+    for(size_t i=0; i < count; i += CACHE_RUN_TUPLES) {
+        size_t end = std::min(count, (size_t)(i + CACHE_RUN_TUPLES));
+        std::sort(begin + i, begin + end, less);
     }
 
+    for(size_t width=CACHE_RUN_TUPLES; width < count; width *= 2) {
+        for(size_t i=0; i + width < count; i += 2*width) {
+            size_t end = std::min(count, i + 2*width);
+            std::inplace_merge(begin + i, begin + i + width, begin + end, less);
+        }
+    }
+}
 
-    // create a merge packet to consume the fscans
-    merge_packet_t* mp;
-    tuple_fifo* merge_out = new tuple_fifo(_tuple_size);
 
-    TRACE(TRACE_ALWAYS,
-          "Argh! Sending merge packet... This means we need to get serial merges working\n");
-    assert(0);
-    mp = new merge_packet_t("SORT_MERGE_PACKET",
-                            merge_out,
-                            new trivial_filter_t(_tuple_size),
-                            fscan_buffers,
-                            _extract->clone(), _compare->clone());
-    dispatcher_t::dispatch_packet(mp);
 
+/**
+ *  @brief Dumps a sorted run to a new temp file.
+ *
+ *  @return The name of the file
+ */
+c_str sort_stage_t::write_run(hint_vector_t &array, qpipe::page* out_page) {
 
-    // if this is the last merge run, send output to SORT worker
-    // thread, not to an FDUMP
-    if(new_level < 0) {
-        merge._signal_buffer = merge_out;
-        return;
-    }
-    
-    
-    // otherwise, redirect merge to an FDUMP so we create a new run on
-    // disk
-    fdump_packet_t* fp;
-    tuple_fifo* fdump_out;
+    // open a temp file to hold the run
     c_str file_name;
+    guard<FILE> file = create_tmp_file(file_name, "sorted-run");
 
+    // dump the run to file
+    for(hint_vector_t::iterator it=array.begin(); it != array.end(); ++it) {
+        // write the tuple
+        tuple_t out(it->data, _tuple_size);
+        out_page->append_tuple(out);
 
-    // KLUDGE! the fdump stage will reopen the file
-    fclose(create_tmp_file(file_name, "merged-run"));
-    fdump_out = new tuple_fifo(_tuple_size);
-    
-    fp = new fdump_packet_t("SORT_FDUMP_PACKET",
-                            fdump_out,
-                            new trivial_filter_t(merge_out->tuple_size()),
-                            merge_out,
-                            file_name.data(), 
-                            &_monitor);
-    dispatcher_t::dispatch_packet(fp);
+        // flush?
+        if(out_page->full())
+            flush_page(out_page, file);
+    }
 
+    // make sure to pick up the stragglers
+    if(!out_page->empty())
+        flush_page(out_page, file);
 
-    merge._output = file_name;
-    merge._signal_buffer = fdump_out;
+    TRACE(TRACE_DEBUG, "Wrote sorted run %s\n", file_name.data());
+    return (file_name);
 }
 
 
 
 /**
- * @brief searches each level of the merge hierarchy and fires off a
- * new merge whenever there are MERGE_FACTOR finished runs.
+ *  @brief Merges the first (count) runs of _runs, and removes
+ *  them. The result goes to the file (out), or to the output of the
+ *  stage if (out) is NULL.
  */
-void sort_stage_t::start_new_merges() {
-
-    
-    TRACE(TRACE_DEBUG, "_run_map has size %zd\n",
-	  _run_map.size());
-    
-
-    // start up as many new runs as possible
-    run_map_t::iterator level_it = _run_map.begin();
-    while(level_it != _run_map.end()) {
-
-	int level = level_it->first;
-	TRACE(TRACE_DEBUG, "Running on level %d\n", level);
-
-        
-        run_list_t &runs = level_it->second;
-        bool started_merges = false;
-	while(runs.size() >= MERGE_FACTOR) {
-	    // "normal" k-way merges
-            start_merge(level+1, runs, MERGE_FACTOR);
-            started_merges = true;
+void sort_stage_t::merge_runs(size_t count, FILE* out, qpipe::page* out_page) {
+
+    assert(count <= _runs.size());
+
+    run_list_t inputs;
+    run_list_t::iterator last = _runs.begin();
+    std::advance(last, count);
+    inputs.splice(inputs.end(), _runs, _runs.begin(), last);
+
+    // the first tuple of each run
+    array_guard_t<run_reader_t> readers = new run_reader_t[count];
+    vector<merge_head_t> heap;
+    heap.reserve(count);
+    merge_head_greater_t greater(_extract, _compare);
+    int run = 0;
+    for(run_list_t::iterator it=inputs.begin(); it != inputs.end(); ++it, ++run) {
+        readers[run].open(*it, _tuple_size);
+        merge_head_t head;
+        head._run = run;
+        if(readers[run].next(head._tuple.data)) {
+            head._tuple.hint = _extract->extract_hint(head._tuple.data);
+            heap.push_back(head);
         }
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
 
-        // increment the iterator. rename for clarity
-        run_map_t::iterator curr_level_it = level_it++;
-        run_map_t::iterator next_level_it = level_it;
-
-	TRACE(TRACE_DEBUG, "curr_level = %d ; next_level = %d\n",
-	      curr_level_it->first,
-	      next_level_it->first);
-        
+    tuple_t tuple(NULL, _tuple_size);
+    while(!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        merge_head_t &head = heap.back();
 
-        // If we have no runs on this level, erase this level's
-        // _run_map entry. Now a level has no runs if no mapping
-        // exists, not if a mapping exists to a set of size 0.
-        if(runs.empty()) {
-            _run_map.erase(curr_level_it);
-            continue;
+        // the tuple is copied out before its reader moves on
+        tuple.data = head._tuple.data;
+        if(out) {
+            out_page->append_tuple(tuple);
+            if(out_page->full())
+                flush_page(out_page, out);
         }
+        else
+            _adaptor->output(tuple);
         
-        // special case -- if sorting has finished, we can't
-        // necessarily wait for MERGE_FACTOR runs to arrive (they may
-        // never come)
-        if(!_sorting_finished || started_merges)
-            continue;
-
-
-	// Try to find (materialized) runs above this
-        // level. 'next_level_it' is set to -1 if no runs exist.
-        // Otherwise, it is set to the lowest level (above us) with
-        // such runs available.
-        int next_run_level =
-	    (next_level_it == _run_map.end()) ? -1 : next_level_it->first;
-
-	
-        // Try to find in-progress merges at or below this
-        // level. 'lowest_merge_level' is set to -1 if no merges are
-        // found. Otherwise, it is set to the lowest level where a
-        // merge is taking place.
-        merge_map_t::iterator merges = _merge_map.begin();
-        int lowest_merge_level = (merges == _merge_map.end())? -1 : merges->first;
-
-
-	TRACE(TRACE_DEBUG, "lowest_merge_level = %d ; next_run_level = %d\n",
-	      lowest_merge_level,
-	      next_run_level);
-
-	
-        // We reduce system I/O when we merge small files together
-        // before moving them up the merge hierarchy.
-
-
-        int next_size, next_level;
-	if ((lowest_merge_level >= 0) && (lowest_merge_level <= level)) {
-	    // There are merges happening below us. Wait for them to
-	    // finish. We really want to merge with the result of
-	    // every merge below before shipping work to higher levels
-	    // of merge hierarchy.
-	    continue;
-	}
-	else if ((lowest_merge_level < 0) && (next_run_level < 0)) {
-	    // No merges taking place in the system and no runs above
-	    // us. Submit one final merge request. start_merge()
-	    // should redirect output to the SORT worker thread and
-	    // optimize for the single-merge case.
-	    start_merge(-1, runs, runs.size());
-	    _run_map.erase(curr_level_it);
-	    continue;
-	}
-	else if (next_run_level < 0) {
-	    // No runs above us, but there are merges taking place!
-	    // Move up to the output level of the lowest merge.
-	    next_level = lowest_merge_level;
-	    next_size  = merges->second.size();
-	}
-        else if (lowest_merge_level < 0) {
-            // No merges taking place, but there are runs above us
-            next_level = next_run_level;
-            next_size  = next_level_it->second.size();
-        }
-        else if(lowest_merge_level > next_run_level) {
-            // only runs at the next level
-            next_level = next_run_level;
-            next_size  = next_level_it->second.size();
-        }
-        else if(lowest_merge_level < next_run_level) {
-            // only merges at the next level
-            next_level = lowest_merge_level;
-            next_size  = merges->second.size();
-        }
-        else {
-            // both runs and merges at the next level
-            next_level = lowest_merge_level;
-            next_size = merges->second.size() + next_level_it->second.size(); 
-	}
-
-
-	TRACE(TRACE_DEBUG, "next_size = %d ; next_level = %d\n",
-	      next_size,
-	      next_level);
-
-                
-        // promote or partial merge?
-        int required_merges = (next_size + MERGE_FACTOR-1)/MERGE_FACTOR;
-        int potential_merges = (next_size + runs.size() + MERGE_FACTOR-1)/MERGE_FACTOR;
-        if(potential_merges > required_merges) {
-            // partial merge
-            start_merge(next_level, runs, runs.size());
-        }
-        else {
-            // promote up
-            run_list_t &next_runs = _run_map[next_level];
-            next_runs.insert(next_runs.end(), runs.begin(), runs.end());
+        if(readers[head._run].next(head._tuple.data)) {
+            head._tuple.hint = _extract->extract_hint(head._tuple.data);
+            std::push_heap(heap.begin(), heap.end(), greater);
         }
-
-        // no more runs at this level. Erase it so the special case
-        // check works right
-        _run_map.erase(curr_level_it);
+        else
+            heap.pop_back();
     }
-}
-
 
+    if(out && !out_page->empty())
+        flush_page(out_page, out);
 
-/**
- * @brief Executed by a separate thread to manage the hierachical
- * merge. Spends most of its time blocked, so very little overhead --
- * we just need a way to detect asynchronous merge completions and
- * handle them.
- */
-tuple_fifo *sort_stage_t::monitor_merge_packets() {
-    // always in a critical section, but usually blocked on cond_wait
-    critical_section_t cs(_monitor._lock);
-    while(1) {
-        // wait for a merge to finish
-        if(_monitor.wait_holding_lock())
-	{
-	    pthread_exit(NULL);
-#warning "MA: Seems to be working but we have to verify nothing breaks, also changed the next return to pthread_exit"
-	    //return NULL;
-	}
-        // find the finished merge run(s)
-        check_finished_merges();
-
-        // fire off new merges as needed
-        start_new_merges();
-
-        // have we started the final merge? The worker thread will take care of it
-        merge_map_t::iterator merge = _merge_map.begin();
-
-        if(merge != _merge_map.end() && merge->first < 0)
-	{
-	    pthread_exit(&merge->second.front()._signal_buffer);
-	    //return merge->second.front()._signal_buffer;
-	}
-    }
-    return NULL;//Put here to be able to compile
+    readers.done();
+    remove_input_files(inputs);
 }
 
 
@@ -389,15 +244,20 @@ void sort_stage_t::process_packet() {
     _tuple_size = _input_buffer->tuple_size();
     _compare = packet->_compare;
     _extract = packet->_extract;
-    _sorting_finished = false;
 
 
     dispatcher_t::dispatch_packet(packet->_input);
 
+    // runs left behind by a packet that did not finish
+    remove_input_files(_runs);
+
 
     // quick optimization: if no input tuples, simply return
     if(!_input_buffer->ensure_read_ready())
         return;
+
+    // a page for each run merged and one to write with
+    memory_grant_t grant(PAGES_PER_INITIAL_SORTED_RUN + 1, MERGE_FACTOR + 1);
     
     // create a buffer page for writing to file
     guard<qpipe::page> out_page = qpipe::page::alloc(_tuple_size);
@@ -405,28 +265,20 @@ void sort_stage_t::process_packet() {
     // create a key array 
     int capacity =
         qpipe::page::capacity(_input_buffer->page_size(), _tuple_size);
-    int tuple_count = PAGES_PER_INITIAL_SORTED_RUN * capacity;
     hint_vector_t array;
-    array.reserve(tuple_count);
-
-
-
-    // use a monitor thread to control the hierarchical merge
-    thread_t *monitor;
-    monitor = member_func_thread(this,
-                                 &sort_stage_t::monitor_merge_packets,
-                                 "MERGE_MONITOR_THREAD");
-    _monitor_thread = thread_create(monitor);
 
 
     // create sorted runs
     bool first_run = true;
+    bool eof = false;
     do {
         // TODO: check for stage cancellation at regular intervals
         
+        size_t run_pages = grant.pages() - 1;
         page_trash_stack pages;
         array.clear();
-        for(unsigned int i=0; i < PAGES_PER_INITIAL_SORTED_RUN; i++) {
+        array.reserve(run_pages * capacity);
+        for(unsigned int i=0; i < run_pages; i++) {
 
             // read in a run of pages
             qpipe::page* p = qpipe::page::alloc(_input_buffer->tuple_size());
@@ -445,15 +297,13 @@ void sort_stage_t::process_packet() {
             }
         }
 
-        // sort the key array (gotta love the STL!)
-        std::sort(array.begin(), array.end(), tuple_less_t(_extract, _compare));
+        sort_run(array);
 
          // are we done?
-        bool eof = !_input_buffer->ensure_read_ready();
+        eof = !_input_buffer->ensure_read_ready();
 
         // shortcut if we fit in memory...
         if(first_run && eof) {
-            _monitor.cancel();
             tuple_t out(NULL, packet->_output_filter->input_tuple_size());
             for(hint_vector_t::iterator it=array.begin(); it != array.end(); ++it) {
                 out.data = it->data;
@@ -463,55 +313,30 @@ void sort_stage_t::process_packet() {
             return;
         }
 
+        if(first_run)
+            memory_broker_t::instance()->note_spill();
         first_run = false;
         
-        // open a temp file to hold the run
-        c_str file_name;
-        guard<FILE> file = create_tmp_file(file_name, "sorted-run");
-
-        // dump the run to file
-        //        for(int i=0; i < index; i++) {
-        for(hint_vector_t::iterator it=array.begin(); it != array.end(); ++it) {
-            // write the tuple
-            tuple_t out(it->data, _tuple_size);
-            out_page->append_tuple(out);
+        _runs.push_back(write_run(array, out_page));
 
-            // flush?
-            if(out_page->full())
-                flush_page(out_page, file);
-        }
+        // the share may have changed since the last run
+        grant.renew();
 
-        // make sure to pick up the stragglers
-        if(!out_page->empty())
-            flush_page(out_page, file);
-
-        // notify the merge monitor thread that another run is ready
-        critical_section_t cs(_monitor._lock);
-	run_list_t &runs = _run_map[0];
-        runs.push_back(file_name);
-        _sorting_finished = eof;
-        _monitor.notify_holding_lock();
-
-	TRACE(TRACE_DEBUG, "Added file %s to _run_map[0]\n", file_name.data());
-
-    } while(!_sorting_finished);
+    } while(!eof);
     
-    // wait for the output buffer from the final merge to arrive
-    tuple_fifo* merge_output = thread_join<tuple_fifo>(_monitor_thread);
 
-    {
-        critical_section_t cs(_monitor._lock);
-        _monitor_thread = 0;
+    // Merge the oldest runs, as many at a time as there are pages
+    // for, into a new run at the end, until the rest can be merged
+    // straight to the output.
+    while(_runs.size() > grant.pages() - 1) {
+        c_str file_name;
+        guard<FILE> file = create_tmp_file(file_name, "merged-run");
+        merge_runs(grant.pages() - 1, file, out_page);
+        _runs.push_back(file_name);
+        grant.renew();
     }
-    if(merge_output == NULL)
-        THROW1(QPipeException, "Merge failed. Terminating Sort");
-    
 
-    // transfer the output of the last merge to the stage output
-    tuple_t out;
-    while (merge_output->get_tuple(out))
-        _adaptor->output(out);
-    
+    merge_runs(_runs.size(), NULL, out_page);
 }
 
 
@@ -526,40 +351,6 @@ static void flush_page(qpipe::page* pg, FILE* file) {
 
 
 
-int sort_stage_t::print_runs() {
-    run_map_t::iterator level_it = _run_map.begin();
-    for( ; level_it != _run_map.end(); ++level_it) {
-        int level = level_it->first;
-        run_list_t &runs = level_it->second;
-        TRACE(TRACE_ALWAYS, "Level %d (%zd):\n", level, runs.size());
-        run_list_t::iterator it = runs.begin();
-        for( ; it != runs.end(); ++it)
-            TRACE(TRACE_ALWAYS, "\t%s\n", it->data());
-    }
-    return 0;
-}
-
-
-
-int sort_stage_t::print_merges() {
-    merge_map_t::iterator level_it = _merge_map.begin();
-    for( ; level_it != _merge_map.end(); ++level_it) {
-        int level = level_it->first;
-        merge_list_t &merges = level_it->second;
-        TRACE(TRACE_ALWAYS, "Level %d (%zd)\n", level, merges.size());
-        merge_list_t::iterator it = merges.begin();
-        for( ; it != merges.end(); ++it) {
-            TRACE(TRACE_ALWAYS, "\t%s <=\n", it->_output.data());
-            run_list_t::iterator run_it = it->_inputs.begin();
-            for( ; run_it != it->_inputs.end(); ++run_it) 
-                TRACE(TRACE_ALWAYS, "\t\t%s\n", run_it->data());
-        }
-    }
-    return 0;
-}
-
-
-
 void sort_stage_t::remove_input_files(run_list_t& files) {
     // delete the files from disk. The delete will occur as soon as
     // all current file handles are closed
@@ -568,4 +359,5 @@ void sort_stage_t::remove_input_files(run_list_t& files) {
             TRACE(TRACE_ALWAYS, "Unable to remove temp file %s", it->data());
 	TRACE(TRACE_TEMP_FILE, "Removed finished temp file %s\n", it->data());
     }
+    files.clear();
 }
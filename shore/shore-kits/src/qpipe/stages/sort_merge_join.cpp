@@ -40,6 +40,44 @@ const c_str sort_merge_join_stage_t::DEFAULT_STAGE_NAME = "SORT_MERGE_JOIN";
 
 
 
+/**
+ * @brief Joins (left) with the right tuples of its key, those in the
+ * (group) pages and those in the (spill) file, if any.
+ */
+void sort_merge_join_stage_t::join_group(const tuple_t &left,
+                                         qpipe::page* group,
+                                         FILE* spill,
+                                         qpipe::page* spill_page,
+                                         char* data)
+{
+    tuple_t out(data, _join->output_tuple_size());
+    for(qpipe::page* right_page = group; right_page; right_page = right_page->next) {
+        qpipe::page::iterator it = right_page->begin();
+        qpipe::page::iterator end = right_page->end();
+        while (it != end) {
+            tuple_t right_tuple_to_add = it.advance();
+            _join->join(out, left, right_tuple_to_add);
+            _adaptor->output(out);
+        }
+    }
+
+    if(!spill)
+        return;
+
+    rewind(spill);
+    while(spill_page->fread_full_page(spill)) {
+        qpipe::page::iterator it = spill_page->begin();
+        qpipe::page::iterator end = spill_page->end();
+        while (it != end) {
+            tuple_t right_tuple_to_add = it.advance();
+            _join->join(out, left, right_tuple_to_add);
+            _adaptor->output(out);
+        }
+    }
+}
+
+
+
 void sort_merge_join_stage_t::process_packet() {
 
     sort_merge_join_packet_t* packet = (sort_merge_join_packet_t *)_adaptor->get_packet();
@@ -67,6 +105,15 @@ void sort_merge_join_stage_t::process_packet() {
     tuple_t left(NULL, _join->left_tuple_size());
     tuple_t right(NULL, _join->right_tuple_size());
     array_guard_t<char> data = new char[_join->output_tuple_size()];
+
+    // The key of the tuples being joined. The key of a tuple is
+    // copied, since the page of the FIFO that holds it may be reused
+    // as soon as we read on.
+    size_t key_size = _join->key_size();
+    array_guard_t<char> group_key = new char[key_size];
+
+    // The pages for the right tuples of a key
+    memory_grant_t grant(MAX_GROUP_PAGES, 1);
     
     // Get first instances of left and right tuples.
     if (!left_buffer->get_tuple(left))
@@ -104,6 +151,10 @@ void sort_merge_join_stage_t::process_packet() {
                 return;
             right_key = _join->right_key(right);
         }
+
+        // Check again, the right tuple may have gone past the left one.
+        if ((_compare->operator ()(left_key, right_key)) != 0)
+            continue;
         
         // We found a left tuple = a right tuple.
         // Now, we must output the cartesian product of
@@ -118,67 +169,103 @@ void sort_merge_join_stage_t::process_packet() {
         // over the right tuples more than once.
         // As such, we will copy these right tuples to new pages, so that in
         // the end we can iterate through them for every left tuple.
+        // The pages we are not granted go to a temp file.
+        memcpy(group_key, right_key, key_size);
         
         page_pool* pool = malloc_page_pool::instance();
         qpipe::page* right_head_page = qpipe::page::alloc(_join->right_tuple_size(), pool);
         qpipe::page* right_page = right_head_page;
+        right_page->next = NULL;
+        size_t group_pages = 1;
+
+        c_str spill_name;
+        file_guard_t spill;
+        guard<qpipe::page> spill_page;
         
         // Start to find out all right tuples with the same key
         // and store them into the pages.
-        const char* right_key_new = _join->right_key(right);
-        while (memcmp(right_key_new, right_key, _join->key_size()) == 0) {
-            // If page is full, create a new one
-            if (right_page->full()) {
+        bool right_eof = false;
+        const char* right_key_new = right_key;
+        while (memcmp(right_key_new, group_key, key_size) == 0) {
+            // If page is full, create a new one, if we may
+            if (right_page->full() && group_pages < grant.pages()) {
                 qpipe::page* new_page = qpipe::page::alloc(_join->right_tuple_size(), pool);
                 right_page->next = new_page;
                 new_page->next = NULL;
                 right_page = new_page;
+                group_pages++;
             }
             
-            // Add new tuple to page
-            right_page->append_tuple(right);
+            // Add new tuple to page, or to the file if out of pages
+            if (!right_page->full())
+                right_page->append_tuple(right);
+            else {
+                if (!spill) {
+                    TRACE(TRACE_DEBUG, "Spilling a group of more than %zd pages\n",
+                          group_pages);
+                    memory_broker_t::instance()->note_spill();
+                    spill = create_tmp_file(spill_name, "smj-group");
+                    spill_page = qpipe::page::alloc(_join->right_tuple_size(), pool);
+                }
+                if (spill_page->full()) {
+                    spill_page->fwrite_full_page(spill);
+                    spill_page->clear();
+                }
+                spill_page->append_tuple(right);
+            }
             
             // Proceed to next right tuple
-            if (!right_buffer->get_tuple(right))
+            if (!right_buffer->get_tuple(right)) {
+                right_eof = true;
                 break;
+            }
             right_key_new = _join->right_key(right);
         }
+
+        if (spill) {
+            // read it back from the start
+            if (!spill_page->empty())
+                spill_page->fwrite_full_page(spill);
+            spill.done();
+            spill = fopen(spill_name.data(), "r");
+            if (!spill)
+                THROW2(FileException, "Unable to reopen %s", spill_name.data());
+        }
         
         // Now, for every left tuple, iterate all over the right tuples
         // stored in the pages, to output the cartesian product.
         // The iteration stops when we find a left tuple with a different key.
         
+        bool left_eof = false;
         const char* left_key_new = _join->left_key(left);
-        while (memcmp(left_key_new, left_key, _join->key_size()) == 0) {
-            // Start reading the right tuples we stored and join them
-            // with the left tuple.
-            right_page = right_head_page;
-            while (right_page != NULL) {
-                qpipe::page::iterator it = right_page->begin();
-                qpipe::page::iterator end = right_page->end();
-                while (it != end) {
-                    tuple_t right_tuple_to_add = it.advance();
-                    tuple_t out(data, _join->output_tuple_size());
-                    _join->join(out, left, right_tuple_to_add);
-                    _adaptor->output(out);
-                }
-
-                right_page = right_page->next;
-            }
+        while (memcmp(left_key_new, group_key, key_size) == 0) {
+            join_group(left, right_head_page, spill, spill_page, data);
             
             // Proceed to next left tuple
-            if (!left_buffer->get_tuple(left))
+            if (!left_buffer->get_tuple(left)) {
+                left_eof = true;
                 break;
+            }
             left_key_new = _join->left_key(left);
         }
         
-        // Now destroy the pages we created
+        // Now destroy the pages and the file we created
         right_page = right_head_page;
         while (right_page != NULL) {
             qpipe::page* next_right_page = right_page->next;
             right_page->free();
             right_page = next_right_page;
         }
+        if (spill) {
+            spill.done();
+            if (remove(spill_name.data()))
+                TRACE(TRACE_ALWAYS, "Unable to remove temp file %s", spill_name.data());
+        }
+
+        // The tuples we hold now belong to the next key, unless an
+        // input ran out.
+        if (left_eof || right_eof)
+            return;
     }
 
 }
@@ -101,6 +101,40 @@ void client_ready() {
 	pthread_cond_signal(&client_cond);
 }
 
+/********************************************************************* 
+ *
+ *  @fn:    count_response
+ *
+ *  @brief: Counts the responses sent to the tbench harness, and marks
+ *          in the interval stats of the sm (sm_stats_sample_ms) where
+ *          the harness begins and ends its region of interest
+ *
+ *  @note:  The harness takes the same TBENCH_WARMUPREQS and
+ *          TBENCH_MAXREQS from the environment
+ *
+ *********************************************************************/
+
+static uint_t _responses_sent = 0;
+
+static uint_t tbench_reqs(const char* name)
+{
+    const char* v = getenv(name);
+    return (v ? uint_t(strtoul(v, NULL, 0)) : 0);
+}
+
+static void count_response()
+{
+    static const uint_t warmup = tbench_reqs("TBENCH_WARMUPREQS");
+    static const uint_t roi = tbench_reqs("TBENCH_MAXREQS");
+    uint_t sent = atomic_inc_uint_nv(&_responses_sent);
+    if (sent == warmup) {
+        ss_m::stats_sample_mark("roi_begin");
+    } else if (sent == warmup + roi) {
+        ss_m::stats_sample_mark("roi_end");
+    }
+}
+
+
 /********************************************************************* 
  *
  *  @fn:    run_xcts
@@ -160,6 +194,7 @@ w_rc_t base_client_t::run_xcts(int xct_type, int num_xct)
             resp.status = Success; 
 
             tBenchSendResp(reinterpret_cast<const void*>(&resp), sizeof(resp));
+            count_response();
         }
 
         break;
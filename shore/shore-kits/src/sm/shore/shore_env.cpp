@@ -29,7 +29,10 @@
  */
 
 
+#include <unistd.h>
+
 #include "util/confparser.h"
+#include "util/stopwatch.h"
 #include "sm/shore/shore_env.h"
 #include "sm/shore/shore_trx_worker.h"
 #include "sm/shore/shore_flusher.h"
@@ -131,6 +134,16 @@ ShoreEnv::ShoreEnv()
         _pd |= PD_PADDED;
     }
 
+    // Hash indexes in front of the primary indexes
+    if (ev->getVarInt("db-hash-pk-index",0)) {
+        _pd |= PD_HASHIDX;
+    }
+
+    // Prefix-compressed btrees for the multi-field indexes
+    if (ev->getVarInt("db-key-compression",0)) {
+        _pd |= PD_KEYCOMPRESS;
+    }
+
 
     _bUseSLI = ev->getVarInt("db-worker-sli",0);
     fprintf(stdout, "SLI= %s\n", (_bUseSLI ? "enabled" : "disabled"));
@@ -657,6 +670,21 @@ int ShoreEnv::close_sm()
     // Disabling fake io delay, if any
     _pssm->disable_fake_disk_latency(*_pvid);
 
+    // Save the pages of the buffer pool for the next run, before the
+    // dismount discards them
+    string bpimage = envVar::instance()->getVar("db-bpool-image","");
+    if (!bpimage.empty()) {
+        w_rc_t e = ss_m::save_buffer_image(bpimage.c_str());
+        if (e.is_error()) {
+            TRACE( TRACE_ALWAYS, "Could not save buffer pool image (%s)\n",
+                   bpimage.c_str());
+        }
+        else {
+            TRACE( TRACE_ALWAYS, "Saved buffer pool image (%s)\n",
+                   bpimage.c_str());
+        }
+    }
+
 
     TRACE( TRACE_ALWAYS, "Dismounting all devices...\n");
 
@@ -883,6 +911,23 @@ int ShoreEnv::start_sm()
 
         // "speculate" that the database is loaded
         _loaded = true;
+
+        // warm up the buffer pool with the pages of a previous run
+        string bpimage = envVar::instance()->getVar("db-bpool-image","");
+        if (!bpimage.empty() && (access(bpimage.c_str(), R_OK) == 0)) {
+            stopwatch_t timer;
+            u_int nloaded = 0;
+            w_rc_t e = ss_m::load_buffer_image(bpimage.c_str(), nloaded);
+            if (e.is_error()) {
+                TRACE( TRACE_ALWAYS, "Could not load buffer pool image (%s)\n",
+                       bpimage.c_str());
+            }
+            else {
+                TRACE( TRACE_ALWAYS, 
+                       "Loaded (%d) pages of buffer pool image (%s) in (%.2f) secs\n",
+                       nloaded, bpimage.c_str(), timer.time());
+            }
+        }
     }
 
     // setting the fake io disk latency - after we mount 
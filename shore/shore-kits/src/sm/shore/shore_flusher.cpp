@@ -32,6 +32,10 @@
 #include "sm/shore/shore_env.h"
 #include "xct.h"
 
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
 ENTER_NAMESPACE(shore);
 
 
@@ -47,8 +51,11 @@ const uint smSEGMENT_SIZE=128*smBLOCK_SIZE;
 
 flusher_stats_t::flusher_stats_t()
     : served(0), flushes(0), logsize(0), alreadyFlushed(0), waiting(0),
-      trigByXcts(0), trigBySize(0), trigByTimeout(0)
+      trigByXcts(0), trigBySize(0), trigByTimeout(0), trigByIdle(0),
+      groupWait(0), groupFlush(0), groupMax(0)
 {
+    memset(latHist, 0, sizeof(latHist));
+
     // With the workers using mrmw instead of srmw queues, flushers may not
     // work. We have not been using them. If you want to use them, changes might
     // be required to queues.
@@ -87,6 +94,19 @@ void flusher_stats_t::print() const
            trigBySize,(double)(100*trigBySize)/(double)flushes);
     TRACE( TRACE_STATISTICS, "By Timeout:  (%d)\t(%.2f%%)\n", 
            trigByTimeout,(double)(100*trigByTimeout)/(double)flushes);
+    TRACE( TRACE_STATISTICS, "By Idle:     (%d)\t(%.2f%%)\n", 
+           trigByIdle,(double)(100*trigByIdle)/(double)flushes);
+
+    uint groups = trigByXcts + trigBySize + trigByTimeout + trigByIdle;
+    if (groups==0) return;
+    TRACE( TRACE_STATISTICS, "Group max:   (%d)\n", groupMax);
+    TRACE( TRACE_STATISTICS, "Group wait:  (%.1f) usec\n", 
+           (double)groupWait/(double)groups);
+    TRACE( TRACE_STATISTICS, "Group flush: (%.1f) usec\n", 
+           (double)groupFlush/(double)groups);
+    TRACE( TRACE_STATISTICS, "Commit lat:  p50 (%ld) p90 (%ld) p99 (%ld) usec\n", 
+           percentile(latHist,50), percentile(latHist,90), 
+           percentile(latHist,99));
 }
 
 void flusher_stats_t::reset()
@@ -101,6 +121,64 @@ void flusher_stats_t::reset()
     trigByXcts = 0;
     trigBySize = 0;
     trigByTimeout = 0;
+    trigByIdle = 0;
+
+    groupWait = 0;
+    groupFlush = 0;
+    groupMax = 0;
+    memset(latHist, 0, sizeof(latHist));
+}
+
+
+/****************************************************************** 
+ *
+ * @fn:     add_group()
+ *
+ * @brief:  Accounts for a flushed group 
+ * 
+ ******************************************************************/
+
+void flusher_stats_t::add_group(const uint gsize, 
+                                const long waitusec, 
+                                const long flushusec)
+{
+    groupWait += waitusec;
+    groupFlush += flushusec;
+    groupMax = std::max(groupMax,gsize);
+    latHist[lat_bucket(waitusec+flushusec)]++;
+}
+
+
+/****************************************************************** 
+ *
+ * @fn:     lat_bucket(), percentile()
+ *
+ * @brief:  Latency histogram helpers. Bucket i holds the latencies in 
+ *          [2^(i-1),2^i) usecs, the percentile is reported as the upper 
+ *          end of the bucket it falls in.
+ * 
+ ******************************************************************/
+
+uint flusher_stats_t::lat_bucket(const long usec)
+{
+    uint b = 0;
+    for (long v = usec; v > 0 && b < LAT_BUCKETS-1; v >>= 1) b++;
+    return (b);
+}
+
+long flusher_stats_t::percentile(const uint* hist, const double pct)
+{
+    long total = 0;
+    for (uint i=0; i<LAT_BUCKETS; i++) total += hist[i];
+    if (total==0) return (0);
+
+    long rank = (long)std::ceil(total*pct/100.0);
+    long seen = 0;
+    for (uint i=0; i<LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= rank) return (1L<<i);
+    }
+    return (1L<<(LAT_BUCKETS-1));
 }
 
 
@@ -126,6 +204,84 @@ long flusher_stats_t::_log_diff(const lsn_t& head, const lsn_t& tail)
 
 
 
+/******************************************************************** 
+ *
+ * @struct: flusher_ctl_t
+ * 
+ ********************************************************************/
+
+// weight of the newest sample in the EWMAs
+static const double CTL_ALPHA = 0.125;
+
+flusher_ctl_t::flusher_ctl_t(const long target, const double pct,
+                             const uint max_group, const long max_timeout)
+    : _target(target), _pct(pct), 
+      _max_group(max_group), _max_timeout(max_timeout),
+      _rate(0), _flush(0), _gain(1.0),
+      _group(max_group), _timeout(std::min(target,max_timeout)),
+      _groups(0)
+{
+    memset(_hist, 0, sizeof(_hist));
+}
+
+
+void flusher_ctl_t::on_flush(const uint gsize, const long sinceusec,
+                             const long waitusec, const long flushusec)
+{
+    // the first group seeds the estimates
+    double rate = (double)gsize / (double)std::max(sinceusec,1L);
+    if (_flush==0) {
+        _rate = rate;
+        _flush = flushusec;
+    }
+    else {
+        _rate += CTL_ALPHA * (rate - _rate);
+        _flush += CTL_ALPHA * ((double)flushusec - _flush);
+    }
+
+    _hist[flusher_stats_t::lat_bucket(waitusec+flushusec)]++;
+    if (++_groups == CTL_WINDOW) {
+        long seen = flusher_stats_t::percentile(_hist,_pct);
+        // the histogram reports the upper end of a bucket, hence up to 2x
+        // the actual latency; only the buckets entirely above the target
+        // count as a miss
+        if (seen > 2*_target) {
+            _gain = std::max(_gain*0.5, 1.0/64);
+        }
+        else if (seen <= _target) {
+            _gain = std::min(_gain*1.125, 1.0);
+        }
+        TRACE( TRACE_DEBUG, "p%.0f (%ld) target (%ld) gain (%.3f)\n",
+               _pct, seen, _target, _gain);
+        _groups = 0;
+        memset(_hist, 0, sizeof(_hist));
+    }
+
+    _retune();
+}
+
+
+void flusher_ctl_t::_retune()
+{
+    // what is left of the target after the flush, scaled by the feedback
+    double budget = ((double)_target - _flush) * _gain;
+    if (budget < 0) budget = 0;
+
+    _timeout = std::min((long)budget, _max_timeout);
+    double group = _rate * budget;
+    _group = (group < 1.0) ? 1 : (group > _max_group) ? _max_group : (uint)group;
+}
+
+
+void flusher_ctl_t::print() const
+{
+    TRACE( TRACE_STATISTICS, 
+           "Adaptive:    group (%d) timeout (%ld) rate (%.1f/msec) flush (%.0f) gain (%.3f)\n",
+           _group, _timeout, _rate*1000, _flush, _gain);
+}
+
+
+
 /******************************************************************** 
  *
  * @struct: flusher_t
@@ -165,11 +321,19 @@ flusher_t::~flusher_t()
 int flusher_t::statistics()
 {
     _stats.print();
+    if (_ctl.get()) _ctl->print();
     _stats.reset();
     return (0);
 }
 
 
+// usecs from b to a
+static inline long _usec_diff(const struct timespec& a, const struct timespec& b)
+{
+    return ((a.tv_sec - b.tv_sec)*1000000L + (a.tv_nsec - b.tv_nsec)/1000);
+}
+
+
 /****************************************************************** 
  *
  * @fn:     _work_ACTIVE_impl()
@@ -178,7 +342,8 @@ int flusher_t::statistics()
  *          The flusher monitors the toflush queue and decides when
  *          it is good time to issue a flush
  *
- * @uses:   A couple of threshold values to decide whether to flush
+ * @uses:   A couple of threshold values to decide whether to flush,
+ *          fixed or tuned by flusher_ctl_t ("flusher-policy")
  *
  * @return: 0 on success
  * 
@@ -196,6 +361,16 @@ int flusher_t::_work_ACTIVE_impl()
     uint maxLogSize = ev->getVarInt("flusher-log-size",FLUSHER_LOG_SIZE_THRESHOLD);
     uint maxTimeIntervalusec = ev->getVarInt("flusher-timeout",FLUSHER_TIME_THRESHOLD);
 
+    int policy = ev->getVarInt("flusher-policy",FLUSHER_POLICY_FIXED);
+    if (policy == FLUSHER_POLICY_ADAPTIVE) {
+        long target = ev->getVarInt("flusher-target-latency",FLUSHER_TARGET_LATENCY);
+        int pct = ev->getVarInt("flusher-target-percentile",FLUSHER_TARGET_PERCENTILE);
+        if ((pct<1) || (pct>100)) pct = FLUSHER_TARGET_PERCENTILE;
+        _ctl = new flusher_ctl_t(target,pct,maxGroupSize,maxTimeIntervalusec);
+        TRACE( TRACE_ALWAYS, "Adaptive group commit, p%d target (%ld) usec\n",
+               pct, target);
+    }
+
     uint waiting = 0;
     lsn_t durablelsn, maxlsn;
     bool bShouldFlush = false;
@@ -204,7 +379,13 @@ int flusher_t::_work_ACTIVE_impl()
     static long const BILLION = 1000*1000*1000;
     bool bSleepNext = false;
 
+    // for the per-group statistics: when the first xct of the group was
+    // seen and when the previous flush completed
+    struct timespec groupStart, lastFlush, flushStart;
+    uint groupThreshold = maxGroupSize;
+
     clock_gettime(CLOCK_REALTIME, &start);
+    lastFlush = groupStart = start;
 
     // set timeout
     ts = start;
@@ -226,10 +407,26 @@ int flusher_t::_work_ACTIVE_impl()
         maxlsn = durablelsn;
 
         // Check the list of waiting to flush xcts
+        uint wasWaiting = waiting;
         _check_waiting(bSleepNext,durablelsn,maxlsn,waiting);
 
+        if ((wasWaiting==0) && (waiting>0)) {
+            // A new group starts. With the adaptive policy its deadline
+            // counts from its first xct.
+            clock_gettime(CLOCK_REALTIME, &groupStart);
+            if (_ctl.get()) {
+                groupThreshold = _ctl->_group;
+                ts = groupStart;
+                ts.tv_nsec += _ctl->_timeout * 1000;
+                while (ts.tv_nsec >= BILLION) {
+                    ts.tv_nsec -= BILLION;
+                    ts.tv_sec++;
+                }
+            }
+        }
+
         // Decide whether to flush or not
-        if (waiting >= maxGroupSize) {
+        if (waiting >= groupThreshold) {
             // Do we have already too many waiting?
             bShouldFlush = true;
             _stats.trigByXcts++;
@@ -248,8 +445,10 @@ int flusher_t::_work_ACTIVE_impl()
                 clock_gettime(CLOCK_REALTIME, &start);
                 if ((start.tv_sec > ts.tv_sec) ||
                     (start.tv_sec == ts.tv_sec && start.tv_nsec > ts.tv_nsec)) {
-                    bShouldFlush = true;
-                    _stats.trigByTimeout++;
+                    if (waiting || !_ctl.get()) {
+                        bShouldFlush = true;
+                        _stats.trigByTimeout++;
+                    }
                     
                     // set next timeout
                     ts = start;
@@ -259,11 +458,21 @@ int flusher_t::_work_ACTIVE_impl()
                         ts.tv_sec++;
                     }
                 }
+                else if (_ctl.get()) {
+                    // The adaptive policy holds the group until it is due,
+                    // polling for more xcts meanwhile. It sleeps only when
+                    // there is nothing to flush.
+                    if (waiting) usleep(FLUSHER_POLL_USEC);
+                    else bSleepNext = true;
+                }
                 else {
                     // Set a flag which will put it to sleep in the next loop,
                     // unless a new request arrives. But, before sleeping call
                     // for a lazy flush 
-                    if (waiting) _env->db()->sync_log();                    
+                    if (waiting) {
+                        _stats.trigByIdle++;
+                        bShouldFlush = true;
+                    }
                     bSleepNext = true;
                 }
             }
@@ -280,7 +489,19 @@ int flusher_t::_work_ACTIVE_impl()
             _stats.flushes++;
             _stats.waiting += waiting;
             _stats.logsize += logWaiting;
+
+            clock_gettime(CLOCK_REALTIME, &flushStart);
             _env->db()->sync_log(); // it will block
+            clock_gettime(CLOCK_REALTIME, &start);
+
+            long waitusec = _usec_diff(flushStart,groupStart);
+            long flushusec = _usec_diff(start,flushStart);
+            _stats.add_group(waiting,waitusec,flushusec);
+            if (_ctl.get()) {
+                _ctl->on_flush(waiting,_usec_diff(start,lastFlush),
+                               waitusec,flushusec);
+            }
+            lastFlush = start;
             
             waiting = 0;
             logWaiting = 0;
@@ -0,0 +1,254 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-kits -- Benchmark implementations for Shore-MT
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file shore_hash_index.cpp
+ *
+ *  @brief Implementation of the in-memory hash index (hash_index_t)
+ *
+ */
+
+#include "sm/shore/shore_hash_index.h"
+
+using namespace shore;
+
+
+/******************************************************************
+ *
+ *  class hash_index_t methods
+ *
+ ******************************************************************/
+
+hash_index_t::hash_index_t()
+    : _bucket_cnt(INITIAL_BUCKETS), _count(0)
+{
+    assert (INITIAL_BUCKETS >= STRIPES); // a bucket is in a single stripe
+    _stripes = new stripe_t[STRIPES];
+    _buckets = new entry_t*[_bucket_cnt];
+    memset(_buckets, 0, _bucket_cnt*sizeof(entry_t*));
+}
+
+hash_index_t::~hash_index_t()
+{
+    clear();
+    delete [] _buckets;
+    delete [] _stripes;
+}
+
+
+void hash_index_t::add_key_field(const uint offset, const uint size)
+{
+    _rec_offset.push_back(offset);
+    _field_size.push_back(size);
+}
+
+
+bool hash_index_t::matches(const char* body, const char* key) const
+{
+    assert (body);
+    assert (key);
+    for (uint i=0; i<_rec_offset.size(); i++) {
+        if (memcmp(body + _rec_offset[i], key, _field_size[i]) != 0)
+            return (false);
+        key += _field_size[i];
+    }
+    return (true);
+}
+
+
+
+/******************************************************************
+ *
+ *  @fn:    _hash_key
+ *
+ *  @brief: FNV-1a of the key bytes
+ *
+ ******************************************************************/
+
+uint hash_index_t::_hash_key(const char* key, const uint klen)
+{
+    uint h = 2166136261U;
+    for (uint i=0; i<klen; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619U;
+    }
+    return (h);
+}
+
+
+
+/******************************************************************
+ *
+ *  @fn:    probe/insert/remove
+ *
+ ******************************************************************/
+
+bool hash_index_t::probe(const char* key, const uint klen, rid_t& rid)
+{
+    uint h = _hash_key(key, klen);
+    mcs_rwlock& lock = _stripe(h);
+    lock.acquire_read();
+    for (entry_t* e = _buckets[h & (_bucket_cnt-1)]; e; e = e->_next) {
+        if ((e->_hash == h) && (e->_klen == klen) &&
+            (memcmp(e->_key, key, klen) == 0)) {
+            rid = e->_rid;
+            lock.release_read();
+            return (true);
+        }
+    }
+    lock.release_read();
+    return (false);
+}
+
+
+void hash_index_t::insert(const char* key, const uint klen, const rid_t& rid)
+{
+    uint h = _hash_key(key, klen);
+    mcs_rwlock& lock = _stripe(h);
+    lock.acquire_write();
+    entry_t** pbucket = &_buckets[h & (_bucket_cnt-1)];
+    for (entry_t* e = *pbucket; e; e = e->_next) {
+        if ((e->_hash == h) && (e->_klen == klen) &&
+            (memcmp(e->_key, key, klen) == 0)) {
+            e->_rid = rid;
+            lock.release_write();
+            return;
+        }
+    }
+
+    entry_t* e = (entry_t*)malloc(sizeof(entry_t) + klen);
+    e->_rid = rid;
+    e->_hash = h;
+    e->_klen = klen;
+    memcpy(e->_key, key, klen);
+    e->_next = *pbucket;
+    *pbucket = e;
+    lock.release_write();
+
+    // keep the chains short
+    if (atomic_inc_uint_nv(&_count) > 2*_bucket_cnt) _grow();
+}
+
+
+void hash_index_t::remove(const char* key, const uint klen)
+{
+    uint h = _hash_key(key, klen);
+    mcs_rwlock& lock = _stripe(h);
+    lock.acquire_write();
+    entry_t** pe = &_buckets[h & (_bucket_cnt-1)];
+    for (; *pe; pe = &(*pe)->_next) {
+        entry_t* e = *pe;
+        if ((e->_hash == h) && (e->_klen == klen) &&
+            (memcmp(e->_key, key, klen) == 0)) {
+            *pe = e->_next;
+            lock.release_write();
+            free (e);
+            atomic_dec_uint(&_count);
+            return;
+        }
+    }
+    lock.release_write();
+}
+
+
+void hash_index_t::remove(const char* key, const uint klen, const rid_t& rid)
+{
+    uint h = _hash_key(key, klen);
+    mcs_rwlock& lock = _stripe(h);
+    lock.acquire_write();
+    entry_t** pe = &_buckets[h & (_bucket_cnt-1)];
+    for (; *pe; pe = &(*pe)->_next) {
+        entry_t* e = *pe;
+        if ((e->_hash == h) && (e->_klen == klen) &&
+            (memcmp(e->_key, key, klen) == 0)) {
+            if (e->_rid != rid) break; // someone already put the new rid
+            *pe = e->_next;
+            lock.release_write();
+            free (e);
+            atomic_dec_uint(&_count);
+            return;
+        }
+    }
+    lock.release_write();
+}
+
+
+
+/******************************************************************
+ *
+ *  @fn:    _grow
+ *
+ *  @brief: Quadruples the buckets. Since the stripe of an entry depends
+ *          only on its hash value, it stays in the same stripe.
+ *
+ ******************************************************************/
+
+void hash_index_t::_grow()
+{
+    for (uint i=0; i<STRIPES; i++) _stripes[i]._lock.acquire_write();
+
+    // someone else may have grown it already
+    if (*&_count > 2*_bucket_cnt) {
+        uint new_cnt = _bucket_cnt*4;
+        entry_t** new_buckets = new entry_t*[new_cnt];
+        memset(new_buckets, 0, new_cnt*sizeof(entry_t*));
+
+        for (uint b=0; b<_bucket_cnt; b++) {
+            entry_t* e = _buckets[b];
+            while (e) {
+                entry_t* next = e->_next;
+                entry_t** pbucket = &new_buckets[e->_hash & (new_cnt-1)];
+                e->_next = *pbucket;
+                *pbucket = e;
+                e = next;
+            }
+        }
+
+        delete [] _buckets;
+        _buckets = new_buckets;
+        _bucket_cnt = new_cnt;
+
+        TRACE( TRACE_DEBUG, "Hash index grew to (%d) buckets for (%d) keys\n",
+               _bucket_cnt, *&_count);
+    }
+
+    for (uint i=0; i<STRIPES; i++) _stripes[i]._lock.release_write();
+}
+
+
+void hash_index_t::clear()
+{
+    for (uint i=0; i<STRIPES; i++) _stripes[i]._lock.acquire_write();
+
+    for (uint b=0; b<_bucket_cnt; b++) {
+        entry_t* e = _buckets[b];
+        while (e) {
+            entry_t* next = e->_next;
+            free (e);
+            e = next;
+        }
+        _buckets[b] = NULL;
+    }
+    _count = 0;
+
+    for (uint i=0; i<STRIPES; i++) _stripes[i]._lock.release_write();
+}
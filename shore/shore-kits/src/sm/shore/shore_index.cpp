@@ -48,7 +48,9 @@ index_desc_t::index_desc_t(const char* name, const int fieldcnt,
                            bool rmapholder)
     : _base(name, fieldcnt, pd),
       _unique(unique), _primary(primary),
-      _rmapholder(rmapholder),
+      _rmapholder(rmapholder), _hash(NULL),
+      _payload(NULL), _payload_count(0), _rec_offset(NULL), 
+      _elem_size(sizeof(rid_t)),
       _next(NULL), _maxkeysize(0),
       _partition_count((partitions > 0)? partitions : 1), _partition_stids(0)
 {
@@ -88,6 +90,9 @@ index_desc_t::index_desc_t(const char* name, const int fieldcnt,
 
     // Check if Latch-less
     _latchless = (pd & PD_NOLATCH);
+
+    // Prefix compression pays off only if the keys have a prefix to share
+    _compressed = (pd & PD_KEYCOMPRESS) && (fieldcnt > 1);
     // if (pd & PD_NOLATCH) {
     //     _latchless = true;
     // }
@@ -129,6 +134,76 @@ index_desc_t::~index_desc_t()
         delete [] _partition_stids;
         _partition_stids = NULL;
     }
+
+    if (_hash) {
+        delete _hash;
+        _hash = NULL;
+    }
+
+    if (_payload) {
+        delete [] _payload;
+        _payload = NULL;
+    }
+
+    if (_rec_offset) {
+        delete [] _rec_offset;
+        _rec_offset = NULL;
+    }
+}
+
+
+/****************************************************************** 
+ *  
+ *  @fn:    set_hash
+ *
+ *  @brief: Puts an in-memory hash index in front of this index. It
+ *          makes sense only for unique indexes probed by equality, 
+ *          and it is not supported on MRBTrees.
+ *
+ ******************************************************************/
+
+void index_desc_t::set_hash(hash_index_t* phash)
+{
+    assert (_unique);
+    assert (!_mr);
+    if (_hash) delete _hash;
+    _hash = phash;
+}
+
+
+
+/****************************************************************** 
+ *  
+ *  @fn:    set_payload
+ *
+ *  @brief: Makes it a covering index, whose entries carry the (num)
+ *          fields, of (payload_size) bytes in total, after the rid. The (offsets) in the disk format of
+ *          the record are of the key fields, followed by the payload
+ *          ones, and they are used to keep the payload up to date on
+ *          in-place updates. It is not supported on MRBTrees.
+ *
+ ******************************************************************/
+
+void index_desc_t::set_payload(const uint* fields, const uint num,
+                               const uint* offsets, const uint payload_size)
+{
+    assert (!_mr);
+    assert (!is_partitioned());
+    assert (num > 0);
+    assert (sizeof(rid_t) + payload_size <= MAX_ELEM_SIZE);
+
+    if (_payload) delete [] _payload;
+    if (_rec_offset) delete [] _rec_offset;
+
+    _payload_count = num;
+    _payload = new uint[num];
+    for (uint i=0; i<num; i++) _payload[i] = fields[i];
+
+    uint cnt = _base._field_count + num;
+    _rec_offset = new uint[cnt];
+    for (uint i=0; i<cnt; i++) _rec_offset[i] = offsets[i];
+
+    _elem_size = sizeof(rid_t) + payload_size;
 }
 
 
@@ -103,11 +103,14 @@ simple_index_iter_t::simple_index_iter_t(ss_m* db, index_desc_t* index,
     : _db(db), _opened(false), _idx(index), _lm(alm)
 {
     assert (_db);
+    assert (_idx);
+    _elem = new char[_idx->elem_size()];
 }
 
 simple_index_iter_t::~simple_index_iter_t()
 {
     close_scan();
+    delete [] _elem;
 }
 
 
@@ -152,15 +155,14 @@ w_rc_t simple_index_iter_t::next(bool& eof, rid_t& rid)
     W_DO(_scanner->next(eof));
 
     if (!eof) {        
-        rid_t    tmprid;
-        vec_t    record(&tmprid, sizeof(rid_t));
-        smsize_t elen = sizeof(rid_t);
+        smsize_t elen = _idx->elem_size();
+        vec_t    record(_elem, elen);
         
         vec_t tmpvec;
         smsize_t tmpsz=0;
 
         W_DO(_scanner->curr(&tmpvec, tmpsz, &record, elen));
-        rid = tmprid;
+        memcpy(&rid, _elem, sizeof(rid_t));
     }    
     return (RCOK);
 }
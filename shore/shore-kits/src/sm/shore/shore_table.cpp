@@ -402,6 +402,140 @@ bool table_desc_t::create_primary_idx_desc(const char* name,
     // make it the primary index
     _primary_idx = p_index;
 
+    // equality probes may skip the B-tree
+    if ((pd & PD_HASHIDX) && !p_index->is_mr()) attach_hash_index(p_index);
+
+    return (true);
+}
+
+
+/****************************************************************** 
+ *  
+ *  @fn:    attach_hash_index
+ *
+ *  @brief: Puts an in-memory hash index in front of the index
+ *
+ *  @note:  The hash index checks its hits on the disk format of the
+ *          record, so it needs a table without null-able fields and
+ *          a key of fixed-length fields, whose offsets in the record 
+ *          are then the same for all the records
+ *
+ ******************************************************************/
+
+bool table_desc_t::attach_hash_index(index_desc_t* pindex)
+{
+    assert (pindex);
+
+    for (uint_t i=0; i<_field_count; i++) {
+        if (_desc[i].allow_null()) {
+            TRACE( TRACE_DEBUG, "(%s) has null-able fields, no hash index\n",
+                   name());
+            return (false);
+        }
+    }
+
+    hash_index_t* phash = new hash_index_t();
+    for (uint_t k=0; k<pindex->field_count(); k++) {
+        uint_t ix = pindex->key_index(k);
+        if (_desc[ix].is_variable_length()) {
+            TRACE( TRACE_DEBUG, "(%s) has variable-length key, no hash index\n",
+                   pindex->name());
+            delete (phash);
+            return (false);
+        }
+
+        phash->add_key_field(fixed_field_offset(ix), _desc[ix].fieldmaxsize());
+    }
+
+    pindex->set_hash(phash);
+    TRACE( TRACE_DEBUG, "(%s) hash index attached\n", pindex->name());
+    return (true);
+}
+
+
+/****************************************************************** 
+ *  
+ *  @fn:    fixed_field_offset
+ *
+ *  @brief: Where a fixed-length field is in the disk format of a 
+ *          record, if the table has no null-able fields
+ *
+ ******************************************************************/
+
+uint_t table_desc_t::fixed_field_offset(const uint_t ix) const
+{
+    // the fixed-length fields are stored one after the other
+    uint_t offset = 0;
+    for (uint_t i=0; i<ix; i++) {
+        if (!_desc[i].is_variable_length()) offset += _desc[i].fieldmaxsize();
+    }
+    return (offset);
+}
+
+
+
+/****************************************************************** 
+ *  
+ *  @fn:    set_index_payload
+ *
+ *  @brief: Makes an index covering: its entries carry the values of
+ *          the fields after the rid, so that the scans which need only
+ *          the key and these fields do not fetch the records
+ *
+ *  @note:  Like the hash index, the payload is kept up to date on 
+ *          in-place updates from the disk format of the record, so
+ *          it needs a table without null-able fields, and key and
+ *          payload of fixed-length fields. Not for MRBTrees and 
+ *          partitioned indexes. Otherwise the index stays as it is.
+ *
+ ******************************************************************/
+
+bool table_desc_t::set_index_payload(const char* name,
+                                     const uint* fields,
+                                     const uint num)
+{
+    index_desc_t* pindex = find_index(name);
+    assert (pindex);
+    assert (!pindex->is_primary());
+
+    if (pindex->is_mr() || pindex->is_partitioned()) {
+        TRACE( TRACE_DEBUG, "(%s) is MRBT or partitioned, not covering\n", name);
+        return (false);
+    }
+
+    for (uint_t i=0; i<_field_count; i++) {
+        if (_desc[i].allow_null()) {
+            TRACE( TRACE_DEBUG, "(%s) has null-able fields, no covering index\n",
+                   this->name());
+            return (false);
+        }
+    }
+
+    uint_t kcnt = pindex->field_count();
+    uint_t* offsets = new uint_t[kcnt + num];
+    uint_t key_size = 0;
+    uint_t payload_size = 0;
+    bool ok = true;
+    for (uint_t i=0; i<kcnt+num; i++) {
+        uint_t ix = (i < kcnt) ? pindex->key_index(i) : fields[i-kcnt];
+        assert (ix < _field_count);
+        if (_desc[ix].is_variable_length()) ok = false;
+        offsets[i] = fixed_field_offset(ix);
+        if (i < kcnt) key_size += _desc[ix].fieldmaxsize();
+        else payload_size += _desc[ix].fieldmaxsize();
+    }
+
+    if (!ok || (key_size > index_desc_t::MAX_COVERING_KEY_SIZE) ||
+        (sizeof(rid_t) + payload_size > index_desc_t::MAX_ELEM_SIZE)) {
+        TRACE( TRACE_DEBUG, "(%s) variable-length or too large fields, not covering\n", 
+               name);
+        delete [] offsets;
+        return (false);
+    }
+
+    pindex->set_payload(fields, num, offsets, payload_size);
+    delete [] offsets;
+    TRACE( TRACE_DEBUG, "(%s) covers (%d) more fields\n", name, num);
     return (true);
 }
 
@@ -829,6 +963,73 @@ bool table_man_t::load_key(const char* string,
 
 
 
+/****************************************************************** 
+ *
+ *  @fn:    format_elem
+ *
+ *  @brief: Writes the element of an entry of the index for the tuple:
+ *          the rid, followed by the payload fields if it is covering.
+ *          Returns the size of the element.
+ *
+ *  @warning: This function should be the inverse of the load_elem() 
+ *            function changes to one of the two functions should be
+ *            mirrored to the other.
+ *
+ *  @note:    The payload fields are of fixed length (as in the disk
+ *            format of the record), see table_desc_t::set_index_payload()
+ *
+ ******************************************************************/
+
+int table_man_t::format_elem(index_desc_t* pindex,
+                             table_tuple* ptuple,
+                             char* elem)
+{
+    assert (pindex);
+    assert (ptuple);
+    assert (elem);
+
+    int esz = pindex->elem_size();
+    memcpy(elem, &ptuple->_rid, sizeof(rid_t));
+    memset(elem + sizeof(rid_t), 0, esz - sizeof(rid_t));
+
+    offset_t offset = sizeof(rid_t);
+    for (uint_t i=0; i<pindex->payload_count(); i++) {
+        field_value_t* pfv = &ptuple->_pvalues[pindex->payload_index(i)];
+        if (!pfv->copy_value(elem+offset)) {
+            assert (false); // problem in copying value
+            return (0);
+        }
+        offset += pfv->maxsize();
+    }
+    return (esz);
+}
+
+
+bool table_man_t::load_elem(const char* elem,
+                            index_desc_t* pindex,
+                            table_tuple* ptuple)
+{
+    assert (pindex);
+    assert (ptuple);
+    assert (elem);
+
+    rid_t rid;
+    memcpy(&rid, elem, sizeof(rid_t));
+    ptuple->set_rid(rid);
+
+    int offset = sizeof(rid_t);
+    for (uint_t i=0; i<pindex->payload_count(); i++) {
+        uint_t field_index = pindex->payload_index(i);
+        uint_t size = ptuple->_pvalues[field_index].maxsize();
+        ptuple->_pvalues[field_index].set_value(elem + offset, size);
+        offset += size;
+    }
+
+    return (true);
+}
+
+
+
 /****************************************************************** 
  *
  *  @fn:    min_key/max_key
@@ -935,6 +1136,38 @@ w_rc_t table_man_t::index_probe(ss_m* db,
                                 table_tuple*  ptuple,
                                 lock_mode_t   lock_mode,
                                 const lpid_t& root)
+{
+    // read the tuple
+    pin_i pin;
+    W_DO(index_probe_pin(db, pindex, ptuple, pin, lock_mode, root));
+
+    if (!load(ptuple, pin.body())) {
+        pin.unpin();
+        return RC(se_WRONG_DISK_DATA);
+    }
+    pin.unpin();
+    return (RCOK);
+}
+
+
+/********************************************************************* 
+ *
+ *  @fn:    index_probe_pin
+ *  
+ *  @brief: Finds the rid of the specified key using a certain index,
+ *          and pins the record
+ *
+ *  @note:  The key is parsed from the tuple that it is passed as parameter.
+ *          On success the caller has to unpin.
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::index_probe_pin(ss_m* db,
+                                    index_desc_t* pindex,
+                                    table_tuple*  ptuple,
+                                    pin_i&        pin,
+                                    lock_mode_t   lock_mode,
+                                    const lpid_t& root)
 {
     assert (_ptable);
     assert (pindex);
@@ -964,6 +1197,27 @@ w_rc_t table_man_t::index_probe(ss_m* db,
 
     int pnum = get_pnum(pindex, ptuple);
 
+    latch_mode_t heap_latch_mode = LATCH_SH;
+    if (system_mode & (PD_MRBT_PART | PD_MRBT_LEAF)) heap_latch_mode = LATCH_NL;
+
+    // try the hash index first, its hits are checked on the record
+    hash_index_t* phash = pindex->hash();
+    if (phash && phash->probe(ptuple->_rep->_dest, key_sz, ptuple->_rid)) {
+        w_rc_t e = pin.pin(ptuple->rid(), 0, lock_mode, heap_latch_mode);
+        if (!e.is_error()) {
+            if (phash->matches(pin.body(), ptuple->_rep->_dest)) 
+                return (RCOK);
+            pin.unpin();
+        }
+        else if ((e.err_num() == smlevel_0::eDEADLOCK) ||
+                 (e.err_num() == smlevel_0::eLOCKTIMEOUT)) {
+            return (e);
+        }
+
+        // stale entry (e.g. of an aborted insert), go to the B-tree
+        phash->remove(ptuple->_rep->_dest, key_sz, ptuple->rid());
+    }
+
     if (pindex->is_mr()) {
 
         // Do the probe
@@ -978,30 +1232,28 @@ w_rc_t table_man_t::index_probe(ss_m* db,
                                  ));
     }
     else {
+        // the element starts with the rid, a covering index has more
+        char elem[index_desc_t::MAX_ELEM_SIZE];
+        len = pindex->elem_size();
         W_DO(ss_m::find_assoc(pindex->fid(pnum),
                               vec_t(ptuple->_rep->_dest, key_sz),
-                              &(ptuple->_rid),
+                              elem,
                               len,
                               found
 #ifdef CFG_DORA
                               ,bIgnoreLocks
 #endif
                               ));
+        if (found) memcpy(&(ptuple->_rid), elem, sizeof(rid_t));
     }
 
     if (!found) return RC(se_TUPLE_NOT_FOUND);
 
-    // read the tuple
-    pin_i pin;
-    latch_mode_t heap_latch_mode = LATCH_SH;
-    if (system_mode & (PD_MRBT_PART | PD_MRBT_LEAF)) heap_latch_mode = LATCH_NL;
+    // pin the tuple
     W_DO(pin.pin(ptuple->rid(), 0, lock_mode, heap_latch_mode));
 
-    if (!load(ptuple, pin.body())) {
-        pin.unpin();
-        return RC(se_WRONG_DISK_DATA);
-    }
-    pin.unpin();
+    // the next probe for this key will skip the B-tree
+    if (phash) phash->insert(ptuple->_rep->_dest, key_sz, ptuple->rid());
     return (RCOK);
 }
 
@@ -1063,6 +1315,9 @@ w_rc_t table_man_t::add_tuple(ss_m* db,
 #endif
                         ));
 
+    // bulk loading, the indexes are built afterwards (see build_index)
+    if (_defer_indexes) return (RCOK);
+
     // update the indexes
     index_desc_t* index = _ptable->indexes();
     int ksz = 0;
@@ -1088,13 +1343,17 @@ w_rc_t table_man_t::add_tuple(ss_m* db,
                                      ));
         }
         else {
+            char elem[index_desc_t::MAX_ELEM_SIZE];
+            int esz = format_elem(index, ptuple, elem);
             W_DO(db->create_assoc(index->fid(pnum),
                                   vec_t(ptuple->_rep->_dest, ksz),
-                                  vec_t(&(ptuple->_rid), sizeof(rid_t))
+                                  vec_t(elem, esz)
 #ifdef CFG_DORA
                                   ,bIgnoreLocks
 #endif
                                   ));
+            if (index->hash()) 
+                index->hash()->insert(ptuple->_rep->_dest, ksz, ptuple->rid());
         }
         // move to next index
 	index = index->next();
@@ -1158,13 +1417,17 @@ w_rc_t table_man_t::add_index_entry(ss_m* db,
 				 ));
     }
     else {
+	char elem[index_desc_t::MAX_ELEM_SIZE];
+	int esz = format_elem(pindex, ptuple, elem);
 	W_DO(db->create_assoc(pindex->fid(pnum),
 			      vec_t(ptuple->_rep->_dest, ksz),
-			      vec_t(&(ptuple->_rid), sizeof(rid_t))
+			      vec_t(elem, esz)
 #ifdef CFG_DORA
 			      ,bIgnoreLocks
 #endif
 			      ));
+	if (pindex->hash()) 
+	    pindex->hash()->insert(ptuple->_rep->_dest, ksz, ptuple->rid());
     }
     
     return (RCOK);
@@ -1377,9 +1640,11 @@ w_rc_t table_man_t::add_plp_tuple(ss_m* db,
                                      lpid_t::null));
         }
         else {
+            char elem[index_desc_t::MAX_ELEM_SIZE];
+            int esz = format_elem(index, ptuple, elem);
             W_DO(db->create_assoc(index->fid(pnum),
                                   vec_t(ptuple->_rep_key->_dest, ksz),
-                                  vec_t(&(ptuple->_rid), sizeof(rid_t))
+                                  vec_t(elem, esz)
 #ifdef CFG_DORA
                                   ,bIgnoreLocks
 #endif
@@ -1402,7 +1667,8 @@ w_rc_t table_man_t::add_plp_tuple(ss_m* db,
  *          on all the indexes of the table
  *
  *  @note:  This function should be called in the context of a trx
- *          The passed tuple should be valid.
+ *          The passed tuple should be valid, and have the payload 
+ *          fields of the covering indexes loaded.
  *
  *********************************************************************/
 
@@ -1445,13 +1711,17 @@ w_rc_t table_man_t::delete_tuple(ss_m* db,
                                       (pindex->is_primary() ? primary_root : lpid_t::null)));
         }
         else {
+            char elem[index_desc_t::MAX_ELEM_SIZE];
+            int esz = format_elem(pindex, ptuple, elem);
             W_DO(db->destroy_assoc(pindex->fid(pnum),
                                    vec_t(ptuple->_rep->_dest, key_sz),
-                                   vec_t(&(todelete), sizeof(rid_t))
+                                   vec_t(elem, esz)
 #ifdef CFG_DORA
                                    ,bIgnoreLocks
 #endif
                                    ));
+            if (pindex->hash()) 
+                pindex->hash()->remove(ptuple->_rep->_dest, key_sz);
         }
 
         // move to next index
@@ -1489,7 +1759,8 @@ w_rc_t table_man_t::delete_tuple(ss_m* db,
  *  @brief: Deletes a tuple's entry from the given index
  *
  *  @note:  This function should be called in the context of a trx
- *          The passed tuple should be valid.
+ *          The passed tuple should be valid, and have the payload 
+ *          fields of a covering index loaded.
  *
  *********************************************************************/
 
@@ -1531,13 +1802,17 @@ w_rc_t table_man_t::delete_index_entry(ss_m* db,
 				  (pindex->is_primary() ? primary_root : lpid_t::null)));
     }
     else {
+	char elem[index_desc_t::MAX_ELEM_SIZE];
+	int esz = format_elem(pindex, ptuple, elem);
 	W_DO(db->destroy_assoc(pindex->fid(pnum),
 			       vec_t(ptuple->_rep->_dest, key_sz),
-			       vec_t(&(todelete), sizeof(rid_t))
+			       vec_t(elem, esz)
 #ifdef CFG_DORA
 			       ,bIgnoreLocks
 #endif
 			       ));
+	if (pindex->hash()) 
+	    pindex->hash()->remove(ptuple->_rep->_dest, key_sz);
     }
 
     return (RCOK);
@@ -1555,15 +1830,16 @@ w_rc_t table_man_t::delete_index_entry(ss_m* db,
  *
  *  @note:  This function should be called in the context of a trx.
  *          The passed tuple rid() should be valid. 
- *          There is no need of updating the indexes. That's why there
- *          is not parameter to primary_root.
+ *          There is no need of updating the indexes, other than the
+ *          payload of the covering ones. That's why there is not 
+ *          parameter to primary_root.
  *
  *  !!! In order to update a field included by an index !!!
  *  !!! the tuple should be deleted and inserted again  !!!
  *
  *********************************************************************/
 
-w_rc_t table_man_t::update_tuple(ss_m* /* db */, 
+w_rc_t table_man_t::update_tuple(ss_m* db, 
                                  table_tuple* ptuple,
                                  const lock_mode_t  lock_mode) // physical_design_t
 {
@@ -1594,8 +1870,14 @@ w_rc_t table_man_t::update_tuple(ss_m* /* db */,
     int tsz = format(ptuple, *ptuple->_rep);
     assert (ptuple->_rep->_dest); // if NULL invalid
 
+    w_rc_t rc = update_covering(db, ptuple->rid(), pin.body(), 
+                                0, ptuple->_rep->_dest, tsz, bIgnoreLocks);
+    if (rc.is_error()) {
+        pin.unpin();
+        return (rc);
+    }
+
     // a. if updated record cannot fit in the previous spot
-    w_rc_t rc;
     if (current_size < tsz) {
         zvec_t azv(tsz - current_size);
 
@@ -1677,6 +1959,170 @@ w_rc_t table_man_t::read_tuple(table_tuple* ptuple,
 
 
 
+/********************************************************************* 
+ *
+ *  @fn:    read_pin
+ *
+ *  @brief: Pins a record directly through its RID
+ *
+ *  @note:  Like read_tuple() without the load(). On success the caller
+ *          has to unpin.
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::read_pin(const rid_t& rid,
+                             pin_i& pin,
+                             lock_mode_t lock_mode)
+{
+    assert (_ptable);
+
+    if (rid == rid_t::null) return RC(se_NO_CURRENT_TUPLE);
+
+    latch_mode_t heap_latch_mode = LATCH_SH;
+    uint4_t system_mode = _ptable->get_pd();
+    if (system_mode & ( PD_MRBT_LEAF | PD_MRBT_PART) ) {
+        heap_latch_mode = LATCH_NL;
+	lock_mode = NL;
+    }
+
+    W_DO(pin.pin(rid, 0, lock_mode, heap_latch_mode));
+    return (RCOK);
+}
+
+
+/********************************************************************* 
+ *
+ *  @fn:    update_pinned
+ *
+ *  @brief: Updates in place (sz) bytes at (offset) of a pinned record
+ *
+ *  @note:  Like update_tuple(), without formatting the whole tuple and
+ *          logging only the bytes that changed. The size of the record
+ *          does not change, so it cannot be used for variable-length
+ *          fields. The record stays pinned. The payload of the
+ *          covering indexes follows.
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::update_pinned(pin_i& pin,
+                                  const uint offset,
+                                  const void* data,
+                                  const uint sz,
+                                  const lock_mode_t lock_mode)
+{
+    assert (_ptable);
+    assert (pin.pinned());
+    assert (offset + sz <= pin.body_size());
+
+    bool bIgnoreLocks = false;
+    if (lock_mode==NL) bIgnoreLocks = true;
+
+    W_DO(update_covering(_ptable->db(), pin.rid(), pin.body(), 
+                         offset, data, sz, bIgnoreLocks));
+
+    w_rc_t rc;
+    if (_ptable->get_pd() & ( PD_MRBT_LEAF | PD_MRBT_PART) ) {
+        rc = pin.update_mrbt_rec(offset, vec_t(data, sz), 0, 
+                                 bIgnoreLocks, 
+                                 true);
+    }
+    else {
+        rc = pin.update_rec(offset, vec_t(data, sz), 0,
+                            bIgnoreLocks);
+    }
+
+    if (rc.is_error()) TRACE( TRACE_DEBUG, "Error updating record in place\n");
+    return (rc);
+}
+
+
+
+
+/********************************************************************* 
+ *
+ *  @fn:    update_covering
+ *
+ *  @brief: Before (sz) bytes at (offset) of the record (body) are
+ *          replaced by (data), it replaces the entries of the covering
+ *          indexes whose payload changes
+ *
+ *  @note:  The key fields are not supposed to change this way (see
+ *          update_tuple()), so the key is read from the record. Both
+ *          are of fixed-length fields at known offsets, see 
+ *          table_desc_t::set_index_payload().
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::update_covering(ss_m* db,
+                                    const rid_t& rid,
+                                    const char* body,
+                                    const uint offset,
+                                    const void* data,
+                                    const uint sz,
+                                    const bool bIgnoreLocks)
+{
+    assert (_ptable);
+    assert (body);
+
+    for (index_desc_t* pindex = _ptable->indexes(); pindex; 
+         pindex = pindex->next()) 
+    {
+        if (!pindex->is_covering()) continue;
+
+        char old_elem[index_desc_t::MAX_ELEM_SIZE];
+        char new_elem[index_desc_t::MAX_ELEM_SIZE];
+        memcpy(old_elem, &rid, sizeof(rid_t));
+        memcpy(new_elem, &rid, sizeof(rid_t));
+
+        // the payload on the record, and with the updated bytes over it
+        uint kcnt = pindex->field_count();
+        uint esz = sizeof(rid_t);
+        for (uint i=0; i<pindex->payload_count(); i++) {
+            uint foff = pindex->rec_offset(kcnt+i);
+            uint fsz = _ptable->desc(pindex->payload_index(i))->fieldmaxsize();
+            memcpy(old_elem+esz, body+foff, fsz);
+            memcpy(new_elem+esz, body+foff, fsz);
+
+            uint from = (foff > offset) ? foff : offset;
+            uint to = (foff+fsz < offset+sz) ? foff+fsz : offset+sz;
+            if (from < to) {
+                memcpy(new_elem+esz+(from-foff), (const char*)data+(from-offset), 
+                       to-from);
+            }
+            esz += fsz;
+        }
+        assert (esz == pindex->elem_size());
+        if (memcmp(old_elem, new_elem, esz) == 0) continue;
+
+        char key[index_desc_t::MAX_COVERING_KEY_SIZE];
+        uint ksz = 0;
+        for (uint i=0; i<kcnt; i++) {
+            uint fsz = _ptable->desc(pindex->key_index(i))->fieldmaxsize();
+            memcpy(key+ksz, body+pindex->rec_offset(i), fsz);
+            ksz += fsz;
+        }
+
+        W_DO(pindex->check_fid(db));
+        W_DO(ss_m::destroy_assoc(pindex->fid(0),
+                                 vec_t(key, ksz),
+                                 vec_t(old_elem, esz)
+#ifdef CFG_DORA
+                                 ,bIgnoreLocks
+#endif
+                                 ));
+        W_DO(ss_m::create_assoc(pindex->fid(0),
+                                vec_t(key, ksz),
+                                vec_t(new_elem, esz)
+#ifdef CFG_DORA
+                                ,bIgnoreLocks
+#endif
+                                ));
+    }
+    return (RCOK);
+}
+
+
+
 /* ---------------- */
 /* --- caching  --- */
 /* ---------------- */
@@ -1753,6 +2199,251 @@ table_fetcher_t::~table_fetcher_t()
 {
 }
 
+
+/********************************************************************* 
+ *
+ *  @fn:    rebuild_hash_index
+ *
+ *  @brief: Refills the hash index of the primary index, if it has one,
+ *          with all the (key,rid) pairs of its B-tree
+ *
+ *  @note:  The hash index is not persistent, so this is for a database
+ *          that was not loaded (and hence not inserted) in this run.
+ *          Without it the hash index is filled by the probes.
+ *          It runs its own trx.
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::rebuild_hash_index(ss_m* db)
+{
+    assert (db);
+    assert (_ptable);
+
+    index_desc_t* pindex = _ptable->primary_idx();
+    if (!pindex || !pindex->hash()) return (RCOK);
+    hash_index_t* phash = pindex->hash();
+
+    W_DO(db->begin_xct());
+    W_DO(pindex->check_fid(db));
+    phash->clear();
+
+    int ksz = _ptable->index_maxkeysize(pindex);
+    array_guard_t<char> key = new char[ksz];
+    rid_t rid;
+    bool eof = false;
+
+    for (int pnum = 0; pnum < pindex->get_partition_count(); pnum++) {
+        scan_index_i scan(pindex->fid(pnum), 
+                          scan_index_i::ge, vec_t::neg_inf,
+                          scan_index_i::le, vec_t::pos_inf, 
+                          false, ss_m::t_cc_none);
+        W_DO(scan.next(eof));
+        while (!eof) {
+            vec_t kvec(key, ksz);
+            vec_t rvec(&rid, sizeof(rid_t));
+            smsize_t klen = ksz;
+            smsize_t rlen = sizeof(rid_t);
+            W_DO(scan.curr(&kvec, klen, &rvec, rlen));
+            phash->insert(key, klen, rid);
+            W_DO(scan.next(eof));
+        }
+    }
+
+    W_DO(db->commit_xct());
+
+    TRACE( TRACE_ALWAYS, "%s: hash index of (%d) keys\n", 
+           pindex->name(), phash->size());
+    return (RCOK);
+}
+
+
+
+
+/********************************************************************* 
+ *
+ *  @fn:    set_defer_indexes
+ *
+ *  @brief: Starts (or stops) deferring the index inserts of add_tuple()
+ *
+ *  @note:  The indexes of a table loaded with deferred indexes are empty
+ *          until build_index() runs, and the loaders cannot probe them.
+ *          Not for MRBTrees, whose inserts also place the records.
+ *
+ *********************************************************************/
+
+void table_man_t::set_defer_indexes(const bool defer)
+{
+    assert (_ptable);
+    for (index_desc_t* pindex = _ptable->indexes(); pindex; 
+         pindex = pindex->next()) {
+        assert (!defer || !pindex->is_mr());
+    }
+    _defer_indexes = defer;
+}
+
+
+
+/********************************************************************* 
+ *
+ *  @fn:    build_index
+ *
+ *  @brief: Inserts the (key,elem) pairs of all the records of the heap
+ *          file to an index, scanning the file without locks
+ *
+ *  @note:  It runs its own trxs, of (batch) records each, so that the 
+ *          trxs of a big table do not run out of log space. A single 
+ *          thread per index does not deadlock with anybody. On an error
+ *          the trx of the failed batch is aborted.
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::build_index(ss_m* db, index_desc_t* pindex, const int batch)
+{
+    assert (db);
+    assert (_ptable);
+    assert (pindex);
+    assert (!pindex->is_mr());
+    assert (batch > 0);
+
+    rid_t start = rid_t::null;
+    bool eof = false;
+    uint_t count = 0;
+
+    while (!eof) {
+        W_DO(db->begin_xct());
+        w_rc_t e = build_index_batch(db, pindex, batch, start, eof, count);
+        if (e.is_error()) {
+            W_COERCE(db->abort_xct());
+            return (e);
+        }
+        W_DO(db->commit_xct());
+    }
+
+    TRACE( TRACE_ALWAYS, "%s: built with (%d) entries\n", 
+           pindex->name(), count);
+    return (RCOK);
+}
+
+/********************************************************************* 
+ *
+ *  @fn:    build_index_batch
+ *
+ *  @brief: The body of a trx of build_index(), attached by the caller
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::build_index_batch(ss_m* db, index_desc_t* pindex, 
+                                      const int batch, rid_t& start, 
+                                      bool& eof, uint_t& count)
+{
+    table_row_t tuple(_ptable);
+    rep_row_t areprow(ts());
+    areprow.set(_ptable->maxsize());
+    char elem[index_desc_t::MAX_ELEM_SIZE];
+
+    W_DO(_ptable->check_fid(db));
+
+    // continue from the first record not inserted yet
+    guard<scan_file_i> scan;
+    if (start == rid_t::null) {
+        scan = new scan_file_i(_ptable->fid(), ss_m::t_cc_none);
+    }
+    else {
+        scan = new scan_file_i(_ptable->fid(), start, ss_m::t_cc_none);
+    }
+
+    pin_i* handle;
+    W_DO(scan->next(handle, 0, eof));
+    for (int i=0; (i<batch) && !eof; i++) {
+        if (!load(&tuple, handle->body()))
+            return RC(se_WRONG_DISK_DATA);
+        tuple.set_rid(handle->rid());
+
+        int ksz = format_key(pindex, &tuple, areprow);
+        assert (areprow._dest);
+        int esz = format_elem(pindex, &tuple, elem);
+
+        int pnum = get_pnum(pindex, &tuple);
+        W_DO(pindex->find_fid(db, pnum));
+        W_DO(db->create_assoc(pindex->fid(pnum),
+                              vec_t(areprow._dest, ksz),
+                              vec_t(elem, esz)
+#ifdef CFG_DORA
+                              ,true
+#endif
+                              ));
+        if (pindex->hash()) 
+            pindex->hash()->insert(areprow._dest, ksz, tuple.rid());
+        ++count;
+
+        W_DO(scan->next(handle, 0, eof));
+    }
+    if (!eof) start = handle->rid();
+    return (RCOK);
+}
+
+
+
+/********************************************************************* 
+ *
+ *  @fn:    build_deferred_indexes
+ *
+ *  @brief: Builds the indexes of the tables loaded with deferred indexes,
+ *          each index by its own thread, and stops deferring
+ *
+ *********************************************************************/
+
+w_rc_t table_man_t::build_deferred_indexes(ss_m* db, 
+                                           table_man_t** mans, 
+                                           const int count)
+{
+    assert (db);
+    vector<index_builder_t*> builders;
+    for (int i=0; i<count; i++) {
+        if (!mans[i]->defer_indexes()) continue;
+        for (index_desc_t* pindex = mans[i]->table()->indexes(); pindex; 
+             pindex = pindex->next()) {
+            builders.push_back(new index_builder_t(db, mans[i], pindex));
+        }
+    }
+
+    TRACE( TRACE_ALWAYS, "Building (%d) indexes ..\n", builders.size());
+    for (uint i=0; i<builders.size(); i++) builders[i]->fork();
+
+    w_rc_t rc = RCOK;
+    for (uint i=0; i<builders.size(); i++) {
+        builders[i]->join();
+        if (builders[i]->_rc.is_error() && !rc.is_error())
+            rc = builders[i]->_rc;
+        delete (builders[i]);
+    }
+
+    for (int i=0; i<count; i++) mans[i]->set_defer_indexes(false);
+    return (rc);
+}
+
+
+index_builder_t::index_builder_t(ss_m* db, table_man_t* pmanager, 
+                                 index_desc_t* pindex)
+    : thread_t(c_str("IB-%s", pindex->name())),
+      _db(db), _pmanager(pmanager), _pindex(pindex)
+{
+}
+
+index_builder_t::~index_builder_t()
+{
+}
+
+void index_builder_t::work()
+{
+    _rc = _pmanager->build_index(_db, _pindex, BUILD_BATCH);
+    if (_rc.is_error()) {
+        cerr << "Error while building index " << _pindex->name() 
+             << endl << _rc << endl;
+    }
+}
+
+
 void table_fetcher_t::work()
 {
     assert(_env);
@@ -45,33 +45,31 @@ countdown_t::reset(const int newcount)
 bool 
 countdown_t::post(bool is_error) 
 {
-    int old_value = *&_state;
-    while (old_value >= 2*CD_NUMBER) {
-        int new_value = (is_error? CD_ERROR : old_value-CD_NUMBER);
-        int cur_value = atomic_cas_32(&_state, old_value, new_value);
+    if (!is_error) {
+        // the last one brings it to zero, unless there was an error
+        return (atomic_add_32_nv(&_state, -CD_NUMBER) == 0);
+    }
+
+    // the first error completes the countdown, the rest of the
+    // posters will never see zero
+    unsigned int old_value = *&_state;
+    while (!(old_value & CD_ERROR)) {
+        unsigned int cur_value = atomic_cas_32(&_state, old_value, 
+                                               old_value | CD_ERROR);
         if (cur_value == old_value) {
-            assert(is_error || new_value >= CD_NUMBER);
-            return (is_error);
+            assert (old_value >= CD_NUMBER);
+            return (true);
         }
 
         // try, try again
         old_value = cur_value;
     }
-
-    // did some other thread report an error?
-    if (old_value == CD_ERROR) {
-        return (false);
-    }
- 
-    // we're the last caller -- no more atomic ops needed
-    assert(old_value == CD_NUMBER);
-    _state = (is_error? CD_ERROR : 0);
-    return (true);
+    return (false);
 }
 
 int countdown_t::remaining() const 
 {
-    int old_value = *&_state;
-    return ((old_value == CD_ERROR) ? -1 : old_value/CD_NUMBER); 
+    unsigned int old_value = *&_state;
+    return ((old_value & CD_ERROR) ? -1 : int(old_value/CD_NUMBER)); 
 }
 
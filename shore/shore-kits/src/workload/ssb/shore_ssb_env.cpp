@@ -283,9 +283,17 @@ ShoreSSBEnv::ShoreSSBEnv()
     _scaling_factor = SSB_SCALING_FACTOR;
 
 #ifdef CFG_QPIPE
-    // Set the default scheduling policy. We will worry later about changing
-    // that, possibly through the shell
-    set_sched_policy(NULL);
+    // Set the scheduling policy from the config (OS by default). We will
+    // worry later about changing that, possibly through the shell
+    string spolicy = envVar::instance()->getVar("qpipe-sched-policy","OS");
+    set_sched_policy(spolicy.c_str());
+
+    // The working memory of the sorts, aggregations and joins of all
+    // the queries, in MB (0 for no limit)
+    int mem_mb = envVar::instance()->getVarInt("qpipe-mem-budget",
+                                               qpipe::memory_broker_t::DEFAULT_BUDGET_MB);
+    qpipe::memory_broker_t::instance()->set_budget(
+        (size_t)mem_mb*1024*1024/qpipe::get_default_page_size());
 
     // Register stage containers
     register_stage_containers();
@@ -359,6 +367,16 @@ policy_t* ShoreSSBEnv::set_sched_policy(const char* spolicy)
             _sched_policy = new policy_rr_module_t();
             return (_sched_policy);
         }
+
+        if ( !strcmp(spolicy, "STEAL_CPU") ) {
+            _sched_policy = new policy_steal_cpu_t();
+            return (_sched_policy);
+        }
+
+        if ( !strcmp(spolicy, "NUMA") ) {
+            _sched_policy = new policy_numa_t();
+            return (_sched_policy);
+        }
     }
     // Use the default scheduling policy (let the OS choose) 
     TRACE( TRACE_ALWAYS, "Default scheduling policy (OS)\n");
@@ -458,10 +476,12 @@ w_rc_t ShoreSSBEnv::loaddata()
        deadlock rates if we try to throw lots of threads at a small
        btree. To work around this we preload a number of records for
        each table and then fire up the (parallel) workers.
+       If the indexes are deferred the loaders touch only the heap files.
      */
 
     // 1. Read the number of parallel loaders and calculate ranges
     int loaders_to_use = envVar::instance()->getVarInt("db-loaders",10);
+    bool defer_indexes = envVar::instance()->getVarInt("db-defer-indexes",0);
     //long total_parts = _scaling_factor*PART_UNIT_PER_SF;
     //long total_custs = _scaling_factor*CUST_UNIT_PER_SF;
     //long parts_per_thread = total_parts/loaders_to_use;
@@ -469,6 +489,11 @@ w_rc_t ShoreSSBEnv::loaddata()
     long total_lineorders = _scaling_factor*LINEORDER_UNIT_PER_SF;
     long lineorders_per_thread = total_lineorders/loaders_to_use;
 
+    table_man_t* mans[] = { _ppart_man, _psupplier_man, _pdate_man,
+                            _pcustomer_man, _plineorder_man };
+    const int man_count = sizeof(mans)/sizeof(mans[0]);
+    for (int i=0; i<man_count; i++) mans[i]->set_defer_indexes(defer_indexes);
+
     // 2. Fire up the table creator and baseline loader
     {
 	guard<table_creator_t> tc;
@@ -506,15 +531,25 @@ w_rc_t ShoreSSBEnv::loaddata()
 	loaders[i]->join();
     }
 
+    time_t tdata = time(NULL);
+
+    // 5. Build the deferred indexes
+    if (defer_indexes) {
+        W_DO(table_man_t::build_deferred_indexes(db(), mans, man_count));
+    }
+
     time_t tstop = time(NULL);
 
-    // 5. Print stats
+    // 6. Print stats
     TRACE( TRACE_STATISTICS, "Loading finished. %d tables loaded in (%d) secs...\n",
            SHORE_SSB_TABLES, (tstop - tstart));
+    TRACE( TRACE_STATISTICS, "SF (%.1f) Loaders (%d) CPUs (%d) Data (%d) secs Indexes (%d) secs\n",
+           _scaling_factor, loaders_to_use, get_max_cpu_count(),
+           (tdata - tstart), (tstop - tdata));
 
     dbgenssb::free_asc_date();
 
-    // 6. Notify that the env is loaded
+    // 7. Notify that the env is loaded
     _loaded = true;
     chk->join();
 
@@ -106,6 +106,9 @@ void ShoreSSBEnv::reset_stats()
 {
     CRITICAL_SECTION(last_stats_cs, _last_stats_mutex);
     _last_stats = _get_stats();
+#ifdef CFG_QPIPE
+    qpipe::memory_broker_t::instance()->clear_stats();
+#endif
 }
 
 
@@ -153,6 +156,17 @@ void ShoreSSBEnv::print_throughput(const double iQueriedSF,
            delay, mioch/delay, avgcpuusage, 
            100*avgcpuusage/get_max_cpu_count(),
            (trxs_att-trxs_abt-trxs_dld)/delay);
+
+#ifdef CFG_QPIPE
+    // Each client runs one query at a time, so the queries in flight
+    // are as many as the clients
+    uint queries = trxs_att-trxs_abt-trxs_dld;
+    if (queries) {
+        TRACE( TRACE_ALWAYS, "AvgLat:    (%.2f ms)\n",
+               1000*iNumOfThreads*delay/queries);
+    }
+    qpipe::memory_broker_t::instance()->trace_stats();
+#endif
 }
 
 
@@ -596,6 +596,17 @@ int ShoreTM1Env::conf()
 
 int ShoreTM1Env::post_init() 
 {
+    // The database was not loaded in this run, refill the hash indexes
+    if (get_pd() & PD_HASHIDX) {
+        table_man_t* mans[] = { _psub_man, _pai_man, _psf_man };
+        for (uint i=0; i<sizeof(mans)/sizeof(mans[0]); i++) {
+            w_rc_t rc = mans[i]->rebuild_hash_index(db());
+            if (rc.is_error()) {
+                cerr << "-> Hash index rebuild failed with: " << rc << endl;
+                return (rc.err_num());
+            }
+        }
+    }
     return (0);
 }
 
@@ -227,7 +227,8 @@ call_forwarding_t::call_forwarding_t(const uint4_t& pd)
 
     // create unique index cf_idx on (s_id, sf_type, start_time)
     uint keys[3] = { 0, 1, 2 }; // IDX { S_ID, SF_TYPE, START_TIME }
-    create_primary_idx_desc("CF_IDX", 0, keys, 3, pd);
+    // inserted, deleted and scanned, no hash index
+    create_primary_idx_desc("CF_IDX", 0, keys, 3, (pd & ~PD_HASHIDX));
 }
 
 
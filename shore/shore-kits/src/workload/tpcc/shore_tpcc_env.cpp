@@ -661,7 +661,19 @@ int ShoreTPCCEnv::post_init()
         else {
             TRACE( TRACE_ALWAYS, "-> Done\n");
             rc = db()->commit_xct();
-            return (0);
+        }
+    }
+
+    // The database was not loaded in this run, refill the hash indexes
+    if (get_pd() & PD_HASHIDX) {
+        table_man_t* mans[] = { _pwarehouse_man, _pdistrict_man, 
+                                _pcustomer_man, _pitem_man, _pstock_man };
+        for (uint i=0; i<sizeof(mans)/sizeof(mans[0]); i++) {
+            w_rc_t rc = mans[i]->rebuild_hash_index(db());
+            if (rc.is_error()) {
+                cerr << "-> Hash index rebuild failed with: " << rc << endl;
+                return (rc.err_num());
+            }
         }
     }
 
@@ -198,7 +198,8 @@ new_order_t::new_order_t(const uint4_t& pd) :
 
     // create unique index no_index on (w_id, d_id, o_id)
     uint keys[3] = {2, 1, 0}; // IDX { NO_W_ID, NO_D_ID, NO_O_ID }
-    create_primary_idx_desc("NO_IDX", 0, keys, 3, pd);
+    // grows with every NewOrder and it is scanned, no hash index
+    create_primary_idx_desc("NO_IDX", 0, keys, 3, (pd & ~PD_HASHIDX));
 }
 
 
@@ -219,11 +220,16 @@ order_t::order_t(const uint4_t& pd) :
 
     // create unique index o_index on (w_id, d_id, o_id)
     uint keys1[3] = {3, 2, 0}; // IDX { O_W_ID, O_D_ID, O_ID }
-    create_primary_idx_desc("O_IDX", 0, keys1, 3, pd);
+    // grows with every NewOrder, no hash index
+    create_primary_idx_desc("O_IDX", 0, keys1, 3, (pd & ~PD_HASHIDX));
 
     // create unique index o_cust_index on (w_id, d_id, c_id, o_id)
     uint keys2[4] = {3, 2, 1, 0}; // IDX { O_W_ID, O_D_ID, O_C_ID, O_ID }
     create_index_desc("O_CUST_IDX", 0, keys2, 4, true, false, pd);
+
+    // OrderStatus reads the rest from the index, without the record
+    uint payload[3] = {4, 5, 6}; // { O_ENTRY_D, O_CARRIER_ID, O_OL_CNT }
+    set_index_payload("O_CUST_IDX", payload, 3);
 }
 
 
@@ -250,7 +256,9 @@ order_line_t::order_line_t(const uint4_t& pd) :
     // Creating 10 indexes in order to be able to have parallel SMOs
     numIdxPartitions = 10; 
 #endif
-    create_primary_idx_desc("OL_IDX", numIdxPartitions, keys, 4, pd);
+    // grows with every NewOrder and it is scanned, no hash index
+    create_primary_idx_desc("OL_IDX", numIdxPartitions, keys, 4, 
+                            (pd & ~PD_HASHIDX));
 }
 
 
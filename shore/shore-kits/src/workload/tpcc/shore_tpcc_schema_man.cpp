@@ -113,6 +113,19 @@ warehouse_man_impl::wh_update_ytd_nl(ss_m* db,
 }
 
 
+w_rc_t 
+warehouse_man_impl::wh_index_pin(ss_m* db,
+                                 warehouse_pin& pin,
+                                 warehouse_tuple* ptuple,
+                                 const int w_id,
+                                 lock_mode_t lm)
+{
+    assert (ptuple);    
+    ptuple->set_value(0, w_id);
+    return (pin.probe(db, _ptable->find_index("W_IDX"), ptuple, lm));
+}
+
+
 
 /* ---------------- */
 /* --- DISTRICT --- */
@@ -198,6 +211,19 @@ w_rc_t district_man_impl::dist_update_next_o_id_nl(ss_m* db,
     return (dist_update_next_o_id(db,ptuple,next_o_id,NL));
 }
 
+w_rc_t district_man_impl::dist_index_pin(ss_m* db,
+                                         district_pin& pin,
+                                         district_tuple* ptuple,
+                                         const int w_id,
+                                         const int d_id,
+                                         lock_mode_t lm)
+{
+    assert (ptuple);
+    ptuple->set_value(0, d_id);
+    ptuple->set_value(1, w_id);
+    return (pin.probe(db, _ptable->find_index("D_IDX"), ptuple, lm));
+}
+
 
 
 /* ---------------- */
@@ -316,6 +342,21 @@ w_rc_t customer_man_impl::cust_index_probe_nl(ss_m * db,
     return (index_probe_nl_by_name(db, "C_IDX", ptuple));
 }
 
+w_rc_t customer_man_impl::cust_index_pin(ss_m* db,
+                                         customer_pin& pin,
+                                         customer_tuple* ptuple,
+                                         const int w_id,
+                                         const int d_id,
+                                         const int c_id,
+                                         lock_mode_t lm)
+{
+    assert (ptuple);
+    ptuple->set_value(0, c_id);
+    ptuple->set_value(1, d_id);
+    ptuple->set_value(2, w_id);
+    return (pin.probe(db, _ptable->find_index("C_IDX"), ptuple, lm));
+}
+
 w_rc_t customer_man_impl::cust_update_tuple(ss_m* db,
                                             customer_tuple* ptuple,
                                             const tpcc_customer_tuple& acustomer,
@@ -338,6 +379,43 @@ w_rc_t customer_man_impl::cust_update_tuple(ss_m* db,
 }
 
 
+w_rc_t customer_man_impl::cust_update_tuple(customer_pin& pin,
+                                            const tpcc_customer_tuple& acustomer,
+                                            const char* adata1,
+                                            const char* adata2)
+{
+    // 1. updates balance, ytd payment and payment count of the pinned 
+    //    tuple in place, with one update of the fields from C_BALANCE to 
+    //    C_PAYMENT_CNT (C_LAST_PAYMENT in-between is written unchanged)
+    // 2. updates the data, if given
+
+    typedef customer_layout L;
+    assert (pin.is_pinned());
+
+    char buf[L::C_PAYMENT_CNT::END - L::C_BALANCE::OFFSET];
+    double balance = acustomer.C_BALANCE.to_double();
+    double ytd_payment = acustomer.C_YTD_PAYMENT.to_double();
+    double last_payment = pin.get<L::C_LAST_PAYMENT>();
+    int payment_cnt = acustomer.C_PAYMENT_CNT;
+    memcpy(buf, &balance, sizeof(balance));
+    memcpy(buf + L::C_YTD_PAYMENT::OFFSET - L::C_BALANCE::OFFSET, 
+           &ytd_payment, sizeof(ytd_payment));
+    memcpy(buf + L::C_LAST_PAYMENT::OFFSET - L::C_BALANCE::OFFSET, 
+           &last_payment, sizeof(last_payment));
+    memcpy(buf + L::C_PAYMENT_CNT::OFFSET - L::C_BALANCE::OFFSET, 
+           &payment_cnt, sizeof(payment_cnt));
+    W_DO((pin.set_span<L::C_BALANCE,L::C_PAYMENT_CNT>(buf)));
+
+    if (adata1)
+        W_DO(pin.set<L::C_DATA_1>(adata1));
+
+    if (adata2)
+        W_DO(pin.set<L::C_DATA_2>(adata2));
+
+    return (RCOK);
+}
+
+
 w_rc_t customer_man_impl::cust_update_tuple_nl(ss_m* db,
                                                customer_tuple* ptuple,
                                                const tpcc_customer_tuple& acustomer,
@@ -550,6 +628,22 @@ w_rc_t order_man_impl::ord_update_carrier_by_index(ss_m* db,
     return (RCOK);
 }
 
+w_rc_t order_man_impl::ord_update_carrier_by_index(ss_m* db,
+                                                   order_pin& pin,
+                                                   order_tuple* ptuple,
+                                                   const int carrier_id)
+{
+    assert (ptuple);
+
+    // 1. idx probe for update the order
+    // 2. update carrier_id in place
+
+    W_DO(pin.probe(db, _ptable->find_index("O_IDX"), ptuple, EX));
+    W_DO(pin.set<order_layout::O_CARRIER_ID>(carrier_id));
+
+    return (RCOK);
+}
+
 w_rc_t order_man_impl::ord_update_carrier_by_index_nl(ss_m* db,
                                                       order_tuple* ptuple,
                                                       const int carrier_id)
@@ -727,6 +821,17 @@ w_rc_t item_man_impl::it_index_probe_nl(ss_m* db,
     return (index_probe_nl_by_name(db, "I_IDX", ptuple));
 }
 
+w_rc_t item_man_impl::it_index_pin(ss_m* db, 
+                                   item_pin& pin,
+                                   item_tuple* ptuple,
+                                   const int i_id,
+                                   lock_mode_t lm)
+{
+    assert (ptuple);
+    ptuple->set_value(0, i_id);
+    return (pin.probe(db, _ptable->find_index("I_IDX"), ptuple, lm));
+}
+
 
 
 /* ------------- */
@@ -767,6 +872,19 @@ w_rc_t stock_man_impl::st_index_probe_nl(ss_m* db,
     return (index_probe_nl_by_name(db, "S_IDX", ptuple));
 }
 
+w_rc_t stock_man_impl::st_index_pin(ss_m* db,
+                                    stock_pin& pin,
+                                    stock_tuple* ptuple,
+                                    const int w_id,
+                                    const int i_id,
+                                    lock_mode_t lm)
+{
+    assert (ptuple);
+    ptuple->set_value(0, i_id);
+    ptuple->set_value(1, w_id);
+    return (pin.probe(db, _ptable->find_index("S_IDX"), ptuple, lm));
+}
+
 w_rc_t  stock_man_impl::st_update_tuple(ss_m* db,
                                         stock_tuple* ptuple,
                                         const tpcc_stock_tuple* pstock,
@@ -792,5 +910,18 @@ w_rc_t  stock_man_impl::st_update_tuple_nl(ss_m* db,
     return (st_update_tuple(db,ptuple,pstock,NL));
 }
 
+w_rc_t  stock_man_impl::st_update_tuple(stock_pin& pin,
+                                        const tpcc_stock_tuple* pstock)
+{
+    // 1. updates the four counters of the pinned tuple, which are
+    //    adjacent on the record, in place
+
+    assert (pin.is_pinned());
+
+    int counters[4] = { pstock->S_REMOTE_CNT, pstock->S_QUANTITY, 
+                        pstock->S_ORDER_CNT, pstock->S_YTD };
+    return (pin.set_span<stock_layout::S_REMOTE_CNT,stock_layout::S_YTD>(counters));
+}
+
 
 EXIT_NAMESPACE(tpcc);
@@ -764,10 +764,12 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
     // 1. retrieve warehouse (read-only)
     TRACE( TRACE_TRX_FLOW, "App: %d NO:wh-idx-probe (%d)\n", 
 	   xct_id, pnoin._wh_id);
-    W_DO(_pwarehouse_man->wh_index_probe(_pssm, prwh, pnoin._wh_id));
-
     tpcc_warehouse_tuple awh;
-    prwh->get_value(7, awh.W_TAX);
+    {
+        warehouse_pin pwh(_pwarehouse_man);
+        W_DO(_pwarehouse_man->wh_index_pin(_pssm, pwh, prwh, pnoin._wh_id));
+        awh.W_TAX = pwh.get<warehouse_layout::W_TAX>();
+    }
 
 
     /* SELECT d_tax, d_next_o_id
@@ -780,35 +782,39 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
     // 2. retrieve district for update
     TRACE( TRACE_TRX_FLOW, "App: %d NO:dist-idx-upd (%d) (%d)\n", 
 	   xct_id, pnoin._wh_id, pnoin._d_id);
-    W_DO(_pdistrict_man->dist_index_probe_forupdate(_pssm, prdist,
-						    pnoin._wh_id, pnoin._d_id));
-    
     tpcc_district_tuple adist;
-    prdist->get_value(8, adist.D_TAX);
-    prdist->get_value(10, adist.D_NEXT_O_ID);
-    adist.D_NEXT_O_ID++;
+    {
+        district_pin pdist(_pdistrict_man);
+        W_DO(_pdistrict_man->dist_index_pin(_pssm, pdist, prdist,
+                                            pnoin._wh_id, pnoin._d_id, EX));
+        adist.D_TAX = pdist.get<district_layout::D_TAX>();
+        adist.D_NEXT_O_ID = pdist.get<district_layout::D_NEXT_O_ID>();
+        adist.D_NEXT_O_ID++;
+
+        /* UPDATE district
+         * SET d_next_o_id = :next_o_id+1
+         * WHERE CURRENT OF dist_cur
+         *
+         * done in place, while the record is still pinned
+         */
+    
+        TRACE( TRACE_TRX_FLOW, "App: %d NO:dist-upd-next-o-id (%d)\n", 
+               xct_id, adist.D_NEXT_O_ID);
+        W_DO(pdist.set<district_layout::D_NEXT_O_ID>(adist.D_NEXT_O_ID));
+    }
 
     // 3. retrieve customer
     TRACE( TRACE_TRX_FLOW, "App: %d NO:cust-idx-probe (%d) (%d) (%d)\n", 
 	   xct_id, pnoin._wh_id, pnoin._d_id, pnoin._c_id);
-    W_DO(_pcustomer_man->cust_index_probe(_pssm, prcust, pnoin._wh_id, 
-					  pnoin._d_id, pnoin._c_id));
-    
     tpcc_customer_tuple  acust;
-    prcust->get_value(15, acust.C_DISCOUNT);
-    prcust->get_value(13, acust.C_CREDIT, 3);
-    prcust->get_value(5, acust.C_LAST, 17);
-    
-    
-    /* UPDATE district
-     * SET d_next_o_id = :next_o_id+1
-     * WHERE CURRENT OF dist_cur
-     */
-    
-    TRACE( TRACE_TRX_FLOW, "App: %d NO:dist-upd-next-o-id (%d)\n", 
-	   xct_id, adist.D_NEXT_O_ID);
-    W_DO(_pdistrict_man->dist_update_next_o_id(_pssm, prdist,
-					       adist.D_NEXT_O_ID));
+    {
+        customer_pin pcust(_pcustomer_man);
+        W_DO(_pcustomer_man->cust_index_pin(_pssm, pcust, prcust, pnoin._wh_id, 
+                                            pnoin._d_id, pnoin._c_id));
+        acust.C_DISCOUNT = pcust.get<customer_layout::C_DISCOUNT>();
+        pcust.get<customer_layout::C_CREDIT>(acust.C_CREDIT, 3);
+        pcust.get<customer_layout::C_LAST>(acust.C_LAST, 17);
+    }
 
     double total_amount = 0;
 
@@ -829,11 +835,13 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
 	tpcc_item_tuple aitem;
 	TRACE( TRACE_TRX_FLOW, "App: %d NO:item-idx-probe (%d)\n", 
 	       xct_id, ol_i_id);
-	W_DO(_pitem_man->it_index_probe(_pssm, pritem, ol_i_id));
-	
-	pritem->get_value(4, aitem.I_DATA, 51);
-	pritem->get_value(3, aitem.I_PRICE);
-	pritem->get_value(2, aitem.I_NAME, 25);
+	{
+	    item_pin pit(_pitem_man);
+	    W_DO(_pitem_man->it_index_pin(_pssm, pit, pritem, ol_i_id));
+	    pit.get<item_layout::I_DATA>(aitem.I_DATA, 51);
+	    aitem.I_PRICE = pit.get<item_layout::I_PRICE>();
+	    pit.get<item_layout::I_NAME>(aitem.I_NAME, 25);
+	}
 	
 	int item_amount = aitem.I_PRICE * pnoin.items[item_cnt]._ol_quantity; 
 	total_amount += item_amount;
@@ -851,19 +859,24 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
 	tpcc_stock_tuple astock;
 	TRACE( TRACE_TRX_FLOW, "App: %d NO:stock-idx-upd (%d) (%d)\n", 
 	       xct_id, ol_supply_w_id, ol_i_id);
-	W_DO(_pstock_man->st_index_probe_forupdate(_pssm, prst,
-						   ol_supply_w_id, ol_i_id));
-	prst->get_value(0, astock.S_I_ID);
-	prst->get_value(1, astock.S_W_ID);
-	prst->get_value(5, astock.S_YTD);
+	stock_pin pst(_pstock_man);
+	W_DO(_pstock_man->st_index_pin(_pssm, pst, prst,
+                                       ol_supply_w_id, ol_i_id, EX));
+	astock.S_I_ID = pst.get<stock_layout::S_I_ID>();
+	astock.S_W_ID = pst.get<stock_layout::S_W_ID>();
+	astock.S_YTD = pst.get<stock_layout::S_YTD>();
 	astock.S_YTD += pnoin.items[item_cnt]._ol_quantity;
-	prst->get_value(2, astock.S_REMOTE_CNT);        
-	prst->get_value(3, astock.S_QUANTITY);
+	astock.S_REMOTE_CNT = pst.get<stock_layout::S_REMOTE_CNT>();
+	astock.S_QUANTITY = pst.get<stock_layout::S_QUANTITY>();
 	astock.S_QUANTITY -= pnoin.items[item_cnt]._ol_quantity;
 	if (astock.S_QUANTITY < 10) astock.S_QUANTITY += 91;
-	//prst->get_value(6+pnoin._d_id, astock.S_DIST[6+pnoin._d_id], 25);
-	prst->get_value(6+pnoin._d_id, astock.S_DIST[pnoin._d_id], 25);
-	prst->get_value(16, astock.S_DATA, 51);
+	// field 6+d_id, as before
+	memcpy(astock.S_DIST[pnoin._d_id], 
+               pst.ptr<stock_layout::S_DIST0>() + 
+               pnoin._d_id * stock_layout::S_DIST0::SIZE,
+               stock_layout::S_DIST0::SIZE);
+	astock.S_DIST[pnoin._d_id][stock_layout::S_DIST0::SIZE] = '\0';
+	pst.get<stock_layout::S_DATA>(astock.S_DATA, 51);
 
 	char c_s_brand_generic;
 	if (strstr(aitem.I_DATA, "ORIGINAL") != NULL && 
@@ -871,7 +884,7 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
 	    c_s_brand_generic = 'B';
 	else c_s_brand_generic = 'G';
 	
-	prst->get_value(4, astock.S_ORDER_CNT);
+	astock.S_ORDER_CNT = pst.get<stock_layout::S_ORDER_CNT>();
 	astock.S_ORDER_CNT++;
 	
 	if (pnoin._wh_id != ol_supply_w_id) {
@@ -886,7 +899,8 @@ w_rc_t ShoreTPCCEnv::xct_new_order(const int xct_id,
 	
 	TRACE( TRACE_TRX_FLOW, "App: %d NO:stock-upd-tuple (%d) (%d)\n", 
 	       xct_id, astock.S_W_ID, astock.S_I_ID);
-	W_DO(_pstock_man->st_update_tuple(_pssm, prst, &astock));
+	W_DO(_pstock_man->st_update_tuple(pst, &astock));
+	pst.unpin();
 	
 	
 	/* INSERT INTO order_line
@@ -992,18 +1006,71 @@ w_rc_t ShoreTPCCEnv::xct_payment(const int xct_id,
     prcust->_rep = &areprow;
     prhist->_rep = &areprow;
 
-    // 1. retrieve warehouse for update
+    /* UPDATE warehouse SET w_ytd = wytd + :h_amount
+     * WHERE w_id = :w_id
+     *
+     * SELECT w_name, w_street_1, w_street_2, w_city, w_state, w_zip
+     * FROM warehouse
+     * WHERE w_id = :w_id
+     *
+     * plan: index probe on "W_IDX"
+     */
+
+    // 1. retrieve warehouse for update, and update it in place
     TRACE( TRACE_TRX_FLOW, "App: %d PAY:wh-idx-upd (%d)\n", 
 	   xct_id, ppin._home_wh_id);
-    W_DO(_pwarehouse_man->wh_index_probe_forupdate(_pssm, prwh, 
-						   ppin._home_wh_id));
+    tpcc_warehouse_tuple awh;
+    {
+        warehouse_pin pwh(_pwarehouse_man);
+        W_DO(_pwarehouse_man->wh_index_pin(_pssm, pwh, prwh, 
+                                           ppin._home_wh_id, EX));
+
+        TRACE( TRACE_TRX_FLOW, "App: %d PAY:wh-update-ytd (%d)\n", 
+               xct_id, ppin._home_wh_id);
+        double w_ytd = pwh.get<warehouse_layout::W_YTD>();
+        W_DO(pwh.set<warehouse_layout::W_YTD>(w_ytd + ppin._h_amount));
+
+        pwh.get<warehouse_layout::W_NAME>(awh.W_NAME, 11);
+        pwh.get<warehouse_layout::W_STREET1>(awh.W_STREET_1, 21);
+        pwh.get<warehouse_layout::W_STREET2>(awh.W_STREET_2, 21);
+        pwh.get<warehouse_layout::W_CITY>(awh.W_CITY, 21);
+        pwh.get<warehouse_layout::W_STATE>(awh.W_STATE, 3);
+        pwh.get<warehouse_layout::W_ZIP>(awh.W_ZIP, 10);
+    }
     
-    // 2. retrieve district for update
+
+    /* UPDATE district SET d_ytd = d_ytd + :h_amount
+     * WHERE d_id = :d_id AND d_w_id = :w_id
+     *
+     * SELECT d_street_1, d_street_2, d_city, d_state, d_zip, d_name
+     * FROM district
+     * WHERE d_id = :d_id AND d_w_id = :w_id
+     *
+     * plan: index probe on "D_IDX"
+     */
+
+    // 2. retrieve district for update, and update it in place
     TRACE( TRACE_TRX_FLOW, "App: %d PAY:dist-idx-upd (%d) (%d)\n", 
 	   xct_id, ppin._home_wh_id, ppin._home_d_id);
-    W_DO(_pdistrict_man->dist_index_probe_forupdate(_pssm, prdist,
-						    ppin._home_wh_id,
-						    ppin._home_d_id));
+    tpcc_district_tuple adistr;
+    {
+        district_pin pdist(_pdistrict_man);
+        W_DO(_pdistrict_man->dist_index_pin(_pssm, pdist, prdist,
+                                            ppin._home_wh_id,
+                                            ppin._home_d_id, EX));
+
+        TRACE( TRACE_TRX_FLOW, "App: %d PAY:dist-upd-ytd (%d) (%d)\n", 
+               xct_id, ppin._home_wh_id, ppin._home_d_id);
+        double d_ytd = pdist.get<district_layout::D_YTD>();
+        W_DO(pdist.set<district_layout::D_YTD>(d_ytd + ppin._h_amount));
+
+        pdist.get<district_layout::D_NAME>(adistr.D_NAME, 11);
+        pdist.get<district_layout::D_STREET1>(adistr.D_STREET_1, 21);
+        pdist.get<district_layout::D_STREET2>(adistr.D_STREET_2, 21);
+        pdist.get<district_layout::D_CITY>(adistr.D_CITY, 21);
+        pdist.get<district_layout::D_STATE>(adistr.D_STATE, 3);
+        pdist.get<district_layout::D_ZIP>(adistr.D_ZIP, 10);
+    }
     
     // 3. retrieve customer for update
 
@@ -1075,33 +1142,32 @@ w_rc_t ShoreTPCCEnv::xct_payment(const int xct_id,
     
     TRACE( TRACE_TRX_FLOW, "App: %d PAY:cust-idx-upd (%d) (%d) (%d)\n", 
 	   xct_id, c_w, c_d, ppin._c_id);
-    W_DO(_pcustomer_man->cust_index_probe_forupdate(_pssm, prcust, 
-						    c_w, c_d, ppin._c_id));
+    customer_pin pcust(_pcustomer_man);
+    W_DO(_pcustomer_man->cust_index_pin(_pssm, pcust, prcust, 
+                                        c_w, c_d, ppin._c_id, EX));
 
-    //double c_balance, c_ytd_payment;
-    //int    c_payment_cnt;
     tpcc_customer_tuple acust;
     
     // retrieve customer
-    prcust->get_value(3,  acust.C_FIRST, 17);
-    prcust->get_value(4,  acust.C_MIDDLE, 3);
-    prcust->get_value(5,  acust.C_LAST, 17);
-    prcust->get_value(6,  acust.C_STREET_1, 21);
-    prcust->get_value(7,  acust.C_STREET_2, 21);
-    prcust->get_value(8,  acust.C_CITY, 21);
-    prcust->get_value(9,  acust.C_STATE, 3);
-    prcust->get_value(10, acust.C_ZIP, 10);
-    prcust->get_value(11, acust.C_PHONE, 17);
-    prcust->get_value(12, acust.C_SINCE);
-    prcust->get_value(13, acust.C_CREDIT, 3);
-    prcust->get_value(14, acust.C_CREDIT_LIM);
-    prcust->get_value(15, acust.C_DISCOUNT);
-    prcust->get_value(16, acust.C_BALANCE);
-    prcust->get_value(17, acust.C_YTD_PAYMENT);
-    prcust->get_value(18, acust.C_LAST_PAYMENT);
-    prcust->get_value(19, acust.C_PAYMENT_CNT);
-    prcust->get_value(20, acust.C_DATA_1, 251);
-    prcust->get_value(21, acust.C_DATA_2, 251);
+    pcust.get<customer_layout::C_FIRST>(acust.C_FIRST, 17);
+    pcust.get<customer_layout::C_MIDDLE>(acust.C_MIDDLE, 3);
+    pcust.get<customer_layout::C_LAST>(acust.C_LAST, 17);
+    pcust.get<customer_layout::C_STREET1>(acust.C_STREET_1, 21);
+    pcust.get<customer_layout::C_STREET2>(acust.C_STREET_2, 21);
+    pcust.get<customer_layout::C_CITY>(acust.C_CITY, 21);
+    pcust.get<customer_layout::C_STATE>(acust.C_STATE, 3);
+    pcust.get<customer_layout::C_ZIP>(acust.C_ZIP, 10);
+    pcust.get<customer_layout::C_PHONE>(acust.C_PHONE, 17);
+    acust.C_SINCE = (time_t)pcust.get<customer_layout::C_SINCE>();
+    pcust.get<customer_layout::C_CREDIT>(acust.C_CREDIT, 3);
+    acust.C_CREDIT_LIM = pcust.get<customer_layout::C_CREDIT_LIM>();
+    acust.C_DISCOUNT = pcust.get<customer_layout::C_DISCOUNT>();
+    acust.C_BALANCE = pcust.get<customer_layout::C_BALANCE>();
+    acust.C_YTD_PAYMENT = pcust.get<customer_layout::C_YTD_PAYMENT>();
+    acust.C_LAST_PAYMENT = pcust.get<customer_layout::C_LAST_PAYMENT>();
+    acust.C_PAYMENT_CNT = pcust.get<customer_layout::C_PAYMENT_CNT>();
+    pcust.get<customer_layout::C_DATA_1>(acust.C_DATA_1, 251);
+    pcust.get<customer_layout::C_DATA_2>(acust.C_DATA_2, 251);
     
     // update customer fields
     acust.C_BALANCE -= ppin._h_amount;
@@ -1133,59 +1199,13 @@ w_rc_t ShoreTPCCEnv::xct_payment(const int xct_id,
 	strncpy(c_new_data_2, acust.C_DATA_2, 250-len);
 	
 	TRACE( TRACE_TRX_FLOW, "App: %d PAY:cust-upd-tuple\n", xct_id);
-	W_DO(_pcustomer_man->cust_update_tuple(_pssm, prcust, acust, 
-					       c_new_data_1, c_new_data_2));
+	W_DO(_pcustomer_man->cust_update_tuple(pcust, acust, 
+                                               c_new_data_1, c_new_data_2));
     } else { // good customer
 	TRACE( TRACE_TRX_FLOW, "App: %d PAY:cust-upd-tuple\n", xct_id);
-	W_DO(_pcustomer_man->cust_update_tuple(_pssm, prcust, acust,
-					       NULL, NULL));
+	W_DO(_pcustomer_man->cust_update_tuple(pcust, acust, NULL, NULL));
     }
-
-    
-    /* UPDATE district SET d_ytd = d_ytd + :h_amount
-     * WHERE d_id = :d_id AND d_w_id = :w_id
-     *
-     * SELECT d_street_1, d_street_2, d_city, d_state, d_zip, d_name
-     * FROM district
-     * WHERE d_id = :d_id AND d_w_id = :w_id
-     *
-     * plan: index probe on "D_IDX"
-     */
-    
-    TRACE( TRACE_TRX_FLOW, "App: %d PAY:dist-upd-ytd (%d) (%d)\n", 
-	   xct_id, ppin._home_wh_id, ppin._home_d_id);
-    W_DO(_pdistrict_man->dist_update_ytd(_pssm, prdist, ppin._h_amount));
-
-    tpcc_district_tuple adistr;
-    prdist->get_value(2, adistr.D_NAME, 11);
-    prdist->get_value(3, adistr.D_STREET_1, 21);
-    prdist->get_value(4, adistr.D_STREET_2, 21);
-    prdist->get_value(5, adistr.D_CITY, 21);
-    prdist->get_value(6, adistr.D_STATE, 3);
-    prdist->get_value(7, adistr.D_ZIP, 10);
-    
-    
-    /* UPDATE warehouse SET w_ytd = wytd + :h_amount
-     * WHERE w_id = :w_id
-     *
-     * SELECT w_name, w_street_1, w_street_2, w_city, w_state, w_zip
-     * FROM warehouse
-     * WHERE w_id = :w_id
-     *
-     * plan: index probe on "W_IDX"
-     */
-    
-    TRACE( TRACE_TRX_FLOW, "App: %d PAY:wh-update-ytd (%d)\n", 
-	   xct_id, ppin._home_wh_id);
-    W_DO(_pwarehouse_man->wh_update_ytd(_pssm, prwh, ppin._h_amount));
-
-    tpcc_warehouse_tuple awh;
-    prwh->get_value(1, awh.W_NAME, 11);
-    prwh->get_value(2, awh.W_STREET_1, 21);
-    prwh->get_value(3, awh.W_STREET_2, 21);
-    prwh->get_value(4, awh.W_CITY, 21);
-    prwh->get_value(5, awh.W_STATE, 3);
-    prwh->get_value(6, awh.W_ZIP, 10);
+    pcust.unpin();
     
     
     /* INSERT INTO history
@@ -1330,14 +1350,16 @@ w_rc_t ShoreTPCCEnv::xct_order_status(const int xct_id,
     
     TRACE( TRACE_TRX_FLOW, "App: %d ORDST:cust-idx-probe (%d) (%d) (%d)\n", 
 	   xct_id, w_id, d_id, pstin._c_id);
-    W_DO(_pcustomer_man->cust_index_probe(_pssm, prcust, 
-					  w_id, d_id, pstin._c_id));
-    
     tpcc_customer_tuple acust;
-    prcust->get_value(3,  acust.C_FIRST, 17);
-    prcust->get_value(4,  acust.C_MIDDLE, 3);
-    prcust->get_value(5,  acust.C_LAST, 17);
-    prcust->get_value(16, acust.C_BALANCE);
+    {
+        customer_pin pcust(_pcustomer_man);
+        W_DO(_pcustomer_man->cust_index_pin(_pssm, pcust, prcust, 
+                                            w_id, d_id, pstin._c_id));
+        pcust.get<customer_layout::C_FIRST>(acust.C_FIRST, 17);
+        pcust.get<customer_layout::C_MIDDLE>(acust.C_MIDDLE, 3);
+        pcust.get<customer_layout::C_LAST>(acust.C_LAST, 17);
+        acust.C_BALANCE = pcust.get<customer_layout::C_BALANCE>();
+    }
     
     // 2. retrieve the last order of this customer
     
@@ -1349,13 +1371,18 @@ w_rc_t ShoreTPCCEnv::xct_order_status(const int xct_id,
      * plan: index scan on "O_CUST_IDX"
      */
     
+    // if covering, O_CUST_IDX carries all the fields read below
+    bool need_tuple = 
+        !_porder_man->table()->find_index("O_CUST_IDX")->is_covering();
+
     guard<index_scan_iter_impl<order_t> > o_iter;
     {
 	index_scan_iter_impl<order_t>* tmp_o_iter;
 	TRACE( TRACE_TRX_FLOW, "App: %d ORDST:ord-iter-by-idx\n", xct_id);
 	W_DO(_porder_man->ord_get_iter_by_index(_pssm, tmp_o_iter, prord,
 						lowrep, highrep,
-						w_id, d_id, pstin._c_id));
+						w_id, d_id, pstin._c_id,
+						SH, need_tuple));
 	o_iter = tmp_o_iter;
     }
     
@@ -1568,11 +1595,13 @@ w_rc_t ShoreTPCCEnv::_xct_delivery_helper(const int xct_id,
 	prord->set_value(0, no_o_id);
 	prord->set_value(2, d_id);
 	prord->set_value(3, w_id);
-	W_DO(_porder_man->ord_update_carrier_by_index(_pssm, prord,
-						      carrier_id));
-
 	int  c_id;
-	prord->get_value(1, c_id);
+	{
+	    order_pin pord(_porder_man);
+	    W_DO(_porder_man->ord_update_carrier_by_index(_pssm, pord, prord,
+                                                          carrier_id));
+	    c_id = pord.get<order_layout::O_C_ID>();
+	}
 	
 	// 4a. Calculate the total amount of the orders from orderlines
 	// 4b. Update all the orderlines with the current timestamp
@@ -1602,15 +1631,17 @@ w_rc_t ShoreTPCCEnv::_xct_delivery_helper(const int xct_id,
 	}
 	
 	// iterate over all the orderlines for the particular order
+	order_line_pin pol(_porder_line_man);
 	W_DO(ol_iter->next(_pssm, eof, *prol));
 	while (!eof) {
 	    // update the total amount
 	    int current_amount;
 	    prol->get_value(8, current_amount);
 	    total_amount += current_amount;
-	    // update orderline
-	    prol->set_value(6, ts_start);
-	    W_DO(_porder_line_man->update_tuple(_pssm, prol));
+	    // update orderline in place
+	    W_DO(pol.pin(prol->rid(), EX));
+	    W_DO(pol.set<order_line_layout::OL_DELIVERY_D>((double)ts_start));
+	    pol.unpin();
 	    // go to the next orderline
 	    W_DO(ol_iter->next(_pssm, eof, *prol));
 	}
@@ -1627,13 +1658,14 @@ w_rc_t ShoreTPCCEnv::_xct_delivery_helper(const int xct_id,
 	TRACE( TRACE_TRX_FLOW,
 	       "App: %d DEL:cust-idx-probe-upd (%d) (%d) (%d)\n", 
 	       xct_id, w_id, d_id, c_id);
-	W_DO(_pcustomer_man->cust_index_probe_forupdate(_pssm, prcust, 
-							w_id, d_id, c_id));
+	{
+	    customer_pin pcust(_pcustomer_man);
+	    W_DO(_pcustomer_man->cust_index_pin(_pssm, pcust, prcust, 
+                                                w_id, d_id, c_id, EX));
 	
-	double   balance;
-	prcust->get_value(16, balance);
-	prcust->set_value(16, balance+total_amount);
-	W_DO(_pcustomer_man->update_tuple(_pssm, prcust));
+	    double balance = pcust.get<customer_layout::C_BALANCE>();
+	    W_DO(pcust.set<customer_layout::C_BALANCE>(balance+total_amount));
+	}
 	
 	if(SPLIT_TRX && dlist.size()) {
 #ifdef CFG_FLUSHER
@@ -1702,11 +1734,13 @@ w_rc_t ShoreTPCCEnv::xct_stock_level(const int xct_id,
     
     TRACE( TRACE_TRX_FLOW, "App: %d STO:dist-idx-probe (%d) (%d)\n", 
 	   xct_id, pslin._wh_id, pslin._d_id);
-    W_DO(_pdistrict_man->dist_index_probe(_pssm, prdist, 
-					  pslin._wh_id, pslin._d_id));
-
     int next_o_id = 0;
-    prdist->get_value(10, next_o_id);
+    {
+        district_pin pdist(_pdistrict_man);
+        W_DO(_pdistrict_man->dist_index_pin(_pssm, pdist, prdist, 
+                                            pslin._wh_id, pslin._d_id));
+        next_o_id = pdist.get<district_layout::D_NEXT_O_ID>();
+    }
 
     
     /*
@@ -1785,6 +1819,7 @@ w_rc_t ShoreTPCCEnv::xct_stock_level(const int xct_id,
     int count = 0;
 
     // 2c. Nested loop join order_line with stock
+    stock_pin pst(_pstock_man);
     W_DO(ol_list_sort_iter.next(_pssm, eof, rsb));
     while (!eof) {
 	// use the index to find the corresponding stock tuple
@@ -1794,11 +1829,11 @@ w_rc_t ShoreTPCCEnv::xct_stock_level(const int xct_id,
 	rsb.get_value(1, w_id);
 
 	// 2d. Index probe the Stock
-	W_DO(_pstock_man->st_index_probe(_pssm, prst, w_id, i_id));
+	W_DO(_pstock_man->st_index_pin(_pssm, pst, prst, w_id, i_id));
 
 	// check if stock quantity below threshold 
-	int quantity;
-	prst->get_value(3, quantity);
+	int quantity = pst.get<stock_layout::S_QUANTITY>();
+	pst.unpin();
 	if (quantity < pslin._threshold) {
 	    // Do join on the two tuples	    
 	    /* the work is to count the number of unique item id. We keep
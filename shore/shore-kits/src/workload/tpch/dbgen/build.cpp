@@ -75,6 +75,46 @@ char lnoise[4] = {'|', '/', '-', '\\' }; // IP: Keep GCC happy
 #define TEXT(avg, sd, tgt)  dbg_text(tgt, (int)(avg * V_STR_LOW),(int)(avg * V_STR_HGH), sd)
 static void gen_phone PROTO((DSS_HUGE ind, char *target, long seed));
 
+/*
+ * The formats of the names and the date strings are made once, by
+ * init_build() (from dbgen_init()), instead of at the first row, so
+ * that the loaders can call the mk_* functions concurrently. Before,
+ * mk_order() also made and freed all the date strings for each order.
+ */
+static char szCustFormat[100];
+static char szClerkFormat[100];
+static char szMfgFormat[100];
+static char szBrandFormat[100];
+static char **asc_date = NULL;
+
+void
+init_build()
+{
+  char **mk_ascdate PROTO((void));
+
+  sprintf(szCustFormat, C_NAME_FMT, 9, HUGE_FORMAT + 1);
+  sprintf(szClerkFormat, O_CLRK_FMT, 9, HUGE_FORMAT + 1);
+  sprintf(szMfgFormat, P_MFG_FMT, 1, HUGE_FORMAT + 1);
+  sprintf(szBrandFormat, P_BRND_FMT, 2, HUGE_FORMAT + 1);
+
+  if (asc_date == NULL) {
+    asc_date = mk_ascdate();
+  }
+}
+
+void
+free_asc_date()
+{
+  if (asc_date == NULL)
+    return;
+
+  for (uint i=0; i<TOTDATE; i++) {
+    free (asc_date[i]);
+  }
+  free(asc_date);
+  asc_date = NULL;
+}
+
 DSS_HUGE
 rpb_routine(DSS_HUGE p)
 {
@@ -113,17 +153,9 @@ long
 mk_cust(DSS_HUGE n_cust, customer_t *c)
 {
   DSS_HUGE i;
-  static int bInit = 0;
-  static char szFormat[100];
-	
-  while (!bInit) {
-    TRACE( TRACE_ALWAYS, "Init mk_cust ..\n");
-    sprintf(szFormat, C_NAME_FMT, 9, HUGE_FORMAT + 1);
-    bInit = 1;
-  }
 
   c->custkey = n_cust;
-  sprintf(c->name, szFormat, C_NAME_TAG, n_cust);
+  sprintf(c->name, szCustFormat, C_NAME_TAG, n_cust);
   V_STR(C_ADDR_LEN, C_ADDR_SD, c->address);
   c->alen = strlen(c->address);
   RANDOM(i, 0, (nations.count - 1), C_NTRG_SD);
@@ -169,22 +201,10 @@ mk_order(DSS_HUGE index, order_t *o, long upd_num)
   DSS_HUGE  c_date;
   DSS_HUGE  clk_num;
   DSS_HUGE  supp_num;
-  char **asc_date = NULL;
   char tmp_str[2];
-  char **mk_ascdate PROTO((void));
   int delta = 1;
-  static int bInit = 0;
-  static char szFormat[100];
-	
-  while (!bInit) {
-    TRACE( TRACE_ALWAYS, "Init mk_order ..\n");
-    sprintf(szFormat, O_CLRK_FMT, 9, HUGE_FORMAT + 1);
-    bInit = 1;
-  }
-	
-  if (asc_date == NULL) {
-    asc_date = mk_ascdate();
-  }
+
+  assert (asc_date);
 
   mk_sparse (index, &o->okey,
              (upd_num == 0) ? 0 : 1 + upd_num / (10000 / arefresh));
@@ -206,7 +226,7 @@ mk_order(DSS_HUGE index, order_t *o, long upd_num)
 	
   pick_str(&o_priority_set, O_PRIO_SD, o->opriority);
   RANDOM(clk_num, 1, MAX((scale * O_CLRK_SCL), O_CLRK_SCL), O_CLRK_SD);
-  sprintf(o->clerk, szFormat, O_CLRK_TAG, clk_num);
+  sprintf(o->clerk, szClerkFormat, O_CLRK_TAG, clk_num);
   TEXT(O_CMNT_LEN, O_CMNT_SD, o->comment);
   o->clen = strlen(o->comment);
 #ifdef DEBUG
@@ -288,12 +308,6 @@ mk_order(DSS_HUGE index, order_t *o, long upd_num)
     o->orderstatus = 'F';
   }
 
-  
-  for (uint i=0; i<TOTDATE; i++) {
-      free (asc_date[i]);
-  }
-  free(asc_date);
-	
   return (0);
 }
 
@@ -303,21 +317,11 @@ mk_part(DSS_HUGE index, part_t *p)
   DSS_HUGE  temp;
   long      snum;
   DSS_HUGE  brnd;  
-  static int bInit = 0;
-  static char szFormat[100];
-  static char szBrandFormat[100];
-
-  if (!bInit) {
-      TRACE( TRACE_ALWAYS, "Init mk_part ..\n");
-      sprintf(szFormat, P_MFG_FMT, 1, HUGE_FORMAT + 1);
-      sprintf(szBrandFormat, P_BRND_FMT, 2, HUGE_FORMAT + 1);
-      bInit = 1;
-  }
-	       
+
   p->partkey = index;
   agg_str(&colors, (long)P_NAME_SCL, (long)P_NAME_SD, p->name); 
   RANDOM(temp, P_MFG_MIN, P_MFG_MAX, P_MFG_SD);
-  sprintf(p->mfgr, szFormat, P_MFG_TAG, temp);
+  sprintf(p->mfgr, szMfgFormat, P_MFG_TAG, temp);
   RANDOM(brnd, P_BRND_MIN, P_BRND_MAX, P_BRND_SD);
   sprintf(p->brand, szBrandFormat, P_BRND_TAG, (temp * 10 + brnd));
   p->tlen = pick_str(&p_types_set, P_TYPE_SD, p->type);
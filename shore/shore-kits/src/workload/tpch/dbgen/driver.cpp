@@ -105,7 +105,7 @@ double flt_scale;
 char *spawn_args[25];
 #endif
 #ifdef RNG_TEST
-extern seed_t Seed[];
+extern __thread seed_t Seed[];
 #endif
 
 
@@ -533,7 +533,7 @@ usage (void)
  * assumes the existance of getopt() to clean up the command 
  * line handling
  */
-int dbgen_init ()
+int dbgen_init (const double sf)
 {
 	
   table = (1 << CUST) |
@@ -553,8 +553,9 @@ int dbgen_init ()
   set_seeds = 0;
   header = 0;
   direct = 0;
-  scale = 1;
-  flt_scale = 1.0;
+  // the key ranges of the foreign keys (e.g. O_CKEY_MAX) follow the SF
+  scale = (sf < 1.0) ? 1 : (long)sf;
+  flt_scale = sf;
   updates = 0;
   arefresh = UPD_PCT;
   step = -1;
@@ -581,6 +582,11 @@ int dbgen_init ()
   // have to do this after init
   tdefs[NATION].base = nations.count;
   tdefs[REGION].base = regions.count;
+
+  // what the loaders share, made before they start
+  seed_reset();
+  init_text_pool();
+  init_build();
 			
   return (0);
 }
@@ -63,7 +63,7 @@ long *permute(long *set, int cnt, long stream, DSS_HUGE& source, long* cs);
 long *permute_dist(distribution *d, long stream, DSS_HUGE& source, distribution* cd);
 long seed;
 const char *eol[2] = {" ", "},"};
-extern seed_t Seed[];
+extern __thread seed_t Seed[];
 #ifdef TEST
 tdef tdefs = { NULL };
 #endif
@@ -109,37 +109,31 @@ permute(long *a, int c, long s, DSS_HUGE& source, long* cset)
 
 long *
 permute_dist(distribution *d, long stream, 
-             DSS_HUGE& source, distribution* cd)
+             DSS_HUGE& source, distribution* /* cd */)
 {
-  static bool bInit = false;
-  static distribution *dist = NULL;
-	
-  if (d != NULL) {
-    if (d->permute == (long *)NULL) {
-      d->permute = (long *)malloc(sizeof(long) * DIST_SIZE(d));
-      MALLOC_CHECK(d->permute);
-      //IP: permute does the same 
-      //for (int i=0; i < DIST_SIZE(d); i++) {
-      //   *(d->permute + i) = i;
-      //}
-    }
+  // Each thread shuffles its own copy of the permutation, instead of
+  // d->permute, so that the loaders can make parts concurrently
+  static __thread distribution *dist = NULL;
+  static __thread long *perm = NULL;
 
-    while (!bInit) {
+  if (d != NULL) {
+    if (perm == (long *)NULL) {
+      perm = (long *)malloc(sizeof(long) * DIST_SIZE(d));
+      MALLOC_CHECK(perm);
       dist = d;
-      bInit = true;
     }
+
     // IP: This will not work in general, but afaict from the code
     //     this function (permute_dist) is called only by mk_part
     //     so 'dist' will never have to change its value. 
     //     This assertion ensures that 'dist' will have a single 
     //     value.    
     assert (dist == d);
-    return (permute(dist->permute, DIST_SIZE(dist), stream, 
-                    source, cd->permute));
+    return (permute(perm, DIST_SIZE(dist), stream, source, perm));
   }
-		
+
   if (dist != NULL) {
-    return (permute(NULL, DIST_SIZE(dist), stream, source, cd->permute));
+    return (permute(NULL, DIST_SIZE(dist), stream, source, perm));
   }
   else {
     INTERNAL_ERROR("Bad call to permute_dist");	
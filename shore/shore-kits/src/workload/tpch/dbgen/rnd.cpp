@@ -73,6 +73,7 @@
 #include "workload/tpch/dbgen/config.h"
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #ifdef LINUX
 #include <stdint.h>
 #endif
@@ -112,6 +113,42 @@ dss_random(DSS_HUGE *tgt, DSS_HUGE lower, DSS_HUGE upper, long stream)
   return;
 }
 
+/*
+ * seed_reset() -- starts all the streams of the calling thread over
+ */
+void
+seed_reset()
+{
+  memcpy(Seed, Seed0, sizeof(Seed0));
+  return;
+}
+
+/*
+ * row_seek(t, n) -- positions the streams of table t (and of its child)
+ * at row n, as if rows 0 .. n-1 had been generated between row_start()
+ * and row_stop(). A loader seeks to the first row of its chunk, so the
+ * rows are the same whatever the number of loaders.
+ */
+void
+row_seek(int t, DSS_HUGE n)
+{
+  int i;
+
+  if (t == ORDER_LINE)
+    t = ORDER;
+  if (t == PART_PSUPP)
+    t = PART;
+
+  for (i=0; i <= MAX_STREAM; i++)
+    if ((Seed0[i].table == t) || 
+        ((tdefs[t].child != NONE) && (Seed0[i].table == tdefs[t].child)))
+      {
+        Seed[i] = Seed0[i];
+        NthElement(n * Seed[i].boundary, &Seed[i].value);
+      }
+  return;
+}
+
 void row_start(int /* t */)                     \
 {
   int i;
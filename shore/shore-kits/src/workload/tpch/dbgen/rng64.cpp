@@ -65,7 +65,7 @@ ENTER_NAMESPACE(dbgentpch);
 
 extern double dM;
 
-extern seed_t Seed[];
+extern __thread seed_t Seed[];
 
 void
 dss_random64(DSS_HUGE *tgt, DSS_HUGE nLow, DSS_HUGE nHigh, long nStream)
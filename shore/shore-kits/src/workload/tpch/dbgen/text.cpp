@@ -258,27 +258,26 @@ txt_sentence(char *dest, int sd)
   return(--res);
 }
 
+static char szTextPool[TEXT_POOL_SIZE + 1];
+static int bTextPool = 0;
+
 /*
- * dbg_text() -- 
- *		produce ELIZA-like text of random, bounded length, truncating the last 
- *		generated sentence as required
+ * init_text_pool() -- 
+ *		preload the text that dbg_text() picks from, once, by 
+ *		dbgen_init(), before the loaders start
  */
 void
-dbg_text(char *tgt, int min, int max, int sd)
+init_text_pool()
 {
-  DSS_HUGE hgLength = 0;
-  DSS_HUGE hgOffset;
   DSS_HUGE wordlen = 0;
   DSS_HUGE s_len;
   DSS_HUGE needed;
   char sentence[MAX_SENT_LEN + 1];
   char *cp;
-  static char szTextPool[TEXT_POOL_SIZE + 1];
-  static int bInit = 0;
   int nLifeNoise = 0;
   int txtPoolIndicator = TEXT_POOL_PROGRESS;
    
-  while (!bInit) {
+  if (!bTextPool) {
 
     cp = &szTextPool[0];
     TRACE( TRACE_ALWAYS, "Preloading text ..\n");
@@ -315,9 +314,25 @@ dbg_text(char *tgt, int min, int max, int sd)
     }
     
     *cp = '\0';
-    bInit = 1;
+    bTextPool = 1;
   }
 
+  return;
+}
+
+/*
+ * dbg_text() -- 
+ *		produce ELIZA-like text of random, bounded length, truncating the last 
+ *		generated sentence as required
+ */
+void
+dbg_text(char *tgt, int min, int max, int sd)
+{
+  DSS_HUGE hgLength = 0;
+  DSS_HUGE hgOffset;
+
+  assert (bTextPool);
+
   RANDOM(hgOffset, 0, TEXT_POOL_SIZE - max, sd);
   RANDOM(hgLength, min, max, sd);
   strncpy(&tgt[0], &szTextPool[hgOffset], (int)hgLength);
@@ -68,6 +68,10 @@ ENTER_NAMESPACE(tpch);
  * Builder      - The parallel working loading workers
  * Checkpointer - Takes a checkpoint every 1 min
  *
+ * With db-defer-indexes the loaders insert only to the heap files, with
+ * larger trxs and without the first rows, and then each index is built
+ * by its own thread (see table_man_t::build_index).
+ *
  ********************************************************************/
 
 const int PART_UNIT_PER_SF = 200000;
@@ -93,15 +97,16 @@ class ShoreTPCHEnv::table_builder_t : public thread_t
     long _cust_end;
     double _sf;
     int _loaders;
+    long _unit;
 public:
     table_builder_t(ShoreTPCHEnv* env, const int id,
                     const long part_start, const long part_end,
                     const long cust_start, const long cust_end,
-                    const double sf, const int loaders)
+                    const double sf, const int loaders, const long unit)
 	: thread_t(c_str("TPC-H L-%d",id)), _env(env), 
           _part_start(part_start), _part_end(part_end), 
           _cust_start(cust_start), _cust_end(cust_end),
-          _sf(sf), _loaders(loaders)
+          _sf(sf), _loaders(loaders), _unit(unit)
     { }
     virtual void work();
 };
@@ -113,14 +118,17 @@ struct ShoreTPCHEnv::table_creator_t : public thread_t
     int _loader_count;
     int _parts_per_thread;
     int _custs_per_thread;
+    int _divisor;
 
     table_creator_t(ShoreTPCHEnv* env, const double sf, const int loader_count,
-                    const int parts_per_thread, const int custs_per_thread)
+                    const int parts_per_thread, const int custs_per_thread,
+                    const int divisor)
 	: thread_t("TPC-H C"), 
           _env(env), _sf(sf), 
           _loader_count(loader_count),
           _parts_per_thread(parts_per_thread),
-          _custs_per_thread(custs_per_thread)
+          _custs_per_thread(custs_per_thread),
+          _divisor(divisor)
     { }
     virtual void work();
 };
@@ -180,7 +188,7 @@ void ShoreTPCHEnv::table_creator_t::work()
 
 
     // Do the baseline transaction
-    populate_baseline_input_t in = {_sf, _loader_count, DIVISOR, 
+    populate_baseline_input_t in = {_sf, _loader_count, _divisor, 
                                     _parts_per_thread, _custs_per_thread};
 
     w_rc_t e = RCOK;
@@ -216,7 +224,7 @@ void ShoreTPCHEnv::table_builder_t::work()
         return;
     }
     // 1. Load Part-related (~140MB)
-    for(int i=_part_start ; i < _part_end; i+=PART_POP_UNIT) {
+    for(int i=_part_start ; i < _part_end; i+=_unit) {
 	while(_env->get_measure() != MST_MEASURE) {
 	    usleep(1000);
 	}
@@ -224,7 +232,7 @@ void ShoreTPCHEnv::table_builder_t::work()
 	long tid = i;
 	populate_some_parts_input_t in = {tid};
 
-        tid = std::min(_part_end-i,PART_POP_UNIT);
+        tid = std::min(_part_end-i,_unit);
 
 	long log_space_needed = 0;
     retrypart:
@@ -249,7 +257,7 @@ void ShoreTPCHEnv::table_builder_t::work()
     TRACE( TRACE_ALWAYS, "Finished Parts %d .. %d \n", _part_start, _part_end);
 
     // 2. Load Cust-related (~825MB)
-    for (uint i=_cust_start ; i < _cust_end; i+=CUST_POP_UNIT) {
+    for (uint i=_cust_start ; i < _cust_end; i+=_unit) {
 	while(_env->get_measure() != MST_MEASURE) {
 	    usleep(1000);
 	}
@@ -257,7 +265,7 @@ void ShoreTPCHEnv::table_builder_t::work()
 	long tid = i;
 	populate_some_custs_input_t in = {tid};
 
-        tid = std::min(_cust_end-i,CUST_POP_UNIT);
+        tid = std::min(_cust_end-i,_unit);
 
 	long log_space_needed = 0;
     retrycust:
@@ -297,9 +305,17 @@ ShoreTPCHEnv::ShoreTPCHEnv()
     _scaling_factor = TPCH_SCALING_FACTOR;
 
 #ifdef CFG_QPIPE
-    // Set the default scheduling policy. We will worry later about changing
-    // that, possibly through the shell
-    set_sched_policy(NULL);
+    // Set the scheduling policy from the config (OS by default). We will
+    // worry later about changing that, possibly through the shell
+    string spolicy = envVar::instance()->getVar("qpipe-sched-policy","OS");
+    set_sched_policy(spolicy.c_str());
+
+    // The working memory of the sorts, aggregations and joins of all
+    // the queries, in MB (0 for no limit)
+    int mem_mb = envVar::instance()->getVarInt("qpipe-mem-budget",
+                                               qpipe::memory_broker_t::DEFAULT_BUDGET_MB);
+    qpipe::memory_broker_t::instance()->set_budget(
+        (size_t)mem_mb*1024*1024/qpipe::get_default_page_size());
 
     // Register stage containers
     register_stage_containers();
@@ -379,6 +395,16 @@ policy_t* ShoreTPCHEnv::set_sched_policy(const char* spolicy)
             _sched_policy = new policy_rr_module_t();
             return (_sched_policy);
         }
+
+        if ( !strcmp(spolicy, "STEAL_CPU") ) {
+            _sched_policy = new policy_steal_cpu_t();
+            return (_sched_policy);
+        }
+
+        if ( !strcmp(spolicy, "NUMA") ) {
+            _sched_policy = new policy_numa_t();
+            return (_sched_policy);
+        }
     }
     // Use the default scheduling policy (let the OS choose) 
     TRACE( TRACE_ALWAYS, "Default scheduling policy (OS)\n");
@@ -468,7 +494,7 @@ w_rc_t ShoreTPCHEnv::loaddata()
     CRITICAL_SECTION(scale_cs, _scaling_mutex);
 
     // 1. Call the function that initializes the dbgen
-    dbgen_init();
+    dbgen_init(_scaling_factor);
 
 
     time_t tstart = time(NULL);
@@ -478,20 +504,31 @@ w_rc_t ShoreTPCHEnv::loaddata()
        deadlock rates if we try to throw lots of threads at a small
        btree. To work around this we preload a number of records for
        each table and then fire up the (parallel) workers.
+       If the indexes are deferred there are no btrees to fight for.
      */
 
     // 1. Read the number of parallel loaders and calculate ranges
     int loaders_to_use = envVar::instance()->getVarInt("db-loaders",10);
+    bool defer_indexes = envVar::instance()->getVarInt("db-defer-indexes",0);
     long total_parts = _scaling_factor*PART_UNIT_PER_SF;
     long total_custs = _scaling_factor*CUST_UNIT_PER_SF;
     long parts_per_thread = total_parts/loaders_to_use;
     long custs_per_thread = total_custs/loaders_to_use;
+    int divisor = (defer_indexes ? 0 : DIVISOR);
+    long unit = (defer_indexes ? BULK_POP_UNIT : PART_POP_UNIT);
+
+    table_man_t* mans[] = { _pnation_man, _pregion_man, _ppart_man,
+                            _psupplier_man, _ppartsupp_man, _pcustomer_man,
+                            _porders_man, _plineitem_man };
+    const int man_count = sizeof(mans)/sizeof(mans[0]);
+    for (int i=0; i<man_count; i++) mans[i]->set_defer_indexes(defer_indexes);
 
     // 2. Fire up the table creator and baseline loader
     {
 	guard<table_creator_t> tc;
 	tc = new table_creator_t(this, _scaling_factor, loaders_to_use,
-                                 parts_per_thread, custs_per_thread);
+                                 parts_per_thread, custs_per_thread,
+                                 divisor);
 	tc->fork();
 	tc->join();
     }
@@ -504,20 +541,22 @@ w_rc_t ShoreTPCHEnv::loaddata()
     TRACE( TRACE_ALWAYS, "Firing up %d loaders ..\n", loaders_to_use);
     array_guard_t< guard<table_builder_t> > loaders(new guard<table_builder_t>[loaders_to_use]);
     for(int i=0; i < loaders_to_use; i++) {
-	long part_start = (i*parts_per_thread) + DIVISOR;
-	long part_end = ((i+1)*parts_per_thread > total_parts - 1) ? 
-            total_parts : (i+1)*parts_per_thread - 1;
+        // the chunks follow each other, the last one takes the rest
+	long part_start = (i*parts_per_thread) + divisor;
+	long part_end = (i == loaders_to_use-1) ? 
+            total_parts : (i+1)*parts_per_thread;
         assert (part_start <= part_end);
 
-	long cust_start = (i*custs_per_thread) + DIVISOR;
-	long cust_end = ((i+1)*custs_per_thread > total_custs - 1) ? 
-            total_custs : (i+1)*custs_per_thread - 1;
+	long cust_start = (i*custs_per_thread) + divisor;
+	long cust_end = (i == loaders_to_use-1) ? 
+            total_custs : (i+1)*custs_per_thread;
         assert (cust_start <= cust_end);
 
 	loaders[i] = new table_builder_t(this, i, 
                                          part_start, part_end, 
                                          cust_start, cust_end,
-                                         _scaling_factor, loaders_to_use);
+                                         _scaling_factor, loaders_to_use,
+                                         unit);
 	loaders[i]->fork();
     }
 
@@ -525,13 +564,23 @@ w_rc_t ShoreTPCHEnv::loaddata()
 	loaders[i]->join();
     }
 
+    time_t tdata = time(NULL);
+
+    // 5. Build the deferred indexes
+    if (defer_indexes) {
+        W_DO(table_man_t::build_deferred_indexes(db(), mans, man_count));
+    }
+
     time_t tstop = time(NULL);
 
-    // 5. Print stats
+    // 6. Print stats
     TRACE( TRACE_STATISTICS, "Loading finished. %d tables loaded in (%d) secs...\n",
            SHORE_TPCH_TABLES, (tstop - tstart));
+    TRACE( TRACE_STATISTICS, "SF (%.1f) Loaders (%d) CPUs (%d) Data (%d) secs Indexes (%d) secs\n",
+           _scaling_factor, loaders_to_use, get_max_cpu_count(),
+           (tdata - tstart), (tstop - tdata));
 
-    // 6. Notify that the env is loaded
+    // 7. Notify that the env is loaded
     _loaded = true;
     chk->join();
 
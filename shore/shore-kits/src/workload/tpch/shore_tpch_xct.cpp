@@ -112,6 +112,9 @@ void ShoreTPCHEnv::reset_stats()
 {
     CRITICAL_SECTION(last_stats_cs, _last_stats_mutex);
     _last_stats = _get_stats();
+#ifdef CFG_QPIPE
+    qpipe::memory_broker_t::instance()->clear_stats();
+#endif
 }
 
 
@@ -159,6 +162,17 @@ void ShoreTPCHEnv::print_throughput(const double iQueriedSF,
            delay, mioch/delay, avgcpuusage, 
            100*avgcpuusage/get_max_cpu_count(),
            (trxs_att-trxs_abt-trxs_dld)/delay);
+
+#ifdef CFG_QPIPE
+    // Each client runs one query at a time, so the queries in flight
+    // are as many as the clients
+    uint queries = trxs_att-trxs_abt-trxs_dld;
+    if (queries) {
+        TRACE( TRACE_ALWAYS, "AvgLat:    (%.2f ms)\n",
+               1000*iNumOfThreads*delay/queries);
+    }
+    qpipe::memory_broker_t::instance()->trace_stats();
+#endif
 }
 
 
@@ -199,6 +213,13 @@ void ShoreTPCHEnv::print_throughput(const double iQueriedSF,
   3) Loads #ParLoaders*DIVISOR Part units (Part,PartSupp)
   4) Loads #ParLoaders*DIVISOR Customer units (Customer,Order,Lineitem)
 
+  Each loader generates a chunk of the Parts and of the Customers. Every
+  population trx first positions the dbgen streams (of its own thread) 
+  at its first row (row_seek), and each row is generated between 
+  row_start and row_stop, so the rows do not depend on the number of 
+  loaders or on the trxs that are retried. When the indexes are deferred
+  (db-defer-indexes) the DIVISOR preloads are not needed.
+
 
   The sizes of the records:
   NATION:   192
@@ -231,7 +252,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_nation(const int id, rep_row_t& areprow)
     prna->_rep = &areprow;
 
     code_t ac;
+    row_start(NATION);
     mk_nation(id, &ac);
+    row_stop(NATION);
     
 #ifdef DO_PRINT_TPCH_RECS
     TRACE( TRACE_ALWAYS, "%ld,%s,%ld,%s,%d\n",
@@ -254,7 +277,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_region(const int id, rep_row_t& areprow)
     prre->_rep = &areprow;
 
     code_t ac;
+    row_start(REGION);
     mk_region(id, &ac);
+    row_stop(REGION);
 
 #ifdef DO_PRINT_TPCH_RECS
     TRACE( TRACE_ALWAYS, "%ld,%s,%s,%d\n", 
@@ -276,7 +301,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_supplier(const int id, rep_row_t& areprow)
     prsu->_rep = &areprow;
 
     dbgentpch::supplier_t as;
+    row_start(SUPP);
     mk_supp(id, &as);
+    row_stop(SUPP);
     
 #ifdef DO_PRINT_TPCH_RECS
     if (id%100==0) {
@@ -309,7 +336,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_part_based(const int id, rep_row_t& areprow)
 
     // 1. Part
     dbgentpch::part_t ap;
+    row_start(PART_PSUPP);
     mk_part(id, &ap);
+    row_stop(PART_PSUPP);
     
 #ifdef DO_PRINT_TPCH_RECS
     if (id%100==0) {
@@ -366,7 +395,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_cust_based(const int id, rep_row_t& areprow)
 
     // 1. Customer
     dbgentpch::customer_t ac;
+    row_start(CUST);
     mk_cust(id, &ac);
+    row_stop(CUST);
     
 #ifdef DO_PRINT_TPCH_RECS        
     if (id%100==0) {
@@ -389,7 +420,9 @@ w_rc_t ShoreTPCHEnv::_gen_one_cust_based(const int id, rep_row_t& areprow)
     for (int i=0; i<ORDERS_PER_CUSTOMER; ++i) {
 	// 2. Orders            
 	dbgentpch::order_t ao;
-	mk_order(id*10+i, &ao, 0);
+	row_start(ORDER_LINE);
+	mk_order(id*ORDERS_PER_CUSTOMER+i, &ao, 0);
+	row_stop(ORDER_LINE);
 	
 #ifdef DO_PRINT_TPCH_RECS
 	if (id%100==0) {
@@ -467,16 +500,19 @@ w_rc_t ShoreTPCHEnv::xct_populate_baseline(const int /* xct_id */,
 
     // 2. Build the small tables
     TRACE( TRACE_ALWAYS, "Building NATION !!!\n");    
+    row_seek(NATION, 0);
     for (int i=0; i<NO_NATIONS; ++i) {
         W_DO(_gen_one_nation(i, areprow));
     }
 
     TRACE( TRACE_ALWAYS, "Building REGION !!!\n");
+    row_seek(REGION, 0);
     for (int i=0; i<NO_REGIONS; ++i) {
         W_DO(_gen_one_region(i, areprow));
     }
 
     TRACE( TRACE_ALWAYS, "Building SUPPLIER !!!\n");
+    row_seek(SUPP, 0);
     for (int i=0; i<in._sf*SUPPLIER_PER_SF; ++i) {
         W_DO(_gen_one_supplier(i, areprow));
     }
@@ -491,6 +527,7 @@ w_rc_t ShoreTPCHEnv::xct_populate_baseline(const int /* xct_id */,
         TRACE( TRACE_ALWAYS, "Building PARTS and PARTSUPP (%d)!!!\n",sf*ppsf);
         //MA: A simplified version of single threaded build for correctness.
         int step=in._sf*PART_PER_SF/10;
+        row_seek(PART_PSUPP, 0);
         for (int i=0; i<in._sf*PART_PER_SF; ++i) {
             W_DO(_gen_one_part_based(i, areprow));
             if (i>0 && i%step==0) {
@@ -503,8 +540,10 @@ w_rc_t ShoreTPCHEnv::xct_populate_baseline(const int /* xct_id */,
         TRACE( TRACE_ALWAYS, "Starting PARTS !!!\n");
         for (int i = 0; i < in._loader_count; ++i) {
             long start = i * in._parts_per_thread;
-            long end = start + in._divisor - 1;
+            long end = start + in._divisor;
+            if (end <= start) continue;
             TRACE(TRACE_ALWAYS, "Parts %d .. %d\n", start, end);
+            row_seek(PART_PSUPP, start);
 	    for (int j = start; j < end; ++j) {
                 W_DO(_gen_one_part_based(j, areprow));
             }
@@ -520,6 +559,8 @@ w_rc_t ShoreTPCHEnv::xct_populate_baseline(const int /* xct_id */,
         int step=in._sf*CUSTOMER_PER_SF/10;
         int step100=in._sf*CUSTOMER_PER_SF/100;
         int current=0;
+        row_seek(CUST, 0);
+        row_seek(ORDER_LINE, 0);
         for (int i=0; i<in._sf*CUSTOMER_PER_SF; ++i) {
             W_DO(_gen_one_cust_based(i,areprow));
             if (i>0 && i%step==0) {
@@ -540,9 +581,12 @@ w_rc_t ShoreTPCHEnv::xct_populate_baseline(const int /* xct_id */,
         TRACE( TRACE_ALWAYS, "Starting CUSTS !!!\n");
         for (int i=0; i < in._loader_count; ++i) {
             long start = i*in._custs_per_thread;
-            long end = start + in._divisor - 1;
+            long end = start + in._divisor;
+            if (end <= start) continue;
             TRACE( TRACE_ALWAYS, "[%d/%d] Custs %d .. %d\n",
 		   i, in._loader_count, start, end);
+            row_seek(CUST, start);
+            row_seek(ORDER_LINE, start*ORDERS_PER_CUSTOMER);
             for (int j=start; j<end; ++j) {
                 W_DO(_gen_one_cust_based(j,areprow));
             }
@@ -568,6 +612,7 @@ w_rc_t ShoreTPCHEnv::xct_populate_some_parts(const int xct_id,
     int id = in._partid;
 
     // Generate (xct_id) parts
+    row_seek(PART_PSUPP, in._partid);
     for (id=in._partid; id<in._partid+xct_id; id++) {
         W_DO(_gen_one_part_based(id, areprow));
     }
@@ -591,6 +636,8 @@ w_rc_t ShoreTPCHEnv::xct_populate_some_custs(const int xct_id,
     int id = in._custid;
 
     // Generate (xct_id) customers
+    row_seek(CUST, in._custid);
+    row_seek(ORDER_LINE, in._custid*ORDERS_PER_CUSTOMER);
     for (id=in._custid; id<in._custid+xct_id; id++) {
         W_DO(_gen_one_cust_based(id, areprow));
     }
@@ -62,21 +62,47 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "w.h"
 #include "sthread.h"
 #include "latch.h"
+#include "sthread_fiber.h"
 #include "w_debug.h"
 
 #include <cstring>
+#include <sched.h>
 #include <sthread_stats.h>
 #include <list>
 #include <algorithm>
 
 const char* const  latch_t::latch_mode_str[3] = { "NL", "SH", "EX" };
 
+int latch_t::big_reader_max = 0;
+int latch_t::big_reader_ratio = 64;
+
+// how many latches are big-reader
+static w_base_t::uint4_t volatile br_latches = 0;
+
+// slot sets given back by latches that turned back, linked through
+// slots[0]._next_free. They are never freed: a reader that took the
+// address of a set just before the latch gave it back may still be
+// backing out of it.
+static latch_br_slot_t* br_spare_slots = NULL;
+static pthread_mutex_t br_spare_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// acquires between two looks at the SH/EX ratio
+enum { br_sh_window = 4096, br_ex_window = 64 };
+
+// a reader first joining a slot: one holder, one acquire
+static const int64_t br_reader = (int64_t(1) << 32) + 1;
+
 
 latch_t::latch_t(const char* const desc) :
 #if LATCH_CAN_BLOCK_LONG
     _blocking(false),
 #endif
-    _total_count(0) 
+    _total_count(0),
+    _br_slots(NULL),
+    _br_on(false),
+    _sh_acquires(0),
+    _ex_acquires(0),
+    _br_reads_seen(0)
 {
 #if LATCH_CAN_BLOCK_LONG
     DO_PTHREAD(pthread_mutex_init(&_block_lock, NULL));
@@ -101,6 +127,160 @@ latch_t::~latch_t()
     w_assert2(!_blocking);
 #endif
 #endif
+    if(_br_slots) {
+        _br_put_slots(_br_slots);
+        atomic_dec_uint(&br_latches);
+    }
+}
+
+/* A set of reader slots, each on a cache line of its own. A spare set
+ * may still have readers backing out of it, so its words are left
+ * alone; they come back to zero.
+ */
+latch_br_slot_t* latch_t::_br_get_slots()
+{
+    {
+        CRITICAL_SECTION(cs, br_spare_lock);
+        latch_br_slot_t* slots = br_spare_slots;
+        if(slots) {
+            br_spare_slots = slots[0]._next_free;
+            return slots;
+        }
+    }
+    void* p = NULL;
+    if(posix_memalign(&p, br_slot_align, sizeof(latch_br_slot_t) * br_slots))
+        return NULL;
+    memset(p, 0, sizeof(latch_br_slot_t) * br_slots);
+    return (latch_br_slot_t*) p;
+}
+
+void latch_t::_br_put_slots(latch_br_slot_t* slots)
+{
+    CRITICAL_SECTION(cs, br_spare_lock);
+    slots[0]._next_free = br_spare_slots;
+    br_spare_slots = slots;
+}
+
+/* Readers running on the same cpu share a slot, so that the word
+ * they update stays in the cache of that core.
+ */
+static int br_home_slot()
+{
+#if defined(linux)
+    int cpu = sched_getcpu();
+    if(cpu >= 0)
+        return cpu % latch_t::br_slots;
+#endif
+    // pthread_t is usually an address: drop the alignment bits
+    return int(((unsigned long) pthread_self() >> 12) % latch_t::br_slots);
+}
+
+uint64_t latch_t::_br_sum(const latch_br_slot_t* slots)
+{
+    uint64_t sum = 0;
+    for(int i=0; i < br_slots; i++) sum += slots[i]._word;
+    return sum;
+}
+
+/* Take the latch in SH mode through the slot of our core. A writer
+ * sets the lock word before it looks at the slots, and we join the
+ * slot before we look at the lock word, so one of us sees the other.
+ * The writer that turns the latch back takes the slots away before
+ * it lets go of the lock, so if they are still ours then, they are
+ * the ones writers drain.
+ */
+bool latch_t::_br_read(latch_holder_t* me)
+{
+    latch_br_slot_t* slots = _br_slots;
+    if(!slots)
+        return false;
+    int s = br_home_slot();
+    latch_br_slot_t &slot = slots[s];
+    atomic_add_64(&slot._word, br_reader);
+    membar_enter();
+    if(_lock.has_writer() || _br_slots != slots) {
+        atomic_add_64(&slot._word, -br_reader);
+        return false;
+    }
+    slot._reads++;
+    me->_br_slot = s;
+    return true;
+}
+
+/* Called by the writer, with the lock held: wait for the readers
+ * holding the latch through the slots to leave.
+ */
+bool latch_t::_br_drain(bool wait) const
+{
+    membar_enter();
+    while(_br_sum(_br_slots)) {
+        if(!wait)
+            return false;
+        FIBER_SPIN_PAUSE();
+    }
+    return true;
+}
+
+/* Called by a reader, with the lock held in SH mode (so no writer
+ * can miss the slots), every br_sh_window SH acquires.
+ */
+void latch_t::_br_consider_on()
+{
+    bool read_mostly = w_base_t::uint8_t(_ex_acquires) * big_reader_ratio 
+                        <= _sh_acquires;
+    _sh_acquires = _ex_acquires = 0;
+    if(!read_mostly || _br_on || !big_reader_max) 
+        return;
+
+    if(!_br_slots) {
+        if(atomic_inc_uint_nv(&br_latches) > (unsigned) big_reader_max) {
+            atomic_dec_uint(&br_latches);
+            return;
+        }
+        latch_br_slot_t* slots = _br_get_slots();
+        if(!slots) {
+            atomic_dec_uint(&br_latches);
+            return;
+        }
+        membar_producer();
+        if(atomic_cas_ptr(&_br_slots, NULL, slots) != NULL) {
+            // another reader beat us to it
+            _br_put_slots(slots);
+            atomic_dec_uint(&br_latches);
+        }
+    }
+    _br_reads_seen = 0;
+    for(int i=0; i < br_slots; i++) _br_reads_seen += _br_slots[i]._reads;
+    membar_producer();
+    _br_on = true;
+}
+
+/* Called by a writer of a big-reader latch, with the lock held and
+ * the slots drained, every br_ex_window EX acquires.
+ */
+void latch_t::_br_consider_off()
+{
+    w_base_t::uint4_t reads = 0;
+    for(int i=0; i < br_slots; i++) reads += _br_slots[i]._reads;
+    // readers that backed out of the slots took the lock
+    w_base_t::uint4_t since = reads - _br_reads_seen + _sh_acquires;
+    _br_reads_seen = reads;
+    _sh_acquires = 0;
+
+    bool read_mostly = w_base_t::uint8_t(_ex_acquires) * big_reader_ratio 
+                        <= since;
+    _ex_acquires = 0;
+    if(read_mostly && big_reader_max) 
+        return;
+
+    // give the slots back, so that the latches that turn big-reader
+    // later (another page in this buffer frame, say) can have them
+    latch_br_slot_t* slots = _br_slots;
+    _br_on = false;
+    _br_slots = NULL;
+    membar_producer();
+    _br_put_slots(slots);
+    atomic_dec_uint(&br_latches);
 }
 
 
@@ -139,6 +319,23 @@ __thread latch_holder_t* latch_holder_t::thread_local_holders(NULL);
  */
 __thread latch_holder_t* latch_holder_t::thread_local_freelist(NULL);
 
+#ifdef SM_FIBERS
+/**\cond skip */
+// Fibers of one carrier share its pthread; each needs its own lists.
+static void** holders_slot()
+{ return (void**) &latch_holder_t::thread_local_holders; }
+static void** freelist_slot()
+{ return (void**) &latch_holder_t::thread_local_freelist; }
+
+static struct latch_fiber_tls_init_t {
+    latch_fiber_tls_init_t() {
+        sthread_carrier_t::register_tls(holders_slot);
+        sthread_carrier_t::register_tls(freelist_slot);
+    }
+} latch_fiber_tls_init;
+/**\endcond skip */
+#endif
+
 /**\brief The list-handling class for latch_holder_t instances.
  *
  * \details
@@ -425,9 +622,10 @@ w_rc_t latch_t::_acquire(latch_mode_t new_mode,
     {
         // we already hold the latch
         w_assert2(me->_mode != LATCH_NL);
-        w_assert2(mode() == me->_mode); 
+        // (a writer may be waiting for the big-reader slots to drain)
+        w_assert2(me->_br_slot >= 0 || mode() == me->_mode); 
         // note: _mode can't change while we hold the latch!
-        if(mode() == LATCH_EX) {
+        if(me->_mode == LATCH_EX) {
             w_assert2(num_holders() == 1);
             // once we hold it in EX all later acquires default to EX as well
             new_mode = LATCH_EX; 
@@ -436,7 +634,10 @@ w_rc_t latch_t::_acquire(latch_mode_t new_mode,
         }
         if(me->_mode == new_mode) {
             DBGTHRD(<< "we already held latch in desired mode " << *this);
-            atomic_inc_uint(&_total_count);// BUG_SEMANTICS_FIX
+            if(me->_br_slot >= 0)
+                atomic_add_64(&_br_slots[me->_br_slot]._word, 1);
+            else
+                atomic_inc_uint(&_total_count);// BUG_SEMANTICS_FIX
             me->_count++; // thread-local
             // fprintf(stderr, "acquire latch %p %dx in mode %s\n", 
             //        this, me->_count, latch_mode_str[new_mode]);
@@ -449,14 +650,43 @@ w_rc_t latch_t::_acquire(latch_mode_t new_mode,
         me->_latch = this;
         me->_mode = LATCH_NL;
         me->_count = 0;
+        me->_br_slot = -1;
     }
 
     // have to acquire for real
     
 #if !LATCH_CAN_BLOCK_LONG
-    if(is_upgrade) {
+    if(new_mode == LATCH_SH && _br_on && _br_read(me)) {
+        // no shared word touched: don't count it in _total_count
+        w_assert2(!is_upgrade);
+        me->_mode = LATCH_SH;
+        me->_count = 1;
+        return RCOK;
+    }
+
+    if(is_upgrade && me->_br_slot >= 0) {
+        // we have to be the only reader left in the slots
+        if(!_lock.attempt_write())
+            return RC(sthread_t::stINUSE);
+        membar_enter();
+        if(_br_sum(_br_slots) != uint64_t(br_reader) + me->_count - 1) {
+            _lock.release_write();
+            return RC(sthread_t::stINUSE);
+        }
+        // move our acquires from the slot to the lock
+        atomic_add_64(&_br_slots[me->_br_slot]._word, 
+                      -(br_reader + me->_count - 1));
+        atomic_add_int(&_total_count, me->_count);
+        me->_br_slot = -1;
+        me->_mode = new_mode;
+    }
+    else if(is_upgrade) {
         if(!_lock.attempt_upgrade())
             return RC(sthread_t::stINUSE);
+        if(_br_slots && !_br_drain(false)) {
+            _lock.downgrade();
+            return RC(sthread_t::stINUSE);
+        }
 
         w_assert2(me->_count > 0);
         w_assert2(new_mode == LATCH_EX);
@@ -467,16 +697,28 @@ w_rc_t latch_t::_acquire(latch_mode_t new_mode,
                 _lock.attempt_read() : _lock.attempt_write();
             if(!success)
                 return RC(sthread_t::stTIMEOUT);
+            if(new_mode == LATCH_EX && _br_slots && !_br_drain(false)) {
+                _lock.release_write();
+                return RC(sthread_t::stTIMEOUT);
+            }
         }
         else {
             // forever timeout
 	    if(new_mode == LATCH_SH) {
-                _lock.acquire_read();
+                if(!_lock.attempt_read()) {
+                    INC_STH_STATS(latch_wait);
+                    _lock.acquire_read();
+                }
             }
             else {
                 w_assert2(new_mode == LATCH_EX);
                 w_assert2(me->_count == 0);
-                _lock.acquire_write();
+                if(!_lock.attempt_write()) {
+                    INC_STH_STATS(latch_wait);
+                    _lock.acquire_write();
+                }
+                if(_br_slots) 
+                    _br_drain(true);
             }
         }
         w_assert2(me->_count == 0);
@@ -485,6 +727,23 @@ w_rc_t latch_t::_acquire(latch_mode_t new_mode,
     atomic_inc_uint(&_total_count);// BUG_SEMANTICS_FIX
     me->_count++;// BUG_SEMANTICS_FIX
 
+    // see if the latch should turn big-reader, or back; with big-reader
+    // latches off (the default) the shared latch is not written here
+    if(big_reader_max || _br_on) {
+        if(new_mode == LATCH_SH) {
+            if(++_sh_acquires >= br_sh_window && !_br_on)
+                _br_consider_on();
+        }
+        else if(_br_on) {
+            if(++_ex_acquires >= br_ex_window)
+                _br_consider_off();
+        }
+        else if(++_ex_acquires >= br_sh_window) {
+            // write-mostly: start over
+            _sh_acquires = _ex_acquires = 0;
+        }
+    }
+
 #endif
 
 #if LATCH_CAN_BLOCK_LONG
@@ -585,6 +844,18 @@ latch_t::_release(latch_holder_t* me)
     w_assert2(me->_mode != LATCH_NL);
     w_assert2(me->_count > 0);
 
+    if(me->_br_slot >= 0) {
+        latch_br_slot_t &slot = _br_slots[me->_br_slot];
+        if(--me->_count) {
+            atomic_add_64(&slot._word, -1);
+            return;
+        }
+        atomic_add_64(&slot._word, -br_reader);
+        me->_br_slot = -1;
+        me->_mode = LATCH_NL;
+        return;
+    }
+
     atomic_dec_uint(&_total_count); 
     if(--me->_count) {
         DBGTHRD(<< "was held multiple times -- still " << me->_count << " " << *this );
@@ -116,6 +116,7 @@ public:
     latch_t*     _latch;
     latch_mode_t _mode;
     int          _count;
+    int          _br_slot; // reader slot of a big-reader SH hold, else -1
 private:
     sthread_t*   _threadid; // REMOVE ME (for debuging)
 
@@ -127,7 +128,8 @@ public:
     latch_holder_t* _next;
     
     latch_holder_t()
-    : _latch(NULL), _mode(LATCH_NL), _count(0), _threadid(NULL)
+    : _latch(NULL), _mode(LATCH_NL), _count(0), _br_slot(-1),
+      _threadid(NULL)
     {
         _threadid = sthread_t::me();
     }
@@ -143,6 +145,21 @@ public:
 
 #include <iosfwd>
 
+/**\brief The reader indicator of a big-reader latch on one core.
+ *
+ * \details
+ * The readers that hold the latch through this slot are counted in the
+ * high half of _word, their acquires (re-entries included) in the low
+ * half, so that the first acquire of a reader is a single atomic add.
+ */
+struct latch_br_slot_t
+{
+    uint64_t volatile  _word;
+    w_base_t::uint4_t  _reads;      // SH acquires, sampled (racy)
+    latch_br_slot_t*   _next_free;  // in slots[0] of a spare set
+    int                _padding[10]; // one slot per cache line
+};
+
 /**\brief A short-term hold (exclusive or shared) on a page.
  *
  * \details
@@ -215,7 +232,7 @@ public:
      */
 
     /// Number of acquires.  A thread may hold more than once.
-    int                     latch_cnt() const { return _total_count; }
+    int                     latch_cnt() const;
 
     /// How many threads hold the R/W lock.
     int                     num_holders() const;
@@ -229,6 +246,23 @@ public:
     /// string names of modes. 
     static const char* const    latch_mode_str[3];
 
+    /**\brief True if SH requests go through the per-core reader slots.
+     * \details
+     * A latch that is acquired in SH mode at least big_reader_ratio times
+     * as often as in EX mode turns into a big-reader latch: a reader
+     * then only touches the slot of its core, and a writer pays for it
+     * by waiting for all the slots to drain. The latch turns back when
+     * the writers catch up. Unreliable, for statistics and tests.
+     */
+    bool                    is_big_reader() const { return _br_on; }
+
+    enum { br_slots = 16, br_slot_align = 64 };
+    /// How many latches may be big-reader at once (0, the default,
+    /// disables them).
+    static int              big_reader_max;
+    /// SH per EX acquire at which a latch turns big-reader.
+    static int              big_reader_ratio;
+
 private:
     // found, iterator
     w_rc_t                _acquire(latch_mode_t m,
@@ -236,6 +270,14 @@ private:
                                  latch_holder_t* me);
     void                  _release(latch_holder_t* me);
     void                  _downgrade(latch_holder_t* me);
+
+    bool                  _br_read(latch_holder_t* me);
+    bool                  _br_drain(bool wait) const;
+    void                  _br_consider_on();
+    void                  _br_consider_off();
+    static uint64_t       _br_sum(const latch_br_slot_t* slots);
+    static latch_br_slot_t* _br_get_slots();
+    static void           _br_put_slots(latch_br_slot_t* slots);
     
 /* 
  * Note: the problem with #threads and #cpus and os preemption is real.
@@ -256,6 +298,15 @@ private:
     latch_t&                     operator=(const latch_t&);
 
     w_base_t::uint4_t            _total_count;
+
+    // big-reader mode; the latch gives its slots back when it turns
+    // back, and they are kept for other latches rather than freed,
+    // for readers may still be backing out of them
+    latch_br_slot_t* volatile    _br_slots;
+    bool volatile                _br_on;
+    w_base_t::uint4_t            _sh_acquires; // sampled (racy)
+    w_base_t::uint4_t            _ex_acquires;
+    w_base_t::uint4_t            _br_reads_seen;
 };
 
 
@@ -277,13 +328,29 @@ latch_t::is_latched() const
      * ... except for assertions / debugging... since there are bugs
      * in acquire/release of latches 
      */
-    return _lock.is_locked();
+    const latch_br_slot_t* slots = _br_slots;
+    return _lock.is_locked() || (slots && _br_sum(slots));
 }
 
+/* The readers counted in the slots while a writer holds the lock
+ * are only backing out of them, so don't count them.
+ */
 inline int
 latch_t::num_holders() const
 {
-    return _lock.num_holders();
+    int n = _lock.num_holders();
+    const latch_br_slot_t* slots = _br_slots;
+    if(slots && !_lock.has_writer()) n += int(_br_sum(slots) >> 32);
+    return n;
+}
+
+inline int
+latch_t::latch_cnt() const
+{
+    int n = _total_count;
+    const latch_br_slot_t* slots = _br_slots;
+    if(slots && !_lock.has_writer()) n += int(_br_sum(slots) & 0xffffffff);
+    return n;
 }
 
 
@@ -291,7 +358,10 @@ inline latch_mode_t
 latch_t::mode() const
 {
     switch(_lock.mode()) {
-    case mcs_rwlock::NONE: return LATCH_NL;
+    case mcs_rwlock::NONE: {
+             const latch_br_slot_t* slots = _br_slots;
+             return (slots && _br_sum(slots))? LATCH_SH : LATCH_NL;
+         }
     case mcs_rwlock::WRITER: return LATCH_EX;
     case mcs_rwlock::READER: return LATCH_SH;
     default: w_assert1(0); // shouldn't ever happen
@@ -0,0 +1,154 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/* Throughput of one read-mostly latch (like the latch of a B-tree
+ * root) for 1, 2, 4... threads, as a plain latch and as a big-reader
+ * latch. Readers check that they never see a writer half-way.
+ */
+
+#include <cstdlib>
+#include <w_base.h>
+#include <sthread.h>
+#include <w_getopt.h>
+#include <latch.h>
+#include <iostream>
+
+int     MaxThreads = 8;
+int     Ops = 1000000;      // per thread
+int     WriteEvery = 1000;  // one EX acquire per this many
+bool    verbose = false;
+
+int     errors = 0;
+
+latch_t* the_latch = NULL;
+long volatile guarded[2];   // equal unless a writer holds the latch
+
+class latch_scale_thread_t : public sthread_t {
+public:
+    latch_scale_thread_t(int id)
+        : sthread_t(t_regular, "latch_scale"), _id(id), _torn(0) { }
+    int torn() const { return _torn; }
+protected:
+    void run() {
+        for(int i=1; i <= Ops; i++) {
+            if(WriteEvery && (i + _id) % WriteEvery == 0) {
+                W_COERCE(the_latch->latch_acquire(LATCH_EX));
+                guarded[0]++;
+                guarded[1]++;
+                the_latch->latch_release();
+            }
+            else {
+                W_COERCE(the_latch->latch_acquire(LATCH_SH));
+                if(guarded[0] != guarded[1]) _torn++;
+                the_latch->latch_release();
+            }
+        }
+    }
+private:
+    int _id;
+    int _torn;
+};
+
+int parse_args(int argc, char **argv)
+{
+    int bad = 0;
+    int c;
+    while((c = getopt(argc, argv, "t:n:w:v")) != EOF) {
+        switch(c) {
+        case 't': MaxThreads = atoi(optarg); break;
+        case 'n': Ops = atoi(optarg); break;
+        case 'w': WriteEvery = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default: bad++; break;
+        }
+    }
+    if(bad || MaxThreads < 1 || Ops < 1 || WriteEvery < 0) {
+        cerr << "usage: " << argv[0]
+             << " [-t max_threads] [-n ops_per_thread]"
+             << " [-w write_every (0: no writes)] [-v]" << endl;
+        return -1;
+    }
+    return optind;
+}
+
+// ops per second of nthreads threads
+double run(int nthreads, bool big_reader)
+{
+    latch_t::big_reader_max = big_reader ? 1 : 0;
+    the_latch = new latch_t("latch_scale");
+    guarded[0] = guarded[1] = 0;
+
+    latch_scale_thread_t** t = new latch_scale_thread_t*[nthreads];
+    for(int i=0; i < nthreads; i++) t[i] = new latch_scale_thread_t(i);
+
+    stime_t start(stime_t::now());
+    for(int i=0; i < nthreads; i++) W_COERCE(t[i]->fork());
+    for(int i=0; i < nthreads; i++) W_COERCE(t[i]->join());
+    sinterval_t elapsed(stime_t::now() - start);
+
+    for(int i=0; i < nthreads; i++) {
+        if(t[i]->torn()) {
+            cerr << "a reader saw a writer half-way " << t[i]->torn()
+                 << " times" << endl;
+            errors++;
+        }
+        delete t[i];
+    }
+    delete [] t;
+
+    if(verbose) {
+        cout << nthreads << " threads: latch "
+             << (the_latch->is_big_reader() ? "is" : "is not")
+             << " big-reader at the end" << endl;
+    }
+    if(the_latch->is_latched() || the_latch->latch_cnt()) {
+        cerr << "latch still held at the end: " << *the_latch;
+        errors++;
+    }
+    delete the_latch;
+    the_latch = NULL;
+
+    double secs = double(elapsed);
+    return secs > 0 ? double(Ops) * nthreads / secs : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if(parse_args(argc, argv) < 0) return 1;
+
+    int saved_max = latch_t::big_reader_max;
+    cout << "threads\tplain ops/s\tbig-reader ops/s" << endl;
+    for(int n=1; n <= MaxThreads; n *= 2) {
+        double plain = run(n, false);
+        double br = run(n, true);
+        cout << n << "\t" << long(plain) << "\t" << long(br) << endl;
+    }
+    latch_t::big_reader_max = saved_max;
+
+    if(verbose) sthread_t::dump_stats(cout);
+    return errors ? 1 : 0;
+}
@@ -98,6 +98,7 @@ class cvec_t : protected VEC_t {
     friend class vec_t; // so vec_t can look at VEC_t
     friend class key_ranges_map; // to reach pair
     friend class data_access_histogram;
+    friend class data_access_sketch;
     
 protected:
     static        CADDR_T  zero_location; // see zvec_t, which is supposed
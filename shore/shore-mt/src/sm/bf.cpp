@@ -65,6 +65,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 
 #include <sm_int_0.h>
 #include "bf_core.h"
+#include <fstream>
 #include "chkpt.h"
 
 #ifdef EXPLICIT_TEMPLATE
@@ -939,6 +940,22 @@ bfcb_t* bf_m::get_cb(const page_s* p)
 }
 
 
+/*********************************************************************
+ *
+ *  bf_m::frame_index(page)
+ *
+ *  Given a frame, return its index in the buffer pool, in
+ *  [0, npages()), or -1 if the page is not a frame.
+ *  NB: like get_cb, this does NOT check the hash table.
+ *
+ *********************************************************************/
+int bf_m::frame_index(const page_s* p) 
+{
+    int idx = p - bf_core_m::_bufpool;
+    return (idx<0 || idx>=bf_core_m::_num_bufs) ? -1 : idx;
+}
+
+
 /*********************************************************************
  *
  *  bf_m::is_bf_page(const page_s* p, bool and_in_htab = true)
@@ -1207,6 +1224,12 @@ bf_m::_fix(
 
             b->set_pid(pid); // to set the store id as well as the page id
         }
+
+        if(b->probation() && !me()->scan_hint()) {
+            // referenced outside the scan: the page is hot after all
+            b->set_probation(false);
+            INC_TSTAT(bf_probation_promote);
+        }
     } else {
         /*
          * Page not found, have to read it or get a new frame 
@@ -1273,6 +1296,10 @@ bf_m::_fix(
         // publish will leave us with the given latch mode,
         // downgrading or releasing the latch as necessary
         _core->publish(b, mode, false /* no error occurred */);
+
+        if(me()->scan_hint()) {
+            _core->admit(b);
+        }
     }
 
     /*
@@ -1650,6 +1677,10 @@ bf_m::unfix(const page_s* buf, bool dirty, int ref_bit)
     w_assert1(b->pin_cnt() > 0);
 
     vid_t        v = b->pid().vol();
+    if(use_2q_replacement && me()->scan_hint()) {
+        // a scan does not come back: don't let the clock keep it around
+        ref_bit = 0;
+    }
     _core->unpin(b, ref_bit);
     // b is invalid now
     INC_TSTAT(page_unfix_cnt);
@@ -3172,6 +3203,68 @@ bf_m::snapshot_me(
 }
 
 
+/*********************************************************************
+ *
+ *  bf_m::save_image(path)
+ *
+ *  Write the ids of the pages now in the buffer pool to the file path,
+ *  one per line, in the order of the pages on the volumes. Like
+ *  snapshot(), it does not lock up the pool: the image only has to be
+ *  good enough for load_image() to warm up a later run.
+ *
+ *********************************************************************/
+rc_t
+bf_m::save_image(const char* path)
+{
+    lpid_t* pids = new lpid_t[npages()];
+    w_auto_delete_array_t<lpid_t> auto_del(pids);
+
+    int count = 0;
+    for (int i = 0; i < npages(); i++) {
+        lpid_t pid = _core->_buftab[i].pid();
+        if (pid.page) pids[count++] = pid;
+    }
+    qsort(pids, count, sizeof(lpid_t), cmp_lpid);
+
+    ofstream f(path, ios::out | ios::trunc);
+    if (!f) return RC(eOS);
+    for (int i = 0; i < count; i++) f << pids[i] << endl;
+    f.close();
+    if (!f) return RC(eOS);
+    return RCOK;
+}
+
+
+/*********************************************************************
+ *
+ *  bf_m::load_image(path, nloaded)
+ *
+ *  Fix (and unfix) the pages listed in the file path by save_image(),
+ *  at most as many as the pool holds. The volumes have to be mounted.
+ *  Pages that cannot be fixed any more (e.g. of a store destroyed
+ *  since) are skipped. Returns in nloaded the number of pages read.
+ *
+ *********************************************************************/
+rc_t
+bf_m::load_image(const char* path, u_int& nloaded)
+{
+    nloaded = 0;
+    ifstream f(path);
+    if (!f) return RC(eOS);
+
+    lpid_t pid;
+    while ((int)nloaded < npages() && (f >> pid)) {
+        if (!pid.valid()) continue;
+        page_p page;
+        store_flag_t store_flags = st_bad;
+        w_rc_t rc = page.fix(pid, page_p::t_any_p, LATCH_SH, 0, store_flags);
+        if (rc.is_error()) continue;
+        nloaded++;
+    } // unfix
+    return RCOK;
+}
+
+
 
 /*********************************************************************
  *  
@@ -200,6 +200,8 @@ public:
                                                        wal_page=0) const;
     
     static bfcb_t*              get_cb(const page_s*) ;
+    // index of the frame in the pool, or -1 if p is not a frame
+    static int                  frame_index(const page_s* p) ;
 
     static void                 dump(ostream &o);
     static void                 stats(
@@ -221,6 +223,11 @@ public:
         u_int&                             ndiff
         );
 
+    // the ids of the pages in the pool, to warm up a later run
+    static rc_t                 save_image(const char* path);
+    static rc_t                 load_image(const char* path, 
+                                           u_int& nloaded);
+
     static lsn_t                min_rec_lsn();
     static rc_t                 get_rec_lsn(
         int                                &start_idx, 
@@ -314,6 +321,30 @@ bf_m::conditional_fix(
         no_read, return_store_flags, ignore_store_id, stflags);
 }
 
+/**\brief Marks the page fixes of the calling thread as part of a
+ * sequential scan, for the lifetime of the object.
+ * \details
+ * With the 2q replacement policy (sm_bufpool_replacement), pages a
+ * scan reads in are put on probation and replaced before the pages
+ * of the working set; see bf_core_m::admit. Nested hints only add up:
+ * a hint with on==false does not clear an enclosing one.
+ */
+class bf_scan_hint_t {
+    bool                _saved;
+public:
+    NORET               bf_scan_hint_t(bool on = true) 
+                            : _saved(me()->scan_hint()) {
+                            me()->set_scan_hint(_saved || on);
+                        }
+    NORET               ~bf_scan_hint_t() {
+                            me()->set_scan_hint(_saved);
+                        }
+private:
+    // disabled
+    NORET               bf_scan_hint_t(const bf_scan_hint_t&);
+    bf_scan_hint_t&     operator=(const bf_scan_hint_t&);
+};
+
 /*<std-footer incl-file-exclusion='BF_H'>  -- do not edit anything below this line -- */
 
 #endif          /*</std-footer>*/
@@ -277,6 +277,12 @@ transit_bucket_t   transit_bucket_t::_transit_buckets[
  */
 int                bf_core_m::_hand = 0; // hand of clock
 
+queue_based_lock_t      bf_core_m::_probq_mutex;
+bf_core_m::probe_t*     bf_core_m::_probq = 0;
+int                     bf_core_m::_probq_size = 0;
+int                     bf_core_m::_probq_head = 0;
+int                     bf_core_m::_probq_count = 0;
+
 inline ostream&
 bfcb_t::print_frame(ostream& o, bool in_htab)
 {
@@ -376,8 +382,10 @@ void bfcb_t::initialize(const char *const name,
 
     _refbit = 0;
     _hotbit = 0;
+    _probation = false;
     _hash = 0;
     _hash_func = hfunc;
+    _mod_stamp = 0;
 }
 
 /*********************************************************************
@@ -437,6 +445,14 @@ bf_core_m::bf_core_m(uint4_t n, char *bp)
 
     if (!_buftab) { W_FATAL(eOUTOFMEMORY); }
 
+    // an eighth of the pool is enough to absorb the read-ahead
+    // of the scans without letting them flush the hot pages
+    _probq_size = std::max(_num_bufs/8, 8);
+    _probq = new probe_t [_probq_size];
+    if (!_probq) { W_FATAL(eOUTOFMEMORY); }
+    _probq_head = 0;
+    _probq_count = 0;
+
     // 512MB per thread...
     static int const CHUNK_SIZE = 1<<16;
     static int const MAX_THREADS = 30;
@@ -511,6 +527,8 @@ bf_core_m::~bf_core_m()
     delete _htab;
 
     delete [] _buftab;
+    delete [] _probq;
+    _probq = 0;
     _unused.shutdown(); // reinitialize it 
 }
 
@@ -1601,7 +1619,13 @@ bf_core_m::replacement()
     int next_round = _num_bufs;
     int rounds = 1;
     while(1) {
-        { // critical section
+        /*
+         * With the 2q policy, pages that a scan read and nobody
+         * referenced since go first, whatever their refbit.
+         */
+        int check_rounds = 3;
+        p = _probation_victim();
+        if(!p) { // critical section
             CRITICAL_SECTION(cs, _bfc_mutex); // PROTOCOL
             int start = _hand;
             int i;
@@ -1658,6 +1682,7 @@ bf_core_m::replacement()
                  */
                 return (bfcb_t*)0; 
             }
+            check_rounds = rounds;
         } // end critical section
 
         /* 
@@ -1728,7 +1753,7 @@ bf_core_m::replacement()
                     if(b.get_frame(pid) == p && // We have the htab bucket lock. 
                         p->pid() == pid && 
                         _in_htab(p) && // could have been removed altogether
-                        can_replace(p, rounds) && 
+                        can_replace(p, check_rounds) && 
                         _htab->remove(p))  // changes p->hash_func
                     {
                         w_assert2(p->hash() == idx);
@@ -1769,6 +1794,84 @@ bf_core_m::replacement()
 }
 
 
+/*********************************************************************
+ *
+ *  bf_core_m::admit(p)
+ *
+ *  Put the frame "p", which the caller just read in for a sequential
+ *  scan, on probation. Called with p pinned. If the probation queue
+ *  is full, the oldest frame leaves it and is left to the clock.
+ *  A frame leaves probation early if someone other than a scan fixes
+ *  it (see bf_m::_fix); its entry in the queue is then stale.
+ *
+ *********************************************************************/
+void
+bf_core_m::admit(bfcb_t* p)
+{
+    w_assert1(p->pin_cnt() > 0);
+    if(!smlevel_0::use_2q_replacement || p->probation()) {
+        return;
+    }
+
+    CRITICAL_SECTION(cs, _probq_mutex);
+    if(_probq_count == _probq_size) {
+        probe_t &e = _probq[_probq_head];
+        bfcb_t* q = _buftab + e.idx;
+        if(q->pid() == e.pid) {
+            q->set_probation(false);
+        }
+        _probq_head = (_probq_head+1 == _probq_size) ? 0 : _probq_head+1;
+        _probq_count--;
+    }
+    probe_t &e = _probq[(_probq_head + _probq_count) % _probq_size];
+    e.idx = p - _buftab;
+    e.pid = p->pid();
+    _probq_count++;
+    p->set_probation(true);
+    INC_TSTAT(bf_probation_admit);
+}
+
+
+/*********************************************************************
+ *
+ *  bf_core_m::_probation_victim()
+ *
+ *  Return the oldest frame on probation that can be replaced, or
+ *  NULL. Entries of frames that were promoted or replaced meanwhile
+ *  are dropped; those of frames still pinned (the scan is on them)
+ *  go back to the tail. Like the clock, the caller must check the
+ *  frame again once it holds the bucket lock and the latch.
+ *
+ *********************************************************************/
+bfcb_t*
+bf_core_m::_probation_victim()
+{
+    if(!smlevel_0::use_2q_replacement || _probq_count == 0) {
+        return 0;
+    }
+
+    CRITICAL_SECTION(cs, _probq_mutex);
+    for(int n = _probq_count; n > 0; n--) {
+        probe_t e = _probq[_probq_head];
+        _probq_head = (_probq_head+1 == _probq_size) ? 0 : _probq_head+1;
+        _probq_count--;
+
+        bfcb_t* p = _buftab + e.idx;
+        if(!p->probation() || !(p->pid() == e.pid) || !_in_htab(p)) {
+            continue;
+        }
+        if(can_replace(p, 3)) {
+            p->set_probation(false);
+            INC_TSTAT(bf_probation_replace);
+            return p;
+        }
+        _probq[(_probq_head + _probq_count) % _probq_size] = e;
+        _probq_count++;
+    }
+    return 0;
+}
+
+
 #if W_DEBUG_LEVEL > 2
 /*********************************************************************
  *
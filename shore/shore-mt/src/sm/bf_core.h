@@ -123,6 +123,7 @@ public:
     bool                         get_cb(const bfpid_t& p, bfcb_t*& ret) const;
 
     bfcb_t*                      replacement();
+    void                         admit(bfcb_t* p);
     w_rc_t                       grab(
         bfcb_t*&                      ret,
         const bfpid_t&                p,
@@ -192,6 +193,7 @@ private:
     struct init_thread_t;
     w_rc_t                      _remove(bfcb_t*& p);
     bool                        _in_htab(const bfcb_t* e) const;
+    bfcb_t*                     _probation_victim();
 
     // FOR DEBUGGING:
     bool                        _in_htab(const lpid_t &) const;
@@ -210,6 +212,20 @@ private:
 
     static int                  _hand; // clock hand
 
+    // FIFO of the frames on probation, i.e., read by a sequential
+    // scan and not referenced since. With the 2q replacement policy
+    // these are replaced before the clock is consulted.
+    // The pid tells a stale entry from the current page of the frame.
+    struct probe_t {
+        int                     idx;
+        bfpid_t                 pid;
+    };
+    static queue_based_lock_t   _probq_mutex; // leaf, never held long
+    static probe_t*             _probq; // array of size _probq_size
+    static int                  _probq_size;
+    static int                  _probq_head;
+    static int                  _probq_count;
+
     // disabled
     NORET                        bf_core_m(const bf_core_m&);
     bf_core_m&                  operator=(const bf_core_m&);
@@ -423,3 +423,89 @@ bf_prefetch_thread_t::run()
     } /* while */
 }
 
+
+NORET
+bf_readahead_thread_t::bf_readahead_thread_t(int depth) 
+: smthread_t(t_regular, "bf_readahead"),
+  _pids(0),
+  _depth(depth),
+  _head(0),
+  _count(0),
+  _retire(false)
+{
+    FUNC(bf_readahead_thread_t::bf_readahead_thread_t);
+    w_assert1(depth > 0);
+    _pids = new lpid_t[_depth]; // deleted in ~bf_readahead_thread_t
+    if (!_pids) { W_FATAL(fcOUTOFMEMORY); }
+
+    DO_PTHREAD(pthread_cond_init(&_activate, NULL));
+    DO_PTHREAD(pthread_mutex_init(&_readahead_mutex, NULL));
+}
+
+NORET
+bf_readahead_thread_t::~bf_readahead_thread_t() 
+{
+    FUNC(bf_readahead_thread_t::~bf_readahead_thread_t);
+    delete[] _pids;
+    _pids = 0;
+    DO_PTHREAD(pthread_mutex_destroy(&_readahead_mutex));
+    DO_PTHREAD(pthread_cond_destroy(&_activate));
+}
+
+void
+bf_readahead_thread_t::retire() 
+{
+    FUNC(bf_readahead_thread_t::retire);
+    {
+        CRITICAL_SECTION(cs, _readahead_mutex);
+        _retire = true; 
+        _count = 0; // what is still queued is of no use to anybody
+        DO_PTHREAD(pthread_cond_signal(&_activate));
+    } // end critical section
+
+    w_assert3( me() != this );
+    W_COERCE(join());
+}
+
+void
+bf_readahead_thread_t::request(const lpid_t& pid) 
+{
+    FUNC(bf_readahead_thread_t::request);
+    CRITICAL_SECTION(cs, _readahead_mutex);
+    if(_count == _depth) {
+        INC_TSTAT(bf_readahead_dropped);
+        return;
+    }
+    _pids[(_head + _count) % _depth] = pid;
+    _count++;
+    INC_TSTAT(bf_readahead_requests);
+    DO_PTHREAD(pthread_cond_signal(&_activate));
+}
+
+void
+bf_readahead_thread_t::run() 
+{
+    FUNC(bf_readahead_thread_t::run);
+    bf_scan_hint_t hint;
+
+    CRITICAL_SECTION(cs, _readahead_mutex);
+    while(!_retire) {
+        if(_count == 0) {
+            DO_PTHREAD(pthread_cond_wait(&_activate, &_readahead_mutex));
+            continue;
+        }
+        lpid_t pid = _pids[_head];
+        _head = (_head+1 == _depth) ? 0 : _head+1;
+        _count--;
+        cs.pause();
+
+        {
+            // errors are the business of the scan when it gets there
+            page_p page;
+            smlevel_0::store_flag_t store_flags = smlevel_0::st_bad;
+            W_IGNORE(page.fix(pid, page_p::t_any_p, LATCH_SH, 0, store_flags));
+        } // unfix
+
+        cs.resume();
+    } /* while */
+}
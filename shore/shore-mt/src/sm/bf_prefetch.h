@@ -112,6 +112,45 @@ public:
         _table[pf_max_unused_status][pf_max_unused_event];
 };
 
+/*
+ * Asynchronous read-ahead of several pages for a sequential scan.
+ *
+ * Unlike bf_prefetch_thread_t, this does not hand fixed pages over
+ * to the scan: it only brings the requested pages into the buffer
+ * pool (fix and unfix), so that the fixes of the scan are hits. It
+ * runs with a scan hint, so with the 2q policy the pages go on
+ * probation. Requests beyond the depth given to the constructor
+ * are dropped; read-ahead is only a hint and the scan fixes its
+ * pages itself regardless.
+ */
+class bf_readahead_thread_t : public smthread_t 
+{
+public:
+    NORET            bf_readahead_thread_t(int depth);
+    NORET            ~bf_readahead_thread_t();
+
+    void            request(const lpid_t& pid);
+                // queue page for reading
+
+    void            retire();
+    virtual void        run();
+
+private:
+    lpid_t*            _pids; // circular queue of size _depth
+    int                _depth;
+    int                _head;
+    int                _count;
+    bool               _retire;
+
+    pthread_mutex_t            _readahead_mutex; // paired with _activate
+    pthread_cond_t             _activate; // paired with _readahead_mutex
+
+    // disabled
+    NORET            bf_readahead_thread_t(
+                    const bf_readahead_thread_t&);
+    bf_readahead_thread_t&    operator=(const bf_readahead_thread_t&);
+};
+
 /*<std-footer incl-file-exclusion='BF_PREFETCH_H'>  -- do not edit anything below this line -- */
 
 #endif          /*</std-footer>*/
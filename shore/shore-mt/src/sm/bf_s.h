@@ -120,8 +120,14 @@ private:
                 // without interfering with clock (replacement)
                 // algorithm.
 
+    bool        _probation; // admitted by a miss, not re-referenced yet;
+                // see bf_core_m::admit()
+
     int4_t       _hash_func; // which hash function was this frame placed with?
     int4_t       volatile    _hash;        // and what was the hash value?
+
+    w_base_t::uint8_t volatile _mod_stamp; // bumped on every change of the
+                // frame's page, logged or not; see page_p::mod_stamp()
 public:
     latch_t     latch;          // latch on the frame
 
@@ -185,6 +191,9 @@ public:
     uint4_t     set_hotbit(int4_t b) { return (_hotbit = b); }
     void        decr_hotbit() { _hotbit--; }
 
+    bool        probation() const { return _probation; }
+    void        set_probation(bool b) { _probation = b; }
+
     void        update_rec_lsn(latch_mode_t);
 
     void        initialize(const char *const _name,
@@ -197,6 +206,9 @@ public:
     int4_t       hash() const { return _hash;}
     void         set_hash(int4_t h) { _hash=h;}
 
+    w_base_t::uint8_t mod_stamp() const { return _mod_stamp; }
+    void         bump_mod_stamp() { _mod_stamp++; }
+
 
 public:
     inline ostream&    print_frame(ostream& o, bool in_htab);
@@ -237,6 +249,7 @@ bfcb_t::clear()
     _rec_lsn = lsn_t::null;
     _hotbit = 0;
     _refbit = 0;
+    _probation = false;
     w_assert3(pin_cnt() == 0);
     w_assert3(latch.num_holders() <= 1);
 }
@@ -119,7 +119,7 @@ public:
         // find out if it's in-transit-out
         for(int i=0; i < _page_count; i++) {
             if( _pages[i] == pid ) {
-                DO_PTHREAD(pthread_cond_wait(&_tb_cond, &_tb_mutex));
+                sthread_t::cond_wait(_tb_cond, _tb_mutex);
                 i=-1; // start over in case the pid changed slots
             }
         }
@@ -143,7 +143,7 @@ public:
             // only happens if the page was dirty before
             w_assert1(_page_count <= transit_bucket_t::MAX_IN_TRANSIT);
             _pages[i] = _pages[--_page_count];
-            pthread_cond_broadcast(&_tb_cond);
+            sthread_t::cond_broadcast(_tb_cond);
         }
     }
 
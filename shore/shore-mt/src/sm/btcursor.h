@@ -110,6 +110,11 @@ public:
     const cvec_t&         bound2() const { return *_bound2;}
     lock_mode_t            mode()   const { return _mode; }
 
+    // true if the fetches are part of a long sequential scan;
+    // see bf_scan_hint_t
+    bool            scan_hint() const { return _scan_hint; }
+    void            set_scan_hint(bool h) { _scan_hint = h; }
+
     bool                        inbounds(const cvec_t&, bool check_both, 
                                       bool& keep_going) const;
     bool                        inbounds(const btrec_t &r, bool check_both, 
@@ -166,6 +171,7 @@ private:
     bool            _backward; // for backward scans
     bool            _eof; // no element left
     bool            _include_nulls; 
+    bool            _scan_hint;
 };
 
 inline NORET
@@ -173,7 +179,7 @@ bt_cursor_t::bt_cursor_t(bool include_nulls)
     : is_mrbt(false), first_time(false), keep_going(true), _slot(-1), 
       _space(0), _splen(0), _klen(0), _elen(0), 
       _bound1_buf(0), _bound2_buf(0), _backward(false), _eof(false),
-      _include_nulls(include_nulls)
+      _include_nulls(include_nulls), _scan_hint(false)
 {
 }
 
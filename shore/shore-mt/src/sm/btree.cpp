@@ -89,6 +89,19 @@ rc_t badcc() {
  *
  ********************************************************************/
 
+NORET
+btree_m::btree_m()
+{
+    // one set of key heads per buffer frame
+    btree_p::init_heads(bf_m::npages());
+}
+
+NORET
+btree_m::~btree_m()
+{
+    btree_p::destroy_heads();
+}
+
 smsize_t                        
 btree_m::max_entry_size() {
     return btree_p::max_entry_size;
@@ -1214,6 +1227,7 @@ btree_m::fetch(cursor_t& cursor, const bool bIgnoreLatches)
     FUNC(btree_m::fetch);
     bool __eof = false;
     bool __found = false;
+    bf_scan_hint_t hint(cursor.scan_hint());
 
     if(!bIgnoreLatches) {
 	get_latches(___s,___e); 
@@ -87,8 +87,8 @@ class btree_m : public smlevel_2 {
     friend class btree_purge_log;
 
 public:
-    NORET                        btree_m()   {};
-    NORET                        ~btree_m()  {};
+    NORET                        btree_m();
+    NORET                        ~btree_m();
 
     static smsize_t                max_entry_size(); 
 
@@ -544,6 +544,152 @@ btree_p::format(
     return RCOK;
 }
 
+/*********************************************************************
+ *
+ *  struct bt_heads_t
+ *
+ *  The normalized key heads of the page in one buffer frame.
+ *  The heads are valid for the page while (pid, lsn, mod_stamp, nrecs)
+ *  match those of the page. The page cannot change while we hold a
+ *  latch on it, so valid heads are never rebuilt under a reader.
+ *  _version is odd while a reader rebuilds stale heads; the others
+ *  check it around their validation, as in a sequence lock.
+ *
+ *********************************************************************/
+struct bt_heads_t {
+    uint4_t volatile    _version;
+    lpid_t              _pid;
+    lsn_t               _lsn;
+    w_base_t::uint8_t   _stamp;
+    int                 _nrecs;
+    int                 _plen;      // bytes of _prefix
+    int                 _capacity;  // of _heads
+    btree_p::head_t*    _heads;     // [_nrecs]
+    char                _prefix[btree_p::max_head_prefix];
+
+    bt_heads_t() : _version(0), _stamp(0), _nrecs(-1), _plen(0),
+                   _capacity(0), _heads(0) {}
+    ~bt_heads_t() { delete [] _heads; }
+};
+
+bt_heads_t*     btree_p::_heads_tab = 0;
+int             btree_p::_heads_count = 0;
+
+/*
+ *  Folds the first (up to) 8 bytes of buf into an integer that
+ *  compares like the bytes do. Missing bytes are zeroes, so keys
+ *  that differ only in trailing zeroes have equal heads.
+ */
+static inline btree_p::head_t
+normalize_head(const char* buf, int len)
+{
+    btree_p::head_t h = 0;
+    for (int i = 0; i < (int)sizeof(h); i++)  {
+        h = (h << 8) | (i < len ? (unsigned char) buf[i] : 0);
+    }
+    return h;
+}
+
+void
+btree_p::init_heads(int nframes)
+{
+    w_assert1(_heads_tab == 0);
+    _heads_tab = new bt_heads_t[nframes];
+    if (! _heads_tab) W_FATAL(eOUTOFMEMORY);
+    _heads_count = nframes;
+}
+
+void
+btree_p::destroy_heads()
+{
+    delete [] _heads_tab;
+    _heads_tab = 0;
+    _heads_count = 0;
+}
+
+/*********************************************************************
+ *
+ *  btree_p::_heads()
+ *
+ *  Return the heads of this page, or null if there are no valid
+ *  heads. Stale heads are rebuilt only under a SH latch: writers
+ *  would invalidate them right away.
+ *
+ *********************************************************************/
+const bt_heads_t*
+btree_p::_heads() const
+{
+    if (! _heads_tab || nrecs() == 0) return 0;
+    int idx = bf_m::frame_index(&persistent_part_const());
+    if (idx < 0 || idx >= _heads_count) return 0;
+    bt_heads_t& h = _heads_tab[idx];
+
+    uint4_t v = h._version;
+    membar_consumer();
+    bool valid = h._nrecs == nrecs() && h._stamp == mod_stamp()
+              && h._pid == pid() && h._lsn == lsn();
+    membar_consumer();
+    if (!(v & 1) && h._version == v)  {
+        if (valid) return &h;
+        if (latch_mode() == LATCH_SH && _build_heads(h)) return &h;
+    }
+    return 0;
+}
+
+/*********************************************************************
+ *
+ *  btree_p::_build_heads(h)
+ *
+ *  Rebuild h for this page. Return false if another reader is
+ *  already at it.
+ *
+ *********************************************************************/
+bool
+btree_p::_build_heads(bt_heads_t& h) const
+{
+    uint4_t v = h._version;
+    if ((v & 1) || atomic_cas_32(&h._version, v, v + 1) != v) return false;
+    membar_enter();
+
+    int n = nrecs();
+    if (h._capacity < n)  {
+        // stale heads are not read by anyone
+        delete [] h._heads;
+        h._capacity = (n + 63) & ~63;
+        h._heads = new head_t[h._capacity];
+        if (! h._heads) W_FATAL(eOUTOFMEMORY);
+    }
+
+    // the keys are sorted: what the first and the last share, all share
+    char buf[max_head_prefix + sizeof(head_t)];
+    int plen = 0;
+    {
+        btrec_t first(*this, 0);
+        btrec_t last(*this, n - 1);
+        int flen = first.key().copy_to(h._prefix, max_head_prefix);
+        int llen = last.key().copy_to(buf, max_head_prefix);
+        while (plen < flen && plen < llen && h._prefix[plen] == buf[plen]) {
+            plen++;
+        }
+    }
+
+    for (int i = 0; i < n; i++)  {
+        btrec_t r(*this, i);
+        int len = r.key().copy_to(buf, plen + sizeof(head_t));
+        w_assert3(len >= plen);
+        h._heads[i] = normalize_head(buf + plen, len - plen);
+    }
+
+    h._plen = plen;
+    h._nrecs = n;
+    h._pid = pid();
+    h._lsn = lsn();
+    h._stamp = mod_stamp();
+    membar_producer();
+    h._version = v + 2;
+    return true;
+}
+
 /*********************************************************************
  *
  *  btree_p::search(key, el, found_key, found_key_elem, ret_slot)
@@ -579,21 +725,64 @@ btree_p::search(
     );
     
     /*
-     *  Binary search.
+     *  With the key heads, a key that does not share the common
+     *  prefix of the page goes before or after all records; otherwise
+     *  the records are read only when their heads equal that of key.
      */
+    _search(key, el, found_key, found_key_elem, ret_slot, _heads());
+    return RCOK;
+}
+
+/*********************************************************************
+ *
+ *  btree_p::_search(key, el, found_key, found_key_elem, ret_slot, h)
+ *
+ *  The binary search of search(), through the heads h if not null.
+ *
+ *********************************************************************/
+void
+btree_p::_search(
+    const cvec_t&     key,
+    const cvec_t&     el,
+    bool&             found_key, 
+    bool&             found_key_elem, 
+    slotid_t&         ret_slot,
+    const bt_heads_t* h) const
+{
     found_key = false;
     found_key_elem = false;
+
+    head_t kh = 0;
+    if (h)  {
+        char buf[max_head_prefix + sizeof(head_t)];
+        int len = key.copy_to(buf, h->_plen + sizeof(head_t));
+        int c = memcmp(buf, h->_prefix, len < h->_plen ? len : h->_plen);
+        if (c == 0 && len < h->_plen) c = -1;
+        if (c != 0)  {
+            ret_slot = (c < 0) ? 0 : nrecs();
+            DBG(<<" outside the page prefix, returning slot " << ret_slot);
+            return;
+        }
+        kh = normalize_head(buf + h->_plen, len - h->_plen);
+    }
+
+    /*
+     *  Binary search.
+     */
+    btrec_t r;
     int mi, lo, hi;
     for (mi = 0, lo = 0, hi = nrecs() - 1; lo <= hi; )  {
         mi = (lo + hi) >> 1;    // ie (lo + hi) / 2
 
-        btrec_t r(*this, mi); 
         int d;
         DBG(<<"(lo=" << lo
             << ",hi=" << hi
             << ") mi=" << mi);
 
-        if ((d = r.key().cmp(key)) == 0)  {
+        if (h && h->_heads[mi] != kh)  {
+            d = (h->_heads[mi] < kh) ? -1 : 1;
+            DBG( << " head(" << mi << ") decides d(" << d << ")");
+        } else if ((d = r.set(*this, mi).key().cmp(key)) == 0)  {
             DBG( << " r=("<<r.key()
                 << ") CMP k=(" <<key
                 << ") = d(" << d << ")");
@@ -625,7 +814,7 @@ btree_p::search(
             ret_slot = mi;
             found_key_elem = true;
             DBG(<<"");
-            return RCOK;
+            return;
         }
     }
     ret_slot = (lo > mi) ? lo : mi;
@@ -654,7 +843,6 @@ btree_p::search(
         <<" found_key=" << found_key
         <<" found_key_elem=" << found_key_elem
     );
-    return RCOK;
 }
 
 /*********************************************************************
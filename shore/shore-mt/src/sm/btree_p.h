@@ -67,6 +67,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 
 struct btree_lf_stats_t;
 struct btree_int_stats_t;
+struct bt_heads_t;
 
 
 class btrec_t {
@@ -210,7 +211,34 @@ public:
     static smsize_t         max_entry_size;
     static smsize_t         overhead_requirement_per_entry;
 
+    /*
+     *  Normalized key heads. For each buffer frame that holds a btree
+     *  page we keep, outside the page, the 8 bytes of every key that
+     *  follow the prefix common to all keys of the page, as a
+     *  big-endian integer. search() binary-searches this array and
+     *  reads the records only to break ties. The array is rebuilt
+     *  lazily by a reader (SH latch) after the page changes.
+     */
+    typedef w_base_t::uint8_t head_t;
+    enum { max_head_prefix = 56 };
+
+    static void             init_heads(int nframes);
+    static void             destroy_heads();
+
 private:
+    static bt_heads_t*      _heads_tab;    // [_heads_count]
+    static int              _heads_count;
+
+    const bt_heads_t* _heads() const;
+    bool            _build_heads(bt_heads_t& h) const;
+    void            _search(
+        const cvec_t&             key,
+        const cvec_t&             el,
+        bool&                     found_key,
+        bool&                     found_key_elem,
+        slotid_t&                 ret_slot,
+        const bt_heads_t*         h) const;
+
     rc_t            _unlink(btree_p &, const bool bIgnoreLatches = false);
     rc_t            _clr_flag(flag_t, bool compensate=false);
     rc_t            _set_flag(flag_t, bool compensate=false);
@@ -270,7 +298,6 @@ inline bool btree_p::is_delete() const
  *--------------------------------------------------------------*/
 inline bool btree_p::is_compressed() const
 {
-    // return _hdr().flags & t_compressed;
     return (_hdr().flags & t_compressed) != 0;
 }
 
@@ -0,0 +1,488 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   data_access_sketch.cpp
+ *
+ *  @brief:  Implementation of the sampled, per-thread count-min sketch
+ *           of data accesses.
+ */
+
+#ifdef __GNUG__
+#           pragma implementation "data_access_sketch.h"
+#endif
+
+#include "data_access_sketch.h"
+
+
+/******************************************************************
+ *
+ * TLS cache of the private sketches of the calling thread
+ *
+ * @note: A thread usually touches a handful of stores, so a small
+ *        array searched linearly is enough. Sketch ids start at 1,
+ *        hence an all-zero entry is empty. When the cache is full an
+ *        entry is replaced round-robin and its private sketch is
+ *        released; if the thread comes back to that sketch it takes
+ *        a free private sketch or registers a new one.
+ *
+ *        When the thread exits, the destructor of _das_key releases
+ *        the private sketches in its cache. The registry of live
+ *        sketches tells which of them still exist.
+ *
+ ******************************************************************/
+
+enum { DAS_TLS_ENTRIES = 16 };
+
+struct das_tls_entry_t
+{
+    uint4_t             _id;
+    data_access_sketch* _sketch;
+    das_local_t*        _local;
+};
+
+static __thread das_tls_entry_t _das_tls[DAS_TLS_ENTRIES];
+static __thread uint4_t _das_tls_victim = 0;
+
+static uint4_t volatile _das_next_id = 0;
+
+static pthread_mutex_t _das_reg_lock = PTHREAD_MUTEX_INITIALIZER;
+static data_access_sketch* _das_reg = NULL;
+
+static pthread_key_t _das_key;
+static pthread_once_t _das_key_once = PTHREAD_ONCE_INIT;
+
+
+
+/******************************************************************
+ *
+ * @struct: das_local_t
+ *
+ ******************************************************************/
+
+das_local_t::das_local_t(const uint4_t seed)
+    : _skip(1), _rand(seed ? seed : 0x9e3779b9), _in_use(true), _next(NULL)
+{
+    memset((void*)_cells, 0, sizeof(_cells));
+}
+
+
+
+/******************************************************************
+ *
+ * @class: das_merger_thread_t
+ *
+ ******************************************************************/
+
+das_merger_thread_t::das_merger_thread_t(data_access_sketch* sketch,
+                                         const uint period_ms)
+    : smthread_t(t_regular, "das_merger"),
+      _sketch(sketch), _period_ms(period_ms), _retire(false)
+{
+}
+
+void das_merger_thread_t::retire()
+{
+    _retire = true;
+    wakeup();
+}
+
+void das_merger_thread_t::run()
+{
+    while (!_retire) {
+        sleep(_period_ms, "das_merger");
+        if (_retire) { break; }
+        _sketch->merge();
+    }
+}
+
+
+
+/******************************************************************
+ *
+ * Construction/Destruction
+ *
+ ******************************************************************/
+
+data_access_sketch::data_access_sketch(const uint ages,
+                                       const uint4_t sample_rate,
+                                       const uint4_t prefix_len)
+    : _sample_rate(sample_rate ? sample_rate : 1),
+      _prefix_len(prefix_len),
+      _locals(NULL),
+      _index(0), _ages(ages ? ages : 1),
+      _merger(NULL)
+{
+    _id = atomic_inc_32_nv(&_das_next_id);
+    DO_PTHREAD(pthread_mutex_init(&_locals_lock, NULL));
+    _merged = new uint4_t[_ages*DEPTH*WIDTH];
+    memset(_merged, 0, _ages*DEPTH*WIDTH*sizeof(uint4_t));
+
+    CRITICAL_SECTION(cs, _das_reg_lock);
+    _reg_next = _das_reg;
+    _das_reg = this;
+}
+
+data_access_sketch::~data_access_sketch()
+{
+    DBG(<<"Destroying the data access sketch: ");
+
+    stop_merger();
+
+    {
+        CRITICAL_SECTION(cs, _das_reg_lock);
+        data_access_sketch** pp = &_das_reg;
+        while (*pp != this) { pp = &(*pp)->_reg_next; }
+        *pp = _reg_next;
+    }
+
+    das_local_t* local = _locals;
+    while (local) {
+        das_local_t* next = local->_next;
+        delete (local);
+        local = next;
+    }
+    _locals = NULL;
+
+    delete [] _merged;
+    DO_PTHREAD(pthread_mutex_destroy(&_locals_lock));
+}
+
+
+w_rc_t data_access_sketch::start_merger(const uint period_ms)
+{
+    assert (!_merger);
+    _merger = new das_merger_thread_t(this, period_ms);
+    if (!_merger) { return (RC(fcOUTOFMEMORY)); }
+    W_DO(_merger->fork());
+    return (RCOK);
+}
+
+void data_access_sketch::stop_merger()
+{
+    if (_merger) {
+        _merger->retire();
+        W_COERCE(_merger->join());
+        delete (_merger);
+        _merger = NULL;
+    }
+}
+
+
+
+/******************************************************************
+ *
+ * @fn:      _get_local()
+ *
+ * @brief:   Returns the private sketch of the calling thread, and
+ *           registers a new one on its first access
+ *
+ ******************************************************************/
+
+void data_access_sketch::_make_key()
+{
+    DO_PTHREAD(pthread_key_create(&_das_key, _release_thread));
+}
+
+das_local_t* data_access_sketch::_get_local()
+{
+    while (true) {
+        for (uint i = 0; i < DAS_TLS_ENTRIES; i++) {
+            if (_das_tls[i]._id == _id) { return (_das_tls[i]._local); }
+        }
+
+        // arm the exit hook on the first registration of this thread
+        DO_PTHREAD(pthread_once(&_das_key_once, _make_key));
+        if (!pthread_getspecific(_das_key)) {
+            DO_PTHREAD(pthread_setspecific(_das_key, this));
+        }
+
+        // The locks below may let another fiber of this carrier run,
+        // and it shares _das_tls with us, so the cache is only touched
+        // between them.
+        das_local_t* local = NULL;
+        {
+            CRITICAL_SECTION(cs, _locals_lock);
+            for (local = _locals; local; local = local->_next) {
+                if (!local->_in_use) { break; }
+            }
+            if (local) {
+                local->_in_use = true;
+                local->_skip = 1;
+            }
+            else {
+                local = new das_local_t(_id * 2654435761u ^ (uint4_t)(long)me());
+                local->_next = _locals;
+                _locals = local;
+            }
+        }
+
+        bool raced = false;
+        for (uint i = 0; i < DAS_TLS_ENTRIES; i++) {
+            if (_das_tls[i]._id == _id) { raced = true; break; }
+        }
+        if (raced) {
+            // another fiber registered us meanwhile, use its entry
+            CRITICAL_SECTION(cs, _locals_lock);
+            local->_in_use = false;
+            continue;
+        }
+
+        uint victim = DAS_TLS_ENTRIES;
+        for (uint i = 0; i < DAS_TLS_ENTRIES; i++) {
+            if (_das_tls[i]._id == 0) { victim = i; break; }
+        }
+        if (victim == DAS_TLS_ENTRIES) {
+            victim = _das_tls_victim;
+            _das_tls_victim = (_das_tls_victim + 1) % DAS_TLS_ENTRIES;
+        }
+        das_tls_entry_t old = _das_tls[victim];
+        _das_tls[victim]._id = _id;
+        _das_tls[victim]._sketch = this;
+        _das_tls[victim]._local = local;
+        if (old._id == 0) { return (local); }
+
+        // look again after the release: it may have let a fiber evict us
+        _release_entry(old);
+    }
+}
+
+
+/******************************************************************
+ *
+ * @fn:      _release_entry()
+ *
+ * @brief:   Hands the private sketch of a TLS cache entry back to its
+ *           sketch, if the sketch still exists. The caller has
+ *           already cleared or reused the entry it was copied from.
+ *
+ * @note:    The registry lock keeps the sketch from being destroyed
+ *           while its private sketch is released. Ids are never
+ *           reused, so a sketch allocated at the address of a
+ *           destroyed one does not match the entry.
+ *
+ ******************************************************************/
+
+void data_access_sketch::_release_entry(const das_tls_entry_t entry)
+{
+    if (entry._id == 0) { return; }
+
+    CRITICAL_SECTION(cs, _das_reg_lock);
+    for (data_access_sketch* s = _das_reg; s; s = s->_reg_next) {
+        if (s == entry._sketch && s->_id == entry._id) {
+            CRITICAL_SECTION(lcs, s->_locals_lock);
+            entry._local->_in_use = false;
+            break;
+        }
+    }
+}
+
+void data_access_sketch::_release_thread(void*)
+{
+    for (uint i = 0; i < DAS_TLS_ENTRIES; i++) {
+        das_tls_entry_t old = _das_tls[i];
+        _das_tls[i]._id = 0;
+        _das_tls[i]._sketch = NULL;
+        _das_tls[i]._local = NULL;
+        _release_entry(old);
+    }
+}
+
+
+/******************************************************************
+ *
+ * @fn:      _columns()
+ *
+ * @brief:   Hashes (root, key prefix) to one column per row, deriving
+ *           the DEPTH hashes from two FNV-1a hashes.
+ *
+ * @note:    A key of length 0 stands for the whole subtree.
+ *
+ ******************************************************************/
+
+void data_access_sketch::_columns(const lpid_t& root, const char* key,
+                                  const uint4_t len, uint cols[DEPTH]) const
+{
+    // hash the fields, lpid_t has padding bytes
+    const uint4_t ids[3] = { root.vol().vol, root.store(), root.page };
+    uint4_t h = 2166136261u;
+    const unsigned char* p = (const unsigned char*) ids;
+    for (uint i = 0; i < sizeof(ids); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    const uint4_t n = (len < _prefix_len) ? len : _prefix_len;
+    p = (const unsigned char*) key;
+    for (uint i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    h = (h ^ n) * 16777619u;
+
+    const uint4_t h1 = h;
+    const uint4_t h2 = (h >> 16 | h << 16) * 0x85ebca6b | 1;
+    for (uint r = 0; r < DEPTH; r++) {
+        cols[r] = (h1 + r*h2) % WIDTH;
+    }
+}
+
+
+
+//// accesses management  ////
+
+
+/******************************************************************
+ *
+ * @fn:      inc_access_count()
+ *
+ * @brief:   increments the access count of the range that the key belongs to by 1
+ *
+ * @param:   lpid_t root  - root of the subtree
+ * @param:   cvec_t key   - the accessed key
+ *
+ ******************************************************************/
+
+w_rc_t data_access_sketch::inc_access_count(const lpid_t& root, const Key& key)
+{
+    return (update_access_count(root, key, 1));
+}
+
+
+/******************************************************************
+ *
+ * @fn:      update_access_count()
+ *
+ * @brief:   updates the access count of the range that the key belings to by the given amount
+ *
+ * @param:   lpid_t root  - root of the subtree
+ * @param:   cvec_t key   - the accessed key
+ * @param:   int amount   - the amount to increment the access count of the key's range
+ *
+ * @note:    Only the sampled accesses go past the countdown. The next
+ *           countdown is drawn uniformly from [1, 2*_sample_rate-1], so
+ *           that periodic access patterns do not alias with the sampling.
+ *
+ ******************************************************************/
+
+w_rc_t data_access_sketch::update_access_count(const lpid_t& root, const Key& key, uint amount)
+{
+    das_local_t* local = _get_local();
+    if (--local->_skip > 0) { return (RCOK); }
+
+    // xorshift
+    uint4_t x = local->_rand;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    local->_rand = x;
+    local->_skip = 1 + (x % (2*_sample_rate - 1));
+
+    uint cols[DEPTH];
+    _columns(root, NULL, 0, cols);
+    for (uint r = 0; r < DEPTH; r++) {
+        local->_cells[r][cols[r]] += amount;
+    }
+    _columns(root, (const char*)key._base[0].ptr, key._base[0].len, cols);
+    for (uint r = 0; r < DEPTH; r++) {
+        local->_cells[r][cols[r]] += amount;
+    }
+    return (RCOK);
+}
+
+
+
+//// queries  ////
+
+
+/******************************************************************
+ *
+ * @fn:      merge()
+ *
+ * @brief:   Drains all the private sketches into the current age slot
+ *           of the shared sketch
+ *
+ ******************************************************************/
+
+void data_access_sketch::merge()
+{
+    das_local_t* local = NULL;
+    {
+        CRITICAL_SECTION(cs, _locals_lock);
+        local = _locals;
+    }
+
+    // private sketches are only unlinked by the destructor
+    _merged_lock.acquire_write();
+    uint4_t* merged = &_merged[_index*DEPTH*WIDTH];
+    for (; local; local = local->_next) {
+        for (uint r = 0; r < DEPTH; r++) {
+            for (uint c = 0; c < WIDTH; c++) {
+                if (local->_cells[r][c]) {
+                    merged[r*WIDTH+c] +=
+                        atomic_swap_32(&local->_cells[r][c], 0);
+                }
+            }
+        }
+    }
+    _merged_lock.release_write();
+}
+
+uint data_access_sketch::_estimate(const lpid_t& root, const char* key,
+                                   const uint4_t len)
+{
+    uint cols[DEPTH];
+    _columns(root, key, len, cols);
+
+    uint est = ~0u;
+    _merged_lock.acquire_read();
+    for (uint r = 0; r < DEPTH; r++) {
+        uint sum = 0;
+        for (uint a = 0; a < _ages; a++) {
+            sum += _merged[(a*DEPTH+r)*WIDTH + cols[r]];
+        }
+        if (sum < est) { est = sum; }
+    }
+    _merged_lock.release_read();
+    return (est * _sample_rate);
+}
+
+uint data_access_sketch::get_access_count(const lpid_t& root, const Key& key)
+{
+    return (_estimate(root, (const char*)key._base[0].ptr, key._base[0].len));
+}
+
+uint data_access_sketch::get_root_access_count(const lpid_t& root)
+{
+    return (_estimate(root, NULL, 0));
+}
+
+
+
+//// aging ////
+
+void data_access_sketch::inc_age()
+{
+    // what is still in the private sketches belongs to the old age
+    merge();
+    _merged_lock.acquire_write();
+    _index = (_index+1) % _ages;
+    memset(&_merged[_index*DEPTH*WIDTH], 0, DEPTH*WIDTH*sizeof(uint4_t));
+    _merged_lock.release_write();
+}
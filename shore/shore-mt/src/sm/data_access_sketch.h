@@ -0,0 +1,228 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/** @file:   data_access_sketch.h
+ *
+ *  @brief:  Sampled, per-thread count-min sketch of data accesses. It
+ *           replaces the data_access_histogram on the access path of
+ *           the load balancing of (MR)BTrees.
+ *
+ *  @note:   Each thread counts a sample of its accesses in a private
+ *           sketch, without locks or atomic operations. A background
+ *           thread periodically drains the private sketches into the
+ *           shared one, which is what the queries read.
+ */
+
+#ifndef _DATA_ACCESS_SKETCH_H
+#define _DATA_ACCESS_SKETCH_H
+
+#include "w_defines.h"
+
+#include "key_ranges_map.h"
+
+#ifdef __GNUG__
+#pragma interface
+#endif
+
+using namespace std;
+
+
+class data_access_sketch;
+struct das_tls_entry_t;
+
+
+/********************************************************************
+ *
+ * @struct: das_local_t
+ *
+ * @brief:  The private sketch of one thread. Only the owner thread
+ *          increments it, and it is recycled when the thread exits. The merger drains it with atomic swaps, so
+ *          an increment that races with the drain of the same cell can
+ *          be lost, which is acceptable for sampled statistics.
+ *
+ ********************************************************************/
+
+struct das_local_t
+{
+    enum { DEPTH = 4, WIDTH = 1024 };
+
+    uint4_t volatile _cells[DEPTH][WIDTH];
+
+    // accesses left until the next sampled one
+    uint4_t _skip;
+    uint4_t _rand;
+
+    // false once the owner thread has exited or dropped it from its
+    // TLS cache; a free private sketch is handed to the next thread
+    // that registers with the sketch
+    bool _in_use;
+
+    das_local_t* _next;
+
+    das_local_t(const uint4_t seed);
+
+}; // EOF: das_local_t
+
+
+
+/********************************************************************
+ *
+ * @class: das_merger_thread_t
+ *
+ * @brief: Drains the private sketches of a data_access_sketch into
+ *         the shared one every few milliseconds.
+ *
+ ********************************************************************/
+
+class das_merger_thread_t : public smthread_t
+{
+private:
+    data_access_sketch* _sketch;
+    uint                _period_ms;
+    bool volatile       _retire;
+
+public:
+    das_merger_thread_t(data_access_sketch* sketch, const uint period_ms);
+    ~das_merger_thread_t() { }
+
+    void retire();
+    virtual void run();
+
+}; // EOF: das_merger_thread_t
+
+
+
+/********************************************************************
+ *
+ * @class: data_access_sketch
+ *
+ * @brief: Estimates how frequently keys and subtrees are accessed.
+ *         This structure is used by the load balancing system of btrees
+ *         (regular or mrbtrees doesn't matter), in place of the
+ *         data_access_histogram.
+ *
+ * @note:  Only 1 out of every _sample_rate accesses (on average) is
+ *         counted, and the estimates are scaled back up. Each sampled 
+ *         access counts both the subtree and the key. Keys are
+ *         counted by their first _prefix_len bytes, so a query for a key
+ *         returns the accesses to all keys that share its prefix; this
+ *         plays the role of the sub-range granularity of the histogram.
+ *         The shared sketch has an age slot per period, as the
+ *         histogram does, and the queries sum over all the ages.
+ *
+ ********************************************************************/
+
+class data_access_sketch
+{
+public:
+    enum { DEPTH = das_local_t::DEPTH,
+           WIDTH = das_local_t::WIDTH };
+
+private:
+
+    typedef cvec_t Key;
+
+    // unique across all sketches, to tell them apart in the TLS cache
+    uint4_t _id;
+
+    uint4_t _sample_rate;
+    uint4_t _prefix_len;
+
+    // the private sketches, registered on the first access of each thread
+    das_local_t* _locals;
+    pthread_mutex_t _locals_lock;
+
+    // the shared sketch, [_ages][DEPTH][WIDTH]
+    uint4_t* _merged;
+    occ_rwlock _merged_lock;
+
+    // index for the current age bucket
+    uint _index;
+
+    // specifies how many age-slots the sketch has
+    uint _ages;
+
+    das_merger_thread_t* _merger;
+
+    // the live sketches, so that an exiting thread only releases the
+    // private sketches of sketches that still exist
+    data_access_sketch* _reg_next;
+
+    das_local_t* _get_local();
+
+    // hand the private sketches of the calling thread back for reuse
+    static void _make_key();
+    static void _release_thread(void*);
+    static void _release_entry(const das_tls_entry_t entry);
+
+    // the WIDTH-column of each of the DEPTH rows for (root,key-prefix)
+    void _columns(const lpid_t& root, const char* key, const uint4_t len,
+                  uint cols[DEPTH]) const;
+    uint _estimate(const lpid_t& root, const char* key, const uint4_t len);
+
+public:
+
+    //// Construction ////
+    data_access_sketch(const uint ages,
+                       const uint4_t sample_rate = 16,
+                       const uint4_t prefix_len = 8);
+    ~data_access_sketch();
+
+    // Starts the background thread that merges the private sketches
+    w_rc_t start_merger(const uint period_ms = 100);
+    void stop_merger();
+
+
+    //// accesses management  ////
+    //// (same interface as the data_access_histogram) ////
+
+    // increments the access count of the range that the key belongs to by 1
+    w_rc_t inc_access_count(const lpid_t& root, const Key& key);
+
+    // updates the access count of the range that the key belings to by the given amount
+    w_rc_t update_access_count(const lpid_t& root, const Key& key, uint amount);
+
+
+    //// queries  ////
+
+    // drains all the private sketches into the shared one
+    void merge();
+
+    // estimated accesses to keys with the same prefix as key, in root
+    uint get_access_count(const lpid_t& root, const Key& key);
+
+    // estimated accesses to the subtree of root
+    uint get_root_access_count(const lpid_t& root);
+
+
+    //// aging ////
+    void inc_age();
+
+private:
+    // not allowed
+    data_access_sketch(const data_access_sketch&);
+    data_access_sketch& operator=(const data_access_sketch&);
+
+}; // EOF: data_access_sketch
+
+#endif
@@ -1343,7 +1343,8 @@ file_m::_find_slotted_page_with_space(
          * looks for free pages at the "end" of the extent, preserving
          * append_t policy.
          */
-        W_DO(_alloc_page(stid,  lastpid, newpid,  page, may_search_file)); 
+        W_DO(_alloc_page(stid,  lastpid, newpid,  page, may_search_file,
+                    policy == t_append)); 
         w_assert3(page.is_fixed());
         w_assert3(page.latch_mode() == LATCH_EX);
         // Now have long-term IX lock on the page
@@ -1595,7 +1596,8 @@ file_m::_find_slotted_mrbt_page_with_space(
          * looks for free pages at the "end" of the extent, preserving
          * append_t policy.
          */
-        W_DO(_alloc_mrbt_page(stid,  lastpid, newpid,  page, may_search_file)); 
+        W_DO(_alloc_mrbt_page(stid,  lastpid, newpid,  page, may_search_file,
+                    policy == t_append)); 
         w_assert3(page.is_fixed());
         w_assert3(page.latch_mode() == LATCH_EX);
         // Now have long-term IX lock on the page
@@ -2828,7 +2830,8 @@ file_m::_alloc_page(
     const lpid_t& near_p,
     lpid_t& allocPid,
     file_p &page,         // leave it fixed here
-    bool search_file     // if false, it indicates strict append
+    bool search_file,    // if false, it indicates append
+    bool strict_append   // if false, the append need not be in page order
 )
 {
     /* 
@@ -2876,7 +2879,8 @@ file_m::_alloc_page(
         // Filter EX-latches the page; we hold the ex latch
         // and return the page latched.
         alloc_file_page_filter_t ok(store_flags, page);
-        W_DO(io->alloc_a_file_page(&ok, fid, near_p, allocPid, IX,search_file));
+        W_DO(io->alloc_a_file_page(&ok, fid, near_p, allocPid, IX,search_file,
+                    strict_append));
         w_assert1(page.is_mine()); // EX-latched
         // Now we format, since it couldn't be done during accept()
         W_DO(page.format(allocPid, page.t_file_p, page.t_virgin, store_flags));
@@ -2909,7 +2913,8 @@ file_m::_alloc_mrbt_page(
     const lpid_t& near_p,
     lpid_t& allocPid,
     file_mrbt_p &page,         // leave it fixed here
-    bool search_file     // if false, it indicates strict append
+    bool search_file,    // if false, it indicates append
+    bool strict_append   // if false, the append need not be in page order
 )
 {
 
@@ -2928,7 +2933,8 @@ file_m::_alloc_mrbt_page(
         // Filter EX-latches the page; we hold the ex latch
         // and return the page latched.
         alloc_file_page_filter_t ok(store_flags, page);
-        W_DO(io->alloc_a_file_page(&ok, fid, near_p, allocPid, IX,search_file));
+        W_DO(io->alloc_a_file_page(&ok, fid, near_p, allocPid, IX,search_file,
+                    strict_append));
         w_assert1(page.is_mine()); // EX-latched
         // Now we format, since it couldn't be done during accept()
         W_DO(page.format(allocPid, page.t_file_mrbt_p, page.t_virgin, store_flags));
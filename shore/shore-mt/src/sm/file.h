@@ -492,13 +492,15 @@ protected:
     static rc_t _alloc_page(stid_t fid, 
                             const lpid_t& near, lpid_t& pid,
 			    file_p &page,
-			    bool   search_file
+			    bool   search_file,
+			    bool   strict_append = true
                          );
 
     static rc_t _alloc_mrbt_page(stid_t fid, 
 				 const lpid_t& near, lpid_t& pid,
 				 file_mrbt_p &page,
-				 bool   search_file
+				 bool   search_file,
+				 bool   strict_append = true
 				 );
     
     static rc_t _locate_page(const rid_t& rid, file_p& page, latch_mode_t mode);
@@ -1425,30 +1425,30 @@ histoid_compare_t::ge(const pginfo_t& left, const pginfo_t& right) const
 // WARNING: this function assumes that a thread only locks one histoid
 // at a time. AFAIK this is the case, and there are assertions to
 // verify as well.
-//static __thread queue_based_lock_t::ext_qnode histoid_me = EXT_QNODE_INITIALIZER;
-static __thread queue_based_lock_t::ext_qnode histoid_me = QUEUE_EXT_QNODE_INITIALIZER;
+// The queue node is in the smthread (get_histoid_me), not in TLS,
+// since fibers of one carrier share the TLS.
 
 void
 histoid_t::_release_mutex() const
 {
-    w_assert2(_histoid_mutex.is_mine(&histoid_me));
-    _histoid_mutex.release(&histoid_me);
+    w_assert2(_histoid_mutex.is_mine(&me()->get_histoid_me()));
+    _histoid_mutex.release(&me()->get_histoid_me());
 }
 void
 histoid_t::_grab_mutex() const
 {
-    w_assert2( ! _histoid_mutex.is_mine(&histoid_me));
-    _histoid_mutex.acquire(&histoid_me);
+    w_assert2( ! _histoid_mutex.is_mine(&me()->get_histoid_me()));
+    _histoid_mutex.acquire(&me()->get_histoid_me());
 }
 void
 histoid_t::_grab_mutex_cond(bool& got) const
 {
-    w_assert2( ! _histoid_mutex.is_mine(&histoid_me));
-    got = _histoid_mutex.attempt(&histoid_me);
+    w_assert2( ! _histoid_mutex.is_mine(&me()->get_histoid_me()));
+    got = _histoid_mutex.attempt(&me()->get_histoid_me());
 }
 
 bool
 histoid_t::_have_mutex() const
 {
-    return _histoid_mutex.is_mine(&histoid_me);
+    return _histoid_mutex.is_mine(&me()->get_histoid_me());
 }
@@ -43,6 +43,7 @@
 
 #include "btree.h"
 #include "sdesc.h"
+#include "sthread_fiber.h"
 
 
 foo::foo() 
@@ -90,6 +91,205 @@ foo& foo::operator=(const foo& v)
 }
 
 
+/****************************************************************** 
+ *
+ * @class: krm_routing_t
+ *
+ ******************************************************************/
+
+krm_routing_t::krm_routing_t(const map<foo, lpid_t, cmp_greater>& m)
+    : _count(m.size()), _head_len(sizeof(head_t)), 
+      _heads(NULL), _roots(NULL), _offsets(NULL), _keys(NULL),
+      _next_retired(NULL), _retire_epoch(0)
+{
+    uint4_t total = 0;
+    map<foo, lpid_t, cmp_greater>::const_iterator cit;
+    for (cit = m.begin(); cit != m.end(); ++cit) {
+        total += cit->first._len;
+        if (cit->first._len < _head_len) { _head_len = cit->first._len; }
+    }
+
+    _heads = new head_t[_count+1];
+    _roots = new lpid_t[_count+1];
+    _offsets = new uint4_t[_count+1];
+    _keys = (char*) malloc(total+1);
+
+    // The map is sorted in descending order, the snapshot in ascending
+    uint idx = _count;
+    uint4_t offset = total;
+    for (cit = m.begin(); cit != m.end(); ++cit) {
+        idx--;
+        offset -= cit->first._len;
+        memcpy(&_keys[offset], cit->first._m, cit->first._len);
+        _offsets[idx] = offset;
+        _heads[idx] = normalize(cit->first._m, _head_len);
+        _roots[idx] = cit->second;
+    }
+    assert (idx == 0 && offset == 0);
+    _offsets[_count] = total;
+}
+
+krm_routing_t::~krm_routing_t()
+{
+    delete [] _heads;
+    delete [] _roots;
+    delete [] _offsets;
+    free (_keys);
+}
+
+
+/****************************************************************** 
+ *
+ * @fn:    normalize()
+ *
+ * @brief: Loads the first (up to 8) bytes of the key as a big-endian
+ *         integer. Comparing two heads gives the same order as 
+ *         umemcmp() on the same number of bytes.
+ *
+ ******************************************************************/
+
+krm_routing_t::head_t krm_routing_t::normalize(const char* key, const uint4_t len)
+{
+    head_t h = 0;
+    const unsigned char* p = (const unsigned char*) key;
+    uint4_t i = 0;
+    for (; i < len && i < sizeof(head_t); i++) {
+        h = (h << 8) | p[i];
+    }
+    for (; i < sizeof(head_t); i++) {
+        h <<= 8;
+    }
+    return (h);
+}
+
+
+/****************************************************************** 
+ *
+ * @fn:    find()
+ *
+ * @brief: Binary search for the largest boundary that is <= key. 
+ *         Probes compare the heads and fall back to the full key only
+ *         when the heads are equal.
+ *
+ * @note:  As in the map, the comparison is on the length of the 
+ *         boundary key.
+ *
+ ******************************************************************/
+
+int krm_routing_t::find(const char* key, const uint4_t len) const
+{
+    const head_t kh = normalize(key, (len < _head_len) ? len : _head_len);
+
+    // invariant: boundaries [0,lo) are <= key, [hi,_count) are > key
+    int lo = 0;
+    int hi = _count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        bool le;
+        if (_heads[mid] != kh) {
+            le = (_heads[mid] < kh);
+        }
+        else {
+            le = (umemcmp(&_keys[_offsets[mid]], key, 
+                          _offsets[mid+1] - _offsets[mid]) <= 0);
+        }
+        if (le) { lo = mid + 1; }
+        else    { hi = mid; }
+    }
+    return (lo - 1);
+}
+
+
+
+/****************************************************************** 
+ *
+ * @class: krm_epoch_t
+ *
+ * @note:  The slot of each thread is kept in plain TLS (zero means that
+ *         the thread has no slot yet, otherwise it is slot+1). It is 
+ *         given back by the TLS destructor at smthread exit.
+ *         Fibers of one carrier share that slot, so nothing may yield
+ *         between enter() and exit().
+ *
+ ******************************************************************/
+
+struct krm_epoch_slot_t
+{
+    uint4_t volatile _epoch; // 0 == not in a critical section
+    uint4_t volatile _owned;
+    long _padding[7];        // one slot per cache line
+};
+
+static krm_epoch_slot_t _krm_slots[krm_epoch_t::MAX_SLOTS];
+static uint4_t volatile _krm_global_epoch = 1;
+static __thread int _krm_my_slot = 0;
+
+struct krm_epoch_slot_owner_t
+{
+    krm_epoch_slot_owner_t() { }
+    ~krm_epoch_slot_owner_t() { krm_epoch_t::release_slot(); }
+};
+DECLARE_TLS(krm_epoch_slot_owner_t, krm_slot_owner);
+
+int krm_epoch_t::enter()
+{
+    int slot = _krm_my_slot - 1;
+    if (slot < 0) {
+        // first lookup of this thread, claim a free slot
+        for (int i = 0; i < MAX_SLOTS; i++) {
+            if (_krm_slots[i]._owned == 0 &&
+                atomic_cas_32(&_krm_slots[i]._owned, 0, 1) == 0) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) { return (-1); }
+        _krm_my_slot = slot + 1;
+    }
+
+    _krm_slots[slot]._epoch = _krm_global_epoch;
+    // the announcement must be visible before we read the snapshot pointer
+    membar_enter();
+    FIBER_FORBID_YIELD();
+    return (slot);
+}
+
+void krm_epoch_t::exit(const int slot)
+{
+    FIBER_ALLOW_YIELD();
+    membar_exit();
+    _krm_slots[slot]._epoch = 0;
+}
+
+uint4_t krm_epoch_t::advance()
+{
+    uint4_t e = atomic_inc_32_nv(&_krm_global_epoch);
+    membar_enter();
+    return (e);
+}
+
+bool krm_epoch_t::is_safe(const uint4_t retire_epoch)
+{
+    for (int i = 0; i < MAX_SLOTS; i++) {
+        uint4_t e = _krm_slots[i]._epoch;
+        if (e != 0 && e < retire_epoch) { return (false); }
+    }
+    return (true);
+}
+
+void krm_epoch_t::release_slot()
+{
+    int slot = _krm_my_slot - 1;
+    if (slot >= 0) {
+        _krm_slots[slot]._epoch = 0;
+        membar_producer();
+        _krm_slots[slot]._owned = 0;
+        _krm_my_slot = 0;
+    }
+}
+
+
+
 /****************************************************************** 
  *
  * Construction/Destruction
@@ -100,9 +300,10 @@ foo& foo::operator=(const foo& v)
  ******************************************************************/
 
 key_ranges_map::key_ranges_map()
-    : _numPartitions(0)
+    : _numPartitions(0), _routing(NULL), _retired(NULL)
 {
     _fookeys.clear();
+    _publish();
 }
 
 key_ranges_map::key_ranges_map(const sinfo_s& sinfo,
@@ -110,9 +311,10 @@ key_ranges_map::key_ranges_map(const sinfo_s& sinfo,
                                const cvec_t& maxKey, 
                                const uint numParts, 
                                const bool physical)
-    : _numPartitions(0)
+    : _numPartitions(0), _routing(NULL), _retired(NULL)
 {
     _fookeys.clear();
+    _publish();
     w_rc_t r = RCOK;
     if (physical) { 
         r = RC(mrb_NOT_PHYSICAL_MRBT); 
@@ -137,10 +339,53 @@ key_ranges_map::~key_ranges_map()
             *iter = NULL;
         }
     }
+    delete (_routing);
+    _routing = NULL;
+    _reclaim(true);
     _rwlock.release_write();    
 }
 
 
+/****************************************************************** 
+ *
+ * @fn:    _publish()
+ *
+ * @brief: Builds a routing snapshot of the current map and swaps it
+ *         in. The previous snapshot is retired at the new epoch, and 
+ *         all retired snapshots no reader can see anymore are freed.
+ *
+ * @note:  Should be called with the write lock held
+ *
+ ******************************************************************/
+
+void key_ranges_map::_publish()
+{
+    krm_routing_t* fresh = new krm_routing_t(_keyRangesMap);
+    krm_routing_t* old = (krm_routing_t*) atomic_swap_ptr(&_routing, fresh);
+    if (old) {
+        old->_retire_epoch = krm_epoch_t::advance();
+        old->_next_retired = _retired;
+        _retired = old;
+    }
+    _reclaim(false);
+}
+
+void key_ranges_map::_reclaim(const bool all)
+{
+    krm_routing_t** pprev = &_retired;
+    while (*pprev) {
+        krm_routing_t* r = *pprev;
+        if (all || krm_epoch_t::is_safe(r->_retire_epoch)) {
+            *pprev = r->_next_retired;
+            delete (r);
+        }
+        else {
+            pprev = &r->_next_retired;
+        }
+    }
+}
+
+
 /****************************************************************** 
  *
  * @fn:     nophy_equal_partitions()
@@ -180,6 +425,7 @@ w_rc_t key_ranges_map::nophy_equal_partitions(const sinfo_s& sinfo,
     // 3. add partitions
     _rwlock.acquire_write();
     _keyRangesMap.clear();
+    _publish();
     _rwlock.release_write();    
     uint size = (minKey_size < maxKey_size) ? minKey_size : maxKey_size;
     stid_t astid;
@@ -234,6 +480,7 @@ w_rc_t key_ranges_map::addPartition(const cvec_t& key, lpid_t& newRoot)
         _keyRangesMap[*newkv] = newRoot;
         _numPartitions++;
         _fookeys.push_back(newkv);
+        _publish();
     }
     else {
         r = RC(mrb_PARTITION_EXISTS);
@@ -302,6 +549,7 @@ w_rc_t key_ranges_map::_deletePartitionByKey(const foo& kv,
     root2 = iter->second;
     _keyRangesMap.erase(iter);
     _numPartitions--;
+    _publish();
     
     _rwlock.release_write();
     return (r);
@@ -382,15 +630,34 @@ w_rc_t key_ranges_map::getPartitionByUnscrambledKey(const sinfo_s& sinfo,
 
 w_rc_t key_ranges_map::getPartitionByKey(const Key& key, lpid_t& pid)
 {
-    foo kv((char*)key._base[0].ptr,key._base[0].len,false);
+    const char* kp = (const char*)key._base[0].ptr;
+    const uint4_t klen = key._base[0].len;
+
+    // Common case: search the published snapshot inside an epoch, 
+    // without touching the rwlock
+    int slot = krm_epoch_t::enter();
+    if (slot >= 0) {
+        krm_routing_t* routing = _routing;
+        int idx = routing->find(kp, klen);
+        if (idx >= 0) { pid = routing->root(idx); }
+        krm_epoch_t::exit(slot);
+        if (idx < 0) {
+            // the key is not in the map, returns error.
+            return (RC(mrb_PARTITION_NOT_FOUND));
+        }
+        return (RCOK);
+    }
+
+    // No epoch slot left for this thread, the read lock keeps the 
+    // snapshot from being reclaimed
     _rwlock.acquire_read();
-    KRMapIt iter = _keyRangesMap.lower_bound(kv);
-    if(iter == _keyRangesMap.end()) {
+    int idx = _routing->find(kp, klen);
+    if (idx < 0) {
 	// the key is not in the map, returns error.
         _rwlock.release_read();
 	return (RC(mrb_PARTITION_NOT_FOUND));
     }
-    pid = iter->second;
+    pid = _routing->root(idx);
     _rwlock.release_read();
     return (RCOK);    
 }
@@ -535,6 +802,7 @@ w_rc_t key_ranges_map::updateRoot(const Key& key, const lpid_t& root)
     _rwlock.acquire_write();
     if(_keyRangesMap.find(kv) != _keyRangesMap.end()) {
         _keyRangesMap[kv] = root;
+        _publish();
     } 
     else {
         _rwlock.release_write();
@@ -697,6 +965,7 @@ key_ranges_map& key_ranges_map::operator=(const key_ranges_map& krm)
 	_numPartitions++;
     }
     assert (_numPartitions == krm._numPartitions);
+    _publish();
 
     _rwlock.release_write();
 
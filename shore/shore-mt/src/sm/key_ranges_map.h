@@ -142,6 +142,101 @@ inline bool cmp_greater::operator()(const foo& a, const foo& b) const
 
 
 
+/******************************************************************** 
+ *
+ * @class: krm_routing_t
+ *
+ * @brief: Immutable snapshot of the partition boundaries of a
+ *         key_ranges_map, sorted in ascending key order. Next to each
+ *         boundary it keeps a normalized head, the first (up to) 8 
+ *         bytes of the key loaded as a big-endian integer, so routing
+ *         a key binary-searches a dense array of integers and touches
+ *         the full key bytes only when two heads are equal.
+ *
+ * @note:  A snapshot is never modified after it is published. The map
+ *         builds a new one under its write lock on every change of the
+ *         partitioning, swaps it in atomically and retires the old one
+ *         through krm_epoch_t.
+ *
+ ********************************************************************/
+
+class krm_routing_t
+{
+public:
+    typedef uint64_t head_t;
+
+private:
+    uint     _count;
+    uint     _head_len;   // # of key bytes folded into each head
+    head_t*  _heads;      // [_count]
+    lpid_t*  _roots;      // [_count]
+    uint4_t* _offsets;    // [_count+1], into _keys
+    char*    _keys;       // the boundary keys, back to back
+
+public:
+    // for the epoch-based reclamation
+    krm_routing_t* _next_retired;
+    uint4_t        _retire_epoch;
+
+    krm_routing_t(const map<foo, lpid_t, cmp_greater>& m);
+    ~krm_routing_t();
+
+    // Returns the index of the partition that "key" belongs to, i.e. the
+    // largest boundary that is <= key, or -1 if key is below all of them
+    int find(const char* key, const uint4_t len) const;
+
+    uint count() const { return (_count); }
+    const lpid_t& root(const int idx) const { return (_roots[idx]); }
+
+    static head_t normalize(const char* key, const uint4_t len);
+
+private:
+    // not allowed
+    krm_routing_t(const krm_routing_t&);
+    krm_routing_t& operator=(const krm_routing_t&);
+
+}; // EOF: krm_routing_t
+
+
+
+/******************************************************************** 
+ *
+ * @class: krm_epoch_t
+ *
+ * @brief: Epoch-based reclamation for the routing snapshots. 
+ *
+ * @note:  Each reader thread owns a cache-line-sized slot, where it 
+ *         announces the global epoch it entered with. A retired snapshot
+ *         is freed once no slot announces an epoch older than the one 
+ *         the snapshot was retired at. Readers only write to their own
+ *         slot, so lookups never touch a shared lock word. 
+ *         If all slots are taken the caller falls back to the read lock.
+ *
+ ********************************************************************/
+
+class krm_epoch_t
+{
+public:
+    enum { MAX_SLOTS = 256 };
+
+    // Returns the slot of the calling thread, or -1 if none is available
+    static int enter();
+    static void exit(const int slot);
+
+    // Advances the global epoch and returns the new value
+    static uint4_t advance();
+
+    // Returns true if no reader can still see a snapshot retired at epoch
+    static bool is_safe(const uint4_t retire_epoch);
+
+    // Gives up the slot of the calling thread (at thread exit)
+    static void release_slot();
+
+}; // EOF: krm_epoch_t
+
+
+
+
 /******************************************************************** 
  *
  * @class: key_ranges_map
@@ -183,6 +278,16 @@ protected:
     // for thread safety multiple readers/single writer lock
     occ_rwlock _rwlock;
 
+    // read-optimized copy of the map used for routing keys, swapped on
+    // every change of the partitioning (under the write lock)
+    krm_routing_t* volatile _routing;
+    krm_routing_t* _retired;
+
+    // Rebuilds and publishes the routing snapshot, and frees the retired
+    // snapshots no reader can still see. Must hold the write lock.
+    void _publish();
+    void _reclaim(const bool all);
+
     // Splits the partition where "key" belongs to two partitions. The start of 
     // the second partition is the "key".
 //     virtual w_rc_t _addPartition(char* keyS, lpid_t& newRoot);
@@ -77,6 +77,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 // DEAD #include "log_buf.h"
 #include "log.h"
 #include "log_core.h"
+#include "sthread_fiber.h"
 
 // chkpt.h needed to kick checkpoint thread
 #include "chkpt.h"
@@ -89,6 +90,9 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 
 #include <map>
 #include <math.h>
+#if defined(linux)
+#include <sched.h>
+#endif
 
 bool       log_core::_initialized = false;
 
@@ -971,6 +975,8 @@ static union {
 
 enum { SLOT_ARRAY_SIZE=256 };
 enum { SLOT_ACTIVE_COUNT=5 };
+// leave enough of the array for the slots of groups still in flight
+enum { SLOT_ACTIVE_MAX=SLOT_ARRAY_SIZE/4 };
 enum { SLOT_AVAILABLE=0,
        SLOT_UNUSED=-1,
        SLOT_PENDING=-2,
@@ -1035,6 +1041,10 @@ struct log_core::insert_info_array {
 		_slot_mark = 0;
             }
             w_assert0(be_patient || _slot_mark != orig_slot_mark);
+            // every slot busy: on a fiber the owners share this
+            // carrier (and this array), so let them run
+            if(_slot_mark == orig_slot_mark)
+                FIBER_SPIN_PAUSE();
 	}
 	insert_info* i2 = &_slot_array[_slot_mark];
 	i2->count = SLOT_AVAILABLE;
@@ -1113,8 +1123,10 @@ log_core::log_core(
       _shutting_down(false),
       _flush_daemon_running(false),
       _slot_array(new insert_info_array(SLOT_ARRAY_SIZE)),
-      _active_slots(SLOT_ACTIVE_COUNT),
-      _slots(new insert_info* volatile[SLOT_ACTIVE_COUNT]),
+      _active_slots(log_insert_slots
+                    ? std::min(int(log_insert_slots), int(SLOT_ACTIVE_MAX))
+                    : int(SLOT_ACTIVE_COUNT)),
+      _slots(new insert_info* volatile[_active_slots]),
       _curr_index(-1),
       _curr_num(1),
       _readbuf(new char[BLOCK_SIZE*4]),
@@ -2089,7 +2101,7 @@ void log_core::_acquire_buffer_space(insert_info* info, long recsize)
               // Use signal since the only thread that should be waiting 
               // on the _flush_cond is the log flush daemon.
               DO_PTHREAD(pthread_cond_signal(&_flush_cond));
-              DO_PTHREAD(pthread_cond_wait(&_wait_cond, &_wait_flush_lock));
+              sthread_t::cond_wait(_wait_cond, _wait_flush_lock);
           }
       }
       _insert_lock.acquire(&info->me);
@@ -2472,6 +2484,22 @@ void log_core::_allocate_slot(long idx) {
     _slots[idx] = _slot_array->allocate();
 }
 
+/* The slot where a thread starts probing. With sm_log_insert_slots
+ * set, threads running on the same cpu start at the same slot, so
+ * that with one slot per core the count of a slot stays in the caches
+ * of the cores that join it instead of bouncing between all of them.
+ */
+long log_core::_home_slot() const {
+#if defined(linux)
+    if(log_insert_slots) {
+	int cpu = sched_getcpu();
+	if(cpu >= 0)
+	    return cpu;
+    }
+#endif
+    return pthread_self();
+}
+
 
 rc_t log_core::insert(logrec_t &rec, lsn_t* rlsn) {
     long size = rec.length();
@@ -2519,7 +2547,7 @@ rc_t log_core::insert(logrec_t &rec, lsn_t* rlsn) {
     
     if(!acquired) {
 	// need to consolidate
-	long idx =  pthread_self();
+	long idx = _home_slot();
 	long old_count;
 	info = _join_slot(idx, old_count, size);
 
@@ -2605,7 +2633,7 @@ rc_t log_core::flush(lsn_t lsn, bool block)
 		// Use signal since the only thread that should be waiting 
 		// on the _flush_cond is the log flush daemon.
 		DO_PTHREAD(pthread_cond_signal(&_flush_cond));
-		DO_PTHREAD(pthread_cond_wait(&_wait_cond, &_wait_flush_lock));
+		sthread_t::cond_wait(_wait_cond, _wait_flush_lock);
 	    }
         }
     } else {
@@ -2638,7 +2666,7 @@ void log_core::flush_daemon()
             CRITICAL_SECTION(cs, _wait_flush_lock);
             if(success && (*&_waiting_for_space || *&_waiting_for_flush)) {
                 _waiting_for_flush = _waiting_for_space = false;
-                DO_PTHREAD(pthread_cond_broadcast(&_wait_cond)); 
+                sthread_t::cond_broadcast(_wait_cond);
                 // wake up anyone waiting on log flush
             }
 
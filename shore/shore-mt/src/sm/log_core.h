@@ -319,6 +319,7 @@ private:
   
     insert_info* _join_slot(long &idx, long &count, long size);
     void _allocate_slot(long idx);	
+    long _home_slot() const;
   
 public:
     // for partition_t
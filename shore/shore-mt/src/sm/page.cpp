@@ -101,6 +101,22 @@ extern "C" void pagestophere()
 {
 }
 
+// The stamp is kept in the frame control block, not in the page, so
+// it is not written to disk and does not wrap around.
+w_base_t::uint8_t
+page_p::mod_stamp() const
+{
+    bfcb_t *b = bf_m::get_cb(_pp);
+    return b ? b->mod_stamp() : 0;
+}
+
+void
+page_p::_bump_mod_stamp()
+{
+    bfcb_t *b = bf_m::get_cb(_pp);
+    if(b) b->bump_mod_stamp();
+}
+
 
 /*********************************************************************
  *
@@ -775,6 +791,7 @@ page_p::_format(const lpid_t& pid, tag_t tag,
     _pp->tag = tag;  // must be set before rsvd_mode() is called
     _pp->space.init_space_t(data_sz + 2*sizeof(slot_t), rsvd_mode() != 0);
     _pp->end = _pp->nslots = _pp->nvacant = 0;
+    _bump_mod_stamp();
 
 
     if(_pp->tag != t_file_p || _pp->tag != t_file_mrbt_p) {
@@ -1098,6 +1115,7 @@ page_p::mark_free(slotid_t idx)
      *  Log the action
      */
     W_DO( log_page_mark(*this, idx) ); /* mark idx free */
+    _bump_mod_stamp();
 
     /*
      *  Release space and mark free
@@ -1196,6 +1214,7 @@ page_p::reclaim(slotid_t idx, const cvec_t& vec, bool log_it)
      *  Log has already been generated ... the following actions must
      *  succeed!
      */
+    _bump_mod_stamp();
     // Q : why is need_slots figured in contig_space() ?
     // A : because need_slots is 0 if we aren't allocating
     // a new slot.
@@ -1463,6 +1482,7 @@ page_p::insert_expand(slotid_t idx, int cnt, const cvec_t *vec,
      *  Log has already been generated ... the following actions must
      *  succeed!
      */
+    _bump_mod_stamp();
 
     if (contig_space() < total)  {
         /*
@@ -1527,6 +1547,7 @@ page_p::remove_compress(slotid_t idx, int cnt)
      *  Log the removal
      */
     W_DO( log_page_remove(*this, idx, cnt) );
+    _bump_mod_stamp();
 
     /*
      *        Compute space space occupied by tuples
@@ -1585,6 +1606,7 @@ page_p::set_byte(slotid_t idx, u_char bits, logical_operation op)
      *  Log the modification
      */
     W_DO( log_page_set_byte(*this, idx, *p, bits, op) );
+    _bump_mod_stamp();
 
     switch(op) {
     case l_none:
@@ -1784,6 +1806,7 @@ page_p::splice(slotid_t idx, slot_length_t start, slot_length_t len, const cvec_
         }
         return RC_AUGMENT(rc);
     }
+    _bump_mod_stamp();
     DBGTHRD(<<"adjustment =" << adjustment);
 
     if (adjustment == 0) {
@@ -2180,6 +2203,7 @@ page_p::_shift_compress(slotid_t from,
      *  Grab the mutex
      */
     CRITICAL_SECTION(cs, page_shift_compress_mutex);
+    _bump_mod_stamp();
     
     w_assert3(from >= 0 && from < _pp->nslots);
     w_assert3(to >= 0 && to < _pp->nslots);
@@ -163,6 +163,9 @@ public:
     
     const lsn_t&                lsn() const;
     void                        set_lsns(const lsn_t& lsn);
+    // changes whenever the slots or the data of the page change
+    // (0 if the page is not in a buffer frame)
+    w_base_t::uint8_t           mod_stamp() const;
     void                        repair_rec_lsn(bool was_dirty, 
                                         lsn_t const &new_rlsn);
     
@@ -400,6 +403,7 @@ protected:
 private:
 
     void                        _compress(slotid_t idx = -1);
+    void                        _bump_mod_stamp();
 
     friend class page_link_log;
     friend class page_insert_log;
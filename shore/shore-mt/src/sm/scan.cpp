@@ -426,6 +426,15 @@ scan_index_i::finish()
 }
 
 
+void
+scan_index_i::set_scan_hint(bool h)
+{
+    if (_btcursor)  {
+        _btcursor->set_scan_hint(h);
+    }
+}
+
+
 /*********************************************************************
  *
  *  scan_index_i::_fetch(key, klen, el, elen, skip)
@@ -675,7 +684,10 @@ scan_file_i::scan_file_i(
   _cc(cc), 
   _bIgnoreLatches(bIgnoreLatches),
   _do_prefetch(pre),
-  _prefetch(0)
+  _scan_hint(true),
+  _prefetch(0),
+  _readahead(0),
+  _ra_ahead(0)
 {
     INIT_SCAN_PROLOGUE_RC(scan_file_i::scan_file_i,
             cc == t_cc_append ? prologue_rc_t::read_write : prologue_rc_t::read_only,
@@ -700,7 +712,10 @@ scan_file_i::scan_file_i(const stid_t& stid_, concurrency_t cc,
   _cc(cc),
   _bIgnoreLatches(bIgnoreLatches),
   _do_prefetch(pre),
-  _prefetch(0)
+  _scan_hint(true),
+  _prefetch(0),
+  _readahead(0),
+  _ra_ahead(0)
 {
     INIT_SCAN_PROLOGUE_RC(scan_file_i::scan_file_i,
         cc == t_cc_append?prologue_rc_t::read_write:prologue_rc_t::read_only,  0);
@@ -731,6 +746,7 @@ rc_t scan_file_i::_init(bool for_append)
     // Can't nest these prologues
     // SCAN_METHOD_PROLOGUE(scan_file_i::_init, read_only, 1);
     this->_prefetch = 0;
+    this->_readahead = 0;
 
     bool  eof = false;
 
@@ -845,7 +861,21 @@ rc_t scan_file_i::_init(bool for_append)
         _next_pid = lpid_t::null;
     } 
 
-    if(smlevel_0::do_prefetch && this->_do_prefetch && !for_append) {
+    if(smlevel_0::do_prefetch && this->_do_prefetch && !for_append
+            && smlevel_0::prefetch_depth > 1) {
+        // read the pages after the first one ahead
+        this->_readahead = 
+            new bf_readahead_thread_t(smlevel_0::prefetch_depth);
+        if (this->_readahead) {
+            W_COERCE( this->_readahead->fork());
+            _ra_pid = _next_pid;
+            _ra_ahead = 0;
+            _error_occurred = _fill_readahead();
+            if (_error_occurred.is_error())  {
+                return w_rc_t(_error_occurred);
+            }
+        }
+    } else if(smlevel_0::do_prefetch && this->_do_prefetch && !for_append) {
         // prefetch first page
         this->_prefetch = new bf_prefetch_thread_t;
         if (this->_prefetch) {
@@ -875,11 +905,37 @@ scan_file_i::next(pin_i*& pin_ptr, smsize_t start, bool& eof)
     return _next(pin_ptr, start, eof);
 }
 
+/*********************************************************************
+ *
+ *  scan_file_i::_fill_readahead()
+ *
+ *  Request read-ahead of the pages after _ra_pid until there
+ *  are prefetch_depth of them past the current page.
+ *
+ *********************************************************************/
+rc_t
+scan_file_i::_fill_readahead()
+{
+    w_assert3(this->_readahead);
+    while(_ra_ahead < smlevel_0::prefetch_depth && _ra_pid != lpid_t::null) {
+        this->_readahead->request(_ra_pid);
+        _ra_ahead++;
+
+        bool tmp_eof;
+        W_DO(fi->next_page(_ra_pid, tmp_eof, NULL/*alloc only*/));
+        if (tmp_eof) {
+            _ra_pid = lpid_t::null;
+        } 
+    }
+    return RCOK;
+}
+
 rc_t
 scan_file_i::_next(pin_i*& pin_ptr, smsize_t start, bool& eof)
 {
     SCAN_METHOD_PROLOGUE1;
     file_p*        curr;
+    bf_scan_hint_t hint(_scan_hint);
 
     w_assert1(xct()->tid() == tid); // (ip) ???
 
@@ -1007,6 +1063,15 @@ scan_file_i::_next(pin_i*& pin_ptr, smsize_t start, bool& eof)
                     _next_pid = lpid_t::null;
                 } 
                 DBGTHRD(<<" next page is " << _next_pid);
+
+                if(this->_readahead) {
+                    // moved on to a page that was read ahead
+                    if(_ra_ahead > 0) _ra_ahead--;
+                    _error_occurred = _fill_readahead();
+                    if (_error_occurred.is_error())  {
+                        return w_rc_t(_error_occurred);
+                    }
+                }
             }
 #if W_DEBUG_LEVEL > 1
         (void) _cursor.is_mine(); // Not an assert - just a 
@@ -1084,6 +1149,11 @@ void scan_file_i::finish()
         delete this->_prefetch;
         this->_prefetch = 0;
     }
+    if (this->_readahead) {
+        this->_readahead->retire();
+        delete this->_readahead;
+        this->_readahead = 0;
+    }
 }
 
 /*********************************************************************
@@ -272,6 +272,16 @@ t_cc_file  | error     | error       | error     | error     | SH/none
     ndx_t            ndx() const { return ntype; }
     const rc_t &     error_code() const { return _error_occurred; }
 
+    /**\brief Tell the buffer manager whether this scan is sequential.
+     * \details
+     * Off by default, since most index scans are short. Turn it on
+     * for long range scans, so that with the 2q replacement policy
+     * (sm_bufpool_replacement) the leaf pages they read in are
+     * replaced before the working set of the other transactions.
+     * See bf_scan_hint_t.
+     */
+    void             set_scan_hint(bool h);
+
 private:
     stid_t               _stid;
     tid_t                tid;
@@ -404,6 +414,7 @@ private:
 };
 
 class bf_prefetch_thread_t;
+class bf_readahead_thread_t;
 
 
 /** \brief Iterator over a file of records. 
@@ -554,6 +565,17 @@ public:
     /**\brief ID of the transaction that created this iterator */
     tid_t           xid() const { return tid; }
 
+    /**\brief Tell the buffer manager whether this scan is sequential.
+     * \details
+     * On by default. With the 2q replacement policy
+     * (sm_bufpool_replacement), the pages read in by the scan are
+     * replaced before the working set of the other transactions.
+     * Turn it off for a scan whose pages are worth keeping.
+     * See bf_scan_hint_t.
+     */
+    void            set_scan_hint(bool h) { _scan_hint = h; }
+    bool            scan_hint() const { return _scan_hint; }
+
 protected:
     tid_t            tid;
     bool             _eof;
@@ -580,8 +602,16 @@ protected:
 
 private:
     bool              _do_prefetch;
+    bool              _scan_hint;
     bf_prefetch_thread_t*    _prefetch;
 
+    // read-ahead, if sm_prefetch_depth > 1
+    bf_readahead_thread_t*   _readahead;
+    lpid_t                   _ra_pid; // next page to read ahead
+    int                      _ra_ahead; // pages requested past curr_rid
+
+    rc_t             _fill_readahead();
+
     // disabled
     NORET            scan_file_i(const scan_file_i&);
     scan_file_i&        operator=(const scan_file_i&);
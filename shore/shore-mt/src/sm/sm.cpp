@@ -73,6 +73,7 @@ class prologue_rc_t;
 #include "sm_int_4.h"
 #include "pin.h"
 #include "chkpt.h"
+#include "stats_sampler.h"
 #include "lgrec.h"
 #include "sm.h"
 #include "sm_vtable_enum.h"
@@ -104,6 +105,11 @@ smlevel_0::operating_mode_t
             //controlled by AutoTurnOffLogging:
 bool        smlevel_0::logging_enabled = true;
 bool        smlevel_0::do_prefetch = false;
+int         smlevel_0::prefetch_depth = 1;
+bool        smlevel_0::use_2q_replacement = false;
+int         smlevel_0::ext_reservation = 0;
+int         smlevel_0::log_insert_slots = 0;
+int         smlevel_0::sort_threads = 1;
 
 #ifndef SM_LOG_WARN_EXCEED_PERCENT
 #define SM_LOG_WARN_EXCEED_PERCENT 40
@@ -244,7 +250,16 @@ option_group_t* ss_m::_options = NULL;
 option_t* ss_m::_hugetlbfs_path = NULL;
 option_t* ss_m::_reformat_log = NULL;
 option_t* ss_m::_prefetch = NULL;
+option_t* ss_m::_prefetch_depth = NULL;
 option_t* ss_m::_bufpoolsize = NULL;
+option_t* ss_m::_bufpool_replacement = NULL;
+option_t* ss_m::_extent_reservation = NULL;
+option_t* ss_m::_log_insert_slots = NULL;
+option_t* ss_m::_sort_threads = NULL;
+option_t* ss_m::_stats_sample_ms = NULL;
+option_t* ss_m::_stats_sample_file = NULL;
+stats_sampler_m* ss_m::_stats_sampler = NULL;
+option_t* ss_m::_big_reader_latches = NULL;
 option_t* ss_m::_locktablesize = NULL;
 option_t* ss_m::_logdir = NULL;
 option_t* smlevel_0::_backgroundflush = NULL;
@@ -357,10 +372,38 @@ rc_t ss_m::setup_options(option_group_t* options)
             "no disables page prefetching on scans",
             false, option_t::set_value_bool, _prefetch));
 
+    W_DO(options->add_option("sm_prefetch_depth", "#>=1", "1",
+            "number of pages a file scan reads ahead if sm_prefetch is yes",
+            false, option_t::set_value_long, _prefetch_depth));
+
     W_DO(options->add_option("sm_bufpoolsize", "#>=8192", NULL,
             "size of buffer pool in Kbytes",
             true, option_t::set_value_long, _bufpoolsize));
 
+    W_DO(options->add_option("sm_bufpool_replacement", "clock/2q", "clock",
+            "2q replaces the pages read by scans before the others",
+            false, option_t::set_value_charstr, _bufpool_replacement));
+
+    W_DO(options->add_option("sm_extent_reservation", "0-64", "0",
+            "empty extents a growing store reserves for later page allocations (0: off)",
+            false, option_t::set_value_long, _extent_reservation));
+
+    W_DO(options->add_option("sm_sort_threads", "1-64", "1",
+            "threads that sort each run of a sort in memory",
+            false, option_t::set_value_long, _sort_threads));
+
+    W_DO(options->add_option("sm_stats_sample_ms", ">=0", "0",
+            "interval of the statistics rows written to sm_stats_sample_file (0 means none)",
+            false, option_t::set_value_long, _stats_sample_ms));
+
+    W_DO(options->add_option("sm_stats_sample_file", "file name", "sm_stats.csv",
+            "file of the sm_stats_sample_ms statistics rows",
+            false, option_t::set_value_charstr, _stats_sample_file));
+
+    W_DO(options->add_option("sm_big_reader_latches", ">=0", "0",
+            "latches that may be big-reader at once when read-mostly (0 means none)",
+            false, option_t::set_value_long, _big_reader_latches));
+
     W_DO(options->add_option("sm_locktablesize", "#>64", "64000",
             "size of lock manager hash table",
             false, option_t::set_value_long, _locktablesize));
@@ -386,6 +429,10 @@ rc_t ss_m::setup_options(option_group_t* options)
             "size of log buffer Kbytes",
             false, option_t::set_value_long, _logbufsize));
 
+    W_DO(options->add_option("sm_log_insert_slots", "0-64", "0",
+            "slots where concurrent log inserts group, picked by cpu (0: the 5 fixed ones)",
+            false, option_t::set_value_long, _log_insert_slots));
+
     W_DO(options->add_option("sm_logsize", "#>8256 or 0", "10000",
             "maximum size of the log in Kbytes, 0 for raw device -> use device size",
             false, _set_option_logsize, _logsize));
@@ -745,6 +792,15 @@ ss_m::_construct_once(
         << flushl; 
         W_FATAL(OPT_BadValue);
     }
+
+    log_insert_slots = int(strtol(_log_insert_slots->value(), NULL, 0));
+    if(log_insert_slots < 0 || log_insert_slots > 64) {
+        errlog->clog << fatal_prio 
+        << "ERROR: sm_log_insert_slots must be between 0 and 64: "
+        << _log_insert_slots->value()
+        << flushl; 
+        W_FATAL(OPT_BadValue);
+    }
     DBG(<<"SHM Need " << space_needed << " for buffer pool" );
 
     /*
@@ -1020,6 +1076,75 @@ ss_m::_construct_once(
     do_prefetch = 
         option_t::str_to_bool(_prefetch->value(), badVal);
     w_assert3(!badVal);
+
+    prefetch_depth = int(strtol(_prefetch_depth->value(), NULL, 0));
+    if(prefetch_depth < 1) {
+        errlog->clog << fatal_prio << "ERROR: sm_prefetch_depth must be at least 1: "
+             << _prefetch_depth->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+
+    if(strcmp(_bufpool_replacement->value(), "2q") == 0) {
+        use_2q_replacement = true;
+    } else if(strcmp(_bufpool_replacement->value(), "clock") == 0) {
+        use_2q_replacement = false;
+    } else {
+        errlog->clog << fatal_prio << "ERROR: sm_bufpool_replacement must be clock or 2q: "
+             << _bufpool_replacement->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+
+    ext_reservation = int(strtol(_extent_reservation->value(), NULL, 0));
+    if(ext_reservation < 0 || ext_reservation > 64) {
+        errlog->clog << fatal_prio << "ERROR: sm_extent_reservation must be between 0 and 64: "
+             << _extent_reservation->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+    if(ext_reservation > 0) {
+        W_COERCE(io->spawn_ext_reserver());
+    }
+
+    sort_threads = int(strtol(_sort_threads->value(), NULL, 0));
+    if(sort_threads < 1 || sort_threads > 64) {
+        errlog->clog << fatal_prio << "ERROR: sm_sort_threads must be between 1 and 64: "
+             << _sort_threads->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+
+    int stats_sample_ms = int(strtol(_stats_sample_ms->value(), NULL, 0));
+    if(stats_sample_ms < 0) {
+        errlog->clog << fatal_prio << "ERROR: sm_stats_sample_ms must be at least 0: "
+             << _stats_sample_ms->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+    if(stats_sample_ms > 0) {
+        FILE* out = fopen(_stats_sample_file->value(), "w");
+        if(!out) {
+            errlog->clog << fatal_prio << "ERROR: cannot open sm_stats_sample_file "
+                 << _stats_sample_file->value() << ": " << strerror(errno)
+                 << flushl;
+            W_FATAL(OPT_BadValue);
+        }
+        _stats_sampler = new stats_sampler_m(out, stats_sample_ms);
+        if (! _stats_sampler) {
+            W_FATAL(eOUTOFMEMORY);
+        }
+        W_COERCE(_stats_sampler->spawn_sampler_thread());
+    }
+
+    int big_reader_latches = int(strtol(_big_reader_latches->value(), NULL, 0));
+    if(big_reader_latches < 0) {
+        errlog->clog << fatal_prio << "ERROR: sm_big_reader_latches must be at least 0: "
+             << _big_reader_latches->value() 
+             << flushl;
+        W_FATAL(OPT_BadValue);
+    }
+    latch_t::big_reader_max = big_reader_latches;
     DBG(<<"constructor done");
 }
 
@@ -1052,6 +1177,12 @@ ss_m::_destruct_once()
         return;
     }
 
+    // the last row covers the time up to the shutdown
+    delete _stats_sampler; _stats_sampler = 0;
+
+    // no more refills of the reserved extents
+    io->retire_ext_reserver();
+
     // We will flush if needed, serially -- not relying on b/g flushing
     W_COERCE(bf->disable_background_flushing());
 
@@ -1663,6 +1794,27 @@ ss_m::snapshot_buffers(u_int& ndirty,
     return RCOK;
 }
 
+/*--------------------------------------------------------------*
+ *  ss_m::save_buffer_image()                            *
+ *--------------------------------------------------------------*/
+rc_t
+ss_m::save_buffer_image(const char* path)
+{
+    W_DO( bf_m::save_image(path) );
+    return RCOK;
+}
+
+/*--------------------------------------------------------------*
+ *  ss_m::load_buffer_image()                            *
+ *--------------------------------------------------------------*/
+rc_t
+ss_m::load_buffer_image(const char* path, u_int& nloaded)
+{
+    SM_PROLOGUE_RC(ss_m::load_buffer_image, not_in_xct, read_only, 0);
+    W_DO( bf_m::load_image(path, nloaded) );
+    return RCOK;
+}
+
 
 /*--------------------------------------------------------------*
  *  ss_m::config_info()                                *
@@ -3397,36 +3549,23 @@ ss_m::gather_xct_stats(sm_stats_info_t& _stats, bool reset)
 rc_t
 ss_m::gather_stats(sm_stats_info_t& _stats)
 {
-    class GatherSmthreadStats : public SmthreadFunc
-    {
-    public:
-        GatherSmthreadStats(sm_stats_info_t &s) : _stats(s)
-        {
-            new (&_stats) sm_stats_info_t; // clear the stats
-            // by invoking the constructor.
-        };
-        void operator()(const smthread_t& t)
-        {
-            t.add_from_TL_stats(_stats);
-        }
-        void compute() { _stats.compute(); }
-    private:
-        sm_stats_info_t &_stats;
-    } F(_stats);
+    new (&_stats) sm_stats_info_t; // clear the stats
+    // by invoking the constructor.
 
     //Gather all the threads' statistics into the copy given by
-    //the client.
-    smthread_t::for_each_smthread(F);
-    F.compute();
-
-    // Now add in the global stats.
-    // Global stats contain all the per-thread stats that were collected
-    // before a per-thread stats structure was cleared. 
-    // (This happens when per-xct stats get gathered for instrumented xcts.)
-    add_from_global_stats(_stats); // from finished threads and cleared stats
+    //the client, and add in the global stats: those of finished threads
+    //and those cleared when per-xct stats get gathered for instrumented
+    //xcts.
+    add_from_all_stats(_stats);
     return RCOK;
 }
 
+void
+ss_m::stats_sample_mark(const char* event)
+{
+    if(_stats_sampler) _stats_sampler->mark(event);
+}
+
 #if W_DEBUG_LEVEL > 0
 extern void dump_all_sm_stats();
 void dump_all_sm_stats()
@@ -194,6 +194,18 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
  *      - default: 128
  *      - required?: no
  *
+ * -sm_log_insert_slots
+ *      - type: number between 0 and 64
+ *      - description: number of slots where concurrent log inserts
+ *      group before one of them takes the log buffer for all. A thread
+ *      joins the slot of the cpu it runs on first, so that with one
+ *      slot per core the threads of a core form the groups and the
+ *      slot stays in that core's cache. 0 (the default) keeps the five
+ *      fixed slots, picked from the thread id. Compare with
+ *      sm/tests/log_insert.
+ *      - default: 0
+ *      - required?: no
+ *
  * -sm_logsize
  *      - type: number
  *      - description: greater than or equal to 8256 
@@ -290,6 +302,73 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
  *      - default: no
  *      - required?: no
  *
+ * -sm_prefetch_depth
+ *      - type: number greater than or equal to 1
+ *      - description: number of pages a file scan keeps in flight ahead
+ *      of its position when sm_prefetch is "yes". A value greater than 1
+ *      replaces the one-page prefetcher with asynchronous read-ahead.
+ *      - default: 1
+ *      - required?: no
+ *
+ * -sm_bufpool_replacement
+ *      - type: string (one of clock | 2q)
+ *      - description: buffer pool replacement policy. With "2q", pages
+ *      read in by sequential scans (see bf_scan_hint_t) are put on
+ *      probation and replaced before the clock considers the others,
+ *      unless something other than a scan fixes them meanwhile.
+ *      - default: clock
+ *      - required?: no
+ *
+ * -sm_extent_reservation
+ *      - type: number between 0 and 64
+ *      - description: number of empty extents kept reserved for each
+ *      store that grows. Threads allocating pages in such a store take
+ *      a reserved extent each and allocate in it without the volume
+ *      mutex; a background thread reserves more when half of them are
+ *      gone. 0 (the default) turns this off: all allocations take the
+ *      volume mutex. Try 8 for inserts from many threads into a few
+ *      stores.
+ *      - default: 0
+ *      - required?: no
+ *
+ * -sm_sort_threads
+ *      - type: number between 1 and 64
+ *      - description: number of threads that sort each run of a
+ *      sort_stream_i (as used by the index bulk-loads) in memory before
+ *      it is written out. Runs of fewer than 1024 records per
+ *      thread are sorted by the calling thread alone.
+ *      - default: 1
+ *      - required?: no
+ *
+ * -sm_stats_sample_ms
+ *      - type: number greater than or equal to 0
+ *      - description: if above 0, a background thread gathers the
+ *      statistics every this many milliseconds and appends what changed
+ *      since the last time (transactions, buffer-pool hits and misses,
+ *      lock and latch waits, log bytes) to sm_stats_sample_file as a
+ *      row of comma-separated values. See ss_m::stats_sample_mark.
+ *      - default: 0
+ *      - required?: no
+ *
+ * -sm_stats_sample_file
+ *      - type: string
+ *      - description: the file the rows of sm_stats_sample_ms go to.
+ *      It is overwritten.
+ *      - default: sm_stats.csv
+ *      - required?: no
+ *
+ * -sm_big_reader_latches
+ *      - type: number greater than or equal to 0
+ *      - description: how many latches (B-tree roots, store and volume
+ *      metadata pages...) may be big-reader at once. A latch acquired
+ *      in SH mode at least 64 times as often as in EX mode then lets
+ *      readers take it by touching only a reader slot of their core,
+ *      and writers wait for the slots to drain; see
+ *      latch_t::is_big_reader. A latch gives its slots (1KB) back when
+ *      writers catch up. 0 keeps all latches plain.
+ *      - default: 0
+ *      - required?: no
+ *
  * \sa  \ref SSMVAS
  */
 
@@ -453,6 +532,7 @@ class file_m;
 class pool_m;
 class dir_m;
 class chkpt_m;
+class stats_sampler_m;
 class lid_m; 
 class sm_stats_cache_t;
 class option_group_t;
@@ -1550,6 +1630,28 @@ public:
         u_int&                 nfixed);
     /**\endcond skip */
 
+    /**\brief Save the ids of the pages in the buffer pool to a file.
+     * \ingroup SSMAPIDEBUG
+     * @param[in] path   File to (over)write.
+     * \details
+     * The image is only a list of page ids, not the pages themselves.
+     * Given to load_buffer_image() after the volumes are mounted again,
+     * it warms up the buffer pool of a later run with the same volumes.
+     */
+    static rc_t            save_buffer_image(const char* path);
+
+    /**\brief Read into the buffer pool the pages of an image.
+     * \ingroup SSMAPIDEBUG
+     * @param[in] path   File written by save_buffer_image().
+     * @param[out] nloaded   Number of pages read.
+     * \details
+     * The pages are read in the order of the volume, up to the size of
+     * the buffer pool. Pages that no longer exist are skipped.
+     */
+    static rc_t            load_buffer_image(
+        const char*            path,
+        u_int&                 nloaded);
+
     /**\brief Get a copy of the statistics from an attached instrumented transaction.
      * \ingroup SSMXCT
      * \details
@@ -1569,6 +1671,18 @@ public:
         sm_stats_info_t&       stats
         );
 
+    /**\brief Note an event in the interval statistics.
+     * \ingroup SSMSTATS
+     * \details
+     * @param[in] event A word naming the event, e.g. "roi_begin".
+     *
+     * If the sm_stats_sample_ms option is set, writes a comment line
+     * with the time and the event among the rows of statistics, so that
+     * they can be lined up with what the server was doing.
+     * Does nothing otherwise.
+     */
+    static void            stats_sample_mark(const char* event);
+
     /**\brief Get a copy of configuration-dependent information.
      * \ingroup OPT
      * \details
@@ -3578,11 +3692,20 @@ private:
     static option_t* _hugetlbfs_path;
     static option_t* _reformat_log;
     static option_t* _prefetch;
+    static option_t* _prefetch_depth;
     static option_t* _bufpoolsize;
+    static option_t* _bufpool_replacement;
+    static option_t* _extent_reservation;
+    static option_t* _sort_threads;
+    static option_t* _stats_sample_ms;
+    static option_t* _stats_sample_file;
+    static stats_sampler_m* _stats_sampler;
+    static option_t* _big_reader_latches;
     static option_t* _locktablesize;
     static option_t* _logdir;
     static option_t* _logsize;
     static option_t* _logbufsize;
+    static option_t* _log_insert_slots;
     static option_t* _error_log;
     static option_t* _error_loglevel;
     static option_t* _lockEscalateToPageThreshold;
@@ -420,6 +420,9 @@ public:
 
     static void  add_to_global_stats(const sm_stats_info_t &from);
     static void  add_from_global_stats(sm_stats_info_t &to);
+    static void  move_to_global_stats(sm_stats_info_t &from);
+    static void  retire_to_global_stats(sm_stats_info_t *&from);
+    static void  add_from_all_stats(sm_stats_info_t &to);
 
     static device_m* dev;
     static io_m* io;
@@ -443,6 +446,11 @@ public:
     static bool        shutting_down;
     static bool        logging_enabled;
     static bool        do_prefetch;
+    static int         prefetch_depth; // pages a file scan reads ahead
+    static bool        use_2q_replacement; // see bf_scan_hint_t
+    static int         ext_reservation; // extents a growing store reserves
+    static int         log_insert_slots; // 0: the fixed log insert slots
+    static int         sort_threads;    // threads that sort a run
 
     static operating_mode_t operating_mode;
     static bool in_recovery() { 
@@ -109,6 +109,12 @@ int                      io_m::vol_cnt = 0;
 vol_t*                   io_m::vol[io_m::max_vols] = { 0 };
 lsn_t                    io_m::_lastMountLSN = lsn_t::null;
 
+// Held by the extent reserver while it works on the mounted volumes
+// with no transaction attached, and by io_m::dismount, which makes
+// the reserver's vol[] entries stay put (see refill_reserved_exts).
+// Taken before the checkpoint-serialization mutex.
+static pthread_mutex_t   resv_dismount_lock = PTHREAD_MUTEX_INITIALIZER;
+
 // used for most io_m methods:
 void
 io_m::auto_leave_t::on_entering() 
@@ -653,6 +659,7 @@ io_m::dismount(vid_t vid, bool flush)
     // grab chkpt_mutex to prevent dismounts during chkpt
     // need to serialize writing dev_tab and dismounts
 
+    CRITICAL_SECTION(cs, resv_dismount_lock);
     auto_leave_and_trx_release_t acquire_and_enter;
     return _dismount(vid, flush);
 }
@@ -993,18 +1000,24 @@ io_m::_alloc_pages(
     DBG(<<"stid " << stid);
     vid_t volid = stid.vol;
 
+    alloc_page_filter_yes_t ok; // accepts any page
+
+    if(npages == 1 && search_file && _use_reserved_exts()) {
+        W_DO(_alloc_reserved_page(&ok, stid, pids[0],
+                    may_realloc, desired_lock_mode, ngot));
+        if(ngot == 1) return RCOK;
+    }
+
     GRAB_W;
 
     // I hate to do this holding the volume mutex but oh, well...
     if(do_prime_caches) W_DO(_prime_cache(v, stid.store));
 
-    alloc_page_filter_yes_t ok; // accepts any page
-
     rc_t r = 
         _alloc_pages_with_vol_mutex(
                 &ok, 
                 v, stid, near_p, npages, ngot, pids, 
-            may_realloc, desired_lock_mode, search_file);
+            may_realloc, desired_lock_mode, search_file, search_file);
 
     return r;
 }
@@ -1056,13 +1069,50 @@ io_m::alloc_a_file_page(
      */
     lpid_t&                         allocPid,
     lock_mode_t                     desired_lock_mode,
-    bool                            search_file
+    bool                            search_file,
+    /*
+     * If search_file==false but strict_append==false too, the page
+     * need not follow all the others in the file: it may come from an
+     * extent reserved for the file (see _alloc_reserved_page).
+     */
+    bool                            strict_append
 )
 {
     FUNC(io_m::alloc_a_file_page);
     auto_leave_t enter;
     vid_t volid = fid.vol;
 
+    if((search_file || !strict_append) && _use_reserved_exts()) {
+        // As below, but without the volume mutex there is no
+        // mutex-anchor order to keep.
+        check_compensated_op_nesting ccon(xct(), __LINE__, __FILE__);
+        auto_release_anchor_t auto_anchor(true/*and compensate*/, __LINE__); 
+
+        int ngot=0;
+        W_DO(_alloc_reserved_page(filter, fid, allocPid, 
+                    false/*may_realloc*/, desired_lock_mode, ngot));
+        if(ngot == 1) {
+            w_assert1(filter->accepted());
+            auto_anchor.compensate();
+
+            rc_t rc = log_alloc_file_page(allocPid);
+            int count=10;
+            while (rc.is_error() && (rc.err_num() == eRETRY) && (--count > 0)) {
+                rc = log_alloc_file_page(allocPid);
+            }
+            if(rc.is_error()) {
+                fprintf(stderr, "could not log_alloc_file_page\n");
+                GRAB_W;
+                rc = _free_page(allocPid, v, false /*do NOT check store mmb*/);
+            }
+            W_COERCE(rc);
+
+            filter->check(); // still hold the EX latch
+            return RCOK;
+        }
+        // Nothing reserved: the anchor goes with this scope
+    }
+
     GRAB_W;
 
     // I hate to do this holding the volume mutex but oh, well...
@@ -1094,7 +1144,8 @@ io_m::alloc_a_file_page(
      */
             false,  /* may_realloc*/
 
-            desired_lock_mode, search_file));
+            desired_lock_mode, search_file, 
+            search_file || !strict_append /* want_reserve */));
 
     w_assert1(ngot == 1);
     w_assert1(filter->accepted());
@@ -1223,6 +1274,104 @@ io_m::alloc_page_group(
     return rc;
 }
 
+bool
+io_m::_use_reserved_exts()
+{
+    return _ext_reserver && !in_recovery() && xct();
+}
+
+/*
+ * io_m::_alloc_reserved_page
+ * Allocate a page of a growing store in an extent reserved for it,
+ * without the volume mutex. The thread allocates in the same extent
+ * until it is full, then takes the next one from the store's pool
+ * (vol_t::take_reserved_ext), waking the extent reserver thread when
+ * the pool runs low. Returns with ngot==0 if the store has no reserved
+ * extent to offer; the caller then allocates under the volume mutex.
+ *
+ * alloc_pages_in_ext works on its own: the extent lock keeps the
+ * extent in the store and the EX latch on the extent map page
+ * serializes the changes to its bits.
+ *
+ * The extent in hand is kept per smthread (smthread_t::get_resv_exts),
+ * so it stays with the thread whatever carrier it runs on.
+ *
+ * The volume is neither grabbed nor pinned: the vol mutex would not
+ * keep it mounted anyway (_dismount does not take it). It cannot go
+ * away because we run with a transaction attached
+ * (_use_reserved_exts), and dismounts happen either with no
+ * transaction in the system (ss_m::dismount_dev, dismount_all and
+ * destroy_vol check num_active_xcts under _begin_xct_mutex; startup
+ * and shutdown) or on a volume just mounted (dir_m::_mount).
+ */
+rc_t
+io_m::_alloc_reserved_page(
+    alloc_page_filter_t     *filter,
+    const stid_t&           stid,
+    lpid_t&                 pid,
+    bool                    may_realloc,
+    lock_mode_t             desired_lock_mode,
+    int&                    ngot
+)
+{
+    ngot = 0;
+    w_assert1(xct()); // keeps the volume mounted, see above
+
+    int i = _find(stid.vol);
+    if(i < 0) return RCOK;
+    vol_t* v = vol[i];
+    w_assert1(v && v->vid() == stid.vol);
+
+    smthread_t::resv_ext_t* exts = me()->get_resv_exts();
+    smthread_t::resv_ext_t* entry = 0;
+    for(int j=0; j < smthread_t::resv_ext_max && !entry; j++) {
+        if(exts[j].vol == stid.vol.vol && exts[j].snum == stid.store) {
+            entry = &exts[j];
+        }
+    }
+    if(!entry) {
+        int& victim = me()->get_resv_ext_victim();
+        entry = &exts[victim++ % smthread_t::resv_ext_max];
+        entry->vol = stid.vol.vol;
+        entry->snum = stid.store;
+        entry->ext = 0;
+    }
+
+    // The extent in hand, then at most one more from the pool
+    for(int tries=0; tries < 2; tries++) {
+        if(entry->ext == 0) {
+            bool low = false;
+            bool got = v->take_reserved_ext(stid.store, entry->ext, low);
+            if(low) _wakeup_ext_reserver();
+            if(!got) return RCOK;
+        }
+
+        bool ok = false;
+        W_DO(v->lock_reserved_ext(stid.store, entry->ext, ok));
+        if(ok) {
+            int  allocated = 0;
+            int  remaining = 0;
+            bool is_last = false;
+            W_DO(v->alloc_pages_in_ext(filter, false, entry->ext, 100,
+                        stid.store, 1, &pid, allocated, remaining, 
+                        is_last, may_realloc, desired_lock_mode));
+            W_IFDEBUG1(if(allocated==1) w_assert1(filter->accepted());)
+            filter->check();
+
+            if(allocated == 1) {
+                if(remaining == 0) entry->ext = 0; // full
+                ngot = 1;
+                ADD_TSTAT(page_alloc_cnt, 1);
+                INC_TSTAT(vol_resv_page_hit);
+                return RCOK;
+            }
+        }
+        // Freed meanwhile, or nothing left we may use
+        entry->ext = 0;
+    }
+    return RCOK;
+}
+
 class autoerase_t {
 public:
     autoerase_t(vol_t *v, snum_t snum) : _v(v), _store(snum) {}
@@ -1289,7 +1438,8 @@ io_m::_alloc_pages_with_vol_mutex(
     lpid_t                  pids[],
     bool                    may_realloc,  
     lock_mode_t             desired_lock_mode,
-    bool                    search_file // append-only semantics if false
+    bool                    search_file, // append-only semantics if false
+    bool                    want_reserve // the store may get reserved extents
 )
 {
 
@@ -1749,6 +1899,13 @@ io_m::_alloc_pages_with_vol_mutex(
             w_assert3(_ext_sz > 0);
 #endif
             Xneeded = (npages - Pcount - 1) / ext_sz + 1;
+
+            // A store that keeps growing gets empty extents reserved,
+            // so that its next allocations need not come down here.
+            if(want_reserve && _ext_reserver && !in_recovery()
+                    && v->want_reserved_exts(stid.store)) {
+                _wakeup_ext_reserver();
+            }
         } /* step 1 */
 
 #if W_DEBUG_LEVEL > 4
@@ -2353,6 +2510,201 @@ io_m::free_ext_after_xct(const extid_t& extid)
 }
 
 
+/*********************************************************************
+ *
+ *  class ext_reserver_thread_t
+ *
+ *  Refills the pools of extents reserved for growing stores
+ *  (sm_extent_reservation) off the page allocation path. It sleeps
+ *  until io_m finds a store growing or a pool running low.
+ *
+ *********************************************************************/
+class ext_reserver_thread_t : public smthread_t {
+public:
+    NORET               ext_reserver_thread_t();
+    NORET               ~ext_reserver_thread_t() {}
+
+    virtual void        run();
+    void                retire();
+    void                awaken();
+private:
+    bool                _retire;
+    bool                _kicked;
+    pthread_mutex_t     _lock; // paired with _cond
+    pthread_cond_t      _cond; // paired with _lock
+
+    // disabled
+    NORET               ext_reserver_thread_t(const ext_reserver_thread_t&);
+    ext_reserver_thread_t& operator=(const ext_reserver_thread_t&);
+};
+
+ext_reserver_thread_t*  io_m::_ext_reserver = 0;
+
+ext_reserver_thread_t::ext_reserver_thread_t()
+    : smthread_t(t_regular, "ext_reserver", WAIT_NOT_USED),
+    _retire(false), _kicked(false)
+{
+    DO_PTHREAD(pthread_mutex_init(&_lock, NULL));
+    DO_PTHREAD(pthread_cond_init(&_cond, NULL));
+}
+
+void
+ext_reserver_thread_t::run()
+{
+    while(true) {
+        {
+            CRITICAL_SECTION(cs, _lock);
+            while(!_kicked && !_retire) {
+                DO_PTHREAD(pthread_cond_wait(&_cond, &_lock));
+            }
+            _kicked = false;
+        }
+        if(_retire) break;
+
+        w_rc_t rc = io_m::refill_reserved_exts();
+        // Out of space is no error here: the allocations
+        // just take the usual path.
+        if(rc.is_error() && rc.err_num() != smlevel_0::eOUTOFSPACE) {
+            smlevel_0::errlog->clog << warning_prio 
+                << "warning: extent reservation failed: " << rc << flushl;
+        }
+    }
+}
+
+void
+ext_reserver_thread_t::retire()
+{
+    CRITICAL_SECTION(cs, _lock);
+    _retire = true;
+    DO_PTHREAD(pthread_cond_signal(&_cond));
+}
+
+void
+ext_reserver_thread_t::awaken()
+{
+    CRITICAL_SECTION(cs, _lock);
+    _kicked = true;
+    DO_PTHREAD(pthread_cond_signal(&_cond));
+}
+
+rc_t
+io_m::spawn_ext_reserver()
+{
+    w_assert1(_ext_reserver == 0);
+    ext_reserver_thread_t* t = new ext_reserver_thread_t;
+    if(!t) return RC(eOUTOFMEMORY);
+    W_DO(t->fork());
+    _ext_reserver = t;
+    return RCOK;
+}
+
+void
+io_m::retire_ext_reserver()
+{
+    ext_reserver_thread_t* t = _ext_reserver;
+    if(!t) return;
+    _ext_reserver = 0; // allocations stop using the pools
+    t->retire();
+    W_COERCE(t->join());
+    delete t;
+}
+
+void
+io_m::_wakeup_ext_reserver()
+{
+    ext_reserver_thread_t* t = _ext_reserver;
+    if(t) t->awaken();
+}
+
+/*********************************************************************
+ *
+ *  io_m::refill_reserved_exts()
+ *
+ *  Called by the extent reserver thread: give each store that asked
+ *  for it a new set of reserved extents. Each set is allocated in a
+ *  transaction of its own and handed out only after the commit, so
+ *  that no page gets allocated in an extent whose allocation could
+ *  still be rolled back.
+ *
+ *  Unlike the allocating threads, the reserver looks at vol[] with no
+ *  transaction attached, so it holds resv_dismount_lock to keep
+ *  io_m::dismount from deleting a volume under it. (dismount_all runs
+ *  only at startup and shutdown, when the reserver is not running.)
+ *
+ *********************************************************************/
+rc_t
+io_m::refill_reserved_exts()
+{
+    CRITICAL_SECTION(cs, resv_dismount_lock);
+    for(int i=0; i < max_vols; i++) {
+        vol_t* v = vol[i];
+        if(!v) continue;
+        vid_t volid = v->vid();
+
+        snum_t snum = 0;
+        int cnt;
+        while((cnt = v->reserved_exts_wanted(snum)) > 0) {
+            extnum_t exts[vol_t::max_resv_exts];
+
+            xct_t* x = xct_t::new_xct();
+            if(!x) return RC(eOUTOFMEMORY);
+            rc_t rc = _reserve_exts(volid, snum, cnt, exts);
+            if(rc.is_error()) {
+                W_COERCE(x->abort());
+                xct_t::destroy_xct(x);
+                return rc;
+            }
+            W_DO(x->commit(true/*lazy*/));
+            xct_t::destroy_xct(x);
+
+            if(cnt > 0) {
+                v->put_reserved_exts(snum, cnt, exts);
+                INC_TSTAT(vol_resv_refills);
+            }
+        }
+    }
+    return RCOK;
+}
+
+rc_t
+io_m::_reserve_exts(vid_t volid, snum_t snum, int& cnt, extnum_t exts[])
+{
+    auto_leave_t enter;
+
+    // Keep the store from being destroyed while we add to it
+    w_rc_t rc = lm->lock(stid_t(volid, snum), IX, t_long, WAIT_IMMEDIATE);
+    if(rc.is_error()) {
+        cnt = 0;
+        if(rc.err_num() == eLOCKTIMEOUT) return RCOK;
+        return rc.reset();
+    }
+
+    GRAB_W;
+
+    if(!v->is_alloc_store(snum)) {
+        cnt = 0;
+        return RCOK;
+    }
+
+    int found = 0;
+    rc = v->find_free_exts(cnt, exts, found, 0);
+    if(rc.is_error()) {
+        if(rc.err_num() != eOUTOFSPACE) return rc.reset();
+        // Reserve what there is
+        rc.reset();
+        cnt = found;
+        if(cnt == 0) return RCOK;
+    }
+
+    extnum_t last = 0;
+    W_DO(v->last_extent(snum, last));
+    W_DO(v->alloc_exts(snum, last, cnt, exts));
+    W_DO(v->reserve_exts(snum, cnt, exts));
+
+    return RCOK;
+}
+
+
 /*********************************************************************
  *
  *  io_m::_is_valid_store(stid)
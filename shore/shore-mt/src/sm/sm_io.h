@@ -66,6 +66,7 @@ class SmStoreMetaStats;
 class store_histo_t; // page_h.h
 class pginfo_t; // page_h.h
 class xct_t; // forward
+class ext_reserver_thread_t; // sm_io.cpp
 
 #ifdef __GNUG__
 #pragma interface
@@ -322,7 +323,8 @@ public:
         const lpid_t&                   near,
         lpid_t&                         pids,
         lock_mode_t                     desired_lock_mode,
-        bool                            search_file
+        bool                            search_file,
+        bool                            strict_append = true
         );
     // Allocate a single page.
     static rc_t                 alloc_a_page(
@@ -361,7 +363,30 @@ private:
 
     static rc_t                 _free_page(const lpid_t& pid, 
                                         vol_t *v, bool chk_st_mmb);
+
+    // Allocation in extents reserved for growing stores, without
+    // the volume mutex; refilled by the extent reserver thread.
+    static bool                 _use_reserved_exts();
+    static rc_t                 _alloc_reserved_page(
+        alloc_page_filter_t            *filter,
+        const stid_t&                   stid,
+        lpid_t&                         pid,
+        bool                            may_realloc, 
+        lock_mode_t                     desired_lock_mode,
+        int&                            cnt_got
+        );
+    static rc_t                 _reserve_exts(
+        vid_t                           vid,
+        snum_t                          snum,
+        int&                            cnt,
+        extnum_t                        exts[]);
+    static void                 _wakeup_ext_reserver();
+    static ext_reserver_thread_t* _ext_reserver;
 public:
+    static rc_t                 spawn_ext_reserver();
+    static void                 retire_ext_reserver();
+    static rc_t                 refill_reserved_exts();
+
 
 
     static rc_t                 free_page(const lpid_t& pid, bool chk_st_mmb);
@@ -616,7 +641,8 @@ private:
         lpid_t                            pids[],
         bool                              may_realloc,
         lock_mode_t                       desired_lock_mode,
-        bool                              search_file
+        bool                              search_file,
+        bool                              want_reserve
         );
     static rc_t                 _create_store(
         vid_t                           vid, 
@@ -63,7 +63,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "ranges_p.h"
 #include "btree_latch_manager.h"
 #ifdef SM_HISTOGRAM
-#include "data_access_histogram.h"
+#include "data_access_sketch.h"
 #endif
 
 // NOTE : this is shared with btree layer
@@ -71,7 +71,7 @@ btree_latch_manager btree_latches;
 
 #ifdef SM_HISTOGRAM
 // to keep data access statistics for load balancing
-map< stid_t, data_access_histogram* > data_accesses;
+map< stid_t, data_access_sketch* > data_accesses;
 #endif
 
 /*==============================================================*
@@ -1113,7 +1113,7 @@ rc_t ss_m::_create_mr_assoc(const stid_t&        stid,
     }
 
 #ifdef SM_HISTOGRAM
-    // update histogram
+    // update the access sketch
     data_accesses[stid]->inc_access_count(subroot, *real_key);
 #endif
     
@@ -1207,7 +1207,7 @@ rc_t ss_m::_destroy_mr_assoc(const stid_t  &      stid,
     DBG(<<"");
 
 #ifdef SM_HISTOGRAM
-    // update histogram
+    // update the access sketch
     data_accesses[stid]->inc_access_count(subroot, *real_key);
 #endif
     
@@ -1304,7 +1304,7 @@ rc_t ss_m::_destroy_mr_all_assoc(const stid_t& stid, const vec_t& key, int& num,
     }
 
 #ifdef SM_HISTOGRAM
-    // update histogram
+    // update the access sketch
     data_accesses[stid]->inc_access_count(subroot, *real_key);
 #endif
     
@@ -1401,7 +1401,7 @@ rc_t ss_m::_find_mr_assoc(const stid_t&         stid,
     }
 
 #ifdef SM_HISTOGRAM
-    // update histogram
+    // update the access sketch
     data_accesses[stid]->inc_access_count(subroot, *real_key);
 #endif
     
@@ -1496,7 +1496,7 @@ rc_t ss_m::_update_mr_assoc(const stid_t&       stid,
 #ifdef SM_HISTOGRAM
 rc_t ss_m::_destroy_all_histograms()
 {
-    for(map< stid_t, data_access_histogram* >::iterator iter = data_accesses.begin();
+    for(map< stid_t, data_access_sketch* >::iterator iter = data_accesses.begin();
 	iter != data_accesses.end();
 	iter++) {
 	delete iter->second;
@@ -1646,9 +1646,10 @@ rc_t ss_m::_make_equal_partitions(stid_t stid, const vec_t& minKey,
     W_DO( ra->fill_page(sd->root(), sd->partitions()) );
 
 #ifdef SM_HISTOGRAM
-    // initialize the histogram (TODO: this should be generalized, like the common gran,
-    //                                 and should be updated as partitions are updated)
-    data_accesses[stid] = new data_access_histogram(sd->partitions(), 100, 7, false);
+    // initialize the access sketch, the private sketches of the threads are 
+    // merged in the background
+    data_accesses[stid] = new data_access_sketch(7);
+    W_DO(data_accesses[stid]->start_merger());
 #endif
     
     return RCOK;    
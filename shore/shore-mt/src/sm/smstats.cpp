@@ -130,3 +130,50 @@ smlevel_0::add_from_global_stats(sm_stats_info_t &to)
     CRITICAL_SECTION(cs, local_ns::_global_stats_mutex);
     to += local_ns::_global_stats_;
 }
+
+/*
+ * The per-thread stats move to the global ones (when a thread ends or
+ * an instrumented xct takes them) under the same mutex that
+ * add_from_all_stats holds, so a gather running meanwhile counts them
+ * once, either in the thread or in the global stats.
+ */
+void
+smlevel_0::move_to_global_stats(sm_stats_info_t &from)
+{
+    CRITICAL_SECTION(cs, local_ns::_global_stats_mutex);
+    local_ns::_global_stats_ += from;
+    memset(&from, '\0', sizeof(from));
+}
+
+// leaves from NULL; the caller frees the stats
+void
+smlevel_0::retire_to_global_stats(sm_stats_info_t *&from)
+{
+    CRITICAL_SECTION(cs, local_ns::_global_stats_mutex);
+    local_ns::_global_stats_ += *from;
+    from = NULL;
+}
+
+void
+smlevel_0::add_from_all_stats(sm_stats_info_t &to)
+{
+    class GatherSmthreadStats : public SmthreadFunc
+    {
+    public:
+        GatherSmthreadStats(sm_stats_info_t &s) : _stats(s) {}
+        void operator()(const smthread_t& t)
+        {
+            t.add_from_TL_stats(_stats);
+        }
+    private:
+        sm_stats_info_t &_stats;
+    } F(to);
+
+    CRITICAL_SECTION(cs, local_ns::_global_stats_mutex);
+    smthread_t::for_each_smthread(F);
+    to.compute();
+
+    // Global stats contain all the per-thread stats that were collected
+    // before a per-thread stats structure was cleared. 
+    to += local_ns::_global_stats_;
+}
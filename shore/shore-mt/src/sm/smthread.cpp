@@ -110,10 +110,11 @@ smthread_t::tcb_t::create_TL_stats() {
 void 
 smthread_t::tcb_t::destroy_TL_stats() {
     if(_TL_stats) {
-        // Global stats are protected by a mutex
-        smlevel_0::add_to_global_stats(TL_stats()); // before detaching them
-        delete _TL_stats;
-        _TL_stats = NULL;
+        // Global stats are protected by a mutex; gather_stats skips
+        // us from the moment they hold our stats
+        sm_stats_info_t* s = _TL_stats;
+        smlevel_0::retire_to_global_stats(_TL_stats); // sets it to NULL
+        delete s;
     }
 }
 
@@ -222,8 +223,7 @@ void
 smthread_t::tcb_t::clear_TL_stats()
 {
     // Global stats are protected by a mutex 
-    smlevel_0::add_to_global_stats(TL_stats()); // before clearing them
-    memset(&TL_stats(),0, sizeof(sm_stats_info_t)); 
+    smlevel_0::move_to_global_stats(TL_stats()); // and clears them
 }
 
 /* Non-thread-safe add from the per-thread copy to another struct.
@@ -237,6 +237,7 @@ smthread_t::tcb_t::clear_TL_stats()
 void 
 smthread_t::add_from_TL_stats(sm_stats_info_t &w) const
 {
+    if(!_tcb.has_TL_stats()) return; // being destroyed
     const sm_stats_info_t &x = _tcb.TL_stats_const();
     w += x; 
 }
@@ -569,6 +570,8 @@ void smthread_t::before_run() {
 }
 void smthread_t::after_run() { // called before destructor
     latch_t::on_thread_destroy(this);
+    // gather_stats no longer sees us once run() returned
+    tcb().clear_TL_stats();
     sthread_t::after_run();
 }
 
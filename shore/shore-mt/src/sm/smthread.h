@@ -217,17 +217,26 @@ class sm_stats_info_t; // forward
  */
 class smthread_t : public sthread_t {
     friend class smthread_init_t;
+public:
+    /// A reserved extent the thread allocates pages in (see sm_io.cpp)
+    struct resv_ext_t {
+        uint2_t  vol;
+        uint4_t  snum;
+        uint4_t  ext; // 0: none in hand
+    };
+    enum { resv_ext_max = 4 };
+private:
     struct tcb_t {
         xct_t*   xct;
         int      pin_count;      // number of rsrc_m pins
         int      prev_pin_count; // previous # of rsrc_m pins
         timeout_in_ms lock_timeout;    // timeout to use for lock acquisitions
         bool    _in_sm;      // thread is in sm ss_m:: function
+        bool    _scan_hint;  // fixes are part of a sequential scan
 #ifdef ARCH_LP64
         /* XXX Really want kc_buf aligned to the alignment of the most
            restrictive type. It would be except sizeof above bool == 8,
            and timeout_in_ms is 4 bytes. */
-        fill1            _fill1;        
         fill2            _fill2;        
 #endif
 
@@ -263,6 +272,11 @@ class smthread_t : public sthread_t {
          * access transaction list. Used in xct.cpp
          */
         queue_based_lock_t::ext_qnode _xlist_mutex_node;
+        /**\var queue_based_lock_t::ext_qnode _histoid_me;
+         * \brief Queue node for holding the mutex of a histoid
+         * (one at a time). Used in histo.cpp
+         */
+        queue_based_lock_t::ext_qnode _histoid_me;
 
         /**\var static __thread queue_based_block_lock_t::ext_qnode log_me_node;
          * \brief Queue node for holding partition lock.
@@ -280,6 +294,13 @@ class smthread_t : public sthread_t {
         int __metarecs;
         int __metarecs_in;
 
+        /**\var resv_ext_t _resv_exts[]
+         * \brief The reserved extents the thread allocates pages in,
+         * one per store. Used in sm_io.cpp (io_m::_alloc_reserved_page).
+         */
+        resv_ext_t _resv_exts[resv_ext_max];
+        int        _resv_ext_victim;
+
         // force this to be 8-byte aligned:
         /**\var static __thread char _kc_buf[] 
          * \brief Used in lexify.cpp for scramble/unscramble scratch space.
@@ -299,6 +320,7 @@ class smthread_t : public sthread_t {
         inline sm_stats_info_t& TL_stats() { return *_TL_stats;}
         inline const sm_stats_info_t& TL_stats_const() const { 
                                                  return *_TL_stats; }
+        inline bool has_TL_stats() const { return _TL_stats != NULL; }
 
         tcb_t() : 
             xct(0), 
@@ -306,14 +328,21 @@ class smthread_t : public sthread_t {
             prev_pin_count(0),
             lock_timeout(WAIT_FOREVER), // default for a thread
             _in_sm(false), 
+            _scan_hint(false), 
             _sdesc_cache(0), 
             _lock_hierarchy(0), 
             _xct_log(0), 
             _TL_stats(0),
             __ordinal(0),
             __metarecs(0),
-            __metarecs_in(0)
+            __metarecs_in(0),
+            _resv_ext_victim(0)
         { 
+            for(int i=0; i < resv_ext_max; i++) {
+                _resv_exts[i].vol = 0;
+                _resv_exts[i].snum = 0;
+                _resv_exts[i].ext = 0;
+            }
             _me1._held = NULL; /*EXT_QNODE_INITIALIZER*/;
             _me2._held = NULL; /*EXT_QNODE_INITIALIZER*/;
             _me3._held = NULL; /*EXT_QNODE_INITIALIZER*/;
@@ -322,6 +351,7 @@ class smthread_t : public sthread_t {
             _1thread_log_me._held = NULL; /*EXT_QNODE_INITIALIZER*/;
             _xct_t_me_node._held = NULL; /*EXT_QNODE_INITIALIZER*/;
             _xlist_mutex_node._held = NULL; /*EXT_QNODE_INITIALIZER*/;
+            _histoid_me._held = NULL; /*EXT_QNODE_INITIALIZER*/;
             _log_me_node._held = NULL; /*EXT_QNODE_INITIALIZER*/;
 
             create_TL_stats();
@@ -562,6 +592,16 @@ public:
     inline 
     bool             is_in_sm() const { return tcb()._in_sm; }
 
+    /*
+     *  Set while the thread runs a sequential scan, so the buffer
+     *  manager keeps the scanned pages out of the hot set. See
+     *  bf_scan_hint_t.
+     */
+    inline
+    void             set_scan_hint(bool h) { tcb()._scan_hint = h; }
+    inline 
+    bool             scan_hint() const { return tcb()._scan_hint; }
+
     void             new_xct(xct_t *);
     void             no_xct(xct_t *);
 
@@ -624,6 +664,8 @@ public:
                                                return tcb()._1thread_xct_me;}
     queue_based_lock_t::ext_qnode& get_xct_t_me_node() {
                                                return tcb()._xct_t_me_node;}
+    queue_based_lock_t::ext_qnode& get_histoid_me() {
+                                               return tcb()._histoid_me;}
     tcb_t::ordinal_number_t &      get__ordinal()  { return tcb().__ordinal; }
     int&                           get___metarecs() { 
                                                return tcb().__metarecs; }
@@ -643,6 +685,10 @@ public:
 	    return &(tcb()._kc_vec);
 	}
     }
+    resv_ext_t*                    get_resv_exts() { 
+                                               return tcb()._resv_exts; }
+    int&                           get_resv_ext_victim() { 
+                                               return tcb()._resv_ext_victim; }
     char *                         get_page_check_map() {
                                          return &(tcb()._page_check_map[0]);  }
 private:
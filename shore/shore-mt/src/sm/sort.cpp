@@ -69,6 +69,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 
 #include "lgrec.h"
 #include "sm.h"
+#include <algorithm>
 
 typedef ssm_sort::key_info_t key_info_t;
 typedef ssm_sort::sort_parm_t sort_parm_t;
@@ -937,7 +938,7 @@ void QuickSort(char* a[], int cnt, int (*compar)(const void*, const void*) )
           code instead of the on-the-stack code */
     const int MAXSTACKDEPTH = 30;
     const int LIMIT = 10;
-    static long randx = 1;
+    long randx = 1; // not static: runs may be sorted concurrently
 
     struct qs_stack_item {
         int l, r;
@@ -1001,6 +1002,179 @@ error:
     W_FATAL(fcOUTOFMEMORY);
 }
 
+/*
+ * Parallel run sort (sm_sort_threads > 1).
+ *
+ * The key pointers of a run are copied into an array of sort_entry_t
+ * that carry an order-preserving 64-bit prefix of the key, so most
+ * comparisons are a single integer compare on a cache-resident array
+ * instead of a call through the comparison function on keys scattered
+ * over the heap. The array is cut into slices, each sorted by its own
+ * thread, and the sorted slices are merged back into the run by a
+ * tournament tree.
+ */
+struct sort_entry_t {
+    w_base_t::uint8_t  norm;   // order-preserving prefix of the key
+    char*              key;    // the sort_key_t or file_sort_key_t
+};
+
+struct sort_entry_less_t {
+    int  (*compar)(const void*, const void*);
+    bool exact;     // equal prefixes mean equal keys
+
+    bool operator()(const sort_entry_t& a, const sort_entry_t& b) const {
+        if(a.norm != b.norm) return a.norm < b.norm;
+        return !exact && compar(a.key, b.key) < 0;
+    }
+};
+
+/*
+ * Set norm to a prefix of the key that sorts like the key under
+ * get_cmp_func(type, up). Returns true if the prefix is the whole key.
+ * Types with no such prefix get 0, which leaves them to the comparison
+ * function.
+ */
+static bool
+sort_entry_norm(key_info_t::key_type_t type, bool up, 
+        const void* val, uint4_t klen, w_base_t::uint8_t& norm)
+{
+    const w_base_t::uint8_t sign = w_base_t::uint8_t(1) << 63;
+    bool exact = true;
+    norm = 0;
+    switch(type) {
+    case sortorder::kt_u1: norm = *(const w_base_t::uint1_t*)val; break;
+    case sortorder::kt_i1: norm = w_base_t::uint8_t(
+            w_base_t::int8_t(*(const w_base_t::int1_t*)val)) ^ sign; break;
+    case sortorder::kt_u2: {
+            w_base_t::uint2_t v; memcpy(&v, val, sizeof(v)); norm = v; 
+        } break;
+    case sortorder::kt_i2: {
+            w_base_t::int2_t v; memcpy(&v, val, sizeof(v)); 
+            norm = w_base_t::uint8_t(w_base_t::int8_t(v)) ^ sign;
+        } break;
+    case sortorder::kt_u4: {
+            w_base_t::uint4_t v; memcpy(&v, val, sizeof(v)); norm = v;
+        } break;
+    case sortorder::kt_i4: {
+            w_base_t::int4_t v; memcpy(&v, val, sizeof(v)); 
+            norm = w_base_t::uint8_t(w_base_t::int8_t(v)) ^ sign;
+        } break;
+    case sortorder::kt_u8: 
+        if(!up) return false; // descending u8 keys use _int4_rcmp
+        memcpy(&norm, val, sizeof(norm)); 
+        break;
+    case sortorder::kt_i8: {
+            if(!up) return false;
+            w_base_t::int8_t v; memcpy(&v, val, sizeof(v)); 
+            norm = w_base_t::uint8_t(v) ^ sign;
+        } break;
+    case sortorder::kt_b: {
+            // big-endian first bytes, zero-padded: ties go to string_cmp
+            const unsigned char* p = (const unsigned char*) val;
+            for(uint4_t i=0; i < sizeof(norm); i++) {
+                norm = (norm << 8) | (i < klen ? p[i] : 0);
+            }
+            exact = false;
+        } break;
+    default:
+        return false;
+    }
+    if(!up) norm = ~norm;
+    return exact;
+}
+
+class sort_slice_thread_t : public smthread_t 
+{
+public:
+    sort_slice_thread_t() : smthread_t(t_regular, "sort_slice"),
+        _first(0), _last(0) { }
+    void set_slice(sort_entry_t* first, sort_entry_t* last,
+            const sort_entry_less_t& less) {
+        _first = first; _last = last; _less = less;
+    }
+    virtual void run() { std::sort(_first, _last, _less); }
+private:
+    sort_entry_t*      _first;
+    sort_entry_t*      _last;
+    sort_entry_less_t  _less;
+};
+
+/*
+ * Sort a[0..cnt) with nthreads threads (the caller is one of them).
+ * Both qsort_cmp and fqsort_cmp only look at val and klen, which
+ * sort_key_t and file_sort_key_t keep at the same place.
+ */
+static void 
+ParallelSort(char* a[], int cnt, int (*compar)(const void*, const void*),
+        key_info_t::key_type_t type, bool up, int nthreads)
+{
+    sort_entry_t* e = new sort_entry_t[cnt];
+    w_auto_delete_array_t<sort_entry_t> auto_del_e(e);
+    record_malloc(e, cnt*sizeof(sort_entry_t));
+
+    sort_entry_less_t less;
+    less.compar = compar;
+    less.exact = true;
+    for(int i=0; i < cnt; i++) {
+        const sort_key_t* k = (const sort_key_t*) a[i];
+        e[i].key = a[i];
+        less.exact &= sort_entry_norm(type, up, k->val, k->klen, e[i].norm);
+    }
+
+    int* start = new int[nthreads+1];
+    w_auto_delete_array_t<int> auto_del_start(start);
+    for(int s=0; s <= nthreads; s++) {
+        start[s] = int(w_base_t::int8_t(cnt) * s / nthreads);
+    }
+
+    sort_slice_thread_t* t = new sort_slice_thread_t[nthreads-1];
+    w_auto_delete_array_t<sort_slice_thread_t> auto_del_t(t);
+    for(int s=1; s < nthreads; s++) {
+        t[s-1].set_slice(e+start[s], e+start[s+1], less);
+        W_COERCE(t[s-1].fork());
+    }
+    std::sort(e, e+start[1], less);
+    for(int s=1; s < nthreads; s++) {
+        W_COERCE(t[s-1].join());
+    }
+
+    // Merge: win[n] is the slice with the smallest head below node n;
+    // the leaves are at win[leaves+s], -1 for an exhausted slice.
+    int leaves = 1;
+    while(leaves < nthreads) leaves <<= 1;
+    int* win = new int[2*leaves];
+    w_auto_delete_array_t<int> auto_del_win(win);
+    for(int s=0; s < leaves; s++) {
+        win[leaves+s] = (s < nthreads && start[s] < start[s+1]) ? s : -1;
+    }
+
+#define SLICE_WINNER(l, r) \
+    ((l) < 0 ? (r) : (r) < 0 ? (l) : \
+     less(e[start[r]], e[start[l]]) ? (r) : (l))
+
+    for(int n=leaves-1; n > 0; n--) {
+        win[n] = SLICE_WINNER(win[2*n], win[2*n+1]);
+    }
+    // start[s] is the head of slice s from here on
+    int* end = new int[nthreads];
+    w_auto_delete_array_t<int> auto_del_end(end);
+    for(int s=0; s < nthreads; s++) end[s] = start[s+1];
+
+    for(int i=0; i < cnt; i++) {
+        int s = win[1];
+        w_assert1(s >= 0);
+        a[i] = e[start[s]++].key;
+        int n = leaves + s;
+        if(start[s] == end[s]) win[n] = -1;
+        for(n >>= 1; n > 0; n >>= 1) {
+            win[n] = SLICE_WINNER(win[2*n], win[2*n+1]);
+        }
+    }
+#undef SLICE_WINNER
+
+    record_free(e, cnt*sizeof(sort_entry_t));
+}
+
 //
 // Sort the entries in the buffer of the current run, 
 // and flush them out to disk page.
@@ -1033,10 +1207,24 @@ sort_stream_i::flush_run()
     _local_cmp = sd->comp;
     _universe_ = ki.universe;
 
+    // don't bother the threads with runs that sort in a blink
+    int nthreads = smlevel_0::sort_threads;
+    if (int(sd->rec_count) < nthreads * 1024) nthreads = 1;
+
     if (_file_sort) {
-        QuickSort(sd->fkeys, sd->rec_count, fqsort_cmp);
+        if (nthreads > 1) {
+            ParallelSort(sd->fkeys, sd->rec_count, fqsort_cmp,
+                    ki.type, sp.ascending, nthreads);
+        } else {
+            QuickSort(sd->fkeys, sd->rec_count, fqsort_cmp);
+        }
     } else {
-        QuickSort(sd->keys, sd->rec_count, qsort_cmp);
+        if (nthreads > 1) {
+            ParallelSort(sd->keys, sd->rec_count, qsort_cmp,
+                    ki.type, sp.ascending, nthreads);
+        } else {
+            QuickSort(sd->keys, sd->rec_count, qsort_cmp);
+        }
         if (ki.len==0 && int(ki.type)!=int(key_info_t::t_string)) {
             ki.len = ((file_sort_key_t*)sd->keys[0])->klen;
         }
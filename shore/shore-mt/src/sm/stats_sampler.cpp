@@ -0,0 +1,246 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+#define SM_SOURCE
+#define STATS_SAMPLER_C
+
+#ifdef __GNUG__
+#   pragma implementation
+#endif
+
+#include "sm_int_0.h"
+#include "sm.h"
+#include "stats_sampler.h"
+#include <sthread_stats.h>
+#include <time.h>
+#include <errno.h>
+
+static w_base_t::uint8_t
+stats_sampler_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return w_base_t::uint8_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * The counters in a row, in order. Misses are vol_reads: every page
+ * the buffer pool does not find is read from the volume.
+ */
+static const struct {
+    const char*                         name;
+    w_base_t::base_stat_t sm_stats_t::* counter;
+} stats_sampler_columns[] = {
+    { "commit_xct",   &sm_stats_t::commit_xct_cnt },
+    { "abort_xct",    &sm_stats_t::abort_xct_cnt },
+    { "bf_look",      &sm_stats_t::bf_look_cnt },
+    { "bf_hit",       &sm_stats_t::bf_hit_cnt },
+    { "vol_reads",    &sm_stats_t::vol_reads },
+    { "vol_writes",   &sm_stats_t::vol_writes },
+    { "lock_acquire", &sm_stats_t::lock_acquire_cnt },
+    { "lock_wait",    &sm_stats_t::lock_wait_cnt },
+    { "deadlock",     &sm_stats_t::lock_deadlock_cnt },
+    { "log_bytes",    &sm_stats_t::log_bytes_generated },
+    { "log_sync",     &sm_stats_t::log_sync_cnt },
+};
+
+static const int stats_sampler_ncolumns = 
+    sizeof(stats_sampler_columns) / sizeof(stats_sampler_columns[0]);
+
+// counters can go back a little: they are read while being updated
+static w_base_t::base_stat_t
+stats_sampler_delta(w_base_t::base_stat_t now, w_base_t::base_stat_t before)
+{
+    return now > before ? now - before : 0;
+}
+
+
+/*********************************************************************
+ *
+ *  class stats_sampler_thread_t
+ *
+ *  Calls sample() at every multiple of the interval after its start,
+ *  so late samples do not make the following ones late as well.
+ *
+ *********************************************************************/
+class stats_sampler_thread_t : public smthread_t {
+public:
+    NORET            stats_sampler_thread_t(stats_sampler_m* sampler);
+    NORET            ~stats_sampler_thread_t();
+
+    virtual void     run();
+    void             retire();
+private:
+    stats_sampler_m* _sampler;
+    bool             _retire;
+    pthread_mutex_t  _retire_lock; // paired with _retire_cond
+    pthread_cond_t   _retire_cond;
+
+    // disabled
+    NORET            stats_sampler_thread_t(const stats_sampler_thread_t&);
+    stats_sampler_thread_t& operator=(const stats_sampler_thread_t&);
+};
+
+stats_sampler_thread_t::stats_sampler_thread_t(stats_sampler_m* sampler)
+    : smthread_t(t_regular, "stats_sampler", WAIT_NOT_USED),
+      _sampler(sampler), _retire(false)
+{
+    DO_PTHREAD(pthread_mutex_init(&_retire_lock, NULL));
+    DO_PTHREAD(pthread_cond_init(&_retire_cond, NULL));
+}
+
+stats_sampler_thread_t::~stats_sampler_thread_t()
+{
+    DO_PTHREAD(pthread_cond_destroy(&_retire_cond));
+    DO_PTHREAD(pthread_mutex_destroy(&_retire_lock));
+}
+
+void
+stats_sampler_thread_t::run()
+{
+    const w_base_t::uint8_t interval = 
+        w_base_t::uint8_t(_sampler->interval_ms()) * 1000000;
+    w_base_t::uint8_t next = stats_sampler_now_ns();
+
+    CRITICAL_SECTION(cs, _retire_lock);
+    while(!_retire) {
+        next += interval;
+        struct timespec when;
+        when.tv_sec = next / 1000000000;
+        when.tv_nsec = next % 1000000000;
+        int err = 0;
+        while(!_retire && err != ETIMEDOUT) {
+            err = pthread_cond_timedwait(&_retire_cond, &_retire_lock, &when);
+        }
+        if(_retire) break;
+
+        cs.pause();
+        _sampler->sample();
+        cs.resume();
+
+        // fell behind (e.g. stopped in a debugger): skip the lost ticks
+        w_base_t::uint8_t now = stats_sampler_now_ns();
+        if(now > next + interval) next = now - (now - next) % interval;
+    }
+}
+
+void
+stats_sampler_thread_t::retire()
+{
+    CRITICAL_SECTION(cs, _retire_lock);
+    _retire = true;
+    DO_PTHREAD(pthread_cond_signal(&_retire_cond));
+}
+
+
+/*********************************************************************
+ *
+ *  class stats_sampler_m
+ *
+ *********************************************************************/
+stats_sampler_m::stats_sampler_m(FILE* out, int interval_ms)
+    : _out(out), _interval_ms(interval_ms), _thread(0),
+      _last_latch_wait(0), _last_ns(0)
+{
+    DO_PTHREAD(pthread_mutex_init(&_lock, NULL));
+}
+
+stats_sampler_m::~stats_sampler_m()
+{
+    if(_thread) {
+        _thread->retire();
+        W_COERCE(_thread->join());
+        delete _thread;
+        _thread = 0;
+    }
+    sample(); // the tail since the last tick
+    fclose(_out);
+    DO_PTHREAD(pthread_mutex_destroy(&_lock));
+}
+
+w_rc_t
+stats_sampler_m::spawn_sampler_thread()
+{
+    w_assert1(_thread == 0);
+
+    {
+        CRITICAL_SECTION(cs, _lock);
+        fprintf(_out, "# sm stats every %d ms, time in ns (CLOCK_REALTIME)\n",
+                _interval_ms);
+        fprintf(_out, "time_ns,interval_ns");
+        for(int i=0; i < stats_sampler_ncolumns; i++) {
+            fprintf(_out, ",%s", stats_sampler_columns[i].name);
+        }
+        fprintf(_out, ",latch_wait\n");
+        fflush(_out);
+
+        W_DO(ss_m::gather_stats(_last));
+        _last_latch_wait = STH_STATS(latch_wait);
+        _last_ns = stats_sampler_now_ns();
+    }
+
+    _thread = new stats_sampler_thread_t(this);
+    if(!_thread) return RC(eOUTOFMEMORY);
+    W_DO(_thread->fork());
+    return RCOK;
+}
+
+void
+stats_sampler_m::sample()
+{
+    // gather outside of _lock, which mark() takes on behalf of workers
+    sm_stats_info_t now;
+    W_COERCE(ss_m::gather_stats(now));
+    w_base_t::base_stat_t latch_wait = STH_STATS(latch_wait);
+    w_base_t::uint8_t ns = stats_sampler_now_ns();
+
+    CRITICAL_SECTION(cs, _lock);
+    fprintf(_out, "%llu,%llu", (unsigned long long) ns,
+            (unsigned long long) (ns - _last_ns));
+    for(int i=0; i < stats_sampler_ncolumns; i++) {
+        w_base_t::base_stat_t sm_stats_t::* c = 
+            stats_sampler_columns[i].counter;
+        fprintf(_out, ",%llu", (unsigned long long) 
+                stats_sampler_delta(now.sm.*c, _last.sm.*c));
+    }
+    fprintf(_out, ",%llu\n", (unsigned long long) 
+            stats_sampler_delta(latch_wait, _last_latch_wait));
+    fflush(_out);
+
+    _last = now;
+    _last_latch_wait = latch_wait;
+    _last_ns = ns;
+}
+
+void
+stats_sampler_m::mark(const char* event)
+{
+    w_base_t::uint8_t ns = stats_sampler_now_ns();
+    CRITICAL_SECTION(cs, _lock);
+    fprintf(_out, "# mark %llu %s\n", (unsigned long long) ns, event);
+    fflush(_out);
+}
@@ -0,0 +1,84 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+   
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+   
+                         All Rights Reserved.
+   
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+   
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#ifndef STATS_SAMPLER_H
+#define STATS_SAMPLER_H
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+#ifdef __GNUG__
+#pragma interface
+#endif
+
+#include <cstdio>
+#include "sm_int_0.h"
+
+class stats_sampler_thread_t;
+
+/*********************************************************************
+ *
+ *  class stats_sampler_m
+ *
+ *  Interval statistics sampler (sm_stats_sample_ms). A background 
+ *  thread gathers the statistics every interval, the way 
+ *  ss_m::gather_stats does -- reading the per-thread counters while 
+ *  their threads keep running -- and appends to a CSV file one row 
+ *  with the change of a few counters since the last row (transactions,
+ *  buffer-pool hits and misses, lock and latch waits, log bytes).
+ *
+ *  Rows are stamped with CLOCK_REALTIME in ns, the clock of the tbench
+ *  harness. mark() adds a comment line with the time of an event,
+ *  such as the beginning of the region of interest.
+ *
+ *********************************************************************/
+class stats_sampler_m : public smlevel_0 {
+public:
+    NORET            stats_sampler_m(FILE* out, int interval_ms);
+    NORET            ~stats_sampler_m(); // retires the thread
+
+    w_rc_t           spawn_sampler_thread();
+    void             mark(const char* event);
+
+    // called by the thread
+    void             sample();
+    int              interval_ms() const { return _interval_ms; }
+
+private:
+    FILE*                    _out;     // written under _lock
+    int                      _interval_ms;
+    stats_sampler_thread_t*  _thread;
+    pthread_mutex_t          _lock;
+    sm_stats_info_t          _last;
+    w_base_t::base_stat_t    _last_latch_wait;
+    w_base_t::uint8_t        _last_ns;
+
+    // disabled
+    NORET            stats_sampler_m(const stats_sampler_m&);
+    stats_sampler_m& operator=(const stats_sampler_m&);
+};
+
+/*<std-footer incl-file-exclusion='STATS_SAMPLER_H'>  -- do not edit anything below this line -- */
+
+#endif          /*</std-footer>*/
@@ -0,0 +1,323 @@
+/*<std-header orig-src='shore'>
+
+SHORE -- Scalable Heterogeneous Object REpository
+
+Copyright (c) 1994-99 Computer Sciences Department, University of
+                      Wisconsin -- Madison
+All Rights Reserved.
+
+Permission to use, copy, modify and distribute this software and its
+documentation is hereby granted, provided that both the copyright
+notice and this permission notice appear in all copies of the
+software, derivative works or modified versions, and any portions
+thereof, and that both notices appear in supporting documentation.
+
+THE AUTHORS AND THE COMPUTER SCIENCES DEPARTMENT OF THE UNIVERSITY
+OF WISCONSIN - MADISON ALLOW FREE USE OF THIS SOFTWARE IN ITS
+"AS IS" CONDITION, AND THEY DISCLAIM ANY LIABILITY OF ANY KIND
+FOR ANY DAMAGES WHATSOEVER RESULTING FROM THE USE OF THIS SOFTWARE.
+
+This software was developed with support by the Advanced Research
+Project Agency, ARPA order number 018 (formerly 8230), monitored by
+the U.S. Army Research Laboratory under contract DAAB07-91-C-Q518.
+
+Further funding for this work was provided by DARPA through
+Rome Research Laboratory Contract No. F30602-97-2-0247.
+
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/*
+ * This program measures insert throughput as threads are added, with
+ * transactions of the shape of an order entry: each one appends a few
+ * rows to a shared file (order lines, history) and enters their keys
+ * in a shared B+-tree. Most of the work is page allocation in two
+ * growing stores. Run it with increasing -t and compare the default
+ * (every allocation takes the volume mutex) with
+ *     -sm_extent_reservation 8
+ * where most pages come from extents reserved ahead. It reports, besides
+ * the throughput, how many pages were allocated without the volume
+ * mutex and how many extents the stores took.
+ *
+ * Each thread inserts keys of its own, so that the threads contend on
+ * the allocation of pages and not on key locks.
+ */
+
+#include <w_stream.h>
+#include <sys/types.h>
+#include <cassert>
+#include <vector>
+#include "sm_vas.h"
+#include "w_getopt.h"
+#include "stopwatch.h"
+
+ss_m* ssm = 0;
+
+typedef w_rc_t rc_t;
+typedef smlevel_0::smksize_t smksize_t;
+
+// this is implemented in options.cpp
+w_rc_t init_config_options(option_group_t& options,
+                        const char* prog_type,
+                        int& argc, char** argv);
+
+void
+usage(option_group_t& options)
+{
+    cerr << "Usage: server [-h] [options]" << endl;
+    cerr << "       -t <#threads> running transactions (default 4)" << endl;
+    cerr << "       -n <#transactions> per thread (trumps num_rec)" << endl;
+    cerr << "       -r <#rows> inserted per transaction (default 10)"
+         << endl;
+    cerr << "       -h print this message" << endl;
+    cerr << "Valid options are: " << endl;
+    options.print_usage(true, cerr);
+}
+
+enum { ROW_SIZE = 500 };
+
+
+/* inserts rows into the file and their keys into the index */
+class smthread_insert_t : public smthread_t
+{
+    stid_t          _file;
+    stid_t          _index;
+    int             _ntrx;
+    int             _nrows;
+    int             _id;
+public:
+    rc_t            rc;
+    int             aborts;
+
+    smthread_insert_t(const stid_t& file, const stid_t& index,
+                      int ntrx, int nrows, int id)
+        : smthread_t(t_regular, "smthread_insert_t"),
+          _file(file), _index(index), _ntrx(ntrx), _nrows(nrows), _id(id),
+          aborts(0)
+    { }
+    ~smthread_insert_t() { }
+
+    rc_t one_xct(int i);
+    rc_t do_work();
+    void run() { rc = do_work(); }
+};
+
+rc_t smthread_insert_t::one_xct(int i)
+{
+    char row[ROW_SIZE];
+    memset(row, '\0', sizeof(row));
+    for (int j = 0; j < _nrows; j++) {
+        // keys of a thread are apart from those of the others
+        int key = (_id << 24) | (i * _nrows + j);
+        memcpy(row, &key, sizeof(key));
+        rid_t rid;
+        W_DO(ssm->create_rec(_file, vec_t(), sizeof(row),
+                             vec_t(row, sizeof(row)), rid));
+        W_DO(ssm->create_assoc(_index, vec_t(&key, sizeof(key)),
+                               vec_t(&rid, sizeof(rid))));
+    }
+    return RCOK;
+}
+
+rc_t smthread_insert_t::do_work()
+{
+    for (int i = 0; i < _ntrx; i++) {
+        W_DO(ssm->begin_xct());
+        rc_t e = one_xct(i);
+        if (e.is_error()) {
+            // page and key-range locks can deadlock with other threads
+            W_DO(ssm->abort_xct());
+            if (e.err_num() != smlevel_0::eDEADLOCK) return e;
+            aborts++;
+            continue;
+        }
+        W_DO(ssm->commit_xct(true));
+    }
+    return RCOK;
+}
+
+
+/* create an smthread based class for all sm-related work */
+class smthread_main_t : public smthread_t
+{
+    int        argc;
+    char       **argv;
+public:
+    int        retval;
+
+    smthread_main_t(int ac, char **av)
+        : smthread_t(t_regular, "smthread_main_t"),
+          argc(ac), argv(av), retval(0)
+    { }
+    ~smthread_main_t() { }
+
+    rc_t setup_device_and_volume(const char* device_name,
+                                 smksize_t quota, vid_t& vid);
+    void run();
+};
+
+rc_t
+smthread_main_t::setup_device_and_volume(const char* device_name,
+                                         smksize_t quota, vid_t& vid)
+{
+    devid_t     devid;
+    u_int       vol_cnt;
+    lvid_t      lvid;
+
+    vid = 10;
+    cout << "Formatting device: " << device_name
+         << " with a " << quota << "KB quota ..." << endl;
+    W_DO(ssm->format_dev(device_name, quota, true));
+    W_DO(ssm->mount_dev(device_name, vol_cnt, devid));
+    W_DO(ssm->generate_new_lvid(lvid));
+    W_DO(ssm->create_vol(device_name, lvid, quota, false, vid));
+    return RCOK;
+}
+
+void smthread_main_t::run()
+{
+    rc_t rc;
+
+    option_t* opt_device_name = 0;
+    option_t* opt_device_quota = 0;
+    option_t* opt_num_rec = 0;
+
+    const int option_level_cnt = 3;
+    option_group_t options(option_level_cnt);
+
+    W_COERCE(options.add_option("device_name", "device/file name",
+                         NULL, "device containg the volume",
+                         true, option_t::set_value_charstr,
+                         opt_device_name));
+
+    W_COERCE(options.add_option("device_quota", "# > 1000",
+                         "2000", "quota for device",
+                         false, option_t::set_value_long,
+                         opt_device_quota));
+
+    W_COERCE(options.add_option("num_rec", "# > 0",
+                         NULL, "number of transactions per thread",
+                         true, option_t::set_value_long,
+                         opt_num_rec));
+
+    // have the SSM add its options to the group
+    W_COERCE(ss_m::setup_options(&options));
+
+    rc = init_config_options(options, "server", argc, argv);
+    if (rc.is_error()) {
+        usage(options);
+        retval = 1;
+        return;
+    }
+
+    int nthreads(4);
+    int ntrx = strtol(opt_num_rec->value(), 0, 0);
+    int nrows(10);
+    int option;
+    while ((option = getopt(argc, argv, "t:n:r:h")) != -1) {
+        switch (option) {
+        case 't' :
+            nthreads = strtol(optarg, 0, 0);
+            break;
+        case 'n' :
+            ntrx = strtol(optarg, 0, 0);
+            break;
+        case 'r' :
+            nrows = strtol(optarg, 0, 0);
+            break;
+        case 'h' :
+        default:
+            usage(options);
+            retval = 1;
+            return;
+        }
+    }
+
+    ssm = new ss_m();
+    if (!ssm) {
+        cerr << "Error: Out of memory for ss_m" << endl;
+        retval = 1;
+        return;
+    }
+
+    vid_t vid;
+    stid_t file, index;
+    W_COERCE(setup_device_and_volume(opt_device_name->value(),
+                strtol(opt_device_quota->value(), 0, 0), vid));
+    W_COERCE(ssm->begin_xct());
+    W_COERCE(ssm->create_file(vid, file, smlevel_3::t_regular));
+    W_COERCE(ssm->create_index(vid, smlevel_0::t_btree,
+                smlevel_3::t_regular, "i4", smlevel_0::t_cc_kvl, index));
+    W_COERCE(ssm->commit_xct());
+
+    sm_stats_info_t before;
+    W_COERCE(ss_m::gather_stats(before));
+
+    stopwatch_t timer;
+    std::vector<smthread_insert_t*> workers;
+    for (int i = 0; i < nthreads; i++) {
+        workers.push_back(new smthread_insert_t(file, index,
+                                                ntrx, nrows, i+1));
+        W_COERCE(workers[i]->fork());
+    }
+    int aborts = 0;
+    for (int i = 0; i < nthreads; i++) {
+        W_COERCE(workers[i]->join());
+        W_COERCE(workers[i]->rc);
+        aborts += workers[i]->aborts;
+        delete workers[i];
+    }
+    double secs = timer.time();
+
+    sm_stats_info_t after;
+    W_COERCE(ss_m::gather_stats(after));
+    int committed = nthreads*ntrx - aborts;
+
+    cout << "Threads: " << nthreads
+         << " extent reservation: " << smlevel_0::ext_reservation << endl;
+    cout << "Transactions: " << committed << " in " << secs
+         << " secs (" << committed/secs << " tps, "
+         << committed*nrows/secs << " rows/sec), "
+         << aborts << " deadlocks" << endl;
+    cout << "Pages allocated: "
+         << after.sm.page_alloc_cnt - before.sm.page_alloc_cnt
+         << ", extents allocated: "
+         << after.sm.vol_alloc_exts - before.sm.vol_alloc_exts
+         << " (reserved ahead: "
+         << after.sm.vol_resv_exts - before.sm.vol_resv_exts
+         << " in " << after.sm.vol_resv_refills - before.sm.vol_resv_refills
+         << " refills)" << endl;
+    cout << "Pages allocated without the volume mutex: "
+         << after.sm.vol_resv_page_hit - before.sm.vol_resv_page_hit
+         << endl;
+
+    delete ssm;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    smthread_main_t *smtu = new smthread_main_t(argc, argv);
+    if (!smtu)
+        W_FATAL(fcOUTOFMEMORY);
+
+    w_rc_t e = smtu->fork();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+    e = smtu->join();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+
+    int rv = smtu->retval;
+    delete smtu;
+
+    return rv;
+}
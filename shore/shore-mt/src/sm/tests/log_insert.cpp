@@ -0,0 +1,362 @@
+/*<std-header orig-src='shore'>
+
+SHORE -- Scalable Heterogeneous Object REpository
+
+Copyright (c) 1994-99 Computer Sciences Department, University of
+                      Wisconsin -- Madison
+All Rights Reserved.
+
+Permission to use, copy, modify and distribute this software and its
+documentation is hereby granted, provided that both the copyright
+notice and this permission notice appear in all copies of the
+software, derivative works or modified versions, and any portions
+thereof, and that both notices appear in supporting documentation.
+
+THE AUTHORS AND THE COMPUTER SCIENCES DEPARTMENT OF THE UNIVERSITY
+OF WISCONSIN - MADISON ALLOW FREE USE OF THIS SOFTWARE IN ITS
+"AS IS" CONDITION, AND THEY DISCLAIM ANY LIABILITY OF ANY KIND
+FOR ANY DAMAGES WHATSOEVER RESULTING FROM THE USE OF THIS SOFTWARE.
+
+This software was developed with support by the Advanced Research
+Project Agency, ARPA order number 018 (formerly 8230), monitored by
+the U.S. Army Research Laboratory under contract DAAB07-91-C-Q518.
+
+Further funding for this work was provided by DARPA through
+Rome Research Laboratory Contract No. F30602-97-2-0247.
+
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/*
+ * This program measures log-insert throughput with transactions of the
+ * shape of TPC-B: each one updates an account, a teller and a branch
+ * record and appends a history record. Run it with increasing -t to
+ * see how the log insert path scales with the number of cores.
+ *
+ * Every thread works on its own branch (the tellers and accounts of
+ * the branch are picked at random), so that the threads contend on the
+ * log and not on the record locks. Commits are lazy unless -d is given,
+ * since the point is the insert path, not the log flush.
+ *
+ * Compare the default insert groups with -sm_log_insert_slots <#cores>.
+ */
+
+#include <w_stream.h>
+#include <sys/types.h>
+#include <cassert>
+#include <vector>
+#include "sm_vas.h"
+#include "w_getopt.h"
+#include "stopwatch.h"
+
+ss_m* ssm = 0;
+
+typedef w_rc_t rc_t;
+typedef smlevel_0::smksize_t smksize_t;
+
+// this is implemented in options.cpp
+w_rc_t init_config_options(option_group_t& options,
+                        const char* prog_type,
+                        int& argc, char** argv);
+
+void
+usage(option_group_t& options)
+{
+    cerr << "Usage: server [-h] [options]" << endl;
+    cerr << "       -t <#threads> running transactions (default 4)" << endl;
+    cerr << "       -n <#transactions> per thread (default 10000)" << endl;
+    cerr << "       -a <#accounts> per branch (trumps num_rec)" << endl;
+    cerr << "       -d durable (non-lazy) commits" << endl;
+    cerr << "       -h print this message" << endl;
+    cerr << "Valid options are: " << endl;
+    options.print_usage(true, cerr);
+}
+
+enum { TELLERS_PER_BRANCH = 10, HISTORY_SIZE = 50, ROW_SIZE = 100 };
+
+/* the records of one branch */
+struct branch_t
+{
+    rid_t              branch;
+    std::vector<rid_t> tellers;
+    std::vector<rid_t> accounts;
+};
+
+
+/* runs TPC-B like transactions against one branch */
+class smthread_tpcb_t : public smthread_t
+{
+    const branch_t& _branch;
+    stid_t          _history;
+    int             _ntrx;
+    bool            _lazy;
+    unsigned int    _seed;
+public:
+    rc_t            rc;
+
+    smthread_tpcb_t(const branch_t& branch, const stid_t& history,
+                    int ntrx, bool lazy, int id)
+        : smthread_t(t_regular, "smthread_tpcb_t"),
+          _branch(branch), _history(history), _ntrx(ntrx), _lazy(lazy),
+          _seed(id*7919+1)
+    { }
+    ~smthread_tpcb_t() { }
+
+    rc_t update_balance(const rid_t& rid, int delta);
+    rc_t do_work();
+    void run() { rc = do_work(); }
+};
+
+rc_t smthread_tpcb_t::update_balance(const rid_t& rid, int delta)
+{
+    pin_i handle;
+    W_DO(handle.pin(rid, 0, EX));
+    int balance;
+    memcpy(&balance, handle.body(), sizeof(balance));
+    balance += delta;
+    W_DO(handle.update_rec(0, vec_t(&balance, sizeof(balance))));
+    handle.unpin();
+    return RCOK;
+}
+
+rc_t smthread_tpcb_t::do_work()
+{
+    char hist[HISTORY_SIZE];
+    memset(hist, '\0', sizeof(hist));
+    rid_t rid;
+    for (int i = 0; i < _ntrx; i++) {
+        int delta = int(rand_r(&_seed) % 1999999) - 999999;
+        const rid_t& account =
+            _branch.accounts[rand_r(&_seed) % _branch.accounts.size()];
+        const rid_t& teller =
+            _branch.tellers[rand_r(&_seed) % _branch.tellers.size()];
+
+        W_DO(ssm->begin_xct());
+        W_DO(update_balance(account, delta));
+        W_DO(update_balance(teller, delta));
+        W_DO(update_balance(_branch.branch, delta));
+        memcpy(hist, &delta, sizeof(delta));
+        W_DO(ssm->create_rec(_history, vec_t(), sizeof(hist),
+                             vec_t(hist, sizeof(hist)), rid));
+        W_DO(ssm->commit_xct(_lazy));
+    }
+    return RCOK;
+}
+
+
+/* create an smthread based class for all sm-related work */
+class smthread_main_t : public smthread_t
+{
+    int        argc;
+    char       **argv;
+public:
+    int        retval;
+
+    smthread_main_t(int ac, char **av)
+        : smthread_t(t_regular, "smthread_main_t"),
+          argc(ac), argv(av), retval(0)
+    { }
+    ~smthread_main_t() { }
+
+    rc_t setup_device_and_volume(const char* device_name,
+                                 smksize_t quota, vid_t& vid);
+    rc_t create_branches(const vid_t& vid, int nbranches, int naccounts,
+                         std::vector<branch_t>& branches, stid_t& history);
+    void run();
+};
+
+rc_t
+smthread_main_t::setup_device_and_volume(const char* device_name,
+                                         smksize_t quota, vid_t& vid)
+{
+    devid_t     devid;
+    u_int       vol_cnt;
+    lvid_t      lvid;
+
+    vid = 10;
+    cout << "Formatting device: " << device_name
+         << " with a " << quota << "KB quota ..." << endl;
+    W_DO(ssm->format_dev(device_name, quota, true));
+    W_DO(ssm->mount_dev(device_name, vol_cnt, devid));
+    W_DO(ssm->generate_new_lvid(lvid));
+    W_DO(ssm->create_vol(device_name, lvid, quota, false, vid));
+    return RCOK;
+}
+
+rc_t
+smthread_main_t::create_branches(const vid_t& vid, int nbranches,
+                                 int naccounts,
+                                 std::vector<branch_t>& branches,
+                                 stid_t& history)
+{
+    stid_t fid;
+    W_DO(ssm->begin_xct());
+    W_DO(ssm->create_file(vid, fid, smlevel_3::t_regular));
+    W_DO(ssm->create_file(vid, history, smlevel_3::t_regular));
+
+    char row[ROW_SIZE];
+    memset(row, '\0', sizeof(row));
+    const vec_t data(row, sizeof(row));
+    branches.resize(nbranches);
+    int nrecs = 0;
+    for (int b = 0; b < nbranches; b++) {
+        W_DO(ssm->create_rec(fid, vec_t(), sizeof(row), data,
+                             branches[b].branch));
+        rid_t rid;
+        for (int j = 0; j < TELLERS_PER_BRANCH + naccounts; j++) {
+            W_DO(ssm->create_rec(fid, vec_t(), sizeof(row), data, rid));
+            if (j < TELLERS_PER_BRANCH) {
+                branches[b].tellers.push_back(rid);
+            } else {
+                branches[b].accounts.push_back(rid);
+            }
+            if (++nrecs % 5000 == 0) {
+                // keep the log from filling up
+                W_DO(ssm->commit_xct());
+                W_DO(ssm->begin_xct());
+            }
+        }
+    }
+    W_DO(ssm->commit_xct());
+    cout << "Created " << nbranches << " branches with "
+         << TELLERS_PER_BRANCH << " tellers and "
+         << naccounts << " accounts each" << endl;
+    return RCOK;
+}
+
+void smthread_main_t::run()
+{
+    rc_t rc;
+
+    option_t* opt_device_name = 0;
+    option_t* opt_device_quota = 0;
+    option_t* opt_num_rec = 0;
+
+    const int option_level_cnt = 3;
+    option_group_t options(option_level_cnt);
+
+    W_COERCE(options.add_option("device_name", "device/file name",
+                         NULL, "device containg the volume",
+                         true, option_t::set_value_charstr,
+                         opt_device_name));
+
+    W_COERCE(options.add_option("device_quota", "# > 1000",
+                         "2000", "quota for device",
+                         false, option_t::set_value_long,
+                         opt_device_quota));
+
+    W_COERCE(options.add_option("num_rec", "# > 0",
+                         NULL, "number of accounts per branch",
+                         true, option_t::set_value_long,
+                         opt_num_rec));
+
+    // have the SSM add its options to the group
+    W_COERCE(ss_m::setup_options(&options));
+
+    rc = init_config_options(options, "server", argc, argv);
+    if (rc.is_error()) {
+        usage(options);
+        retval = 1;
+        return;
+    }
+
+    int nthreads(4);
+    int ntrx(10000);
+    int naccounts = strtol(opt_num_rec->value(), 0, 0);
+    bool lazy(true);
+    int option;
+    while ((option = getopt(argc, argv, "t:n:a:dh")) != -1) {
+        switch (option) {
+        case 't' :
+            nthreads = strtol(optarg, 0, 0);
+            break;
+        case 'n' :
+            ntrx = strtol(optarg, 0, 0);
+            break;
+        case 'a' :
+            naccounts = strtol(optarg, 0, 0);
+            break;
+        case 'd' :
+            lazy = false;
+            break;
+        case 'h' :
+        default:
+            usage(options);
+            retval = 1;
+            return;
+        }
+    }
+
+    ssm = new ss_m();
+    if (!ssm) {
+        cerr << "Error: Out of memory for ss_m" << endl;
+        retval = 1;
+        return;
+    }
+
+    vid_t vid;
+    std::vector<branch_t> branches;
+    stid_t history;
+    W_COERCE(setup_device_and_volume(opt_device_name->value(),
+                strtol(opt_device_quota->value(), 0, 0), vid));
+    W_COERCE(create_branches(vid, nthreads, naccounts, branches, history));
+
+    sm_stats_info_t before;
+    W_COERCE(ss_m::gather_stats(before));
+
+    stopwatch_t timer;
+    std::vector<smthread_tpcb_t*> workers;
+    for (int i = 0; i < nthreads; i++) {
+        workers.push_back(new smthread_tpcb_t(branches[i], history,
+                                              ntrx, lazy, i+1));
+        W_COERCE(workers[i]->fork());
+    }
+    for (int i = 0; i < nthreads; i++) {
+        W_COERCE(workers[i]->join());
+        W_COERCE(workers[i]->rc);
+        delete workers[i];
+    }
+    double secs = timer.time();
+
+    sm_stats_info_t after;
+    W_COERCE(ss_m::gather_stats(after));
+    double inserts = double(after.sm.log_inserts - before.sm.log_inserts);
+    double bytes = double(after.sm.log_bytes_generated
+                          - before.sm.log_bytes_generated);
+
+    cout << "Threads: " << nthreads << endl;
+    cout << "Transactions: " << nthreads*ntrx << " in " << secs
+         << " secs (" << nthreads*ntrx/secs << " tps)" << endl;
+    cout << "Log inserts: " << inserts/secs << " per sec, "
+         << bytes/secs/(1024*1024) << " MB/sec" << endl;
+
+    delete ssm;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    smthread_main_t *smtu = new smthread_main_t(argc, argv);
+    if (!smtu)
+        W_FATAL(fcOUTOFMEMORY);
+
+    w_rc_t e = smtu->fork();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+    e = smtu->join();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+
+    int rv = smtu->retval;
+    delete smtu;
+
+    return rv;
+}
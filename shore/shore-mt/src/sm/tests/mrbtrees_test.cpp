@@ -43,6 +43,8 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "sm_vas.h"
 #include "w_getopt.h"
 #include "stopwatch.h"
+#include "data_access_histogram.h"
+#include "data_access_sketch.h"
 #include <vector>
 
 ss_m* ssm = 0;
@@ -83,8 +85,8 @@ typedef        smlevel_0::smksize_t        smksize_t;
 
 void usage(option_group_t& options)
 {
-  // "hit:n:s:r:dpo:"
-  cerr << "Usage: server [-h] [-i] [-t] [-n] [-s] [-r] [-d] [-p] [-o] [options]" << endl;
+  // "hit:n:s:r:dpo:l:k:"
+  cerr << "Usage: server [-h] [-i] [-t] [-n] [-s] [-r] [-d] [-p] [-o] [-l] [-k] [options]" << endl;
   cerr << "       -i initialize device/volume and create file - default false" << endl;
   cerr << "       -h print this message" << endl;
   cerr << "       -t <which test - see below for options> - default 0" << endl;
@@ -94,6 +96,8 @@ void usage(option_group_t& options)
   cerr << "       -d ignore locks - default false" << endl;
   cerr << "       -p ignore latches - default false" << endl;
   cerr << "       -o <which plp design> - default plp-regular/mrbtnorm" << endl;
+  cerr << "       -l <#lookup threads> - for tests 8,9,10 - default 4" << endl;
+  cerr << "       -k <#lookups per thread> - for tests 8,9,10 - default 1000000" << endl;
 
   cerr << "        \tTESTS" << endl;
   cerr << "        \t0) MRBtree with single partition!" << endl;
@@ -103,6 +107,10 @@ void usage(option_group_t& options)
   cerr << "        \t4) Merge partitions when root1.level > root2.level in MRBtree." << endl;
   cerr << "        \t5) Merge partitions when root1.level < root2.level in MRBtree." << endl;
   cerr << "        \t6) Make equal initial partitions. Then insert the records." << endl;
+  cerr << "        \t7) Bulk loading. Single threaded." << endl;
+  cerr << "        \t8) Multi-threaded key_ranges_map lookups while the partitioning changes." << endl;
+  cerr << "        \t9) Overhead of recording data accesses: histogram vs sampled sketch." << endl;
+  cerr << "        \t10) Btree lookups on TPC-C-like composite keys, with and without prefix compression." << endl;
   
   cerr << "Valid options are: " << endl;
   options.print_usage(true, cerr);
@@ -167,6 +175,8 @@ public:
   bool        _bIgnoreLocks; // indicates whether to ignore locks or not
   bool        _bIgnoreLatches; // indicates whether to ignore latches or not 
   int         _design_no; // 1-regular/2-part/3-leaf (which mrbt design)
+  int         _num_lookup_threads; // for test 8
+  int         _num_lookups; // lookups per thread for test 8
   
   int         retval;
     
@@ -186,6 +196,8 @@ public:
       _bIgnoreLocks(false),
       _bIgnoreLatches(false),
       _design_no(1),
+      _num_lookup_threads(4),
+      _num_lookups(1000000),
       retval(0) { }
 
   ~smthread_main_t()  { if(_options) delete _options; }
@@ -206,6 +218,9 @@ public:
   w_rc_t mr_index_test5();
   w_rc_t mr_index_test6();
   w_rc_t mr_index_test7();
+  w_rc_t mr_index_test8();
+  w_rc_t mr_index_test9();
+  w_rc_t mr_index_test10();
 
   w_rc_t print_the_index();
   w_rc_t static print_updated_rids(vector<rid_t>& old_rids, vector<rid_t>& new_rids);
@@ -281,6 +296,222 @@ public:
   void run();
 };
 
+// to route keys through a key_ranges_map (test 8)
+class smthread_lookup_t : public smthread_t 
+{
+  key_ranges_map* _ranges;
+  int _num_lookups;
+  int _key_space;
+  int _part_size;
+  int _num_parts;
+  unsigned int _seed;
+public:
+  int _errors;
+  double _secs;
+
+  smthread_lookup_t(key_ranges_map* ranges, int num_lookups, int key_space,
+		    int part_size, int num_parts, unsigned int seed)
+    : smthread_t(t_regular, "smthread_lookup_t"),
+      _ranges(ranges), _num_lookups(num_lookups), _key_space(key_space),
+      _part_size(part_size), _num_parts(num_parts), _seed(seed),
+      _errors(0), _secs(0)
+  { }
+
+  ~smthread_lookup_t() {}
+
+  void run();
+};
+
+// looks up random keys in a btree of (w_id, d_id, o_id) keys (test 10)
+class smthread_btlookup_t : public smthread_t 
+{
+  stid_t _stid;
+  int _num_lookups;
+  int _key_space;
+  unsigned int _seed;
+public:
+  int _errors;
+  double _secs;
+
+  smthread_btlookup_t(stid_t stid, int num_lookups, int key_space, unsigned int seed)
+    : smthread_t(t_regular, "smthread_btlookup_t"),
+      _stid(stid), _num_lookups(num_lookups), _key_space(key_space), _seed(seed),
+      _errors(0), _secs(0)
+  { }
+
+  ~smthread_btlookup_t() {}
+
+  void run();
+};
+
+// keeps swapping the routing snapshot of a key_ranges_map (test 8)
+class smthread_repartitioner_t : public smthread_t 
+{
+  key_ranges_map* _ranges;
+  int _part_size;
+  int _num_parts;
+public:
+  bool volatile _stop;
+  int _swaps;
+
+  smthread_repartitioner_t(key_ranges_map* ranges, int part_size, int num_parts)
+    : smthread_t(t_regular, "smthread_repartitioner_t"),
+      _ranges(ranges), _part_size(part_size), _num_parts(num_parts),
+      _stop(false), _swaps(0)
+  { }
+
+  ~smthread_repartitioner_t() {}
+
+  void run();
+};
+
+// records data accesses the way the load balancer does (test 9)
+class smthread_recorder_t : public smthread_t 
+{
+  data_access_histogram* _histogram;
+  data_access_sketch* _sketch;
+  int _num_accesses;
+  int _key_space;
+  int _part_size;
+  int _num_parts;
+  unsigned int _seed;
+public:
+  double _secs;
+
+  smthread_recorder_t(data_access_histogram* histogram, data_access_sketch* sketch,
+		      int num_accesses, int key_space, int part_size, int num_parts,
+		      unsigned int seed)
+    : smthread_t(t_regular, "smthread_recorder_t"),
+      _histogram(histogram), _sketch(sketch), _num_accesses(num_accesses),
+      _key_space(key_space), _part_size(part_size), _num_parts(num_parts),
+      _seed(seed), _secs(0)
+  { }
+
+  ~smthread_recorder_t() {}
+
+  void run();
+};
+
+// the boundaries are stored big-endian so that byte order is key order
+static void put_be_key(char* buf, unsigned int key)
+{
+  buf[0] = (char)(key >> 24);
+  buf[1] = (char)(key >> 16);
+  buf[2] = (char)(key >> 8);
+  buf[3] = (char)(key);
+}
+
+void smthread_lookup_t::run()
+{
+  char buf[sizeof(unsigned int)];
+  cvec_t key;
+  lpid_t pid;
+  unsigned int x = _seed;
+  stopwatch_t timer;
+  for(int i=0; i<_num_lookups; i++) {
+    // xorshift
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    int k = x % _key_space;
+    put_be_key(buf, k);
+    key.reset();
+    key.put(buf, sizeof(buf));
+    w_rc_t rc = _ranges->getPartitionByKey(key, pid);
+    int expected = k / _part_size;
+    if(expected >= _num_parts) {
+      expected = _num_parts - 1;
+    }
+    if(rc.is_error() || (int)pid.page != expected) {
+      _errors++;
+    }
+  }
+  _secs = timer.time();
+}
+
+// 10 districts per warehouse, 3000 orders per district
+static void put_tpcc_key(char* buf, int k)
+{
+  put_be_key(buf, k / 30000);
+  put_be_key(buf + 4, (k / 3000) % 10);
+  put_be_key(buf + 8, k % 3000);
+}
+
+void smthread_btlookup_t::run()
+{
+  char buf[3*sizeof(unsigned int)];
+  unsigned int x = _seed;
+  W_COERCE(ssm->begin_xct());
+  stopwatch_t timer;
+  for(int i=0; i<_num_lookups; i++) {
+    // xorshift
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    int k = x % _key_space;
+    put_tpcc_key(buf, k);
+    vec_t key(buf, sizeof(buf));
+    int el = -1;
+    smsize_t elen = sizeof(el);
+    bool found = false;
+    w_rc_t rc = ssm->find_assoc(_stid, key, &el, elen, found);
+    if(rc.is_error() || !found || el != k) {
+      _errors++;
+    }
+  }
+  _secs = timer.time();
+  W_COERCE(ssm->commit_xct());
+}
+
+void smthread_recorder_t::run()
+{
+  char buf[sizeof(unsigned int)];
+  cvec_t key;
+  stid_t astid;
+  lpid_t root(astid,0);
+  unsigned int x = _seed;
+  stopwatch_t timer;
+  for(int i=0; i<_num_accesses; i++) {
+    // xorshift
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    int k = x % _key_space;
+    put_be_key(buf, k);
+    key.reset();
+    key.put(buf, sizeof(buf));
+    root.page = k / _part_size;
+    if((int)root.page >= _num_parts) {
+      root.page = _num_parts - 1;
+    }
+    if(_histogram) {
+      W_COERCE(_histogram->inc_access_count(root, key));
+    } else if(_sketch) {
+      W_COERCE(_sketch->inc_access_count(root, key));
+    }
+  }
+  _secs = timer.time();
+}
+
+void smthread_repartitioner_t::run()
+{
+  char buf[sizeof(unsigned int)];
+  cvec_t key;
+  stid_t astid;
+  lpid_t root(astid,0);
+  int i = 0;
+  while(!_stop) {
+    // same root for the same boundary, only the snapshot changes
+    root.page = i;
+    put_be_key(buf, i * _part_size);
+    key.reset();
+    key.put(buf, sizeof(buf));
+    W_COERCE(_ranges->updateRoot(key, root));
+    _swaps++;
+    i = (i + 1) % _num_parts;
+  }
+}
+
 void smthread_creator_t::run()
 { 
   rc_t rc = find_file_info();
@@ -982,6 +1213,204 @@ rc_t smthread_main_t::mr_index_test7()
     return RCOK;
 }
 
+rc_t smthread_main_t::mr_index_test8()
+{
+    cout << endl;
+    cout << " ------- TEST8 -------" << endl;
+    cout << "Multi-threaded key_ranges_map lookups while the partitioning changes!" << endl;
+    cout << endl;
+
+    if(_num_parts < 1 || _num_rec < _num_parts) {
+      cerr << "Need at least one record per partition" << endl;
+      return RC(fcASSERT);
+    }
+
+    // partition i covers [i*part_size, (i+1)*part_size)
+    key_ranges_map ranges;
+    int part_size = _num_rec / _num_parts;
+    char buf[sizeof(unsigned int)];
+    cvec_t key;
+    stid_t astid;
+    lpid_t root(astid,0);
+    for(int i=0; i<_num_parts; i++) {
+      root.page = i;
+      put_be_key(buf, i * part_size);
+      key.reset();
+      key.put(buf, sizeof(buf));
+      W_DO(ranges.addPartition(key, root));
+    }
+
+    cout << "partitions: " << _num_parts 
+	 << " lookup threads: " << _num_lookup_threads
+	 << " lookups/thread: " << _num_lookups << endl;
+
+    smthread_repartitioner_t* repartitioner = 
+      new smthread_repartitioner_t(&ranges, part_size, _num_parts);
+    smthread_lookup_t** lookups = new smthread_lookup_t* [_num_lookup_threads];
+    for(int i=0; i<_num_lookup_threads; i++) {
+      lookups[i] = new smthread_lookup_t(&ranges, _num_lookups, _num_rec,
+					 part_size, _num_parts, 2463534242u + i);
+    }
+
+    stopwatch_t timer;
+    W_DO(repartitioner->fork());
+    for(int i=0; i<_num_lookup_threads; i++) {
+      W_DO(lookups[i]->fork());
+    }
+    for(int i=0; i<_num_lookup_threads; i++) {
+      W_DO(lookups[i]->join());
+    }
+    double secs = timer.time();
+    repartitioner->_stop = true;
+    W_DO(repartitioner->join());
+
+    int errors = 0;
+    for(int i=0; i<_num_lookup_threads; i++) {
+      errors += lookups[i]->_errors;
+      cout << "thread " << i << ": " 
+	   << (_num_lookups / lookups[i]->_secs / 1e6) << " Mlookups/s" << endl;
+      delete lookups[i];
+    }
+    delete[] lookups;
+
+    cout << "total: " 
+	 << ((double)_num_lookups * _num_lookup_threads / secs / 1e6) << " Mlookups/s"
+	 << " in " << secs << " secs, " 
+	 << repartitioner->_swaps << " snapshot swaps, "
+	 << errors << " misrouted keys" << endl;
+    delete repartitioner;
+
+    if(errors > 0) {
+      return RC(fcASSERT);
+    }
+    return RCOK;
+}
+
+rc_t smthread_main_t::mr_index_test9()
+{
+    cout << endl;
+    cout << " ------- TEST9 -------" << endl;
+    cout << "Overhead of recording data accesses: histogram vs sampled sketch!" << endl;
+    cout << endl;
+
+    if(_num_parts < 1 || _num_rec < _num_parts) {
+      cerr << "Need at least one record per partition" << endl;
+      return RC(fcASSERT);
+    }
+
+    key_ranges_map ranges;
+    int part_size = _num_rec / _num_parts;
+    char buf[sizeof(unsigned int)];
+    cvec_t key;
+    stid_t astid;
+    lpid_t root(astid,0);
+    for(int i=0; i<_num_parts; i++) {
+      root.page = i;
+      put_be_key(buf, i * part_size);
+      key.reset();
+      key.put(buf, sizeof(buf));
+      W_DO(ranges.addPartition(key, root));
+    }
+
+    data_access_histogram* histogram = new data_access_histogram(ranges, 100, 7, false);
+    data_access_sketch* sketch = new data_access_sketch(7);
+    W_DO(sketch->start_merger());
+
+    // 0: no recording, 1: histogram, 2: sketch
+    const char* names[] = { "none", "histogram", "sketch" };
+    double base_ns = 0;
+    for(int mode=0; mode<3; mode++) {
+      smthread_recorder_t** recorders = new smthread_recorder_t* [_num_lookup_threads];
+      for(int i=0; i<_num_lookup_threads; i++) {
+	recorders[i] = new smthread_recorder_t((mode==1) ? histogram : NULL,
+					       (mode==2) ? sketch : NULL,
+					       _num_lookups, _num_rec, part_size,
+					       _num_parts, 2463534242u + i);
+      }
+      for(int i=0; i<_num_lookup_threads; i++) {
+	W_DO(recorders[i]->fork());
+      }
+      double secs = 0;
+      for(int i=0; i<_num_lookup_threads; i++) {
+	W_DO(recorders[i]->join());
+	secs += recorders[i]->_secs;
+	delete recorders[i];
+      }
+      delete[] recorders;
+
+      double ns = secs * 1e9 / ((double)_num_lookups * _num_lookup_threads);
+      if(mode == 0) {
+	base_ns = ns;
+      }
+      cout << names[mode] << ": " << ns << " ns/access"
+	   << " (+" << (ns - base_ns) << " ns)" << endl;
+    }
+
+    // keys are uniform, so partition 0 gets part_size/_num_rec of the accesses
+    sketch->merge();
+    root.page = 0;
+    cout << "sketch estimate for partition 0: " << sketch->get_root_access_count(root)
+	 << " expected: " 
+	 << ((double)_num_lookups * _num_lookup_threads * part_size / _num_rec) << endl;
+
+    delete sketch;
+    delete histogram;
+    return RCOK;
+}
+
+rc_t smthread_main_t::mr_index_test10()
+{
+    cout << endl;
+    cout << " ------- TEST10 -------" << endl;
+    cout << "Btree lookups on TPC-C-like composite keys, with and without prefix compression!" << endl;
+    cout << endl;
+
+    // a capital letter makes the key part prefix-compressible
+    const char* keydescs[] = { "i4i4i4", "I4i4i4" };
+    int errors = 0;
+    for(int c=0; c<2; c++) {
+      stid_t stid;
+      W_DO(ssm->begin_xct());
+      W_DO(ssm->create_index(_vid, smlevel_0::t_btree, smlevel_3::t_regular, 
+			     keydescs[c], smlevel_0::t_cc_none, stid));
+      char buf[3*sizeof(unsigned int)];
+      for(int k=0; k<_num_rec; k++) {
+	put_tpcc_key(buf, k);
+	W_DO(ssm->create_assoc(stid, vec_t(buf, sizeof(buf)), vec_t(&k, sizeof(k))));
+	if(k % 20000 == 19999) {
+	  W_DO(ssm->commit_xct());
+	  W_DO(ssm->begin_xct());
+	}
+      }
+      W_DO(ssm->commit_xct());
+
+      smthread_btlookup_t** lookups = new smthread_btlookup_t* [_num_lookup_threads];
+      for(int i=0; i<_num_lookup_threads; i++) {
+	lookups[i] = new smthread_btlookup_t(stid, _num_lookups, _num_rec, 2463534242u + i);
+      }
+      for(int i=0; i<_num_lookup_threads; i++) {
+	W_DO(lookups[i]->fork());
+      }
+      double secs = 0;
+      for(int i=0; i<_num_lookup_threads; i++) {
+	W_DO(lookups[i]->join());
+	secs += lookups[i]->_secs;
+	errors += lookups[i]->_errors;
+	delete lookups[i];
+      }
+      delete[] lookups;
+
+      cout << keydescs[c] << ": " 
+	   << (secs * 1e9 / ((double)_num_lookups * _num_lookup_threads)) << " ns/lookup" << endl;
+    }
+
+    cout << errors << " failed lookups" << endl;
+    if(errors > 0) {
+      return RC(fcASSERT);
+    }
+    return RCOK;
+}
+
 // prints the btree
 rc_t smthread_main_t::print_the_index() 
 {
@@ -1168,6 +1597,15 @@ rc_t smthread_main_t::no_init()
     case 7:
       W_DO(mr_index_test7()); //
       break;
+    case 8:
+      W_DO(mr_index_test8()); //
+      break;
+    case 9:
+      W_DO(mr_index_test9()); //
+      break;
+    case 10:
+      W_DO(mr_index_test10()); //
+      break;
     }
 
     // scan the file if given in the input
@@ -1254,7 +1692,7 @@ w_rc_t smthread_main_t::handle_options()
 
     // Process the command line
     int option;
-    while ((option = getopt(_argc, _argv, "hit:n:s:r:dpo:")) != -1) {
+    while ((option = getopt(_argc, _argv, "hit:n:s:r:dpo:l:k:")) != -1) {
         switch (option) {
         case 'i' :
             _initialize_device = true;
@@ -1291,6 +1729,14 @@ w_rc_t smthread_main_t::handle_options()
 	case 'o': // which mrbt design
 	  _design_no = atoi(optarg);;
 	  break;
+
+	case 'l': // lookup threads for tests 8,9
+	  _num_lookup_threads = atoi(optarg);
+	  break;
+
+	case 'k': // lookups per thread for tests 8,9
+	  _num_lookups = atoi(optarg);
+	  break;
 	  
         default:
             usage(options);
@@ -1329,7 +1775,9 @@ w_rc_t smthread_main_t::handle_options()
 	 << "_num_parts: " << _num_parts << endl
 	 << "_scan_file: " << _scan_file << endl
       	 << "_bIgnoreLocks: " << _bIgnoreLocks << endl
-	 << "_bIgnoreLatches: " << _bIgnoreLatches << endl;
+	 << "_bIgnoreLatches: " << _bIgnoreLatches << endl
+	 << "_num_lookup_threads: " << _num_lookup_threads << endl
+	 << "_num_lookups: " << _num_lookups << endl;
     
     return RCOK;
 }
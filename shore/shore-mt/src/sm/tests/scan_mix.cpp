@@ -0,0 +1,384 @@
+/*<std-header orig-src='shore'>
+
+SHORE -- Scalable Heterogeneous Object REpository
+
+Copyright (c) 1994-99 Computer Sciences Department, University of
+                      Wisconsin -- Madison
+All Rights Reserved.
+
+Permission to use, copy, modify and distribute this software and its
+documentation is hereby granted, provided that both the copyright
+notice and this permission notice appear in all copies of the
+software, derivative works or modified versions, and any portions
+thereof, and that both notices appear in supporting documentation.
+
+THE AUTHORS AND THE COMPUTER SCIENCES DEPARTMENT OF THE UNIVERSITY
+OF WISCONSIN - MADISON ALLOW FREE USE OF THIS SOFTWARE IN ITS
+"AS IS" CONDITION, AND THEY DISCLAIM ANY LIABILITY OF ANY KIND
+FOR ANY DAMAGES WHATSOEVER RESULTING FROM THE USE OF THIS SOFTWARE.
+
+This software was developed with support by the Advanced Research
+Project Agency, ARPA order number 018 (formerly 8230), monitored by
+the U.S. Army Research Laboratory under contract DAAB07-91-C-Q518.
+
+Further funding for this work was provided by DARPA through
+Rome Research Laboratory Contract No. F30602-97-2-0247.
+
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/*
+ * This program measures the latency of short transactions that
+ * read records of a small "hot" file while another thread scans a
+ * "cold" file larger than the buffer pool, over and over.
+ *
+ * Compare the percentiles for
+ *     -sm_bufpool_replacement clock
+ *     -sm_bufpool_replacement 2q
+ * and with -sm_prefetch yes -sm_prefetch_depth <n> for the scan.
+ * Run with -s to get the numbers without the concurrent scan.
+ */
+
+#include <w_stream.h>
+#include <sys/types.h>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include "sm_vas.h"
+#include "w_getopt.h"
+#include "stopwatch.h"
+
+ss_m* ssm = 0;
+
+typedef w_rc_t rc_t;
+typedef smlevel_0::smksize_t smksize_t;
+
+// this is implemented in options.cpp
+w_rc_t init_config_options(option_group_t& options,
+                        const char* prog_type,
+                        int& argc, char** argv);
+
+void
+usage(option_group_t& options)
+{
+    cerr << "Usage: server [-h] [options]" << endl;
+    cerr << "       -w <#records> in the hot file (default 500)" << endl;
+    cerr << "       -c <#records> in the cold file (trumps num_rec)" << endl;
+    cerr << "       -t <#threads> reading the hot file (default 2)" << endl;
+    cerr << "       -n <#transactions> per thread (default 20000)" << endl;
+    cerr << "       -s no concurrent scan" << endl;
+    cerr << "       -h print this message" << endl;
+    cerr << "Valid options are: " << endl;
+    options.print_usage(true, cerr);
+}
+
+static bool volatile _done = false;
+
+
+/* reads random records of the hot file, one per transaction */
+class smthread_reader_t : public smthread_t
+{
+    const std::vector<rid_t>& _rids;
+    int                       _ntrx;
+    unsigned int              _seed;
+public:
+    std::vector<int>          lat_us;
+
+    smthread_reader_t(const std::vector<rid_t>& rids, int ntrx, int id)
+        : smthread_t(t_regular, "smthread_reader_t"),
+          _rids(rids), _ntrx(ntrx), _seed(id*7919+1)
+    { lat_us.reserve(ntrx); }
+    ~smthread_reader_t() { }
+
+    void run();
+};
+
+void smthread_reader_t::run()
+{
+    pin_i handle;
+    for (int i = 0; i < _ntrx; i++) {
+        const rid_t& rid = _rids[rand_r(&_seed) % _rids.size()];
+        stopwatch_t timer;
+        W_COERCE(ssm->begin_xct());
+        W_COERCE(handle.pin(rid, 0, SH));
+        int refi;
+        memcpy(&refi, handle.hdr(), sizeof(refi));
+        handle.unpin();
+        W_COERCE(ssm->commit_xct());
+        lat_us.push_back(int(timer.time_us()));
+    }
+}
+
+
+/* scans the cold file until the readers are done */
+class smthread_scanner_t : public smthread_t
+{
+    stid_t _fid;
+public:
+    int    npasses;
+    long   nrecs;
+
+    smthread_scanner_t(const stid_t& fid)
+        : smthread_t(t_regular, "smthread_scanner_t"),
+          _fid(fid), npasses(0), nrecs(0)
+    { }
+    ~smthread_scanner_t() { }
+
+    void run();
+};
+
+void smthread_scanner_t::run()
+{
+    while (!_done) {
+        W_COERCE(ssm->begin_xct());
+        {
+            scan_file_i scan(_fid, ss_m::t_cc_file, true /*prefetch*/);
+            W_COERCE(scan.error_code());
+            pin_i* handle;
+            bool   eof = false;
+            while (!_done) {
+                W_COERCE(scan.next(handle, 0, eof));
+                if (eof) break;
+                nrecs++;
+            }
+        }
+        W_COERCE(ssm->commit_xct());
+        npasses++;
+    }
+}
+
+
+/* create an smthread based class for all sm-related work */
+class smthread_main_t : public smthread_t
+{
+    int        argc;
+    char       **argv;
+public:
+    int        retval;
+
+    smthread_main_t(int ac, char **av)
+        : smthread_t(t_regular, "smthread_main_t"),
+          argc(ac), argv(av), retval(0)
+    { }
+    ~smthread_main_t() { }
+
+    rc_t setup_device_and_volume(const char* device_name,
+                                 smksize_t quota, vid_t& vid);
+    rc_t create_file(const vid_t& vid, int nrecs, smsize_t rec_size,
+                     stid_t& fid, std::vector<rid_t>* rids);
+    void run();
+};
+
+rc_t
+smthread_main_t::setup_device_and_volume(const char* device_name,
+                                         smksize_t quota, vid_t& vid)
+{
+    devid_t     devid;
+    u_int       vol_cnt;
+    lvid_t      lvid;
+
+    vid = 10;
+    cout << "Formatting device: " << device_name
+         << " with a " << quota << "KB quota ..." << endl;
+    W_DO(ssm->format_dev(device_name, quota, true));
+    W_DO(ssm->mount_dev(device_name, vol_cnt, devid));
+    W_DO(ssm->generate_new_lvid(lvid));
+    W_DO(ssm->create_vol(device_name, lvid, quota, false, vid));
+    return RCOK;
+}
+
+rc_t
+smthread_main_t::create_file(const vid_t& vid, int nrecs, smsize_t rec_size,
+                             stid_t& fid, std::vector<rid_t>* rids)
+{
+    W_DO(ssm->begin_xct());
+    W_DO(ssm->create_file(vid, fid, smlevel_3::t_regular));
+
+    char* dummy = new char[rec_size];
+    memset(dummy, '\0', rec_size);
+    vec_t data(dummy, rec_size);
+    rid_t rid;
+    for (int j = 0; j < nrecs; j++) {
+        const vec_t hdr(&j, sizeof(j));
+        W_DO(ssm->create_rec(fid, hdr, rec_size, data, rid));
+        if (rids) rids->push_back(rid);
+        if (j % 500 == 499) {
+            // keep the log from filling up
+            W_DO(ssm->commit_xct());
+            W_DO(ssm->begin_xct());
+        }
+    }
+    delete [] dummy;
+    W_DO(ssm->commit_xct());
+    cout << "Created file " << fid << " with " << nrecs << " records" << endl;
+    return RCOK;
+}
+
+void smthread_main_t::run()
+{
+    rc_t rc;
+
+    option_t* opt_device_name = 0;
+    option_t* opt_device_quota = 0;
+    option_t* opt_num_rec = 0;
+    option_t* opt_rec_size = 0;
+
+    const int option_level_cnt = 3;
+    option_group_t options(option_level_cnt);
+
+    W_COERCE(options.add_option("device_name", "device/file name",
+                         NULL, "device containg the volume",
+                         true, option_t::set_value_charstr,
+                         opt_device_name));
+
+    W_COERCE(options.add_option("device_quota", "# > 1000",
+                         "2000", "quota for device",
+                         false, option_t::set_value_long,
+                         opt_device_quota));
+
+    W_COERCE(options.add_option("num_rec", "# > 0",
+                         NULL, "number of records in the cold file",
+                         true, option_t::set_value_long,
+                         opt_num_rec));
+
+    W_COERCE(options.add_option("rec_size", "# > 0",
+                         "7800", "size for records",
+                         false, option_t::set_value_long,
+                         opt_rec_size));
+
+    // have the SSM add its options to the group
+    W_COERCE(ss_m::setup_options(&options));
+
+    rc = init_config_options(options, "server", argc, argv);
+    if (rc.is_error()) {
+        usage(options);
+        retval = 1;
+        return;
+    }
+
+    int nhot(500);
+    int ncold = strtol(opt_num_rec->value(), 0, 0);
+    int nthreads(2);
+    int ntrx(20000);
+    bool scan(true);
+    int option;
+    while ((option = getopt(argc, argv, "w:c:t:n:sh")) != -1) {
+        switch (option) {
+        case 'w' :
+            nhot = strtol(optarg, 0, 0);
+            break;
+        case 'c' :
+            ncold = strtol(optarg, 0, 0);
+            break;
+        case 't' :
+            nthreads = strtol(optarg, 0, 0);
+            break;
+        case 'n' :
+            ntrx = strtol(optarg, 0, 0);
+            break;
+        case 's' :
+            scan = false;
+            break;
+        case 'h' :
+        default:
+            usage(options);
+            retval = 1;
+            return;
+        }
+    }
+
+    ssm = new ss_m();
+    if (!ssm) {
+        cerr << "Error: Out of memory for ss_m" << endl;
+        retval = 1;
+        return;
+    }
+
+    vid_t vid;
+    stid_t hot_fid;
+    stid_t cold_fid;
+    std::vector<rid_t> hot_rids;
+    smsize_t rec_size = strtol(opt_rec_size->value(), 0, 0);
+    W_COERCE(setup_device_and_volume(opt_device_name->value(),
+                strtol(opt_device_quota->value(), 0, 0), vid));
+    W_COERCE(create_file(vid, nhot, rec_size, hot_fid, &hot_rids));
+    W_COERCE(create_file(vid, ncold, rec_size, cold_fid, NULL));
+
+    // warm up the buffer pool with the hot file
+    {
+        smthread_reader_t warmup(hot_rids, 4*nhot, 0);
+        W_COERCE(warmup.fork());
+        W_COERCE(warmup.join());
+    }
+
+    smthread_scanner_t* scanner = NULL;
+    if (scan) {
+        scanner = new smthread_scanner_t(cold_fid);
+        W_COERCE(scanner->fork());
+    }
+
+    stopwatch_t timer;
+    std::vector<smthread_reader_t*> readers;
+    for (int i = 0; i < nthreads; i++) {
+        readers.push_back(new smthread_reader_t(hot_rids, ntrx, i+1));
+        W_COERCE(readers[i]->fork());
+    }
+    std::vector<int> lat_us;
+    for (int i = 0; i < nthreads; i++) {
+        W_COERCE(readers[i]->join());
+        lat_us.insert(lat_us.end(),
+                      readers[i]->lat_us.begin(), readers[i]->lat_us.end());
+        delete readers[i];
+    }
+    double secs = timer.time();
+
+    _done = true;
+    if (scanner) {
+        W_COERCE(scanner->join());
+    }
+
+    std::sort(lat_us.begin(), lat_us.end());
+    long sum = 0;
+    for (uint i = 0; i < lat_us.size(); i++) sum += lat_us[i];
+    cout << "Transactions: " << lat_us.size()
+         << " in " << secs << " secs (" << lat_us.size()/secs << " tps)" << endl;
+    cout << "Latency (us): avg " << double(sum)/lat_us.size()
+         << " p50 " << lat_us[lat_us.size()/2]
+         << " p99 " << lat_us[lat_us.size()*99/100]
+         << " max " << lat_us.back() << endl;
+    if (scanner) {
+        cout << "Scanned: " << scanner->nrecs << " records of the cold file in "
+             << scanner->npasses << " passes" << endl;
+        delete scanner;
+    }
+
+    delete ssm;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    smthread_main_t *smtu = new smthread_main_t(argc, argv);
+    if (!smtu)
+        W_FATAL(fcOUTOFMEMORY);
+
+    w_rc_t e = smtu->fork();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+    e = smtu->join();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+
+    int rv = smtu->retval;
+    delete smtu;
+
+    return rv;
+}
@@ -0,0 +1,338 @@
+/*<std-header orig-src='shore'>
+
+SHORE -- Scalable Heterogeneous Object REpository
+
+Copyright (c) 1994-99 Computer Sciences Department, University of
+                      Wisconsin -- Madison
+All Rights Reserved.
+
+Permission to use, copy, modify and distribute this software and its
+documentation is hereby granted, provided that both the copyright
+notice and this permission notice appear in all copies of the
+software, derivative works or modified versions, and any portions
+thereof, and that both notices appear in supporting documentation.
+
+THE AUTHORS AND THE COMPUTER SCIENCES DEPARTMENT OF THE UNIVERSITY
+OF WISCONSIN - MADISON ALLOW FREE USE OF THIS SOFTWARE IN ITS
+"AS IS" CONDITION, AND THEY DISCLAIM ANY LIABILITY OF ANY KIND
+FOR ANY DAMAGES WHATSOEVER RESULTING FROM THE USE OF THIS SOFTWARE.
+
+This software was developed with support by the Advanced Research
+Project Agency, ARPA order number 018 (formerly 8230), monitored by
+the U.S. Army Research Laboratory under contract DAAB07-91-C-Q518.
+
+Further funding for this work was provided by DARPA through
+Rome Research Laboratory Contract No. F30602-97-2-0247.
+
+*/
+
+#include "w_defines.h"
+
+
+/*
+ * This program measures how fast a sort_stream_i sorts as the
+ * threads that sort its runs are added (-sm_sort_threads). It puts
+ * num_rec pseudo-random keys into a stream, sorts them with 1, 2, 4 ...
+ * up to -t threads, checks the order they come back in, and reports
+ * the keys sorted per second for each thread count.
+ *
+ * Runs are sorted in memory, so give the stream runs large enough
+ * for the threads to have something to do (-r, in pages).
+ */
+
+#include <w_stream.h>
+#include <sys/types.h>
+#include <cassert>
+#include <cstring>
+#include "sm_vas.h"
+#include "w_getopt.h"
+#include "stopwatch.h"
+
+ss_m* ssm = 0;
+
+typedef w_rc_t rc_t;
+typedef smlevel_0::smksize_t smksize_t;
+
+// this is implemented in options.cpp
+w_rc_t init_config_options(option_group_t& options,
+                        const char* prog_type,
+                        int& argc, char** argv);
+
+void
+usage(option_group_t& options)
+{
+    cerr << "Usage: server [-h] [options]" << endl;
+    cerr << "       -t <#threads> most threads sorting a run (default 4)"
+         << endl;
+    cerr << "       -n <#keys> to sort (trumps num_rec)" << endl;
+    cerr << "       -r <#pages> run size (default 500)" << endl;
+    cerr << "       -s sort 16-byte strings instead of i4s" << endl;
+    cerr << "       -d sort in descending order" << endl;
+    cerr << "       -h print this message" << endl;
+    cerr << "Valid options are: " << endl;
+    options.print_usage(true, cerr);
+}
+
+enum { STR_KEY_SIZE = 16 };
+
+
+/* create an smthread based class for all sm-related work */
+class smthread_main_t : public smthread_t
+{
+    int        argc;
+    char       **argv;
+public:
+    int        retval;
+
+    smthread_main_t(int ac, char **av)
+        : smthread_t(t_regular, "smthread_main_t"),
+          argc(ac), argv(av), retval(0)
+    { }
+    ~smthread_main_t() { }
+
+    rc_t setup_device_and_volume(const char* device_name,
+                                 smksize_t quota, vid_t& vid);
+    rc_t sort_keys(vid_t vid, int nkeys, int run_size,
+                   bool strings, bool ascending, double& secs);
+    void run();
+};
+
+rc_t
+smthread_main_t::setup_device_and_volume(const char* device_name,
+                                         smksize_t quota, vid_t& vid)
+{
+    devid_t     devid;
+    u_int       vol_cnt;
+    lvid_t      lvid;
+
+    vid = 10;
+    cout << "Formatting device: " << device_name
+         << " with a " << quota << "KB quota ..." << endl;
+    W_DO(ssm->format_dev(device_name, quota, true));
+    W_DO(ssm->mount_dev(device_name, vol_cnt, devid));
+    W_DO(ssm->generate_new_lvid(lvid));
+    W_DO(ssm->create_vol(device_name, lvid, quota, false, vid));
+    return RCOK;
+}
+
+/* the same keys for every thread count */
+static void
+make_key(int i, bool strings, char* key, int& klen)
+{
+    w_base_t::uint4_t x = w_base_t::uint4_t(i) * 2654435761u + 12345;
+    if (strings) {
+        // some keys share a prefix longer than 8 bytes
+        for (int j = 0; j < STR_KEY_SIZE; j++) {
+            key[j] = (j < 10 && (x & 1)) ? 'a' : 'a' + (x >> (j % 24)) % 26;
+        }
+        klen = STR_KEY_SIZE;
+    } else {
+        w_base_t::int4_t v = w_base_t::int4_t(x);
+        memcpy(key, &v, sizeof(v));
+        klen = sizeof(v);
+    }
+}
+
+rc_t
+smthread_main_t::sort_keys(vid_t vid, int nkeys, int run_size,
+                           bool strings, bool ascending, double& secs)
+{
+    using ssm_sort::key_info_t;
+    using ssm_sort::sort_parm_t;
+
+    key_info_t kinfo;
+    kinfo.type = strings ? sortorder::kt_b : sortorder::kt_i4;
+    kinfo.derived = false;
+    kinfo.where = key_info_t::t_hdr;
+    kinfo.offset = 0;
+    kinfo.len = strings ? STR_KEY_SIZE : sizeof(w_base_t::int4_t);
+    kinfo.est_reclen = kinfo.len + sizeof(int);
+
+    sort_parm_t behav;
+    behav.run_size = run_size;
+    behav.vol = vid;
+    behav.unique = false;
+    behav.ascending = ascending;
+    behav.destructive = false;
+    behav.property = ss_m::t_temporary;
+
+    W_DO(ssm->begin_xct());
+    stopwatch_t timer;
+    {
+        sort_stream_i stream(kinfo, behav, kinfo.est_reclen);
+        for (int i = 0; i < nkeys; i++) {
+            char key[STR_KEY_SIZE];
+            int klen;
+            make_key(i, strings, key, klen);
+            W_DO(stream.put(vec_t(key, klen), vec_t(&i, sizeof(i))));
+        }
+
+        char prev[STR_KEY_SIZE];
+        int count = 0;
+        bool eof = false;
+        while (true) {
+            vec_t key, elem;
+            W_DO(stream.get_next(key, elem, eof));
+            if (eof) break;
+            char cur[STR_KEY_SIZE];
+            int i;
+            key.copy_to(cur, kinfo.len);
+            elem.copy_to(&i, sizeof(i));
+
+            char expect[STR_KEY_SIZE];
+            int klen;
+            make_key(i, strings, expect, klen);
+            if (memcmp(cur, expect, klen)) {
+                cerr << "key of element " << i << " changed" << endl;
+                return RC(fcINTERNAL);
+            }
+            if (count > 0) {
+                int c;
+                if (strings) {
+                    c = memcmp(prev, cur, STR_KEY_SIZE);
+                } else {
+                    w_base_t::int4_t p, q;
+                    memcpy(&p, prev, sizeof(p));
+                    memcpy(&q, cur, sizeof(q));
+                    c = p < q ? -1 : p > q;
+                }
+                if (ascending ? c > 0 : c < 0) {
+                    cerr << "key " << count << " out of order" << endl;
+                    return RC(fcINTERNAL);
+                }
+            }
+            memcpy(prev, cur, sizeof(prev));
+            count++;
+        }
+        if (count != nkeys) {
+            cerr << "sorted " << count << " keys of " << nkeys << endl;
+            return RC(fcINTERNAL);
+        }
+    }
+    secs = timer.time();
+    W_DO(ssm->commit_xct());
+    return RCOK;
+}
+
+void smthread_main_t::run()
+{
+    rc_t rc;
+
+    option_t* opt_device_name = 0;
+    option_t* opt_device_quota = 0;
+    option_t* opt_num_rec = 0;
+
+    const int option_level_cnt = 3;
+    option_group_t options(option_level_cnt);
+
+    W_COERCE(options.add_option("device_name", "device/file name",
+                         NULL, "device containg the volume",
+                         true, option_t::set_value_charstr,
+                         opt_device_name));
+
+    W_COERCE(options.add_option("device_quota", "# > 1000",
+                         "2000", "quota for device",
+                         false, option_t::set_value_long,
+                         opt_device_quota));
+
+    W_COERCE(options.add_option("num_rec", "# > 0",
+                         NULL, "number of keys to sort",
+                         true, option_t::set_value_long,
+                         opt_num_rec));
+
+    // have the SSM add its options to the group
+    W_COERCE(ss_m::setup_options(&options));
+
+    rc = init_config_options(options, "server", argc, argv);
+    if (rc.is_error()) {
+        usage(options);
+        retval = 1;
+        return;
+    }
+
+    int max_threads(4);
+    int nkeys = strtol(opt_num_rec->value(), 0, 0);
+    int run_size(500);
+    bool strings(false);
+    bool ascending(true);
+    int option;
+    while ((option = getopt(argc, argv, "t:n:r:sdh")) != -1) {
+        switch (option) {
+        case 't' :
+            max_threads = strtol(optarg, 0, 0);
+            break;
+        case 'n' :
+            nkeys = strtol(optarg, 0, 0);
+            break;
+        case 'r' :
+            run_size = strtol(optarg, 0, 0);
+            break;
+        case 's' :
+            strings = true;
+            break;
+        case 'd' :
+            ascending = false;
+            break;
+        case 'h' :
+        default:
+            usage(options);
+            retval = 1;
+            return;
+        }
+    }
+
+    ssm = new ss_m();
+    if (!ssm) {
+        cerr << "Error: Out of memory for ss_m" << endl;
+        retval = 1;
+        return;
+    }
+
+    vid_t vid;
+    W_COERCE(setup_device_and_volume(opt_device_name->value(),
+                strtol(opt_device_quota->value(), 0, 0), vid));
+
+    cout << "Sorting " << nkeys << (strings ? " string" : " i4")
+         << " keys " << (ascending ? "ascending" : "descending")
+         << ", runs of " << run_size << " pages" << endl;
+    for (int t = 1; t <= max_threads; t <<= 1) {
+        // what sm_sort_threads sets
+        smlevel_0::sort_threads = t;
+        double secs;
+        rc = sort_keys(vid, nkeys, run_size, strings, ascending, secs);
+        if (rc.is_error()) {
+            cerr << "Sort with " << t << " threads failed: " << rc << endl;
+            retval = 1;
+            break;
+        }
+        cout << "Threads: " << t << " " << secs << " secs ("
+             << nkeys/secs << " keys/sec)" << endl;
+    }
+
+    delete ssm;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+    smthread_main_t *smtu = new smthread_main_t(argc, argv);
+    if (!smtu)
+        W_FATAL(fcOUTOFMEMORY);
+
+    w_rc_t e = smtu->fork();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+    e = smtu->join();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+
+    int rv = smtu->retval;
+    delete smtu;
+
+    return rv;
+}
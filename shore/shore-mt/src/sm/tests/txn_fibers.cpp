@@ -0,0 +1,361 @@
+/*<std-header orig-src='shore'>
+
+SHORE -- Scalable Heterogeneous Object REpository
+
+Copyright (c) 1994-99 Computer Sciences Department, University of
+                      Wisconsin -- Madison
+All Rights Reserved.
+
+Permission to use, copy, modify and distribute this software and its
+documentation is hereby granted, provided that both the copyright
+notice and this permission notice appear in all copies of the
+software, derivative works or modified versions, and any portions
+thereof, and that both notices appear in supporting documentation.
+
+THE AUTHORS AND THE COMPUTER SCIENCES DEPARTMENT OF THE UNIVERSITY
+OF WISCONSIN - MADISON ALLOW FREE USE OF THIS SOFTWARE IN ITS
+"AS IS" CONDITION, AND THEY DISCLAIM ANY LIABILITY OF ANY KIND
+FOR ANY DAMAGES WHATSOEVER RESULTING FROM THE USE OF THIS SOFTWARE.
+
+This software was developed with support by the Advanced Research
+Project Agency, ARPA order number 018 (formerly 8230), monitored by
+the U.S. Army Research Laboratory under contract DAAB07-91-C-Q518.
+
+Further funding for this work was provided by DARPA through
+Rome Research Laboratory Contract No. F30602-97-2-0247.
+
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/*
+ * This program compares running transactions on pthreads with running
+ * them as fibers on a few carriers (see sthread_carrier_t). Each
+ * transaction reads -r random records of a file much larger than the
+ * buffer pool and updates one of them, so most of its time goes into
+ * buffer-pool misses. Compare
+ *     -c 0 -t <n>         one pthread per transaction stream
+ *     -c <cores> -t <n>   the same streams as fibers on <cores> carriers
+ * with -t large enough to keep the disk busy.
+ */
+
+#include <w_stream.h>
+#include <sys/types.h>
+#include <cassert>
+#include <vector>
+#include "sm_vas.h"
+#include "sthread_fiber.h"
+#include "sthread_stats.h"
+#include "w_getopt.h"
+#include "stopwatch.h"
+
+#ifdef SM_FIBERS
+
+ss_m* ssm = 0;
+
+typedef w_rc_t rc_t;
+typedef smlevel_0::smksize_t smksize_t;
+
+// this is implemented in options.cpp
+w_rc_t init_config_options(option_group_t& options,
+                        const char* prog_type,
+                        int& argc, char** argv);
+
+void
+usage(option_group_t& options)
+{
+    cerr << "Usage: server [-h] [options]" << endl;
+    cerr << "       -t <#streams> of transactions (default 16)" << endl;
+    cerr << "       -c <#carriers> to run them on, 0 for pthreads"
+         << " (default 0)" << endl;
+    cerr << "       -n <#transactions> per stream (default 500)" << endl;
+    cerr << "       -r <#reads> per transaction (default 8)" << endl;
+    cerr << "       -h print this message" << endl;
+    cerr << "Valid options are: " << endl;
+    options.print_usage(true, cerr);
+}
+
+enum { ROW_SIZE = 3000 };
+
+
+/* runs read-mostly transactions on random records of the file */
+class smthread_txn_t : public smthread_t
+{
+    const std::vector<rid_t>& _rids;
+    int             _ntrx;
+    int             _nreads;
+    unsigned int    _seed;
+public:
+    rc_t            rc;
+    int             aborts;
+
+    smthread_txn_t(const std::vector<rid_t>& rids, int ntrx, int nreads,
+                   int id)
+        : smthread_t(t_regular, "smthread_txn_t"),
+          _rids(rids), _ntrx(ntrx), _nreads(nreads), _seed(id*7919+1),
+          aborts(0)
+    { }
+    ~smthread_txn_t() { }
+
+    rc_t one_xct();
+    rc_t do_work();
+    void run() { rc = do_work(); }
+};
+
+rc_t smthread_txn_t::one_xct()
+{
+    int sum = 0;
+    for (int j = 0; j < _nreads; j++) {
+        pin_i handle;
+        W_DO(handle.pin(_rids[rand_r(&_seed) % _rids.size()], 0));
+        sum += handle.body()[0];
+    }
+    pin_i handle;
+    W_DO(handle.pin(_rids[rand_r(&_seed) % _rids.size()], 0, EX));
+    W_DO(handle.update_rec(0, vec_t(&sum, sizeof(sum))));
+    return RCOK;
+}
+
+rc_t smthread_txn_t::do_work()
+{
+    for (int i = 0; i < _ntrx; i++) {
+        W_DO(ssm->begin_xct());
+        rc_t e = one_xct();
+        if (e.is_error()) {
+            // the reads and the update can deadlock with other streams
+            if (e.err_num() != smlevel_0::eDEADLOCK) return e;
+            W_DO(ssm->abort_xct());
+            aborts++;
+            continue;
+        }
+        W_DO(ssm->commit_xct(true));
+    }
+    return RCOK;
+}
+
+
+/* create an smthread based class for all sm-related work */
+class smthread_main_t : public smthread_t
+{
+    int        argc;
+    char       **argv;
+public:
+    int        retval;
+
+    smthread_main_t(int ac, char **av)
+        : smthread_t(t_regular, "smthread_main_t"),
+          argc(ac), argv(av), retval(0)
+    { }
+    ~smthread_main_t() { }
+
+    rc_t setup_device_and_volume(const char* device_name,
+                                 smksize_t quota, vid_t& vid);
+    rc_t create_records(const vid_t& vid, int nrecs,
+                        std::vector<rid_t>& rids);
+    void run();
+};
+
+rc_t
+smthread_main_t::setup_device_and_volume(const char* device_name,
+                                         smksize_t quota, vid_t& vid)
+{
+    devid_t     devid;
+    u_int       vol_cnt;
+    lvid_t      lvid;
+
+    vid = 10;
+    cout << "Formatting device: " << device_name
+         << " with a " << quota << "KB quota ..." << endl;
+    W_DO(ssm->format_dev(device_name, quota, true));
+    W_DO(ssm->mount_dev(device_name, vol_cnt, devid));
+    W_DO(ssm->generate_new_lvid(lvid));
+    W_DO(ssm->create_vol(device_name, lvid, quota, false, vid));
+    return RCOK;
+}
+
+rc_t
+smthread_main_t::create_records(const vid_t& vid, int nrecs,
+                                std::vector<rid_t>& rids)
+{
+    stid_t fid;
+    W_DO(ssm->begin_xct());
+    W_DO(ssm->create_file(vid, fid, smlevel_3::t_regular));
+
+    char row[ROW_SIZE];
+    memset(row, '\0', sizeof(row));
+    const vec_t data(row, sizeof(row));
+    rid_t rid;
+    for (int i = 0; i < nrecs; i++) {
+        W_DO(ssm->create_rec(fid, vec_t(), sizeof(row), data, rid));
+        rids.push_back(rid);
+        if ((i+1) % 2000 == 0) {
+            // keep the log from filling up
+            W_DO(ssm->commit_xct());
+            W_DO(ssm->begin_xct());
+        }
+    }
+    W_DO(ssm->commit_xct());
+    // start from a cold buffer pool
+    W_DO(ssm->force_buffers(true));
+    cout << "Created " << nrecs << " records of "
+         << ROW_SIZE << " bytes" << endl;
+    return RCOK;
+}
+
+void smthread_main_t::run()
+{
+    rc_t rc;
+
+    option_t* opt_device_name = 0;
+    option_t* opt_device_quota = 0;
+    option_t* opt_num_rec = 0;
+
+    const int option_level_cnt = 3;
+    option_group_t options(option_level_cnt);
+
+    W_COERCE(options.add_option("device_name", "device/file name",
+                         NULL, "device containg the volume",
+                         true, option_t::set_value_charstr,
+                         opt_device_name));
+
+    W_COERCE(options.add_option("device_quota", "# > 1000",
+                         "2000", "quota for device",
+                         false, option_t::set_value_long,
+                         opt_device_quota));
+
+    W_COERCE(options.add_option("num_rec", "# > 0",
+                         NULL, "number of records in the file",
+                         true, option_t::set_value_long,
+                         opt_num_rec));
+
+    // have the SSM add its options to the group
+    W_COERCE(ss_m::setup_options(&options));
+
+    rc = init_config_options(options, "server", argc, argv);
+    if (rc.is_error()) {
+        usage(options);
+        retval = 1;
+        return;
+    }
+
+    int nstreams(16);
+    int ncarriers(0);
+    int ntrx(500);
+    int nreads(8);
+    int option;
+    while ((option = getopt(argc, argv, "t:c:n:r:h")) != -1) {
+        switch (option) {
+        case 't' :
+            nstreams = strtol(optarg, 0, 0);
+            break;
+        case 'c' :
+            ncarriers = strtol(optarg, 0, 0);
+            break;
+        case 'n' :
+            ntrx = strtol(optarg, 0, 0);
+            break;
+        case 'r' :
+            nreads = strtol(optarg, 0, 0);
+            break;
+        case 'h' :
+        default:
+            usage(options);
+            retval = 1;
+            return;
+        }
+    }
+
+    ssm = new ss_m();
+    if (!ssm) {
+        cerr << "Error: Out of memory for ss_m" << endl;
+        retval = 1;
+        return;
+    }
+
+    vid_t vid;
+    std::vector<rid_t> rids;
+    W_COERCE(setup_device_and_volume(opt_device_name->value(),
+                strtol(opt_device_quota->value(), 0, 0), vid));
+    W_COERCE(create_records(vid, strtol(opt_num_rec->value(), 0, 0), rids));
+
+    std::vector<sthread_carrier_t*> carriers;
+    for (int i = 0; i < ncarriers; i++) {
+        carriers.push_back(new sthread_carrier_t);
+    }
+
+    w_base_t::base_stat_t reads = STH_STATS(read);
+    stopwatch_t timer;
+    std::vector<smthread_txn_t*> workers;
+    int aborts = 0;
+    for (int i = 0; i < nstreams; i++) {
+        workers.push_back(new smthread_txn_t(rids, ntrx, nreads, i+1));
+        if (ncarriers > 0) {
+            W_COERCE(workers[i]->fork(*carriers[i % ncarriers]));
+        } else {
+            W_COERCE(workers[i]->fork());
+        }
+    }
+    for (int i = 0; i < nstreams; i++) {
+        W_COERCE(workers[i]->join());
+        W_COERCE(workers[i]->rc);
+        aborts += workers[i]->aborts;
+        delete workers[i];
+    }
+    double secs = timer.time();
+    reads = STH_STATS(read) - reads;
+
+    for (int i = 0; i < ncarriers; i++) {
+        delete carriers[i];
+    }
+
+    cout << "Streams: " << nstreams << " on ";
+    if (ncarriers > 0) {
+        cout << ncarriers << " carriers" << endl;
+    } else {
+        cout << "pthreads" << endl;
+    }
+    cout << "Transactions: " << nstreams*ntrx - aborts << " in " << secs
+         << " secs (" << (nstreams*ntrx - aborts)/secs << " tps), "
+         << aborts << " aborted" << endl;
+    cout << "Page reads: " << reads << " (" << reads/secs
+         << " per sec)" << endl;
+
+    delete ssm;
+}
+
+int
+main(int argc, char* argv[])
+{
+    smthread_main_t *smtu = new smthread_main_t(argc, argv);
+    if (!smtu)
+        W_FATAL(fcOUTOFMEMORY);
+
+    w_rc_t e = smtu->fork();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+    e = smtu->join();
+    if(e.is_error()) {
+        cerr << "error forking thread: " << e <<endl;
+        return 1;
+    }
+
+    int rv = smtu->retval;
+    delete smtu;
+
+    return rv;
+}
+
+#else
+
+int
+main()
+{
+    cout << "fibers not compiled in (configure --enable-fibers)" << endl;
+    return 0;
+}
+
+#endif /* SM_FIBERS */
@@ -1121,6 +1121,7 @@ vol_t::dismount(bool flush)
 
     INC_TSTAT(vol_cache_clears);
     _free_ext_cache.shutdown(); 
+    memset(_resv_pools, 0, sizeof(_resv_pools));
 
     /*
      *  Flush or force all pages of the volume cached in bf.
@@ -2125,6 +2126,193 @@ vol_t::alloc_exts(
     return RCOK;
 }
 
+/*********************************************************************
+ *
+ *  vol_t::reserve_exts(snum, cnt, exts)
+ *
+ *  The "cnt" extents in "exts" were just allocated to store "snum"
+ *  by alloc_exts and no page was allocated in them.  Keep them in
+ *  the store instead of letting the release of the extent locks free
+ *  them again at the end of the transaction; the caller then hands
+ *  them out with put_reserved_exts.
+ *
+ *  Nothing is logged here: the extents' allocation to the store was
+ *  logged by alloc_exts.  An extent is freed at restart if it is still
+ *  empty (free_exts_during_recovery), or when a transaction frees the
+ *  last page allocated in it.
+ *
+ *********************************************************************/
+rc_t
+vol_t::reserve_exts(
+    snum_t                 snum,
+    int                    cnt, 
+    const extnum_t         exts[])
+{
+    FUNC(vol_t::reserve_exts);
+
+    for(int i=0; i < cnt; i++) {
+        w_assert1(is_alloc_ext_of(exts[i], snum));
+
+        extid_t extid;
+        extid.vol = _vid;
+        extid.ext = exts[i];
+
+        // We hold the IX lock from find_free_exts; this just gets
+        // at the lock's name to mark it the way alloc_pages_in_ext does.
+        lockid_t* name = 0;
+        W_DO( lm->lock(extid, IX, t_long, WAIT_IMMEDIATE, 0, 0, &name) );
+        name->set_ext_has_page_alloc(true);
+    }
+    ADD_TSTAT(vol_resv_exts, cnt);
+
+    return RCOK;
+}
+
+/*********************************************************************
+ *
+ *  Reserved extent pools
+ *
+ *  A store that keeps growing gets a pool of empty extents reserved
+ *  for it (want_reserved_exts).  io_m takes them one at a time
+ *  (take_reserved_ext) and allocates pages in them without the volume
+ *  mutex; the extent reserver thread in sm_io.cpp refills the pools
+ *  (reserved_exts_wanted, put_reserved_exts).
+ *
+ *  None of this takes a lock.  A pool belongs to the store whose
+ *  number was swapped into it, and an extent to the thread that
+ *  swapped it out.  Only the reserver thread puts extents in.
+ *  An extent can be freed while it sits in a pool (the store was
+ *  destroyed, or a transaction freed it when it found it empty), so
+ *  whoever takes one checks its owner under the extent lock
+ *  (lock_reserved_ext) before using it.
+ *
+ *********************************************************************/
+vol_t::resv_pool_t*
+vol_t::_resv_pool(snum_t snum)
+{
+    for(int i=0; i < max_resv_stores; i++) {
+        if(_resv_pools[i].snum == snum) return &_resv_pools[i];
+    }
+    return 0;
+}
+
+bool
+vol_t::take_reserved_ext(snum_t snum, extnum_t& ext, bool& low)
+{
+    ext = 0;
+    low = false;
+    resv_pool_t* pool = _resv_pool(snum);
+    if(!pool) return false;
+
+    int left = 0;
+    for(int i=0; i < max_resv_exts; i++) {
+        extnum_t e = pool->exts[i];
+        if(e == 0) continue;
+        if(ext == 0) {
+            if(atomic_cas_32(&pool->exts[i], e, 0) == e) ext = e;
+            continue;
+        }
+        left++;
+    }
+
+    // Ask for a refill when half the reservation is gone
+    if(left <= smlevel_0::ext_reservation / 2 && pool->snum == snum) {
+        low = (atomic_cas_32(&pool->wanted, 0, 1) == 0);
+    }
+    return ext != 0;
+}
+
+bool
+vol_t::want_reserved_exts(snum_t snum)
+{
+    resv_pool_t* pool = _resv_pool(snum);
+    for(int i=0; !pool && i < max_resv_stores; i++) {
+        if(atomic_cas_32(&_resv_pools[i].snum, 0, snum) == 0) {
+            pool = &_resv_pools[i];
+        }
+    }
+    if(!pool) return false; // too many growing stores
+    return (atomic_cas_32(&pool->wanted, 0, 1) == 0);
+}
+
+int
+vol_t::reserved_exts_wanted(snum_t& snum)
+{
+    for(int i=0; i < max_resv_stores; i++) {
+        resv_pool_t& pool = _resv_pools[i];
+        if(pool.wanted == 0 || atomic_cas_32(&pool.wanted, 1, 0) != 1) {
+            continue;
+        }
+        snum = pool.snum;
+        if(snum == 0) continue;
+
+        int held = 0;
+        for(int j=0; j < max_resv_exts; j++) {
+            if(pool.exts[j]) held++;
+        }
+        if(held < smlevel_0::ext_reservation) {
+            return smlevel_0::ext_reservation - held;
+        }
+    }
+    return 0;
+}
+
+int
+vol_t::put_reserved_exts(snum_t snum, int cnt, const extnum_t exts[])
+{
+    resv_pool_t* pool = _resv_pool(snum);
+    if(!pool) return 0; // dropped meanwhile
+
+    int put = 0;
+    for(int j=0; put < cnt && j < max_resv_exts; j++) {
+        if(pool->exts[j] == 0) {
+            // Takers only ever clear a slot, so this cannot race
+            pool->exts[j] = exts[put++];
+        }
+    }
+    membar_producer();
+    return put;
+}
+
+void
+vol_t::drop_reserved_exts(snum_t snum)
+{
+    resv_pool_t* pool = _resv_pool(snum);
+    if(!pool) return;
+    for(int j=0; j < max_resv_exts; j++) {
+        pool->exts[j] = 0;
+    }
+    pool->wanted = 0;
+    membar_producer();
+    pool->snum = 0;
+}
+
+/*********************************************************************
+ *
+ *  vol_t::lock_reserved_ext(snum, ext, ok)
+ *
+ *  Lock an extent taken from a pool for page allocation and tell,
+ *  in "ok", if it still belongs to store "snum". The extent is not
+ *  freed while we hold the lock.
+ *
+ *********************************************************************/
+rc_t
+vol_t::lock_reserved_ext(snum_t snum, extnum_t ext, bool& ok)
+{
+    ok = false;
+    extid_t extid;
+    extid.vol = _vid;
+    extid.ext = ext;
+
+    w_rc_t rc = lm->lock(extid, IX, t_long, WAIT_IMMEDIATE);
+    if(rc.is_error()) {
+        if(rc.err_num() == eLOCKTIMEOUT) return RCOK; // being freed
+        return rc.reset();
+    }
+    ok = is_alloc_ext_of(ext, snum);
+    return RCOK;
+}
+
 /*********************************************************************
  *
  *  rc_t vol_t::update_ext_histo()
@@ -2543,6 +2731,7 @@ vol_t::free_store(snum_t snum, bool acquire_lock)
     }
 
     _free_ext_cache.erase_all(snum); 
+    drop_reserved_exts(snum);
     return RCOK;
 }
 
@@ -2596,6 +2785,7 @@ vol_t::free_store_after_xct(snum_t snum)
     W_DO( store_operation(param) );
 
     _free_ext_cache.erase_all(snum); 
+    drop_reserved_exts(snum);
 
     return RCOK;
 }
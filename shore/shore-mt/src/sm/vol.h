@@ -230,6 +230,10 @@ public:
         int                  cnt,
         const extnum_t       exts[]);
 
+    rc_t            reserve_exts(
+        snum_t               num,
+        int                  cnt,
+        const extnum_t       exts[]);
 
     rc_t            update_ext_histo(const lpid_t& pid, space_bucket_t b);
     rc_t            next_ext(extnum_t ext, extnum_t &res);
@@ -556,6 +560,30 @@ private:
     // cache of reserved pages in extents by store number:
     ext_cache_t&             free_ext_cache() { return _free_ext_cache; }
 
+    /*
+     * Pools of empty extents reserved for growing stores, handed out
+     * without the volume mutex (see vol.cpp).
+     */
+    enum { max_resv_stores = 16, max_resv_exts = 64 };
+    bool                     take_reserved_ext(
+                                snum_t s, extnum_t &ext, bool &low);
+    bool                     want_reserved_exts(snum_t s);
+    int                      reserved_exts_wanted(snum_t &s);
+    int                      put_reserved_exts(
+                                snum_t s, int cnt, const extnum_t exts[]);
+    void                     drop_reserved_exts(snum_t s);
+    rc_t                     lock_reserved_ext(
+                                snum_t s, extnum_t ext, bool &ok);
+ private:
+    struct resv_pool_t {
+        snum_t volatile      snum;   // 0 if the pool is free
+        uint4_t volatile     wanted; // 1 if a refill was asked for
+        extnum_t volatile    exts[max_resv_exts]; // 0 if taken
+    };
+    resv_pool_t              _resv_pools[max_resv_stores];
+    resv_pool_t*             _resv_pool(snum_t s);
+ public:
+
 
     static const char*       prolog[]; // string array for volume hdr
 
@@ -580,7 +608,9 @@ inline vol_t::vol_t(const bool apply_fake_io_latency, const int fake_disk_latenc
              : _unix_fd(-1), _min_free_ext_num(1),
                _apply_fake_disk_latency(apply_fake_io_latency), 
                _fake_disk_latency(fake_disk_latency) // IP: default fake io values
-{}
+{
+    memset(_resv_pools, 0, sizeof(_resv_pools));
+}
 
 inline vol_t::~vol_t() { 
     shutdown();
@@ -89,6 +89,10 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "sthread_stats.h"
 #include <sdisk.h>
 #include <sdisk_unix.h>
+#include <sdisk_overlay.h>
+#ifdef SM_FIBERS
+#include "sthread_fiber.h"
+#endif
 
 #if defined(HUGEPAGESIZE) && (HUGEPAGESIZE == 0)
 #undef HUGEPAGESIZE
@@ -839,7 +843,10 @@ sthread_t::open(const char* path, int flags, int mode, int &ret_fd)
         pointer in array, unlocking here, opening, etc */
 
     if (open_local) {
-        e = sdisk_unix_t::make(path, flags, mode, dp);
+        if (sdisk_overlay_t::has_base(path))
+            e = sdisk_overlay_t::make(path, flags, mode, dp);
+        else
+            e = sdisk_unix_t::make(path, flags, mode, dp);
     }
 
 
@@ -1010,6 +1017,18 @@ w_rc_t    sthread_t::pread(int fd, void *buf, int n, fileoff_t pos)
     w_rc_t    e;
 
     errno = 0;
+#ifdef SM_FIBERS
+    if(sthread_carrier_t::on_fiber()) {
+        sthread_io_request_t req;
+        req.op = sthread_io_request_t::t_pread;
+        req.disk = _disks[fd];
+        req.buf = buf;
+        req.n = n;
+        req.pos = pos;
+        e = sthread_carrier_t::_io(req);
+        done = req.done;
+    } else
+#endif
     e = _disks[fd]->pread(buf, n, pos, done);
     if (!e.is_error() && done != n) {
         e = RC2(stSHORTIO, done);
@@ -1030,6 +1049,18 @@ w_rc_t    sthread_t::pwrite(int fd, const void *buf, int n, fileoff_t pos)
     int    done = 0;
     w_rc_t    e;
 
+#ifdef SM_FIBERS
+    if(sthread_carrier_t::on_fiber()) {
+        sthread_io_request_t req;
+        req.op = sthread_io_request_t::t_pwrite;
+        req.disk = _disks[fd];
+        req.buf = (void*) buf;
+        req.n = n;
+        req.pos = pos;
+        e = sthread_carrier_t::_io(req);
+        done = req.done;
+    } else
+#endif
     e = _disks[fd]->pwrite(buf, n, pos, done);
     if (!e.is_error() && done != n)
         e = RC(stSHORTIO);
@@ -1047,6 +1078,17 @@ w_rc_t    sthread_t::fsync(int fd)
     w_rc_t        e;
     INC_STH_STATS(sync);
 
+#ifdef SM_FIBERS
+    if(sthread_carrier_t::on_fiber()) {
+        sthread_io_request_t req;
+        req.op = sthread_io_request_t::t_fsync;
+        req.disk = _disks[fd];
+        req.buf = NULL;
+        req.n = 0;
+        req.pos = 0;
+        e = sthread_carrier_t::_io(req);
+    } else
+#endif
     e = _disks[fd]->sync();
 
     return e;
@@ -29,27 +29,32 @@
 #include "mcs_lock.h"
 #include "sthread.h"
 #include "srwlock.h"
+#include "sthread_fiber.h"
+
+/* A fiber spinning on a lock lets the other fibers of its carrier
+ * run: the holder may be one of them. (Nothing without SM_FIBERS.)
+ */
 
 void mcs_lock::spin_on_waiting(qnode* me) {
-    while(me->vthis()->_waiting) ;
+    while(me->vthis()->_waiting) FIBER_SPIN_PAUSE();
 }
 
 mcs_lock::qnode* mcs_lock::spin_on_next(qnode* me) {
     qnode* next;
-    while(!(next=me->vthis()->_next)) ;
+    while(!(next=me->vthis()->_next)) FIBER_SPIN_PAUSE();
     return next;
 }
 
 
 void mcs_rwlock::_spin_on_writer() 
 {
-    while(has_writer()) ;
+    while(has_writer()) FIBER_SPIN_PAUSE();
     // callers do membar_enter
 }
 
 void mcs_rwlock::_spin_on_readers() 
 {
-    while(has_reader()) ;
+    while(has_reader()) FIBER_SPIN_PAUSE();
     // callers do membar_enter
 }
 
@@ -64,10 +69,10 @@ void occ_rwlock::acquire_read()
             
             // nasty race: we could have fooled a writer into sleeping...
             if(count == WRITER)
-                DO_PTHREAD(pthread_cond_signal(&_write_cond));
+                sthread_t::cond_signal(_write_cond);
             
             while(*&_active_count & WRITER) {
-                DO_PTHREAD(pthread_cond_wait(&_read_cond, &_read_write_mutex));
+                sthread_t::cond_wait(_read_cond, _read_write_mutex);
             }
         }
         count = atomic_add_32_nv(&_active_count, READER);
@@ -80,7 +85,7 @@ void occ_rwlock::acquire_write()
     // only one writer allowed in at a time...
     CRITICAL_SECTION(cs, _read_write_mutex);    
     while(*&_active_count & WRITER) {
-        DO_PTHREAD(pthread_cond_wait(&_read_cond, &_read_write_mutex));
+        sthread_t::cond_wait(_read_cond, _read_write_mutex);
     }
     
     // any lurking writers are waiting on the cond var
@@ -89,9 +94,9 @@ void occ_rwlock::acquire_write()
 
     // drain readers
     while(count != WRITER) {
-        DO_PTHREAD(pthread_cond_wait(&_write_cond, &_read_write_mutex));
+        sthread_t::cond_wait(_write_cond, _read_write_mutex);
         count = *&_active_count;
     }
 }
 
-void tatas_lock::spin() { while(*&(_holder.handle)) ; }
+void tatas_lock::spin() { while(*&(_holder.handle)) FIBER_SPIN_PAUSE(); }
@@ -0,0 +1,433 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/* Copy-on-write files over a base image. See sdisk_overlay.h */
+
+#if defined(linux) && !defined(_GNU_SOURCE)
+/* for SEEK_DATA and SEEK_HOLE */
+#define _GNU_SOURCE
+#endif
+
+#include <w.h>
+#include <sthread.h>
+#include <sdisk.h>
+#include <sdisk_unix.h>
+#include <sdisk_overlay.h>
+
+#include "os_fcntl.h"
+#include <cerrno>
+#include <string>
+#include <sys/stat.h>
+
+#include <os_interface.h>
+
+/**\cond skip */
+
+const int stBADFD = sthread_base_t::stBADFD;
+const int stINVAL = sthread_base_t::stINVAL;
+const int stSHORTIO = sthread_base_t::stSHORTIO;
+
+const char* sdisk_overlay_t::base_suffix = ".base";
+
+
+bool    sdisk_overlay_t::has_base(const char *name)
+{
+    std::string    base(name);
+    base += base_suffix;
+    os_stat_t    st;
+    return ::os_stat(base.c_str(), &st) == 0;
+}
+
+
+sdisk_overlay_t::sdisk_overlay_t()
+: _delta(0), _base(0), _base_size(0), _size(0), _pos(0),
+  _chunk(MIN_CHUNK)
+{
+}
+
+
+sdisk_overlay_t::~sdisk_overlay_t()
+{
+    if (_delta)
+        W_COERCE(close());
+}
+
+
+w_rc_t    sdisk_overlay_t::make(const char *name, int flags, int mode,
+               sdisk_t *&disk)
+{
+    sdisk_overlay_t    *od;
+    w_rc_t        e;
+
+    disk = 0;    /* default value*/
+
+    od = new sdisk_overlay_t;
+    if (!od)
+        return RC(fcOUTOFMEMORY);
+
+    e = od->open(name, flags, mode);
+    if (e.is_error()) {
+        delete od;
+        return e;
+    }
+
+    disk = od;
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::open(const char *name, int flags, int mode)
+{
+    if (_delta)
+        return RC(stBADFD);    /* XXX in use */
+
+    std::string    base(name);
+    base += base_suffix;
+
+    sdisk_t    *d;
+    W_DO(sdisk_unix_t::make(name, flags, mode, d));
+    _delta = (sdisk_unix_t *) d;
+
+    w_rc_t    e = sdisk_unix_t::make(base.c_str(), OPEN_RDONLY, 0, d);
+    if (e.is_error()) {
+        W_IGNORE(close());
+        return e;
+    }
+    _base = (sdisk_unix_t *) d;
+
+    filestat_t    st;
+    W_DO(_base->stat(st));
+    // a truncated file has nothing left of the base
+    _base_size = hasOption(flags, OPEN_TRUNC) ? 0 : st.st_size;
+
+    W_DO(_delta->stat(st));
+    _size = (st.st_size > _base_size) ? st.st_size : _base_size;
+    _pos = 0;
+
+    // whole blocks of the file system, so that a chunk is either
+    // all hole or all data
+    _chunk = MIN_CHUNK;
+    while (st.st_block_size && (_chunk % st.st_block_size))
+        _chunk *= 2;
+
+    return _load_present();
+}
+
+
+w_rc_t    sdisk_overlay_t::close()
+{
+    if (!_delta)
+        return RC(stBADFD);    /* XXX closed */
+
+    w_rc_t    e = _delta->close();
+    delete _delta;
+    _delta = 0;
+    if (_base) {
+        w_rc_t    eb = _base->close();
+        if (!e.is_error())
+            e = eb;
+        delete _base;
+        _base = 0;
+    }
+    _present.clear();
+    return e;
+}
+
+
+/*
+ * The chunks that are not holes of the delta were written,
+ * so they are to be read from the delta.
+ */
+w_rc_t    sdisk_overlay_t::_load_present()
+{
+    int    fd = _delta->fd();
+    fileoff_t    off = 0;
+
+    _present.assign((_size + _chunk - 1) / _chunk, false);
+
+    while (off < _size) {
+        fileoff_t    data = ::os_lseek(fd, off, SEEK_DATA);
+        if (data == -1) {
+            if (errno == ENXIO)
+                break;    // only a hole to the end
+            w_rc_t rc = RC(fcOS);
+            RC_APPEND_MSG(rc, << "Cannot find the holes of "
+                    << _delta->path());
+            return rc;
+        }
+        fileoff_t    hole = ::os_lseek(fd, data, SEEK_HOLE);
+        if (hole == -1)
+            return RC(fcOS);
+        for (fileoff_t c = data / _chunk; c * _chunk < hole; c++)
+            _set_present(c);
+        off = hole;
+    }
+
+    return RCOK;
+}
+
+
+bool    sdisk_overlay_t::_is_present(fileoff_t chunk)
+{
+    CRITICAL_SECTION(cs, _lock);
+    return (size_t) chunk < _present.size() && _present[chunk];
+}
+
+
+void    sdisk_overlay_t::_set_present(fileoff_t chunk)
+{
+    if ((size_t) chunk >= _present.size())
+        _present.resize(chunk + 1, false);
+    _present[chunk] = true;
+}
+
+
+/* bytes of the base, zeros past its end */
+w_rc_t    sdisk_overlay_t::_read_base(char *buf, int count, fileoff_t pos)
+{
+    int    done = 0;
+    while (done < count && pos + done < _base_size) {
+        int    n;
+        fileoff_t    left = _base_size - (pos + done);
+        int    want = (left < count - done) ? int(left) : count - done;
+        W_DO(_base->pread(buf + done, want, pos + done, n));
+        if (n == 0)
+            break;    // the base shrank under us
+        done += n;
+    }
+    if (done < count)
+        memset(buf + done, 0, count - done);
+    return RCOK;
+}
+
+
+/*
+ * First write of part of a chunk: the chunk goes to the delta as a
+ * whole, with the rest of it from the base.
+ */
+w_rc_t    sdisk_overlay_t::_copy_up(const char *buf, int count, fileoff_t pos)
+{
+    fileoff_t    start = (pos / _chunk) * _chunk;
+    w_assert1(pos + count <= start + _chunk);
+
+    CRITICAL_SECTION(cs, _lock);
+    if ((size_t)(start / _chunk) < _present.size()
+            && _present[start / _chunk]) {
+        // someone else copied it up meanwhile
+        cs.exit();
+        int    n;
+        return _delta->pwrite(buf, count, pos, n);
+    }
+
+    // not past the end of the file
+    fileoff_t    end = start + _chunk;
+    fileoff_t    file_end = (_size > pos + count) ? _size : pos + count;
+    if (end > file_end)
+        end = file_end;
+
+    // aligned, in case the delta is open with OPEN_RAW
+    void    *chunk;
+    if (posix_memalign(&chunk, MIN_CHUNK, _chunk))
+        return RC(fcOUTOFMEMORY);
+    int    n = 0;
+    w_rc_t    e = _read_base((char *) chunk, int(end - start), start);
+    if (!e.is_error()) {
+        memcpy((char *) chunk + (pos - start), buf, count);
+        e = _delta->pwrite(chunk, int(end - start), start, n);
+    }
+    free(chunk);
+    W_DO(e);
+    if (n != end - start)
+        return RC(stSHORTIO);
+    _set_present(start / _chunk);
+    if (end > _size)
+        _size = end;
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::pread(void *buf, int count, fileoff_t pos,
+               int &done)
+{
+    if (!_delta)
+        return RC(stBADFD);
+
+    char    *b = (char *) buf;
+    fileoff_t    size = _size;
+    if (pos + count > size)
+        count = (pos >= size) ? 0 : int(size - pos);
+
+    done = 0;
+    while (done < count) {
+        // a run of chunks all in the delta, or all in the base
+        fileoff_t    at = pos + done;
+        bool    in_delta = _is_present(at / _chunk);
+        fileoff_t    end = (at / _chunk + 1) * _chunk;
+        while (end < pos + count && _is_present(end / _chunk) == in_delta)
+            end += _chunk;
+        if (end > pos + count)
+            end = pos + count;
+        int    len = int(end - at);
+
+        if (in_delta) {
+            int    n;
+            W_DO(_delta->pread(b + done, len, at, n));
+            done += n;
+            if (n != len)
+                break;
+        }
+        else {
+            W_DO(_read_base(b + done, len, at));
+            done += len;
+        }
+    }
+
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::pwrite(const void *buf, int count, fileoff_t pos,
+                int &done)
+{
+    if (!_delta)
+        return RC(stBADFD);
+
+    const char    *b = (const char *) buf;
+
+    done = 0;
+    while (done < count) {
+        fileoff_t    at = pos + done;
+        fileoff_t    c = at / _chunk;
+        int    off = int(at - c * _chunk);
+        int    len = (count - done < _chunk - off) ? count - done
+                                                   : _chunk - off;
+
+        if (off == 0 && len == _chunk) {
+            // whole chunks need nothing of the base
+            while (done + len + _chunk <= count)
+                len += _chunk;
+        }
+        else if (!_is_present(c)) {
+            W_DO(_copy_up(b + done, len, at));
+            done += len;
+            continue;
+        }
+
+        int    n;
+        W_DO(_delta->pwrite(b + done, len, at, n));
+        {
+            CRITICAL_SECTION(cs, _lock);
+            for (fileoff_t i = c; i * _chunk < at + n; i++)
+                _set_present(i);
+            if (at + n > _size)
+                _size = at + n;
+        }
+        done += n;
+        if (n != len)
+            break;
+    }
+
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::read(void *buf, int count, int &done)
+{
+    W_DO(pread(buf, count, _pos, done));
+    _pos += done;
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::write(const void *buf, int count, int &done)
+{
+    W_DO(pwrite(buf, count, _pos, done));
+    _pos += done;
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::seek(fileoff_t pos, int origin, fileoff_t &newpos)
+{
+    if (!_delta)
+        return RC(stBADFD);
+
+    switch (origin) {
+    case SEEK_AT_SET:
+        break;
+    case SEEK_AT_CUR:
+        pos += _pos;
+        break;
+    case SEEK_AT_END:
+        pos += _size;
+        break;
+    default:
+        return RC(stINVAL);
+    }
+    if (pos < 0)
+        return RC(stINVAL);
+
+    newpos = _pos = pos;
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::truncate(fileoff_t size)
+{
+    if (!_delta)
+        return RC(stBADFD);
+
+    W_DO(_delta->truncate(size));
+
+    CRITICAL_SECTION(cs, _lock);
+    // what is cut off of the base is gone, even if the file grows again
+    if (_base_size > size)
+        _base_size = size;
+    _size = size;
+    _present.resize((size + _chunk - 1) / _chunk, false);
+    return RCOK;
+}
+
+
+w_rc_t    sdisk_overlay_t::sync()
+{
+    if (!_delta)
+        return RC(stBADFD);
+    return _delta->sync();
+}
+
+
+w_rc_t    sdisk_overlay_t::stat(filestat_t &st)
+{
+    if (!_delta)
+        return RC(stBADFD);
+    W_DO(_delta->stat(st));
+    st.st_size = _size;
+    return RCOK;
+}
+
+/**\endcond skip */
@@ -0,0 +1,108 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#ifndef SDISK_OVERLAY_H
+#define SDISK_OVERLAY_H
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+#include <vector>
+
+class sdisk_unix_t;
+
+/**\cond skip */
+
+/*
+ * A copy-on-write file on top of a read-only base image.
+ *
+ * The file itself (the "delta") is sparse. Next to it, <name>.base
+ * names (usually as a symlink) the base image, e.g. a clean and
+ * checkpointed volume. A chunk of the file that was never written
+ * is a hole in the delta and is read from the base; the first write
+ * to a chunk copies the rest of it from the base, so afterwards the
+ * whole chunk is in the delta. Hence which chunks are in the delta is
+ * known from the holes of the file (SEEK_DATA/SEEK_HOLE), and nothing
+ * but the delta has to be kept across opens.
+ *
+ * Restoring a volume from the base is then creating an empty sparse
+ * file of the size of the base, instead of copying the whole image.
+ * sthread_t::open() uses an overlay for a file whenever <name>.base
+ * exists.
+ */
+class sdisk_overlay_t : public sdisk_t {
+    sdisk_unix_t*    _delta;
+    sdisk_unix_t*    _base;
+    fileoff_t        _base_size;  // bytes of the base still visible
+    fileoff_t        _size;
+    fileoff_t        _pos;        // for read/write/seek
+    int              _chunk;      // bytes, a multiple of the fs block
+
+    // chunks in the delta; also serializes copying a chunk up
+    std::vector<bool> _present;
+    queue_based_lock_t _lock;
+
+    enum { MIN_CHUNK = 8192 };   // the default page size of the sm
+
+    sdisk_overlay_t();
+
+    bool      _is_present(fileoff_t chunk);
+    void      _set_present(fileoff_t chunk);
+    w_rc_t    _load_present();
+    w_rc_t    _read_base(char* buf, int count, fileoff_t pos);
+    w_rc_t    _copy_up(const char* buf, int count, fileoff_t pos);
+
+public:
+    static    const char* base_suffix;
+
+    // true if name has a base image next to it
+    static    bool    has_base(const char *name);
+
+    static    w_rc_t    make(const char *name,
+                 int flags, int mode,
+                 sdisk_t *&disk);
+    ~sdisk_overlay_t();
+
+    w_rc_t    open(const char *name, int flags, int mode);
+    w_rc_t    close();
+
+    w_rc_t    read(void *buf, int count, int &done);
+    w_rc_t    write(const void *buf, int count, int &done);
+
+    w_rc_t    pread(void *buf, int count, fileoff_t pos, int &done);
+    w_rc_t    pwrite(const void *buf, int count, fileoff_t pos, int &done);
+
+    w_rc_t    seek(fileoff_t pos, int origin, fileoff_t &newpos);
+
+    w_rc_t    truncate(fileoff_t size);
+
+    w_rc_t    sync();
+
+    w_rc_t    stat(filestat_t &st);
+};
+/**\endcond skip */
+
+/*<std-footer incl-file-exclusion='SDISK_OVERLAY_H'>  -- do not edit anything below this line -- */
+
+#endif          /*</std-footer>*/
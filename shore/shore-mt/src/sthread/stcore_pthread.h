@@ -59,6 +59,8 @@ typedef struct sthread_core_t {
     void        *start_arg;        /* argument for start_proc */
     int         stack_size;        /* stack size */
     void        *sthread;        /* sthread which uses this core */
+    int          is_started;        /* TRUE once the pthread or fiber exists */
+    struct sthread_fiber_t *fiber;  /* non-NULL if it runs on a carrier */
     pthread_t   pthread;
     pthread_t   creator;         /* thread that created this pthread, for
                                     debugging only */
@@ -71,6 +73,8 @@ extern int  sthread_core_init(sthread_core_t* t,
                               void (*proc)(void *), void *arg,
                               unsigned stack_size);
 
+extern int  sthread_core_start(sthread_core_t* t);
+
 extern void sthread_core_exit(sthread_core_t *t, bool &joined);
 
 /*<std-footer incl-file-exclusion='STCORE_PTHREAD_H'>  -- do not edit anything below this line -- */
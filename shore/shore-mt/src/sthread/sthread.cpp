@@ -104,6 +104,9 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include "rand48.h"
 #include "sthread_stats.h"
 #include "stcore_pthread.h"
+#ifdef SM_FIBERS
+#include "sthread_fiber.h"
+#endif
 
 #ifdef PURIFY
 #include <purify.h>
@@ -504,6 +507,27 @@ sthread_t::join(timeout_in_ms /*timeout*/)
  */
 
 w_rc_t    sthread_t::fork()
+{
+    return _fork(NULL);
+}
+
+#ifdef SM_FIBERS
+w_rc_t    sthread_t::fork(sthread_carrier_t &carrier)
+{
+    return _fork(&carrier);
+}
+#endif
+
+bool sthread_t::is_fiber() const
+{
+#ifdef SM_FIBERS
+    return _core->fiber != NULL;
+#else
+    return false;
+#endif
+}
+
+w_rc_t    sthread_t::_fork(sthread_carrier_t* carrier)
 {
     {
         sthread_init_t::do_init();
@@ -531,6 +555,20 @@ w_rc_t    sthread_t::fork()
             DO_PTHREAD( pthread_cond_signal(_start_cond) );
         }
     }
+
+    if(this != _main_thread) {
+#ifdef SM_FIBERS
+        if(carrier) {
+            carrier->_spawn(this);
+        } else
+#else
+        w_assert0(!carrier); // only fork(sthread_carrier_t&) passes one
+#endif
+        if(sthread_core_start(_core) == -1) {
+            cerr << "sthread_t: cannot start thread core" << endl;
+            W_FATAL(stINTERNAL);
+        }
+    }
 #if TRACE_START_TERM
     {   w_ostrstream o;
         o << *this << endl;
@@ -726,6 +764,19 @@ void    sthread_t::__start(void *arg)
     me_lval() = t;
     t->_start_frame = &t; // used to gauge danger of stack overflow
 
+#ifdef SM_FIBERS
+    if(t->_core->fiber) {
+        // the carrier allocated the stack, no need to guess
+        char*  low;
+        size_t sz;
+        sthread_carrier_t::stack_bounds(t->_core->fiber, low, sz);
+        t->_stack_size = sz;
+        t->_danger = (void *)(low + sz/8);
+        t->_start();
+        return;
+    }
+#endif
+
 #ifndef PTHREAD_STACK_MIN
     size_t PTHREAD_STACK_MIN = get_pthread_stack_min();
 #endif
@@ -796,6 +847,10 @@ void sthread_t::_start()
 {
     pid_t tid = gettid();
     std::cerr << "Starting " << name() << " (tid = " << tid << ")" << std::endl;
+#ifdef SM_FIBERS
+    // a fiber shares the thread-local storage of its carrier
+    if(!_core->fiber)
+#endif
     tls_tricks::tls_manager::thread_init();
     w_assert1(me() == this);
  
@@ -880,6 +935,11 @@ void sthread_t::_start()
         w_assert1(_status == t_defunct);
         // wake up any thread that joined on us
         DBGTHRD(<< name() << " terminating");
+#ifdef SM_FIBERS
+        if(_core->fiber) {
+            sthread_carrier_t::_exit();
+        }
+#endif
         tls_tricks::tls_manager::thread_fini();
         DBGTHRD(<< name() << " pthread_exiting");
         pthread_exit(0);
@@ -1003,6 +1063,30 @@ sthread_t::_block(
 
     int error = 0;
     self->_unblock_flag = false;
+#ifdef SM_FIBERS
+    if(self->_core->fiber) {
+        // let the other fibers run until someone unblocks us
+        timespec when;
+        if(timeout > 0) timeout_to_timespec(timeout, when);
+        while(!self->_unblock_flag) {
+            if(timeout > 0) {
+                struct timeval now;
+                gettimeofday(&now, NULL);
+                if(now.tv_sec > when.tv_sec || (now.tv_sec == when.tv_sec
+                            && now.tv_usec*1000 >= when.tv_nsec)) {
+                    error = ETIMEDOUT;
+                    break;
+                }
+            }
+            // _unblock can't be missed: it takes _wait_lock and then
+            // wakes us, even before we are parked
+            DO_PTHREAD(pthread_mutex_unlock(&self->_wait_lock));
+            sthread_carrier_t::_park(timeout > 0 ? &when : NULL);
+            sthread_mutex_lock(&self->_wait_lock);
+        }
+    }
+    else
+#endif
     if(timeout > 0) {
         timespec when;
         timeout_to_timespec(timeout, when);
@@ -1100,6 +1184,11 @@ sthread_t::_unblock(w_rc_t::errcode_t e)
      */
     _unblock_flag = true;
     membar_producer(); // make sure the unblock_flag is visible
+#ifdef SM_FIBERS
+    if(_core->fiber) {
+        sthread_carrier_t::_wake(_core->fiber);
+    } else
+#endif
     DO_PTHREAD(pthread_cond_signal(&_wait_cond));
     _status = t_running;
 
@@ -1108,6 +1197,55 @@ sthread_t::_unblock(w_rc_t::errcode_t e)
 
 
 
+#ifdef SM_FIBERS
+/*********************************************************************
+ *
+ *  sthread_t::cond_wait(cond, lock)
+ *  sthread_t::cond_signal(cond)
+ *  sthread_t::cond_broadcast(cond)
+ *
+ *  Condition variables that fibers can wait on too. A fiber does not
+ *  wait for the pthread signal, which would hold up its whole
+ *  carrier: it parks until cond_signal or cond_broadcast wakes it
+ *  (see sthread_carrier_t::_cond_wait). Without SM_FIBERS these are
+ *  the pthread calls, inline (sthread.h).
+ *
+ *********************************************************************/
+void sthread_t::cond_wait(pthread_cond_t &cond, pthread_mutex_t &lock)
+{
+    if(sthread_carrier_t::on_fiber()) {
+        sthread_carrier_t::_cond_wait(cond, lock);
+    } else {
+        DO_PTHREAD(pthread_cond_wait(&cond, &lock));
+    }
+}
+
+void sthread_t::cond_signal(pthread_cond_t &cond)
+{
+    DO_PTHREAD(pthread_cond_signal(&cond));
+    sthread_carrier_t::_cond_wake(cond, false);
+}
+
+void sthread_t::cond_broadcast(pthread_cond_t &cond)
+{
+    DO_PTHREAD(pthread_cond_broadcast(&cond));
+    sthread_carrier_t::_cond_wake(cond, true);
+}
+
+
+void sthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    if(sthread_carrier_t::on_fiber()) {
+        while(pthread_mutex_trylock(mutex)) {
+            sthread_carrier_t::spin_pause();
+        }
+    } else {
+        pthread_mutex_lock(mutex);
+    }
+}
+#endif
+
+
 /*********************************************************************
  *
  *  sthread_t::yield()
@@ -1119,6 +1257,12 @@ sthread_t::_unblock(w_rc_t::errcode_t e)
  *********************************************************************/
 void sthread_t::yield()
 {
+#ifdef SM_FIBERS
+    if(sthread_carrier_t::on_fiber()) {
+        sthread_carrier_t::_yield();
+        return;
+    }
+#endif
 #define USE_YIELD
 #ifdef USE_YIELD
     sthread_t* self = me();
@@ -1369,7 +1513,7 @@ void occ_rwlock::release_read()
     if(count == WRITER) {
         // wake it up
         CRITICAL_SECTION(cs, _read_write_mutex);
-        DO_PTHREAD(pthread_cond_signal(&_write_cond));
+        sthread_t::cond_signal(_write_cond);
     }
 }
 
@@ -1378,7 +1522,7 @@ void occ_rwlock::release_write()
     w_assert9(_active_count & WRITER);
     CRITICAL_SECTION(cs, _read_write_mutex);
     atomic_add_32(&_active_count, -WRITER);
-    DO_PTHREAD(pthread_cond_broadcast(&_read_cond));
+    sthread_t::cond_broadcast(_read_cond);
 }
 
 /**\cond skip */
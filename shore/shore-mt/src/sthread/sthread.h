@@ -99,6 +99,7 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 
 class sthread_t;
 class smthread_t;
+class sthread_carrier_t;
 
 
 #ifdef __GNUC__
@@ -379,6 +380,19 @@ public:
 #undef CASFUNC 
 };
 
+#ifdef SM_FIBERS
+/**\brief pthread_mutex_lock(), except that a fiber does not block its
+ * carrier: it lets the other fibers run until the mutex is free.
+ * See sthread_carrier_t.
+ */
+extern void sthread_mutex_lock(pthread_mutex_t *mutex);
+#else
+inline void sthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+#endif
+
 /**\brief Wrapper for pthread mutexes, with a queue-based lock API.
  *
  * This lock uses a Pthreads mutex for the lock.
@@ -451,7 +465,7 @@ public:
         w_assert1(!is_mine(me));
         w_assert1( me->_held == 0 );  // had better not 
         // be using this qnode for another lock!
-        pthread_mutex_lock(&_mutex);
+        sthread_mutex_lock(&_mutex);
         me->_held = this;
         _holder = this;
         {
@@ -647,6 +661,7 @@ class sthread_t : public sthread_named_base_t
 {
     friend class sthread_init_t;
     friend class sthread_main_t;
+    friend class sthread_carrier_t;
 #if LATCH_CAN_BLOCK_LONG 
     friend class sthread_priority_list_t;
 #endif
@@ -717,6 +732,15 @@ public:
                             const void *           id = 0);
     static w_rc_t::errcode_t       block(int4_t  timeout = WAIT_FOREVER);
 
+    /// pthread_cond_wait(), except that a fiber lets the other fibers
+    /// of its carrier run instead. Either may return spuriously.
+    static void          cond_wait(pthread_cond_t &cond,
+                                   pthread_mutex_t &lock);
+    /// pthread_cond_signal() and pthread_cond_broadcast() for a
+    /// cond_wait(): they wake the fibers waiting too.
+    static void          cond_signal(pthread_cond_t &cond);
+    static void          cond_broadcast(pthread_cond_t &cond);
+
     virtual void        _dump(std::ostream &) const; // to be over-ridden
 
     // these traverse all threads
@@ -854,6 +878,14 @@ public:
     // start a thread
     w_rc_t            fork();
 
+#ifdef SM_FIBERS
+    // start a thread as a fiber of the carrier; see sthread_carrier_t
+    w_rc_t            fork(sthread_carrier_t &carrier);
+#endif
+
+    // true if this thread runs as a fiber
+    bool              is_fiber() const;
+
     // give up the processor
     static void        yield();
     std::ostream            &print(std::ostream &) const;
@@ -925,6 +957,8 @@ private:
     static    unsigned       open_max;
     static    unsigned       open_count;
 
+    w_rc_t                 _fork(sthread_carrier_t* carrier);
+
     /* in-thread startup and shutdown */ 
     static void            __start(void *arg_thread);
     void                   _start();
@@ -1081,7 +1115,7 @@ private:                      \
 // I undef-ed this and found all occurrances of CRITICAL_SECTION with this.
 // and hand-checked them.
 SPECIALIZE_CS(pthread_mutex_t, int _dummy,  (_dummy=0), 
-    pthread_mutex_lock(_mutex), pthread_mutex_unlock(_mutex));
+    sthread_mutex_lock(_mutex), pthread_mutex_unlock(_mutex));
 
 // tatas_lock doesn't have is_mine, but I changed its release()
 // to Release and through compiling saw everywhere that uses release,
@@ -1153,6 +1187,24 @@ sthread_t::status() const
     } \
 }
 
+#ifndef SM_FIBERS
+// no fibers to wake: the pthread calls
+inline void sthread_t::cond_wait(pthread_cond_t &cond, pthread_mutex_t &lock)
+{
+    DO_PTHREAD(pthread_cond_wait(&cond, &lock));
+}
+
+inline void sthread_t::cond_signal(pthread_cond_t &cond)
+{
+    DO_PTHREAD(pthread_cond_signal(&cond));
+}
+
+inline void sthread_t::cond_broadcast(pthread_cond_t &cond)
+{
+    DO_PTHREAD(pthread_cond_broadcast(&cond));
+}
+#endif
+
 /*<std-footer incl-file-exclusion='STHREAD_H'>  -- do not edit anything below this line -- */
 
 #endif          /*</std-footer>*/
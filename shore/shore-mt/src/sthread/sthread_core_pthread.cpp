@@ -73,6 +73,9 @@ Rome Research Laboratory Contract No. F30602-97-2-0247.
 #include <w_stream.h>
 #include <pthread.h>
 #include "stcore_pthread.h"
+#ifdef SM_FIBERS
+#include "sthread_fiber.h"
+#endif
 
 
 
@@ -142,8 +145,6 @@ int sthread_core_init(sthread_core_t *core,
               void (*proc)(void *), void *arg,
               unsigned stack_size)
 {
-    int    n;
-
     /* Get a life; XXX magic number */
     if (stack_size > 0 && stack_size < 1024)
         return -1;
@@ -152,20 +153,15 @@ int sthread_core_init(sthread_core_t *core,
     core->start_proc = proc;
     core->start_arg = arg;
     core->stack_size = stack_size;
+    core->fiber = 0;
 
     if (stack_size > 0) {
-        /* A real thread :thread id, default attributes, start func, arg */
-        n = pthread_create(&core->pthread, NULL, pthread_core_start, core);
-        if (n == -1) {
-            w_rc_t e= RC(fcOS);
-            // EAGAIN: insufficient resources
-            // Really, there's no way to tell when the system will
-            // say it's hit the maximum # threads because that depends
-            // on a variety of resources, and in any case, we don't
-            // know how much memory will be required for another thread.
-            std::cerr << "pthread_create():" << std::endl << e << std::endl;
-            return -1;
-        }
+        /* A real thread. The pthread is created by sthread_core_start
+           when the sthread is forked, unless it is forked onto a
+           carrier, which runs it as a fiber instead.
+         */
+        core->is_started = 0;
+        core->pthread = pthread_self();
         core->creator = pthread_self();
     }
     else {
@@ -181,12 +177,35 @@ int sthread_core_init(sthread_core_t *core,
 
         /* The system stack is never virgin */
         core->is_virgin = 0;
+        core->is_started = 1;
         core->pthread = pthread_self();
         core->creator = core->pthread; // main thread
     }
     return 0;
 }
 
+/* create the pthread of a forked sthread */
+int sthread_core_start(sthread_core_t *core)
+{
+    if (core->is_started || core->stack_size == 0)
+        return 0;
+
+    /* thread id, default attributes, start func, arg */
+    int n = pthread_create(&core->pthread, NULL, pthread_core_start, core);
+    if (n != 0) {
+        w_rc_t e= RC(fcOS);
+        // EAGAIN: insufficient resources
+        // Really, there's no way to tell when the system will
+        // say it's hit the maximum # threads because that depends
+        // on a variety of resources, and in any case, we don't
+        // know how much memory will be required for another thread.
+        std::cerr << "pthread_create():" << std::endl << e << std::endl;
+        return -1;
+    }
+    core->is_started = 1;
+    return 0;
+}
+
 /* clean up : called on destruction.
  * All we do now is join the thread
  */
@@ -197,9 +216,18 @@ void sthread_core_exit(sthread_core_t* core, bool &joined)
         return;
     }
 
+#ifdef SM_FIBERS
+    if (core->fiber) {
+        sthread_carrier_t::join_fiber(core->fiber);
+        core->fiber = 0;
+        joined = true;
+        return;
+    }
+#endif
+
     /* must wait for the thread and then harvest its thread */
 
-    if (core->stack_size > 0) {
+    if (core->stack_size > 0 && core->is_started) {
         int res = pthread_join(core->pthread, &join_value);
         if(res) {
             const char *msg="";
@@ -0,0 +1,624 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+/* Carriers: pthreads that run sthreads as fibers. See sthread_fiber.h */
+
+#include "w_defines.h"
+
+#ifdef SM_FIBERS
+
+#include <w.h>
+#include <sys/mman.h>
+#include "sthread.h"
+#include "sthread_stats.h"
+#include "stcore_pthread.h"
+#include "sdisk.h"
+#include "tls.h"
+#include "sthread_fiber.h"
+
+struct sthread_fiber_t
+{
+    enum state_t { f_ready, f_running, f_parked };
+
+    ucontext_t          _ctx;
+    char*               _stack;     // the lowest page is a guard page
+    size_t              _stack_size;
+    sthread_t*          _thread;
+    sthread_carrier_t*  _carrier;
+    void*               _tls[sthread_carrier_t::max_tls_slots];
+    bool                _exited;    // returned from run(), carrier-private
+    bool                _parking;   // switched out by _park
+    const timespec*     _until;     // ... with this timeout, if any
+
+    // under the carrier's _lock
+    state_t             _state;
+    bool                _woken;     // woken while still running
+    bool                _timed;     // in the carrier's _timed list
+    bool                _done;
+    sthread_fiber_t*    _next;      // in _incoming or the ready queue
+    sthread_fiber_t*    _next_timed;
+};
+
+__thread sthread_fiber_t* sthread_carrier_t::_running(NULL);
+__thread int         sthread_carrier_t::_no_yield(0);
+sthread_carrier_t::tls_slot_t
+                     sthread_carrier_t::_tls_slots[max_tls_slots];
+int                  sthread_carrier_t::_tls_count(0);
+
+static long          _page_size = 0;
+
+static bool timespec_passed(const timespec& when, const timeval& now)
+{
+    return now.tv_sec > when.tv_sec || (now.tv_sec == when.tv_sec
+                && now.tv_usec*1000 >= when.tv_nsec);
+}
+
+
+void sthread_carrier_t::register_tls(tls_slot_t slot)
+{
+    w_assert0(_tls_count < max_tls_slots);
+    _tls_slots[_tls_count++] = slot;
+}
+
+
+NORET sthread_carrier_t::sthread_carrier_t(int io_threads,
+                                           size_t fiber_stack)
+    : _fiber_stack(fiber_stack),
+      _incoming(NULL), _ready_head(NULL), _ready_tail(NULL),
+      _timed(NULL), _count(0), _idle(false), _stopping(false),
+      _owner(NULL),
+      _io_count(io_threads > 0 ? io_threads : 1),
+      _io_threads(NULL),
+      _io_head(NULL), _io_tail(NULL), _io_stopping(false)
+{
+    if(!_page_size) _page_size = sysconf(_SC_PAGESIZE);
+    _fiber_stack = (_fiber_stack + _page_size - 1) & ~(_page_size - 1);
+
+    DO_PTHREAD(pthread_mutex_init(&_lock, NULL));
+    DO_PTHREAD(pthread_cond_init(&_kick_cond, NULL));
+    DO_PTHREAD(pthread_cond_init(&_done_cond, NULL));
+    DO_PTHREAD(pthread_mutex_init(&_io_lock, NULL));
+    DO_PTHREAD(pthread_cond_init(&_io_cond, NULL));
+
+    _io_threads = new pthread_t[_io_count];
+    if(!_io_threads) W_FATAL(fcOUTOFMEMORY);
+    for(int i=0; i < _io_count; i++) {
+        DO_PTHREAD(pthread_create(&_io_threads[i], NULL, _io_main, this));
+    }
+    DO_PTHREAD(pthread_create(&_pthread, NULL, _carrier_main, this));
+}
+
+NORET sthread_carrier_t::~sthread_carrier_t()
+{
+    {
+        CRITICAL_SECTION(cs, _lock);
+        _stopping = true;
+        _owner = sthread_t::me();
+        DO_PTHREAD(pthread_cond_signal(&_kick_cond));
+    }
+    DO_PTHREAD(pthread_join(_pthread, NULL));
+
+    {
+        CRITICAL_SECTION(cs, _io_lock);
+        _io_stopping = true;
+        DO_PTHREAD(pthread_cond_broadcast(&_io_cond));
+    }
+    for(int i=0; i < _io_count; i++) {
+        DO_PTHREAD(pthread_join(_io_threads[i], NULL));
+    }
+    delete [] _io_threads;
+
+    DO_PTHREAD(pthread_cond_destroy(&_io_cond));
+    DO_PTHREAD(pthread_mutex_destroy(&_io_lock));
+    DO_PTHREAD(pthread_cond_destroy(&_done_cond));
+    DO_PTHREAD(pthread_cond_destroy(&_kick_cond));
+    DO_PTHREAD(pthread_mutex_destroy(&_lock));
+}
+
+
+/*********************************************************************
+ *
+ *  sthread_carrier_t::_spawn(t)
+ *
+ *  Give a forked sthread a stack and hand it to the carrier.
+ *
+ *********************************************************************/
+void sthread_carrier_t::_spawn(sthread_t* t)
+{
+    sthread_fiber_t* f = new sthread_fiber_t;
+    if(!f) W_FATAL(fcOUTOFMEMORY);
+
+    f->_stack_size = _fiber_stack + _page_size;
+    f->_stack = (char*) mmap(NULL, f->_stack_size, PROT_READ|PROT_WRITE,
+                             MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(f->_stack == MAP_FAILED) W_FATAL(fcOUTOFMEMORY);
+    // overflows fault instead of trashing the heap
+    if(mprotect(f->_stack, _page_size, PROT_NONE)) W_FATAL(fcOS);
+
+    f->_thread = t;
+    f->_carrier = this;
+    memset(f->_tls, 0, sizeof(f->_tls));
+    f->_exited = false;
+    f->_parking = false;
+    f->_until = NULL;
+    f->_state = sthread_fiber_t::f_ready;
+    f->_woken = false;
+    f->_timed = false;
+    f->_done = false;
+    f->_next = NULL;
+    f->_next_timed = NULL;
+
+    DO_PTHREAD(getcontext(&f->_ctx) == -1 ? errno : 0);
+    f->_ctx.uc_stack.ss_sp = f->_stack + _page_size;
+    f->_ctx.uc_stack.ss_size = _fiber_stack;
+    f->_ctx.uc_link = NULL;
+    // makecontext passes ints
+    unsigned long addr = (unsigned long) f;
+    makecontext(&f->_ctx, (void (*)()) _fiber_main, 2,
+                unsigned(addr >> 32), unsigned(addr & 0xffffffff));
+
+    sthread_core_t* core = t->_core;
+    core->fiber = f;
+    core->is_started = 1;
+    core->pthread = _pthread;
+
+    CRITICAL_SECTION(cs, _lock);
+    f->_next = _incoming;
+    _incoming = f;
+    if(_idle) DO_PTHREAD(pthread_cond_signal(&_kick_cond));
+}
+
+void sthread_carrier_t::stack_bounds(sthread_fiber_t* f,
+                                     char*& low, size_t& size)
+{
+    low = f->_stack + _page_size;
+    size = f->_stack_size - _page_size;
+}
+
+void sthread_carrier_t::_fiber_main(unsigned hi, unsigned lo)
+{
+    sthread_fiber_t* f = (sthread_fiber_t*)
+        ((unsigned long) hi << 32 | (unsigned long) lo);
+    f->_thread->_core->is_virgin = 0;
+    sthread_t::__start(f->_thread);
+    W_FATAL(sthread_t::stINTERNAL);    // never reached: _start() ends in _exit()
+}
+
+
+/*********************************************************************
+ *
+ *  sthread_carrier_t::_run()
+ *
+ *  The carrier: runs the fiber at the head of the ready queue until it
+ *  switches back, then puts it at the tail, or leaves it parked until
+ *  _wake() (or its timeout) makes it ready again. With nothing ready
+ *  it sleeps on _kick_cond, until the next timeout if a fiber has one.
+ *
+ *  Caller holds _lock for the queue helpers.
+ *
+ *********************************************************************/
+void* sthread_carrier_t::_carrier_main(void* arg)
+{
+    ((sthread_carrier_t*) arg)->_run();
+    return NULL;
+}
+
+void sthread_carrier_t::_make_ready(sthread_fiber_t* f)
+{
+    f->_state = sthread_fiber_t::f_ready;
+    f->_next = NULL;
+    if(_ready_tail) _ready_tail->_next = f;
+    else _ready_head = f;
+    _ready_tail = f;
+}
+
+// ready the parked fibers whose timeout has passed; next gets the
+// earliest timeout still to come (tv_sec 0 if none)
+void sthread_carrier_t::_wake_timed(timespec& next)
+{
+    next.tv_sec = 0;
+    next.tv_nsec = 0;
+    if(!_timed) return;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    sthread_fiber_t** link = &_timed;
+    while(*link) {
+        sthread_fiber_t* f = *link;
+        w_assert1(f->_state == sthread_fiber_t::f_parked);
+        if(timespec_passed(*f->_until, now)) {
+            *link = f->_next_timed;
+            f->_timed = false;
+            _make_ready(f);
+        } else {
+            if(!next.tv_sec || f->_until->tv_sec < next.tv_sec
+                    || (f->_until->tv_sec == next.tv_sec
+                        && f->_until->tv_nsec < next.tv_nsec)) {
+                next = *f->_until;
+            }
+            link = &f->_next_timed;
+        }
+    }
+}
+
+void sthread_carrier_t::_run()
+{
+    tls_tricks::tls_manager::thread_init();
+
+    CRITICAL_SECTION(cs, _lock);
+    while(true) {
+        while(_incoming) {
+            sthread_fiber_t* f = _incoming;
+            _incoming = f->_next;
+            _make_ready(f);
+            _count++;
+        }
+        timespec next;
+        _wake_timed(next);
+
+        sthread_fiber_t* f = _ready_head;
+        if(!f) {
+            if(!_count && _stopping) break;
+            _idle = true;
+            if(next.tv_sec) {
+                DO_PTHREAD_TIMED(pthread_cond_timedwait(&_kick_cond,
+                                                        &_lock, &next));
+            } else {
+                DO_PTHREAD(pthread_cond_wait(&_kick_cond, &_lock));
+            }
+            _idle = false;
+            continue;
+        }
+        _ready_head = f->_next;
+        if(!_ready_head) _ready_tail = NULL;
+        f->_state = sthread_fiber_t::f_running;
+
+        cs.pause();
+        _switch_to(f);
+        cs.resume();
+
+        if(f->_exited) {
+            _count--;
+            f->_done = true;
+            // the joiner frees f as soon as it sees _done
+            cs.pause();
+            sthread_t::cond_broadcast(_done_cond);
+            cs.resume();
+            continue;
+        }
+        if(f->_parking && !f->_woken) {
+            f->_state = sthread_fiber_t::f_parked;
+            if(f->_until) {
+                f->_timed = true;
+                f->_next_timed = _timed;
+                _timed = f;
+            }
+        } else {
+            _make_ready(f);
+        }
+        f->_woken = false;
+    }
+    cs.exit();
+
+    // The destructors of the thread-local objects the fibers shared
+    // may expect me() to be an sthread of their kind. Run them on
+    // behalf of the thread deleting us, which waits for us to end.
+    sthread_t::me_lval() = _owner;
+    tls_tricks::tls_manager::thread_fini();
+    sthread_t::me_lval() = NULL;
+}
+
+void sthread_carrier_t::_switch_to(sthread_fiber_t* f)
+{
+    void* saved[max_tls_slots];
+    for(int i=0; i < _tls_count; i++) {
+        void** slot = _tls_slots[i]();
+        saved[i] = *slot;
+        *slot = f->_tls[i];
+    }
+    sthread_t::me_lval() = f->_thread;
+    _running = f;
+    INC_STH_STATS(fiber_switch);
+
+    DO_PTHREAD(swapcontext(&_ctx, &f->_ctx) == -1 ? errno : 0);
+
+    _running = NULL;
+    sthread_t::me_lval() = NULL;
+    for(int i=0; i < _tls_count; i++) {
+        void** slot = _tls_slots[i]();
+        f->_tls[i] = *slot;
+        *slot = saved[i];
+    }
+}
+
+/*
+ * _yield: back to the carrier, staying ready.
+ * _park: back to the carrier, not to run again until _wake() or
+ * the timeout. It may return early (a _wake() meant for an earlier
+ * wait), so callers wait in a loop.
+ */
+void sthread_carrier_t::_yield()
+{
+    sthread_fiber_t* f = _running;
+    w_assert1(f);
+    w_assert1(!_no_yield);
+    f->_parking = false;
+    DO_PTHREAD(swapcontext(&f->_ctx, &f->_carrier->_ctx) == -1 ? errno : 0);
+    // back on the carrier's pthread; _running is f again
+}
+
+void sthread_carrier_t::_park(const timespec* until)
+{
+    sthread_fiber_t* f = _running;
+    w_assert1(f);
+    w_assert1(!_no_yield);
+    f->_parking = true;
+    f->_until = until;
+    DO_PTHREAD(swapcontext(&f->_ctx, &f->_carrier->_ctx) == -1 ? errno : 0);
+    f->_parking = false;
+    f->_until = NULL;
+}
+
+void sthread_carrier_t::_exit()
+{
+    sthread_fiber_t* f = _running;
+    w_assert1(f);
+    f->_exited = true;
+    setcontext(&f->_carrier->_ctx);
+    W_FATAL(sthread_t::stINTERNAL);    // never reached
+}
+
+// Called with other mutexes held (the thread's _wait_lock, a cond
+// bucket), so it takes _lock without letting other fibers run: it
+// never waits long for it.
+void sthread_carrier_t::_wake(sthread_fiber_t* f)
+{
+    sthread_carrier_t* c = f->_carrier;
+    DO_PTHREAD(pthread_mutex_lock(&c->_lock));
+    switch(f->_state) {
+    case sthread_fiber_t::f_parked:
+        if(f->_timed) {
+            sthread_fiber_t** link = &c->_timed;
+            while(*link != f) link = &(*link)->_next_timed;
+            *link = f->_next_timed;
+            f->_timed = false;
+        }
+        c->_make_ready(f);
+        if(c->_idle) DO_PTHREAD(pthread_cond_signal(&c->_kick_cond));
+        break;
+    case sthread_fiber_t::f_running:
+        // it has yet to switch out; the carrier will not park it
+        f->_woken = true;
+        break;
+    case sthread_fiber_t::f_ready:
+        break;
+    }
+    DO_PTHREAD(pthread_mutex_unlock(&c->_lock));
+}
+
+
+/*********************************************************************
+ *
+ *  sthread_carrier_t::_cond_wait(cond, lock)
+ *  sthread_carrier_t::_cond_wake(cond, all)
+ *
+ *  Condition variables for fibers. A fiber waiting on a pthread_cond_t
+ *  enters a waiter in the bucket of the cond's address and parks;
+ *  sthread_t::cond_signal and cond_broadcast wake the waiters of the
+ *  cond in that bucket, besides signaling the cond for pthreads.
+ *
+ *  The waiter is entered before the lock is released, so a signal
+ *  sent after the caller's condition was changed under the lock finds
+ *  it.
+ *
+ *********************************************************************/
+struct fiber_cond_waiter_t
+{
+    pthread_cond_t*       cond;
+    sthread_fiber_t*      fiber;
+    fiber_cond_waiter_t*  next;
+};
+
+struct fiber_cond_bucket_t
+{
+    pthread_mutex_t       lock; // plain pthread mutex, never held long
+    fiber_cond_waiter_t*  head;
+};
+
+enum { FIBER_COND_BUCKETS = 64 };
+static fiber_cond_bucket_t _cond_buckets[FIBER_COND_BUCKETS];
+static pthread_once_t      _cond_buckets_once = PTHREAD_ONCE_INIT;
+
+static void _init_cond_buckets()
+{
+    for(int i=0; i < FIBER_COND_BUCKETS; i++) {
+        DO_PTHREAD(pthread_mutex_init(&_cond_buckets[i].lock, NULL));
+        _cond_buckets[i].head = NULL;
+    }
+}
+
+static fiber_cond_bucket_t& _cond_bucket(pthread_cond_t* cond)
+{
+    DO_PTHREAD(pthread_once(&_cond_buckets_once, _init_cond_buckets));
+    unsigned long h = (unsigned long) cond;
+    h ^= h >> 7;
+    h ^= h >> 13;
+    return _cond_buckets[h % FIBER_COND_BUCKETS];
+}
+
+void sthread_carrier_t::_cond_wait(pthread_cond_t &cond,
+                                   pthread_mutex_t &lock)
+{
+    sthread_fiber_t* f = _running;
+    w_assert1(f);
+    fiber_cond_bucket_t& b = _cond_bucket(&cond);
+
+    fiber_cond_waiter_t w;
+    w.cond = &cond;
+    w.fiber = f;
+    DO_PTHREAD(pthread_mutex_lock(&b.lock));
+    w.next = b.head;
+    b.head = &w;
+    DO_PTHREAD(pthread_mutex_unlock(&b.lock));
+
+    DO_PTHREAD(pthread_mutex_unlock(&lock));
+    _park(NULL);
+
+    // still entered if the wake-up was not ours
+    DO_PTHREAD(pthread_mutex_lock(&b.lock));
+    for(fiber_cond_waiter_t** link = &b.head; *link; link = &(*link)->next) {
+        if(*link == &w) {
+            *link = w.next;
+            break;
+        }
+    }
+    DO_PTHREAD(pthread_mutex_unlock(&b.lock));
+    sthread_mutex_lock(&lock);
+}
+
+void sthread_carrier_t::_cond_wake(pthread_cond_t &cond, bool all)
+{
+    fiber_cond_bucket_t& b = _cond_bucket(&cond);
+    // the waiters can't leave their _cond_wait while we hold the
+    // bucket lock, so they are still there to wake
+    DO_PTHREAD(pthread_mutex_lock(&b.lock));
+    fiber_cond_waiter_t** link = &b.head;
+    while(*link) {
+        fiber_cond_waiter_t* w = *link;
+        if(w->cond == &cond) {
+            *link = w->next;
+            _wake(w->fiber);
+            if(!all) break;
+        } else {
+            link = &w->next;
+        }
+    }
+    DO_PTHREAD(pthread_mutex_unlock(&b.lock));
+}
+
+
+/*********************************************************************
+ *
+ *  sthread_carrier_t::join_fiber(f)
+ *
+ *  Wait until the fiber has left its carrier for good, then free it.
+ *
+ *********************************************************************/
+void sthread_carrier_t::join_fiber(sthread_fiber_t* f)
+{
+    sthread_carrier_t* c = f->_carrier;
+    {
+        CRITICAL_SECTION(cs, c->_lock);
+        while(!f->_done) {
+            sthread_t::cond_wait(c->_done_cond, c->_lock);
+        }
+    }
+    munmap(f->_stack, f->_stack_size);
+    delete f;
+}
+
+
+/*********************************************************************
+ *
+ *  sthread_carrier_t::_io(req)
+ *
+ *  Called by a fiber, in place of a blocking system call: queue the
+ *  request for an I/O thread and let the other fibers run until the
+ *  I/O thread unblocks us.
+ *
+ *********************************************************************/
+w_rc_t sthread_carrier_t::_io(sthread_io_request_t& req)
+{
+    sthread_fiber_t* f = _running;
+    w_assert1(f);
+    sthread_carrier_t* c = f->_carrier;
+    sthread_t* self = f->_thread;
+
+    req.waiter = self;
+    req.done = 0;
+    req.err = 0;
+    req.next = NULL;
+
+    INC_STH_STATS(fiber_io);
+    w_rc_t::errcode_t rce;
+    {
+        // hold our _wait_lock, so that unblock() can't come first
+        CRITICAL_SECTION(cs, self->_wait_lock);
+        {
+            CRITICAL_SECTION(iocs, c->_io_lock);
+            if(c->_io_tail) c->_io_tail->next = &req;
+            else c->_io_head = &req;
+            c->_io_tail = &req;
+            DO_PTHREAD(pthread_cond_signal(&c->_io_cond));
+        }
+        rce = sthread_t::_block(sthread_t::WAIT_FOREVER, "fiber_io", &req);
+    }
+    if(rce) return RC(rce);
+    if(req.err) return RC(req.err);
+    return RCOK;
+}
+
+void* sthread_carrier_t::_io_main(void* arg)
+{
+    ((sthread_carrier_t*) arg)->_io_run();
+    return NULL;
+}
+
+void sthread_carrier_t::_io_run()
+{
+    tls_tricks::tls_manager::thread_init();
+    while(true) {
+        sthread_io_request_t* req;
+        {
+            CRITICAL_SECTION(cs, _io_lock);
+            while(!_io_head && !_io_stopping) {
+                DO_PTHREAD(pthread_cond_wait(&_io_cond, &_io_lock));
+            }
+            if(!_io_head) break;
+            req = _io_head;
+            _io_head = req->next;
+            if(!_io_head) _io_tail = NULL;
+        }
+
+        {
+            // the w_rc_t lives and dies on this pthread
+            w_rc_t e;
+            switch(req->op) {
+            case sthread_io_request_t::t_pread:
+                e = req->disk->pread(req->buf, req->n, req->pos, req->done);
+                break;
+            case sthread_io_request_t::t_pwrite:
+                e = req->disk->pwrite(req->buf, req->n, req->pos, req->done);
+                break;
+            case sthread_io_request_t::t_fsync:
+                e = req->disk->sync();
+                break;
+            }
+            req->err = e.is_error() ? e.err_num() : 0;
+        }
+        W_COERCE(req->waiter->unblock(sthread_t::stOK));
+    }
+    tls_tricks::tls_manager::thread_fini();
+}
+
+#endif /* SM_FIBERS */
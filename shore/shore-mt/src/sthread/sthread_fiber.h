@@ -0,0 +1,217 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#ifndef STHREAD_FIBER_H
+#define STHREAD_FIBER_H
+
+#include "w_defines.h"
+
+/* Fibers exist only in a build configured with --enable-fibers
+ * (SM_FIBERS). Without it the hooks below compile to nothing and the
+ * spin loops, mutexes and condition waits are plain pthread ones.
+ */
+#ifdef SM_FIBERS
+
+#include <ucontext.h>
+#include <sthread.h>
+
+class sdisk_t;
+struct sthread_fiber_t;
+
+/**\brief An I/O of a fiber, done by an I/O thread of its carrier */
+struct sthread_io_request_t
+{
+    enum op_t { t_pread, t_pwrite, t_fsync };
+
+    op_t                  op;
+    sdisk_t*              disk;
+    void*                 buf;
+    int                   n;
+    sthread_t::fileoff_t  pos;
+    int                   done;  // bytes transferred
+    w_rc_t::errcode_t     err;   // 0 if the I/O succeeded
+    sthread_t*            waiter;
+    sthread_io_request_t* next;
+};
+
+/**\brief A pthread that runs many sthreads as fibers.
+ *
+ * \details
+ * An sthread forked with sthread_t::fork(sthread_carrier_t&) gets no
+ * pthread of its own: it runs on a stack of its own inside the
+ * carrier's pthread. The carrier runs the fibers of its ready queue in
+ * turn, each until it has to wait:
+ *  - in sthread_t::block, sleep and join (lock waits go through
+ *    smthread_block), and in sthread_t::cond_wait (log flush, page
+ *    transit and occ_rwlock waits), the fiber leaves the ready queue
+ *    until sthread_t::unblock or sthread_t::cond_signal/cond_broadcast
+ *    puts it back (or its timeout passes);
+ *  - in the spin loops of mcs_lock, mcs_rwlock and tatas_lock
+ *    (latches, buffer-pool and log mutexes) and on pthread mutexes
+ *    taken with CRITICAL_SECTION or w_pthread_lock_t (see
+ *    sthread_mutex_lock), it goes to the back of the ready queue, since
+ *    nobody tells it when the lock is free;
+ *  - sthread_t::pread, pwrite and fsync are handed to a few I/O
+ *    threads of the carrier (buffer-pool misses), and the fiber waits
+ *    as in block().
+ * A carrier with nothing ready sleeps until a fiber is woken up.
+ *
+ * So one carrier per core keeps that core busy with the other
+ * transactions while some wait, without an OS thread per transaction.
+ *
+ * A fiber never moves to another carrier, hence the __thread
+ * variables of the carrier stay valid for it, but the fibers of a
+ * carrier share them. me() and the pointers registered with
+ * register_tls() are saved and restored on every switch, so each fiber
+ * sees its own. The rest of the thread-local state of the storage
+ * manager is per smthread (smthread_t::tcb_t), or per carrier on
+ * purpose:
+ *  - allocator pools (block_alloc, xct, lock, logrec pools), random
+ *    number generators, statistics and debugging timestamps, which
+ *    are used in one go, without a wait in the middle;
+ *  - hints that are checked before use (histoid_t's last extent);
+ *  - the key_ranges_map epoch slot, which is entered and left with no
+ *    wait in between (checked: forbid_yield);
+ *  - the private sketch cache of data_access_sketch, which is only
+ *    changed between the locks that may switch fibers;
+ *  - the log's insert_info slots, which are handed out one per insert.
+ * New thread-local state must be one of these, or go to the tcb.
+ *
+ * The price is that a fiber must not block anywhere else while another
+ * fiber of its carrier may need to run first: a bare pthread_mutex_lock
+ * or pthread_cond_wait on something only another fiber of the same
+ * carrier can release stalls the whole carrier for good.
+ */
+class sthread_carrier_t
+{
+public:
+    /// Returns the address of a thread-local pointer in the calling pthread
+    typedef void** (*tls_slot_t)();
+
+    enum { max_tls_slots = 8 };
+    enum { default_fiber_stack = 256*1024 };
+    enum { default_io_threads = 4 };
+
+    NORET            sthread_carrier_t(
+                            int io_threads = default_io_threads,
+                            size_t fiber_stack = default_fiber_stack);
+    /// Waits for all the fibers to end
+    NORET            ~sthread_carrier_t();
+
+    /// True if the calling code runs on a fiber
+    static bool      on_fiber() { return _running != NULL; }
+
+    /// The body of a spin loop: lets the other fibers of the carrier run
+    static void      spin_pause() { if(_running) _yield(); }
+
+    /// Between these two the calling fiber must not let the others run
+    /// (checked by _yield and _park in debug builds)
+    static void      forbid_yield() { _no_yield++; }
+    static void      allow_yield() { w_assert1(_no_yield > 0); _no_yield--; }
+
+    /// Give every fiber its own copy of the pointer at slot().
+    /// Call at static-initialization time, before any fiber exists.
+    static void      register_tls(tls_slot_t slot);
+
+    /// Wait for the fiber to end and free it (sthread_t::join does it)
+    static void      join_fiber(sthread_fiber_t* f);
+
+private:
+    friend class sthread_t;
+
+    // the fiber running on this pthread, if any
+    static __thread sthread_fiber_t* _running;
+    static __thread int              _no_yield;
+
+    static tls_slot_t _tls_slots[max_tls_slots];
+    static int        _tls_count;
+
+    size_t           _fiber_stack;
+
+    // carrier-private: the context to go back to
+    pthread_t        _pthread;
+    ucontext_t       _ctx;
+
+    // protects all of the fibers' scheduling state below
+    pthread_mutex_t  _lock;
+    pthread_cond_t   _kick_cond; // the idle carrier waits for a fiber
+    pthread_cond_t   _done_cond; // joiners wait for a fiber to end
+    sthread_fiber_t* _incoming;  // forked, not yet seen by the carrier
+    sthread_fiber_t* _ready_head;
+    sthread_fiber_t* _ready_tail;
+    sthread_fiber_t* _timed;     // parked with a timeout
+    int              _count;     // fibers not yet ended
+    bool             _idle;      // waiting on _kick_cond
+    bool             _stopping;
+    sthread_t*       _owner;     // the thread deleting the carrier
+
+    // hand-off of the I/O of fibers
+    int                   _io_count;
+    pthread_t*            _io_threads;
+    pthread_mutex_t       _io_lock;
+    pthread_cond_t        _io_cond;
+    sthread_io_request_t* _io_head;
+    sthread_io_request_t* _io_tail;
+    bool                  _io_stopping;
+
+    static void*     _carrier_main(void* arg);
+    static void*     _io_main(void* arg);
+    static void      _fiber_main(unsigned hi, unsigned lo);
+
+    void             _run();
+    void             _io_run();
+    void             _switch_to(sthread_fiber_t* f);
+    void             _make_ready(sthread_fiber_t* f);
+    void             _wake_timed(timespec& next);
+
+    // called by sthread_t
+    void             _spawn(sthread_t* t);
+    static void      _yield();
+    static void      _park(const timespec* until);
+    static void      _exit(); // does not return
+    static void      _wake(sthread_fiber_t* f);
+    static void      _cond_wait(pthread_cond_t &cond,
+                            pthread_mutex_t &lock);
+    static void      _cond_wake(pthread_cond_t &cond, bool all);
+    static w_rc_t    _io(sthread_io_request_t& req);
+    static void      stack_bounds(sthread_fiber_t* f,
+                            char*& low, size_t& size);
+
+    // disabled
+    NORET            sthread_carrier_t(const sthread_carrier_t&);
+    sthread_carrier_t& operator=(const sthread_carrier_t&);
+};
+
+#define FIBER_SPIN_PAUSE()      sthread_carrier_t::spin_pause()
+#define FIBER_FORBID_YIELD()    sthread_carrier_t::forbid_yield()
+#define FIBER_ALLOW_YIELD()     sthread_carrier_t::allow_yield()
+
+#else
+
+#define FIBER_SPIN_PAUSE()
+#define FIBER_FORBID_YIELD()
+#define FIBER_ALLOW_YIELD()
+
+#endif /* SM_FIBERS */
+
+#endif
@@ -0,0 +1,291 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/* sthreads running as fibers on carriers: lock hand-offs between
+ * fibers of the same carrier, sleeps, condition waits, I/O and joins.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include <w.h>
+#include <sthread.h>
+#include <sthread_fiber.h>
+#include <sthread_stats.h>
+#include <w_getopt.h>
+#include <iostream>
+
+#ifdef SM_FIBERS
+
+int     NumFibers = 16;
+int     NumCarriers = 2;
+int     Iterations = 1000;
+int     SleepTime = 200;    // ms
+bool    verbose = false;
+
+int     errors = 0;
+
+static queue_based_lock_t  counter_lock;
+static long                counter = 0;
+
+/* Bumps the counter with the lock held, giving up the carrier in the
+ * middle so that the other fibers have to wait for the lock.
+ */
+class counter_thread_t : public sthread_t {
+public:
+    counter_thread_t() : sthread_t(t_regular, "counter") { }
+protected:
+    void run() {
+        for(int i=0; i < Iterations; i++) {
+            CRITICAL_SECTION(cs, counter_lock);
+            long c = counter;
+            if(i % 10 == 0) sthread_t::yield();
+            counter = c + 1;
+        }
+    }
+};
+
+class sleep_thread_t : public sthread_t {
+public:
+    sleep_thread_t() : sthread_t(t_regular, "sleeper") { }
+protected:
+    void run() { sthread_t::sleep(SleepTime); }
+};
+
+static pthread_mutex_t     go_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      go_cond = PTHREAD_COND_INITIALIZER;
+static bool                go = false;
+
+/* Waits for the main thread to say go */
+class cond_thread_t : public sthread_t {
+public:
+    cond_thread_t() : sthread_t(t_regular, "cond") { }
+protected:
+    void run() {
+        CRITICAL_SECTION(cs, go_lock);
+        while(!go) sthread_t::cond_wait(go_cond, go_lock);
+    }
+};
+
+/* Writes its own block of the file, syncs, and reads it back */
+class io_thread_t : public sthread_t {
+public:
+    io_thread_t(int fd, int id)
+        : sthread_t(t_regular, "io"), _fd(fd), _id(id) { }
+protected:
+    void run() {
+        enum { BLOCK = 8192 };
+        char out[BLOCK], in[BLOCK];
+        memset(out, 'a' + _id % 26, BLOCK);
+        memset(in, 0, BLOCK);
+        fileoff_t pos = fileoff_t(_id) * BLOCK;
+        W_COERCE(sthread_t::pwrite(_fd, out, BLOCK, pos));
+        W_COERCE(sthread_t::fsync(_fd));
+        W_COERCE(sthread_t::pread(_fd, in, BLOCK, pos));
+        if(memcmp(in, out, BLOCK)) {
+            cerr << "io fiber " << _id << " read back wrong data" << endl;
+            errors++;
+        }
+    }
+private:
+    int _fd;
+    int _id;
+};
+
+/* Forks a fiber on its own carrier and joins it */
+class parent_thread_t : public sthread_t {
+public:
+    parent_thread_t(sthread_carrier_t &c)
+        : sthread_t(t_regular, "parent"), _carrier(c) { }
+protected:
+    void run() {
+        sleep_thread_t child;
+        W_COERCE(child.fork(_carrier));
+        W_COERCE(child.join());
+        if(!is_fiber()) {
+            cerr << "parent is not a fiber" << endl;
+            errors++;
+        }
+    }
+private:
+    sthread_carrier_t &_carrier;
+};
+
+
+int parse_args(int argc, char **argv)
+{
+    int bad = 0;
+    int c;
+    while((c = getopt(argc, argv, "n:c:i:s:v")) != EOF) {
+        switch(c) {
+        case 'n': NumFibers = atoi(optarg); break;
+        case 'c': NumCarriers = atoi(optarg); break;
+        case 'i': Iterations = atoi(optarg); break;
+        case 's': SleepTime = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        default: bad++; break;
+        }
+    }
+    if(bad || NumFibers < 1 || NumCarriers < 1) {
+        cerr << "usage: " << argv[0]
+             << " [-n fibers] [-c carriers] [-i iterations]"
+             << " [-s sleep_ms] [-v]" << endl;
+        return -1;
+    }
+    return optind;
+}
+
+template<class T>
+void run_all(T** t, sthread_carrier_t** carriers)
+{
+    for(int i=0; i < NumFibers; i++) {
+        W_COERCE(t[i]->fork(*carriers[i % NumCarriers]));
+    }
+    for(int i=0; i < NumFibers; i++) {
+        W_COERCE(t[i]->join());
+        delete t[i];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if(parse_args(argc, argv) < 0) return 1;
+
+    sthread_carrier_t** carriers = new sthread_carrier_t*[NumCarriers];
+    for(int i=0; i < NumCarriers; i++) {
+        carriers[i] = new sthread_carrier_t;
+    }
+
+    {
+        counter_thread_t** t = new counter_thread_t*[NumFibers];
+        for(int i=0; i < NumFibers; i++) t[i] = new counter_thread_t;
+        run_all(t, carriers);
+        delete [] t;
+        if(counter != long(NumFibers) * Iterations) {
+            cerr << "counter " << counter << " expected "
+                 << long(NumFibers) * Iterations << endl;
+            errors++;
+        }
+        cout << "counter: " << (errors ? "failed" : "ok") << endl;
+    }
+
+    {
+        // they all sleep at once, even on one carrier
+        stime_t start(stime_t::now());
+        sleep_thread_t** t = new sleep_thread_t*[NumFibers];
+        for(int i=0; i < NumFibers; i++) t[i] = new sleep_thread_t;
+        run_all(t, carriers);
+        delete [] t;
+        sinterval_t elapsed(stime_t::now() - start);
+        if(verbose) cout << "slept " << elapsed << endl;
+        bool ok = double(elapsed) * 1000 <
+            double(SleepTime) * (NumFibers + NumCarriers - 1) / NumCarriers;
+        if(NumFibers > NumCarriers && !ok) {
+            cerr << "fibers did not sleep concurrently" << endl;
+            errors++;
+        }
+        cout << "sleep: " << (ok || NumFibers <= NumCarriers
+                             ? "ok" : "failed") << endl;
+    }
+
+    {
+        // the waiters are parked, not polled, until the broadcast
+        w_base_t::base_stat_t before = STH_STATS(fiber_switch);
+        cond_thread_t** t = new cond_thread_t*[NumFibers];
+        for(int i=0; i < NumFibers; i++) {
+            t[i] = new cond_thread_t;
+            W_COERCE(t[i]->fork(*carriers[i % NumCarriers]));
+        }
+        sthread_t::me()->sleep(SleepTime);
+        {
+            CRITICAL_SECTION(cs, go_lock);
+            go = true;
+        }
+        // after the unlock, or the woken fibers spin on go_lock
+        sthread_t::cond_broadcast(go_cond);
+        for(int i=0; i < NumFibers; i++) {
+            W_COERCE(t[i]->join());
+            delete t[i];
+        }
+        delete [] t;
+        w_base_t::base_stat_t switches = STH_STATS(fiber_switch) - before;
+        if(verbose) cout << "cond switches " << switches << endl;
+        // run, wake up, maybe retake the lock once more
+        bool ok = switches <= w_base_t::base_stat_t(4 * NumFibers);
+        if(!ok) {
+            cerr << "cond waiters ran " << switches << " times" << endl;
+            errors++;
+        }
+        cout << "cond: " << (ok ? "ok" : "failed") << endl;
+    }
+
+    {
+        char path[] = "/tmp/fiber1XXXXXX";
+        int tmp = mkstemp(path);
+        if(tmp < 0) { perror("mkstemp"); return 1; }
+        ::close(tmp);
+        int fd;
+        W_COERCE(sthread_t::open(path, sthread_t::OPEN_RDWR, 0666, fd));
+        w_base_t::base_stat_t before = STH_STATS(fiber_io);
+        io_thread_t** t = new io_thread_t*[NumFibers];
+        for(int i=0; i < NumFibers; i++) t[i] = new io_thread_t(fd, i);
+        run_all(t, carriers);
+        delete [] t;
+        W_COERCE(sthread_t::close(fd));
+        unlink(path);
+        if(STH_STATS(fiber_io) - before
+                != w_base_t::base_stat_t(3 * NumFibers)) {
+            cerr << "I/Os did not go through the carriers" << endl;
+            errors++;
+        }
+        cout << "io: " << (errors ? "failed" : "ok") << endl;
+    }
+
+    {
+        parent_thread_t parent(*carriers[0]);
+        W_COERCE(parent.fork(*carriers[0]));
+        W_COERCE(parent.join());
+        cout << "join: " << (errors ? "failed" : "ok") << endl;
+    }
+
+    for(int i=0; i < NumCarriers; i++) delete carriers[i];
+    delete [] carriers;
+
+    if(verbose) sthread_t::dump_stats(cout);
+    return errors ? 1 : 0;
+}
+
+#else
+
+int main()
+{
+    cout << "fibers not compiled in (configure --enable-fibers)" << endl;
+    return 0;
+}
+
+#endif /* SM_FIBERS */
@@ -0,0 +1,155 @@
+/* -*- mode:C++; c-basic-offset:4 -*-
+     Shore-MT -- Multi-threaded port of the SHORE storage manager
+
+                       Copyright (c) 2007-2009
+      Data Intensive Applications and Systems Labaratory (DIAS)
+               Ecole Polytechnique Federale de Lausanne
+
+                         All Rights Reserved.
+
+   Permission to use, copy, modify and distribute this software and
+   its documentation is hereby granted, provided that both the
+   copyright notice and this permission notice appear in all copies of
+   the software, derivative works or modified versions, and any
+   portions thereof, and that both notices appear in supporting
+   documentation.
+
+   This code is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. THE AUTHORS
+   DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER
+   RESULTING FROM THE USE OF THIS SOFTWARE.
+*/
+
+#include "w_defines.h"
+
+/*  -- do not edit anything above this line --   </std-header>*/
+
+/* A file opened over a base image (<file>.base): reads through to the
+ * base, whole and partial page writes, growing the file, and the same
+ * contents after a reopen. The base must not change.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+
+#include <w.h>
+#include <sthread.h>
+#include <iostream>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+typedef sthread_t::fileoff_t fileoff_t;
+
+enum { PAGE = 8192, BASE_PAGES = 16 };
+
+int     errors = 0;
+
+char    dir[] = "/tmp/overlay1XXXXXX";
+char    image[64];
+char    file[64];
+char    base_link[64];
+
+// what page p of the file should hold
+char    expected[BASE_PAGES + 4][PAGE];
+
+void check(int fd, const char* when)
+{
+    char buf[PAGE];
+    sthread_base_t::filestat_t st;
+    W_COERCE(sthread_t::fstat(fd, st));
+    if(st.st_size != (BASE_PAGES + 4) * PAGE) {
+        cerr << when << ": size " << st.st_size << endl;
+        errors++;
+    }
+    for(int p=0; p < BASE_PAGES + 4; p++) {
+        W_COERCE(sthread_t::pread(fd, buf, PAGE, fileoff_t(p) * PAGE));
+        if(memcmp(buf, expected[p], PAGE)) {
+            cerr << when << ": page " << p << " is wrong" << endl;
+            errors++;
+        }
+    }
+    // across pages of the base and of the delta at once
+    char two[2*PAGE];
+    W_COERCE(sthread_t::pread(fd, two, 2*PAGE, 2 * PAGE + 100));
+    if(memcmp(two, expected[2] + 100, PAGE - 100)
+       || memcmp(two + PAGE - 100, expected[3], PAGE)
+       || memcmp(two + 2*PAGE - 100, expected[4], 100)) {
+        cerr << when << ": read across pages is wrong" << endl;
+        errors++;
+    }
+}
+
+int main()
+{
+    if(!mkdtemp(dir)) { perror("mkdtemp"); return 1; }
+    sprintf(image, "%s/vol", dir);
+    sprintf(file, "%s/db", dir);
+    sprintf(base_link, "%s/db.base", dir);
+
+    // the base: page p full of 'a'+p
+    FILE* f = fopen(image, "w");
+    for(int p=0; p < BASE_PAGES; p++) {
+        memset(expected[p], 'a' + p, PAGE);
+        fwrite(expected[p], PAGE, 1, f);
+    }
+    fclose(f);
+    for(int p=BASE_PAGES; p < BASE_PAGES + 4; p++)
+        memset(expected[p], 0, PAGE);
+
+    // the restore: an empty file of the size of the base
+    f = fopen(file, "w");
+    fclose(f);
+    if(truncate(file, BASE_PAGES * PAGE) || symlink(image, base_link)) {
+        perror("restore");
+        return 1;
+    }
+
+    int fd;
+    W_COERCE(sthread_t::open(file, sthread_t::OPEN_RDWR, 0666, fd));
+
+    // a whole page, part of a page, and past the end of the base
+    memset(expected[3], 'X', PAGE);
+    W_COERCE(sthread_t::pwrite(fd, expected[3], PAGE, 3 * PAGE));
+    memset(expected[5] + 1000, 'Y', 100);
+    W_COERCE(sthread_t::pwrite(fd, expected[5] + 1000, 100, 5 * PAGE + 1000));
+    memset(expected[BASE_PAGES + 3], 'Z', PAGE);
+    W_COERCE(sthread_t::pwrite(fd, expected[BASE_PAGES + 3], PAGE,
+                               fileoff_t(BASE_PAGES + 3) * PAGE));
+    // two pages at once, the second one only in part
+    memset(expected[8] + 10, 'W', PAGE - 10);
+    memset(expected[9], 'W', 10);
+    W_COERCE(sthread_t::pwrite(fd, expected[8] + 10, PAGE, 8 * PAGE + 10));
+
+    check(fd, "written");
+    W_COERCE(sthread_t::close(fd));
+
+    W_COERCE(sthread_t::open(file, sthread_t::OPEN_RDWR, 0666, fd));
+    check(fd, "reopened");
+    W_COERCE(sthread_t::close(fd));
+
+    // the base did not change
+    char buf[PAGE];
+    f = fopen(image, "r");
+    for(int p=0; p < BASE_PAGES; p++) {
+        char want[PAGE];
+        memset(want, 'a' + p, PAGE);
+        if(fread(buf, PAGE, 1, f) != 1 || memcmp(buf, want, PAGE)) {
+            cerr << "base page " << p << " changed" << endl;
+            errors++;
+        }
+    }
+    fclose(f);
+
+    unlink(base_link);
+    unlink(file);
+    unlink(image);
+    rmdir(dir);
+
+    cout << "overlay: " << (errors ? "failed" : "ok") << endl;
+    return errors ? 1 : 0;
+}